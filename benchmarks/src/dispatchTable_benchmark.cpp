@@ -0,0 +1,124 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file dispatchTable_benchmark.cpp
+* @author Christophe Calmejane
+* @brief Compares the per-message cost of a hashed std::function map (former dispatch method) with the DispatchTable, for a table the size of the AEM commands one.
+*/
+
+// Internal API
+#include "dispatchTable.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+constexpr auto TableSize = la::avdecc::AemCommandTypeDispatchSize;
+constexpr auto DefaultIterations = std::size_t{ 10000000u };
+
+// Handlers, same for both dispatch methods
+void handler0(std::uint64_t& counter, std::uint16_t const key)
+{
+	counter += key;
+}
+void handler1(std::uint64_t& counter, std::uint16_t const key)
+{
+	counter ^= key;
+}
+
+using Signature = void(std::uint64_t& counter, std::uint16_t const key);
+using Table = la::avdecc::DispatchTable<std::uint16_t, TableSize, Signature>;
+
+template<std::size_t... Keys>
+constexpr Table makeTable(std::index_sequence<Keys...>)
+{
+	return Table{ { static_cast<std::uint16_t>(Keys), (Keys % 2) == 0 ? &handler0 : &handler1 }... };
+}
+
+/** Dispatches the specified number of messages, returning the resulting counter and the cost per message (in ns) */
+template<typename Dispatch>
+std::pair<std::uint64_t, double> run(std::size_t const iterations, Dispatch&& dispatch)
+{
+	auto counter = std::uint64_t{ 0u };
+	auto const start = std::chrono::steady_clock::now();
+	for (auto i = std::size_t{ 0u }; i < iterations; ++i)
+	{
+		dispatch(counter, static_cast<std::uint16_t>((i * 7u) % TableSize));
+	}
+	auto const duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	return std::make_pair(counter, static_cast<double>(duration.count()) / static_cast<double>(iterations));
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto const iterations = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : DefaultIterations;
+	if (iterations == 0u)
+	{
+		std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+		return 1;
+	}
+
+	auto map = std::unordered_map<std::uint16_t, std::function<Signature>>{};
+	for (auto key = std::uint16_t{ 0u }; key < TableSize; ++key)
+	{
+		map[key] = (key % 2) == 0 ? &handler0 : &handler1;
+	}
+	static constexpr auto s_Table = makeTable(std::make_index_sequence<TableSize>{});
+
+	auto const [mapCounter, mapCost] = run(iterations,
+		[&map](std::uint64_t& counter, std::uint16_t const key)
+		{
+			auto const it = map.find(key);
+			if (it != map.end())
+			{
+				it->second(counter, key);
+			}
+		});
+	auto const [tableCounter, tableCost] = run(iterations,
+		[](std::uint64_t& counter, std::uint16_t const key)
+		{
+			auto const handler = s_Table.get(key);
+			if (handler != nullptr)
+			{
+				handler(counter, key);
+			}
+		});
+
+	// Both methods must call the same handlers (also prevents the compiler from optimizing the loops away)
+	if (mapCounter != tableCounter)
+	{
+		std::cerr << "Dispatch methods did not call the same handlers" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Dispatch cost per message (" << iterations << " messages, " << TableSize << " keys):" << std::endl;
+	std::cout << "  unordered_map<std::function>: " << mapCost << " ns" << std::endl;
+	std::cout << "  DispatchTable:                " << tableCost << " ns" << std::endl;
+
+	return 0;
+}
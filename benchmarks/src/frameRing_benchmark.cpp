@@ -0,0 +1,206 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameRing_benchmark.cpp
+* @author Christophe Calmejane
+* @brief Reports the throughput (frames/s) of the virtual interface FrameRing alone (several producers, a single consumer),
+*        then of the ProtocolInterfaceVirtual (messages sent by one interface, received by an observer of another interface of the same network).
+*/
+
+// Internal API
+#include "protocolInterface/frameRing.hpp"
+#include "protocolInterface/protocolInterface_virtual.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr auto DefaultFramesCount = std::size_t{ 4000000u };
+constexpr auto FrameSize = std::size_t{ 64u };
+
+/** Pushes framesCount frames (split between producersCount threads) to a FrameRing, returns the throughput in frames/s */
+double benchmarkFrameRing(std::size_t const producersCount, std::size_t const framesCount)
+{
+	auto ring = la::avdecc::protocol::FrameRing{};
+	auto const framesPerProducer = framesCount / producersCount;
+
+	auto const start = std::chrono::steady_clock::now();
+
+	auto producers = std::vector<std::thread>{};
+	for (auto producer = std::size_t{ 0u }; producer < producersCount; ++producer)
+	{
+		producers.emplace_back(
+			[&ring, framesPerProducer, producer]
+			{
+				auto frame = std::array<std::uint8_t, FrameSize>{};
+				frame[0] = static_cast<std::uint8_t>(producer);
+				for (auto sequence = std::size_t{ 0u }; sequence < framesPerProducer; ++sequence)
+				{
+					std::memcpy(&frame[1], &sequence, sizeof(sequence));
+					while (!ring.tryPush(frame.data(), frame.size()))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+	}
+
+	auto received = std::size_t{ 0u };
+	auto frames = std::array<la::avdecc::protocol::FrameRing::Frame const*, 32>{};
+	while (received < producersCount * framesPerProducer)
+	{
+		auto const count = ring.peek(frames.data(), frames.size());
+		ring.release(count);
+		received += count;
+		if (count == 0u)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	auto const duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	return static_cast<double>(received) / duration.count();
+}
+
+class Observer final : public la::avdecc::protocol::ProtocolInterface::Observer
+{
+public:
+	Observer(std::size_t const expectedCount) noexcept
+		: _expectedCount(expectedCount)
+	{
+	}
+
+	/** Waits for the expected number of ADPDUs to be received, returns false on timeout */
+	bool waitForAdpdus()
+	{
+		auto lock = std::unique_lock{ _lock };
+		return _condition.wait_for(lock, std::chrono::seconds(60),
+			[this]
+			{
+				return _receivedCount.load(std::memory_order_relaxed) >= _expectedCount;
+			});
+	}
+
+private:
+	virtual void onAdpduReceived(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::protocol::Adpdu const& /*adpdu*/) noexcept override
+	{
+		// Only wake up the waiting thread once all the expected ADPDUs are received, so the notification does not weigh on the measure
+		if ((_receivedCount.fetch_add(1u, std::memory_order_relaxed) + 1u) == _expectedCount)
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_condition.notify_all();
+		}
+	}
+
+	DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+
+	std::size_t const _expectedCount{ 0u };
+	std::atomic<std::size_t> _receivedCount{ 0u };
+	std::mutex _lock{};
+	std::condition_variable _condition{};
+};
+
+/** Sends framesCount ADPDUs from a virtual interface to another one, returns the throughput in frames/s (0 if not all frames were received) */
+double benchmarkProtocolInterfaceVirtual(std::size_t const framesCount)
+{
+	auto const networkName = std::string{ "FrameRingBenchmark" };
+	auto sender = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto receiver = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	auto observer = Observer{ framesCount };
+	receiver->registerObserver(&observer);
+
+	// Build adpdu frame
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	// Set Ether2 fields
+	adpdu.setSrcAddress(sender->getMacAddress());
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	// Set ADP fields
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	adpdu.setValidTime(31);
+	adpdu.setEntityID(la::avdecc::UniqueIdentifier{ 0x0001020304050607 });
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setControllerCapabilities(la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented });
+	adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+
+	auto const start = std::chrono::steady_clock::now();
+	for (auto index = std::size_t{ 0u }; index < framesCount; ++index)
+	{
+		adpdu.setAvailableIndex(static_cast<std::uint32_t>(index));
+		sender->sendAdpMessage(adpdu);
+	}
+	auto const isComplete = observer.waitForAdpdus();
+	auto const duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+	receiver->unregisterObserver(&observer);
+
+	if (!isComplete)
+	{
+		return 0.0;
+	}
+	return static_cast<double>(framesCount) / duration.count();
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	auto const framesCount = argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : DefaultFramesCount;
+	if (framesCount == 0u)
+	{
+		std::cerr << "Usage: " << argv[0] << " [frames count]" << std::endl;
+		return 1;
+	}
+
+	std::cout << "FrameRing (" << la::avdecc::protocol::FrameRing::Capacity << " slots, " << FrameSize << " bytes frames, " << framesCount << " frames):" << std::endl;
+	for (auto const producersCount : { std::size_t{ 1u }, std::size_t{ 2u }, std::size_t{ 4u } })
+	{
+		std::cout << "  " << producersCount << " producer(s): " << static_cast<std::uint64_t>(benchmarkFrameRing(producersCount, framesCount)) << " frames/s" << std::endl;
+	}
+
+	// Virtual interface frames go through the full dispatch path (decoding, state machines), use less of them
+	auto const virtualFramesCount = std::max(framesCount / 10u, std::size_t{ 1u });
+	auto const virtualThroughput = benchmarkProtocolInterfaceVirtual(virtualFramesCount);
+	if (virtualThroughput == 0.0)
+	{
+		std::cerr << "ProtocolInterfaceVirtual: not all frames were received" << std::endl;
+		return 1;
+	}
+	std::cout << "ProtocolInterfaceVirtual (ADPDU, " << virtualFramesCount << " frames): " << static_cast<std::uint64_t>(virtualThroughput) << " frames/s" << std::endl;
+
+	return 0;
+}
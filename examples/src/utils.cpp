@@ -153,6 +153,7 @@ avdecc_protocol_interface_type_t chooseProtocolInterfaceType()
 		checkAndDisplayInterfaceType(avdecc_protocol_interface_type_pcap);
 		checkAndDisplayInterfaceType(avdecc_protocol_interface_type_macos_native);
 		checkAndDisplayInterfaceType(avdecc_protocol_interface_type_proxy);
+		checkAndDisplayInterfaceType(avdecc_protocol_interface_type_raw_socket);
 
 		outputText("\n> ");
 
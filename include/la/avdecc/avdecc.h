@@ -41,7 +41,7 @@
 * A change in the visible interface is any modification in a public header file.
 * Any other change (including inline methods, defines, typedefs, ...) are considered a modification of the interface.
 */
-#define LA_AVDECC_InterfaceVersion 100
+#define LA_AVDECC_InterfaceVersion 101
 
 /**
 * @brief Checks if the library is compatible with specified interface version.
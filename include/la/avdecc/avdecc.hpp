@@ -70,7 +70,7 @@ namespace avdecc
 * (either added, removed or signature modification).
 * Any other change (including templates, inline methods, defines, typedefs, ...) are considered a modification of the interface.
 */
-constexpr std::uint32_t InterfaceVersion = 301;
+constexpr std::uint32_t InterfaceVersion = 302;
 
 /**
 * @brief Checks if the library is compatible with specified interface version.
@@ -0,0 +1,129 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file entityFarm.hpp
+* @author Christophe Calmejane
+* @brief Synthetic entities load generator, for controller scale testing.
+*/
+
+#pragma once
+
+#include "entity.hpp"
+#include "entityModelTree.hpp"
+#include "protocolInterface.hpp"
+#include "exports.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace la
+{
+namespace avdecc
+{
+namespace entity
+{
+/**
+* @brief Simulates many AEM entities on a virtual network interface.
+* @details The farm owns its own ProtocolInterface (ProtocolInterface::Type::Virtual) on the specified virtual network interface, and makes all
+*          its entities share its MAC address. Each entity is a copy of the same template EntityTree: it is advertised through ADP, answers
+*          READ_DESCRIPTOR and the GET_* AEM commands a Controller uses during enumeration from response buffers serialized once for all entities,
+*          and answers the ACMP state queries. Other commands are answered with a NOT_IMPLEMENTED status.
+*          If requested, GET_COUNTERS unsolicited notifications are sent to the controllers registered to the entities.
+*          Intended to measure the enumeration time, memory and CPU usage of a Controller connected to the same virtual network interface.
+*/
+class EntityFarm
+{
+public:
+	using UniquePointer = std::unique_ptr<EntityFarm, void (*)(EntityFarm*)>;
+
+	/** Farm parameters */
+	struct Configuration
+	{
+		std::size_t numberOfEntities{ 1u }; /**< Number of simulated entities */
+		UniqueIdentifier baseEntityID{ 0x001B92FFFA000000 }; /**< EntityID of the first entity, the next ones being allocated sequentially */
+		networkInterface::MacAddress macAddress{ { 0x02, 0x00, 0x00, 0xfa, 0x00, 0x00 } }; /**< MAC address shared by all the entities (must be different from the one of the Controller) */
+		std::uint8_t validTime{ 31u }; /**< ADP valid time of the entities (in 2-seconds periods), they are advertised again after half of it */
+		std::uint32_t unsolicitedNotificationsPerSecond{ 0u }; /**< Total number of unsolicited notifications sent per second by the farm (0 to disable) */
+	};
+
+	/** Counters of the farm, since its creation */
+	struct Statistics
+	{
+		std::uint64_t receivedCommands{ 0u }; /**< AECP and ACMP commands received for the entities of the farm */
+		std::uint64_t sentResponses{ 0u }; /**< Responses sent (including the NOT_IMPLEMENTED ones) */
+		std::uint64_t notImplementedResponses{ 0u }; /**< Responses sent with a NOT_IMPLEMENTED status */
+		std::uint64_t sentUnsolicitedNotifications{ 0u }; /**< Unsolicited notifications sent */
+		std::uint64_t sentAdvertisements{ 0u }; /**< ADP ENTITY_AVAILABLE messages sent */
+	};
+
+	/**
+	* @brief Factory method to create a new EntityFarm.
+	* @details Creates the virtual ProtocolInterface, serializes the responses of the template EntityTree then advertises all the entities.
+	* @param[in] networkInterfaceName The name of the virtual network interface to simulate the entities on.
+	* @param[in] commonInformation The ADP information of the entities (the entityID field is ignored, see Configuration::baseEntityID).
+	* @param[in] entityTree The template AEM of the entities (for example loaded from a JSON file using la::avdecc::entity::model::jsonSerializer::createEntityTree).
+	* @param[in] configuration The parameters of the farm.
+	* @return A new EntityFarm as a EntityFarm::UniquePointer.
+	* @note Throws ProtocolInterface::Exception if the virtual ProtocolInterface is not supported or cannot be created, and std::invalid_argument if numberOfEntities is 0 or the EntityTree does not contain its current configuration. Descriptors of the EntityTree that cannot be serialized are answered with a NOT_IMPLEMENTED status.
+	*/
+	static UniquePointer create(std::string const& networkInterfaceName, Entity::CommonInformation const& commonInformation, model::EntityTree const& entityTree, Configuration const& configuration)
+	{
+		auto deleter = [](EntityFarm* self)
+		{
+			self->destroy();
+		};
+		return UniquePointer(createRawEntityFarm(networkInterfaceName, commonInformation, entityTree, configuration), deleter);
+	}
+
+	/** Returns the ProtocolInterface the entities are simulated on. */
+	virtual protocol::ProtocolInterface& getProtocolInterface() noexcept = 0;
+
+	/** Returns the number of simulated entities. */
+	virtual std::size_t getNumberOfEntities() const noexcept = 0;
+
+	/** Returns the EntityID of the simulated entity at the specified index (in the [0, getNumberOfEntities()[ range). */
+	virtual UniqueIdentifier getEntityID(std::size_t const index) const noexcept = 0;
+
+	/** Returns the counters of the farm. */
+	virtual Statistics getStatistics() const noexcept = 0;
+
+	// Deleted compiler auto-generated methods
+	EntityFarm(EntityFarm&&) = delete;
+	EntityFarm(EntityFarm const&) = delete;
+	EntityFarm& operator=(EntityFarm const&) = delete;
+	EntityFarm& operator=(EntityFarm&&) = delete;
+
+protected:
+	EntityFarm() noexcept = default;
+	virtual ~EntityFarm() noexcept = default;
+
+private:
+	/** Entry point */
+	static LA_AVDECC_API EntityFarm* LA_AVDECC_CALL_CONVENTION createRawEntityFarm(std::string const& networkInterfaceName, Entity::CommonInformation const& commonInformation, model::EntityTree const& entityTree, Configuration const& configuration);
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept = 0;
+};
+
+} // namespace entity
+} // namespace avdecc
+} // namespace la
@@ -46,6 +46,7 @@
 #include <functional>
 #include <optional>
 #include <chrono>
+#include <atomic>
 
 namespace la
 {
@@ -53,6 +54,9 @@ namespace avdecc
 {
 namespace protocol
 {
+class FrameRecorder;
+class FrameTap;
+
 class ProtocolInterface : public la::avdecc::utils::Subject<ProtocolInterface, std::recursive_mutex>
 {
 public:
@@ -64,6 +68,9 @@ public:
 		MacOSNative = 1u << 1, /**< macOS native API protocol interface - Only usable on macOS. */
 		Proxy = 1u << 2, /**< IEEE Std 1722.1 Proxy protocol interface. */
 		Virtual = 1u << 3, /**< Virtual protocol interface. */
+		RawSocket = 1u << 4, /**< Linux AF_PACKET raw socket protocol interface - Only usable on linux. */
+		SharedMemory = 1u << 5, /**< Shared memory virtual network, connecting processes of the same machine - Only usable on linux. */
+		PcapReplay = 1u << 6, /**< Replay of a packet capture file (the network interface name being the path to the file), for benchmarks and regression tests. */
 	};
 
 	/** Possible Error status returned (or thrown) by a ProtocolInterface */
@@ -102,10 +109,65 @@ public:
 		Error const _error{ Error::NoError };
 	};
 
+	/** Priority of an AECP command, ordering the commands waiting to be sent to the same target entity (the commands already inflight are not affected) */
+	enum class AecpCommandPriority
+	{
+		Interactive = 0, /**< Command triggered by a user action (changing a value, acquiring an entity, ...), sent before any queued Background command. */
+		Background = 1, /**< Enumeration or polling command, sent when no Interactive command is waiting for the same target entity. */
+	};
+
 	using UniquePointer = std::unique_ptr<ProtocolInterface, void (*)(ProtocolInterface*)>;
 	using SupportedProtocolInterfaceTypes = la::avdecc::utils::EnumBitfield<Type>;
 	using AecpCommandResultHandler = std::function<void(la::avdecc::protocol::Aecpdu const* const response, la::avdecc::protocol::ProtocolInterface::Error const error)>;
 	using AcmpCommandResultHandler = std::function<void(la::avdecc::protocol::Acmpdu const* const response, la::avdecc::protocol::ProtocolInterface::Error const error)>;
+	using EntityReferences = std::vector<std::reference_wrapper<la::avdecc::entity::Entity const>>;
+
+	/** Statistics of the pool recycling the PDUs created on the receive path */
+	struct PduPoolStatistics
+	{
+		std::uint64_t hits{ 0u }; /**< Number of received PDUs that reused a recycled object. */
+		std::uint64_t misses{ 0u }; /**< Number of received PDUs that required a new allocation. */
+	};
+
+	/** Statistics of the transmit queue */
+	struct TransmitQueueStatistics
+	{
+		std::uint64_t sentFrames{ 0u }; /**< Number of frames successfully sent. */
+		std::uint64_t sendBatches{ 0u }; /**< Number of batches handed to the transport (each batch being sent with as few system calls as the transport allows). */
+		std::uint64_t failedFrames{ 0u }; /**< Number of frames the transport failed to send. */
+		std::uint64_t droppedFrames{ 0u }; /**< Number of frames dropped because the queue was full (the sender got a TransportError right away). On the virtual interface, number of frames the virtual network could not accept (being destroyed or out of memory). */
+		std::uint64_t failedCommands{ 0u }; /**< Number of failed frames carrying a command, reported to the command state machine (the command then fails with TransportError instead of timing out). */
+		std::uint64_t commandWaits{ 0u }; /**< Number of times the commands had to wait for the queue to have room (back-pressure, the commands being kept queued by the command state machine). */
+		std::uint64_t maximumDepth{ 0u }; /**< Highest number of frames waiting in the queue. */
+	};
+
+	/** Statistics of the inflight commands timeout checks */
+	struct CommandTimeoutStatistics
+	{
+		std::uint64_t checks{ 0u }; /**< Number of times the inflight commands were checked for timeout. */
+		std::uint64_t examinedCommands{ 0u }; /**< Number of inflight commands examined by the checks (cost of the checks). */
+		std::uint64_t expiredCommands{ 0u }; /**< Number of examined commands that had timed out (either retried or failed). */
+	};
+
+	/** Statistics of the lock of the whole ProtocolInterface (see lock()) */
+	struct LockStatistics
+	{
+		std::uint64_t acquisitions{ 0u }; /**< Number of times the lock was acquired (recursive acquisitions by the thread already holding it not being counted). */
+		std::uint64_t contentions{ 0u }; /**< Number of acquisitions that had to wait for another thread to release the lock. */
+		std::chrono::nanoseconds totalWaitTime{ 0 }; /**< Total time spent waiting for the lock. */
+		std::chrono::nanoseconds maximumWaitTime{ 0 }; /**< Longest time spent waiting for the lock. */
+		std::chrono::nanoseconds totalHoldTime{ 0 }; /**< Total time the lock was held. */
+		std::chrono::nanoseconds maximumHoldTime{ 0 }; /**< Longest time the lock was held. */
+		std::uint64_t deferredCommands{ 0u }; /**< Number of commands handed over to the thread holding the lock, instead of waiting for it. */
+	};
+
+	/** Statistics of the frames received by the capture (as reported by the kernel or the capture library) */
+	struct ReceiveStatistics
+	{
+		std::uint64_t receivedFrames{ 0u }; /**< Number of frames that passed the capture filter. */
+		std::uint64_t droppedFrames{ 0u }; /**< Number of frames dropped because the capture buffer was full (frames lost before being processed). */
+		std::uint64_t interfaceDroppedFrames{ 0u }; /**< Number of frames dropped by the network interface or its driver (if reported). */
+	};
 
 	/** Interface definition for ProtocolInterface events observation */
 	class Observer : public la::avdecc::utils::Observer<ProtocolInterface>
@@ -123,6 +185,14 @@ public:
 		virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept {}
 		virtual void onRemoteEntityOffline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::UniqueIdentifier const /*entityID*/) noexcept {}
 		virtual void onRemoteEntityUpdated(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept {}
+		/** Notification for the remote entities updated during the coalescing delay (see setRemoteEntitiesUpdateCoalescingDelay), each entity being listed once with its latest state. Defaults to calling onRemoteEntityUpdated for each entity. */
+		virtual void onRemoteEntitiesUpdated(la::avdecc::protocol::ProtocolInterface* const pi, EntityReferences const& entities) noexcept
+		{
+			for (auto const& entity : entities)
+			{
+				onRemoteEntityUpdated(pi, entity);
+			}
+		}
 
 		/* **** AECP notifications **** */
 		/** Notification for when an AECP Command is received (for a locally registered entity). */
@@ -259,6 +329,15 @@ public:
 	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept = 0;
 	/** Sets automatic discovery delay. 0 (default) for no automatic discovery. */
 	virtual Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) const noexcept = 0;
+	/** Sets the delay during which remote entities updates (gPTP, capabilities, ...) are coalesced, to be notified at once through onRemoteEntitiesUpdated. 0 (default) to notify each update right away through onRemoteEntityUpdated. */
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept = 0;
+	/**
+	* @brief Enables or disables the paced automatic discovery (disabled by default).
+	* @details When disabled, a global DISCOVER message is sent every automatic discovery delay, and all the entities of the network answer at once.
+	*          When enabled, the known entities not heard of during the last delay are sent a targeted DISCOVER message, spread over the delay, and a global DISCOVER message is only sent
+	*          when no remote entity is known or after a remote entity timed out. The delay is also jittered (up to 10%) so that controllers of the network do not discover in sync.
+	*/
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept = 0;
 
 	/* ************************************************************ */
 	/* Sending entry points                                         */
@@ -271,11 +350,15 @@ public:
 	virtual Error sendAecpMessage(Aecpdu const& aecpdu) const noexcept = 0;
 	/** Sends an ACMP message directly on the network (not supported by all kinds of ProtocolInterface). */
 	virtual Error sendAcmpMessage(Acmpdu const& acmpdu) const noexcept = 0;
-	/** Sends an AECP command message. Only registered LocalEntities are allowed to call this method. VuAecpdu that are not handled by the ControllerStateMachine are not allowed to call this method (use sendAecpMessage for those cases). */
-	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult) const noexcept = 0;
+	/**
+	* @brief Sends an AECP command message.
+	* @details Only registered LocalEntities are allowed to call this method. VuAecpdu that are not handled by the ControllerStateMachine are not allowed to call this method (use sendAecpMessage for those cases). When the command cannot be sent right away (too many inflight commands for the target entity), it is queued after the other commands of the same priority.
+	* @warning If another thread holds the ProtocolInterface lock, the command is handed over to that thread and NoError is returned right away (without waiting for the lock): any error detected when the command is actually sent (sending LocalEntity unregistered in the meantime, ...) is then reported through onResult, called from the thread releasing the lock. Whenever this method returns an error, onResult is never called.
+	*/
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority = AecpCommandPriority::Interactive) const noexcept = 0;
 	/** Sends an AECP response message. Only registered LocalEntities are allowed to call this method. */
 	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept = 0;
-	/** Sends an ACMP command message. Only registered LocalEntities are allowed to call this method. */
+	/** Sends an ACMP command message. Only registered LocalEntities are allowed to call this method. Like sendAecpCommand, the command is handed over to the thread holding the ProtocolInterface lock (if any), later errors being reported through onResult from that thread. */
 	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept = 0;
 	/** Sends an ACMP response message. Only registered LocalEntities are allowed to call this method. */
 	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept = 0;
@@ -287,6 +370,52 @@ public:
 	/** Debug method: Returns true if the whole ProtocolInterface is locked by the calling thread */
 	virtual bool isSelfLocked() const noexcept = 0;
 
+	/* ************************************************************ */
+	/* Statistics entry points                                      */
+	/* ************************************************************ */
+	/** Returns the statistics of the receive path PDU pool (not supported by all kinds of ProtocolInterface, returns all 0 if not supported). */
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept = 0;
+
+	/** Returns the statistics of the transmit queue (not supported by all kinds of ProtocolInterface, returns all 0 if not supported). */
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept = 0;
+
+	/** Returns the statistics of the inflight commands timeout checks (not supported by all kinds of ProtocolInterface, returns all 0 if not supported). */
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept = 0;
+
+	/** Returns the statistics of the lock of the whole ProtocolInterface (not supported by all kinds of ProtocolInterface, returns all 0 if not supported). */
+	virtual LockStatistics getLockStatistics() const noexcept = 0;
+
+	/** Returns the statistics of the frames received by the capture (not supported by all kinds of ProtocolInterface, returns all 0 if not supported). Counters may be sampled periodically by the capture thread, so they can lag slightly behind. */
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept = 0;
+
+	/* ************************************************************ */
+	/* Kernel filtering entry points                                */
+	/* ************************************************************ */
+	/**
+	* @brief Enables or disables the sniffing mode (disabled by default).
+	* @details When the sniffing mode is disabled, ProtocolInterfaces supporting kernel filtering only let through the AECP messages that are multicast, or addressed to (or answering) a registered LocalEntity,
+	*          the filter being regenerated each time a LocalEntity is registered or unregistered. AECP messages exchanged between other entities are then no longer reported to observers (onAecpduReceived).
+	*          When enabled, all AVDECC messages are received. ProtocolInterfaces not supporting kernel filtering always receive all AVDECC messages, and return Error::NoError.
+	*/
+	virtual Error setSniffingMode(bool const enabled) noexcept = 0;
+
+	/* ************************************************************ */
+	/* Frame recorder entry points                                  */
+	/* ************************************************************ */
+	/**
+	* @brief Starts recording the raw frames received and sent by this ProtocolInterface, for post-mortem analysis.
+	* @details Frames are copied, with their timestamp, to a ring preallocated on the first call and kept until the ProtocolInterface is destroyed, the oldest frames being overwritten.
+	*          Calling this method again re-enables the recorder (without clearing it), bufferSize must then be the same than the first time.
+	* @param[in] bufferSize The size of the ring, in bytes.
+	* @param[in] transportErrorDumpFilePath If not empty, the recorded frames are automatically dumped to this pcapng file upon transport error.
+	* @note Frames are recorded when handed to the transport for sending, and before being decoded when received (not supported by all kinds of ProtocolInterface).
+	*/
+	LA_AVDECC_API Error LA_AVDECC_CALL_CONVENTION enableFrameRecorder(std::size_t const bufferSize, std::string const& transportErrorDumpFilePath) noexcept;
+	/** Stops recording frames. Already recorded frames are kept and can still be dumped. */
+	LA_AVDECC_API Error LA_AVDECC_CALL_CONVENTION disableFrameRecorder() noexcept;
+	/** Writes the recorded frames to a pcapng file (Error::InvalidParameters is returned if the recorder was never enabled or the file cannot be created). */
+	LA_AVDECC_API Error LA_AVDECC_CALL_CONVENTION dumpRecordedFrames(std::string const& filePath) const noexcept;
+
 	/** Returns true if the specified protocol interface type is supported on the local computer. */
 	static LA_AVDECC_API bool LA_AVDECC_CALL_CONVENTION isSupportedProtocolInterfaceType(Type const protocolInterfaceType) noexcept;
 
@@ -320,7 +449,7 @@ protected:
 	*/
 	ProtocolInterface(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress);
 
-	virtual ~ProtocolInterface() noexcept = default;
+	virtual ~ProtocolInterface() noexcept;
 
 	/** Returns true is the specified AecpMessageType is a Response kind, false if it's a Command kind. */
 	bool isAecpResponseMessageType(AecpMessageType const messageType) const noexcept;
@@ -331,6 +460,21 @@ protected:
 	/** Returns the VendorUniqueDelegate handling the specified protocolIdentifier, or nullptr if none has been registered. WARNING: Once returned, the pointed object is NOT locked. */
 	VendorUniqueDelegate* getVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept;
 
+	/** Records a frame handed to the transport for sending, if the frame recorder is enabled. */
+	void recordSentFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept;
+
+	/** Records a frame received from the transport, if the frame recorder is enabled. */
+	void recordReceivedFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept;
+
+	/** Hands a frame received from the transport to the frame tap, if any. Returns true if the frame has been consumed by the tap and must not be decoded. */
+	bool tapReceivedFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept;
+
+	/** Notifies the frame tap, if any, that the current batch of received frames is complete. */
+	void completeTapBatch() const noexcept;
+
+	/** Sends an already serialized ethernet frame directly on the network (not supported by all kinds of ProtocolInterface, returns Error::MessageNotSupported if not supported). */
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept;
+
 	std::string const _networkInterfaceName{};
 
 private:
@@ -342,6 +486,13 @@ private:
 
 	networkInterface::MacAddress _networkInterfaceMacAddress{};
 	std::unordered_map<VuAecpdu::ProtocolIdentifier, VendorUniqueDelegate*, VuAecpdu::ProtocolIdentifier::hash> _vendorUniqueDelegates{};
+	std::atomic<FrameRecorder*> _frameRecorder{ nullptr }; // Created by the first call to enableFrameRecorder, owned by this ProtocolInterface
+	std::atomic<FrameTap*> _frameTap{ nullptr }; // Set by the ProxyServer serving this ProtocolInterface, not owned
+
+	// The receive stage shared by all transports records frames
+	friend class FrameDecoder;
+	// The proxy server installs a frame tap and sends the frames of its clients
+	friend class ProxyServerImpl;
 };
 
 /* Operator overloads */
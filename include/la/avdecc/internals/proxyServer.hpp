@@ -0,0 +1,115 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file proxyServer.hpp
+* @author Christophe Calmejane
+* @brief Server side of the proxy ProtocolInterface.
+*/
+
+#pragma once
+
+#include "protocolInterface.hpp"
+#include "exports.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Shares a single ProtocolInterface with many processes.
+* @details The server owns a ProtocolInterface (usually a PCap or raw socket one) and serves the AVDECC frames it receives to the proxy ProtocolInterfaces
+*          connected to it (ProtocolInterface::Type::Proxy), through a Unix domain or TCP socket. Frames are sent by batches, each client only receiving the frames
+*          relevant to its registered LocalEntities (unless it enabled the sniffing mode). Frames sent by a client are sent on the network (and received back by all the clients, like any frame captured by the served ProtocolInterface).
+*          All clients share the MAC address of the served network interface: frames sent by a client are only sent on the network if they are AVTP frames
+*          with this source MAC address (see Statistics::rejectedFrames).
+* @warning There is no access control on the listening socket: any process able to connect to it can send (AVTP) frames on the network and receive the captured ones.
+*          A Unix domain socket is protected by its file system permissions, but a TCP listen address is reachable by any host that can route to it (use a loopback address unless the network is trusted).
+*/
+class ProxyServer
+{
+public:
+	using UniquePointer = std::unique_ptr<ProxyServer, void (*)(ProxyServer*)>;
+
+	/** Counters of the server, since its creation */
+	struct Statistics
+	{
+		std::size_t connectedClients{ 0u }; /**< Number of currently connected clients */
+		std::uint64_t receivedFrames{ 0u }; /**< Frames received from the network */
+		std::uint64_t clientFrames{ 0u }; /**< Frames received from the clients */
+		std::uint64_t forwardedFrames{ 0u }; /**< Frames sent to the clients (a frame sent to N clients counts N times) */
+		std::uint64_t droppedFrames{ 0u }; /**< Frames not sent to a client because it did not read its socket fast enough */
+		std::uint64_t rejectedFrames{ 0u }; /**< Frames received from the clients but not sent on the network (too short, not AVTP, or not sent from the MAC address of the served network interface) */
+	};
+
+	/**
+	* @brief Factory method to create a new ProxyServer.
+	* @details Creates the ProtocolInterface to share, then starts listening for proxy ProtocolInterfaces.
+	* @param[in] protocolInterfaceType The type of the ProtocolInterface to share.
+	* @param[in] networkInterfaceName The name of the network interface to share.
+	* @param[in] listenAddress The address to listen on: 'unix:<path>' (or a path starting with '/') for a Unix domain socket, '<host>:<port>' for a TCP socket (no access control, any host reaching it can use the shared interface). If empty, getDefaultAddress(networkInterfaceName) is used.
+	* @return A new ProxyServer as a ProxyServer::UniquePointer.
+	* @note Throws ProtocolInterface::Exception if the ProtocolInterface cannot be created or the address cannot be listened on.
+	*/
+	static UniquePointer create(ProtocolInterface::Type const protocolInterfaceType, std::string const& networkInterfaceName, std::string const& listenAddress)
+	{
+		auto deleter = [](ProxyServer* self)
+		{
+			self->destroy();
+		};
+		return UniquePointer(createRawProxyServer(protocolInterfaceType, networkInterfaceName, listenAddress), deleter);
+	}
+
+	/** Returns the address a ProxyServer listens on by default, for the specified network interface (also used by a proxy ProtocolInterface created with a network interface name instead of an address). */
+	static LA_AVDECC_API std::string LA_AVDECC_CALL_CONVENTION getDefaultAddress(std::string const& networkInterfaceName) noexcept;
+
+	/** Returns the shared ProtocolInterface. Received frames are forwarded to the clients without being decoded, LocalEntities have to be registered through a proxy ProtocolInterface. */
+	virtual ProtocolInterface& getProtocolInterface() noexcept = 0;
+
+	/** Returns the counters of the server. */
+	virtual Statistics getStatistics() const noexcept = 0;
+
+	// Deleted compiler auto-generated methods
+	ProxyServer(ProxyServer&&) = delete;
+	ProxyServer(ProxyServer const&) = delete;
+	ProxyServer& operator=(ProxyServer const&) = delete;
+	ProxyServer& operator=(ProxyServer&&) = delete;
+
+protected:
+	ProxyServer() noexcept = default;
+	virtual ~ProxyServer() noexcept = default;
+
+private:
+	/** Entry point */
+	static LA_AVDECC_API ProxyServer* LA_AVDECC_CALL_CONVENTION createRawProxyServer(ProtocolInterface::Type const protocolInterfaceType, std::string const& networkInterfaceName, std::string const& listenAddress);
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept = 0;
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -121,6 +121,9 @@ enum avdecc_protocol_interface_type_e
 	avdecc_protocol_interface_type_macos_native = 1u << 1, /**< macOS native API protocol interface - Only usable on macOS. */
 	avdecc_protocol_interface_type_proxy = 1u << 2, /**< IEEE Std 1722.1 Proxy protocol interface. */
 	avdecc_protocol_interface_type_virtual = 1u << 3, /**< Virtual protocol interface. */
+	avdecc_protocol_interface_type_raw_socket = 1u << 4, /**< Linux AF_PACKET raw socket protocol interface - Only usable on linux. */
+	avdecc_protocol_interface_type_shared_memory = 1u << 5, /**< Shared memory virtual network, connecting processes of the same machine - Only usable on linux. */
+	avdecc_protocol_interface_type_pcap_replay = 1u << 6, /**< Replay of a packet capture file (the network interface name being the path to the file), for benchmarks and regression tests. */
 };
 
 /** Valid values for avdecc_protocol_interface_error_t */
@@ -32,6 +32,8 @@
 #include <mutex>
 #include <string>
 #include <chrono>
+#include <limits>
+#include <cstddef>
 
 namespace la
 {
@@ -60,6 +62,8 @@ public:
 	};
 
 	using SharedPointer = std::shared_ptr<WatchDog>; /**< Alias for a shared pointer on the class */
+	using HeartbeatHandle = std::size_t; /**< Handle to a heartbeat watch slot */
+	static constexpr HeartbeatHandle InvalidHeartbeatHandle = std::numeric_limits<HeartbeatHandle>::max();
 
 	static LA_AVDECC_API SharedPointer LA_AVDECC_CALL_CONVENTION getInstance() noexcept;
 
@@ -70,6 +74,22 @@ public:
 	virtual void unregisterWatch(std::string const& name, bool const isThreadSpecific) noexcept = 0;
 	virtual void alive(std::string const& name, bool const isThreadSpecific) noexcept = 0;
 
+	/**
+	* @brief Registers a heartbeat watch, in a free slot (the slots storage grows as required, without ever moving the existing slots).
+	* @details Unlike registerWatch, a heartbeat is registered once and then armed/disarmed as many times as required without any allocation nor lock.
+	*          The heartbeat is only checked while armed.
+	* @param[in] name The name of the watch, reported to the observers if the maximum interval is exceeded.
+	* @param[in] maximumInterval The maximum interval allowed between armHeartbeat and disarmHeartbeat calls.
+	* @return A handle to the heartbeat, or InvalidHeartbeatHandle if the slots storage could not grow (out of memory).
+	*/
+	virtual HeartbeatHandle registerHeartbeat(std::string const& name, std::chrono::milliseconds const maximumInterval) noexcept = 0;
+	/** Unregisters a heartbeat watch previously registered with registerHeartbeat, releasing its slot. InvalidHeartbeatHandle is ignored. */
+	virtual void unregisterHeartbeat(HeartbeatHandle const handle) noexcept = 0;
+	/** Arms the heartbeat (or refreshes it if already armed). Lock-free and allocation-free, can be called from any thread. */
+	virtual void armHeartbeat(HeartbeatHandle const handle) noexcept = 0;
+	/** Disarms the heartbeat. Lock-free and allocation-free, can be called from any thread. */
+	virtual void disarmHeartbeat(HeartbeatHandle const handle) noexcept = 0;
+
 	// Deleted compiler auto-generated methods
 	WatchDog(WatchDog&&) = delete;
 	WatchDog(WatchDog const&) = delete;
@@ -0,0 +1,103 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file dispatchTable.hpp
+* @author Christophe Calmejane
+* @brief Densely indexed message dispatch table.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace la
+{
+namespace avdecc
+{
+/** Number of possible values of the 4 bits message_type field of ADP, AECP and ACMP messages (see Clause 6.2.1.5, 8.2.1.5 and 9.2.1.1.5) */
+static constexpr auto MessageTypeDispatchSize = std::size_t{ 16u };
+/** Number of AEM command types currently defined (highest is GET_STREAM_BACKUP) */
+static constexpr auto AemCommandTypeDispatchSize = std::size_t{ 0x004b };
+/** Number of MVU command types currently defined (highest is GET_MILAN_INFO) */
+static constexpr auto MvuCommandTypeDispatchSize = std::size_t{ 0x0001 };
+
+template<typename KeyType, std::size_t Size, typename Signature>
+class DispatchTable;
+
+/**
+* @brief Jump table of handlers indexed by a small integral key (message type, command type).
+* @details Handlers are plain function pointers (capture-less lambdas convert to them) stored in an array directly indexed by the key,
+*          so a lookup is a bound check followed by a direct call, without hashing nor std::function indirection.
+*          Construction is constexpr, a duplicate or out of range key being detected at compile time when the table is built in a constant expression.
+*/
+template<typename KeyType, std::size_t Size, typename ReturnType, typename... Parameters>
+class DispatchTable<KeyType, Size, ReturnType(Parameters...)> final
+{
+public:
+	using Handler = ReturnType (*)(Parameters...);
+
+	struct Entry
+	{
+		KeyType key;
+		Handler handler;
+	};
+
+	constexpr DispatchTable(std::initializer_list<Entry> const entries)
+	{
+		for (auto const& entry : entries)
+		{
+			auto const index = static_cast<std::size_t>(entry.key);
+			if (index >= Size)
+			{
+				throw std::out_of_range("DispatchTable key out of range");
+			}
+			if (_handlers[index] != nullptr)
+			{
+				throw std::invalid_argument("DispatchTable duplicate key");
+			}
+			_handlers[index] = entry.handler;
+		}
+	}
+
+	/** Returns the handler for the specified key, or nullptr if there is none. */
+	constexpr Handler get(KeyType const key) const noexcept
+	{
+		auto const index = static_cast<std::size_t>(key);
+		if (index < Size)
+		{
+			return _handlers[index];
+		}
+		return nullptr;
+	}
+
+	static constexpr std::size_t size() noexcept
+	{
+		return Size;
+	}
+
+private:
+	std::array<Handler, Size> _handlers{};
+};
+
+} // namespace avdecc
+} // namespace la
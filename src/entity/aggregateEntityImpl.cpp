@@ -1066,6 +1066,22 @@ void AggregateEntityImpl::onRemoteEntityUpdated(protocol::ProtocolInterface* con
 	}
 }
 
+void AggregateEntityImpl::onRemoteEntitiesUpdated(protocol::ProtocolInterface* const pi, protocol::ProtocolInterface::EntityReferences const& entities) noexcept
+{
+	if (_controllerCapabilityDelegate != nullptr)
+	{
+		_controllerCapabilityDelegate->onRemoteEntitiesUpdated(pi, entities);
+	}
+	if (_listenerCapabilityDelegate != nullptr)
+	{
+		_listenerCapabilityDelegate->onRemoteEntitiesUpdated(pi, entities);
+	}
+	if (_talkerCapabilityDelegate != nullptr)
+	{
+		_talkerCapabilityDelegate->onRemoteEntitiesUpdated(pi, entities);
+	}
+}
+
 /* **** AECP notifications **** */
 void AggregateEntityImpl::onAecpAemUnsolicitedResponse(protocol::ProtocolInterface* const pi, protocol::AemAecpdu const& aecpdu) noexcept
 {
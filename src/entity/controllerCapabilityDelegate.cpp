@@ -27,10 +27,13 @@
 #include "controllerCapabilityDelegate.hpp"
 #include "protocol/protocolAemPayloads.hpp"
 #include "protocol/protocolMvuPayloads.hpp"
+#include "dispatchTable.hpp"
 
+#include <array>
 #include <exception>
 #include <chrono>
 #include <thread>
+#include <vector>
 
 namespace la
 {
@@ -51,6 +54,34 @@ static model::AsPath const s_emptyAsPath{}; // Empty AsPath used by timeout call
 static model::AvdeccFixedString const s_emptyAvdeccFixedString{}; // Empty AvdeccFixedString used by timeout callback (needs a ref to a std::string)
 static model::MilanInfo const s_emptyMilanInfo{}; // Empty MilanInfo used by timeout callback (need a ref to a MilanInfo)
 
+/* ************************************************************************** */
+/* Commands priority                                                          */
+/* ************************************************************************** */
+/** Commands only reading the entity model or its state (enumeration and polling) are queued behind the ones changing it */
+static protocol::ProtocolInterface::AecpCommandPriority getAemCommandPriority(protocol::AemCommandType const commandType) noexcept
+{
+	using Priorities = std::array<protocol::ProtocolInterface::AecpCommandPriority, AemCommandTypeDispatchSize>;
+	// Table directly indexed by the command type, built once (the AemCommandType constants are not constexpr)
+	static auto const s_priorities = []()
+	{
+		auto priorities = Priorities{};
+		priorities.fill(protocol::ProtocolInterface::AecpCommandPriority::Interactive);
+		for (auto const commandType : { protocol::AemCommandType::EntityAvailable, protocol::AemCommandType::ControllerAvailable, protocol::AemCommandType::ReadDescriptor, protocol::AemCommandType::GetConfiguration, protocol::AemCommandType::GetStreamFormat, protocol::AemCommandType::GetStreamInfo, protocol::AemCommandType::GetName, protocol::AemCommandType::GetAssociationID, protocol::AemCommandType::GetSamplingRate, protocol::AemCommandType::GetClockSource, protocol::AemCommandType::GetControl, protocol::AemCommandType::GetSignalSelector, protocol::AemCommandType::GetMixer, protocol::AemCommandType::GetMatrix, protocol::AemCommandType::RegisterUnsolicitedNotification, protocol::AemCommandType::GetAvbInfo, protocol::AemCommandType::GetAsPath, protocol::AemCommandType::GetCounters, protocol::AemCommandType::GetAudioMap, protocol::AemCommandType::GetMemoryObjectLength })
+		{
+			priorities[static_cast<std::size_t>(commandType.getValue())] = protocol::ProtocolInterface::AecpCommandPriority::Background;
+		}
+		return priorities;
+	}();
+
+	auto const index = static_cast<std::size_t>(commandType.getValue());
+	return index < s_priorities.size() ? s_priorities[index] : protocol::ProtocolInterface::AecpCommandPriority::Interactive;
+}
+
+static protocol::ProtocolInterface::AecpCommandPriority getMvuCommandPriority(protocol::MvuCommandType const commandType) noexcept
+{
+	return commandType == protocol::MvuCommandType::GetMilanInfo ? protocol::ProtocolInterface::AecpCommandPriority::Background : protocol::ProtocolInterface::AecpCommandPriority::Interactive;
+}
+
 /* ************************************************************************** */
 /* Exceptions                                                                 */
 /* ************************************************************************** */
@@ -1611,72 +1642,36 @@ void CapabilityDelegate::onRemoteEntityOffline(protocol::ProtocolInterface* cons
 
 void CapabilityDelegate::onRemoteEntityUpdated(protocol::ProtocolInterface* const pi, Entity const& entity) noexcept
 {
-	enum class Action
-	{
-		NotifyUpdate = 0,
-		ForwardOnline = 1,
-		ForwardOffline = 2,
-		ForwardOfflineOnline = 3,
-	};
-
-	auto const entityID = entity.getEntityID();
-	auto action = Action::NotifyUpdate;
+	auto action = UpdateAction::NotifyUpdate;
 	{
 		// Lock ProtocolInterface
 		std::lock_guard<decltype(*pi)> const lg(*pi);
 
-		auto discoveredEntityIt = _discoveredEntities.find(entityID);
-		if (AVDECC_ASSERT_WITH_RET(discoveredEntityIt != _discoveredEntities.end(), "CapabilityDelegate::onRemoteEntityUpdated: Entity not found"))
-		{
-			auto& discoveredEntity = discoveredEntityIt->second;
+		action = updateDiscoveredEntity(entity);
+	}
 
-			// Entity still has its "main" interface index, we can proceed with the update
-			if (entity.hasInterfaceIndex(discoveredEntity.mainInterfaceIndex))
-			{
-				discoveredEntity.entity = entity;
-			}
-			else
-			{
-				if (AVDECC_ASSERT_WITH_RET(!entity.getInterfacesInformation().empty(), "CapabilityDelegate::onRemoteEntityUpdated called but entity has no valid AvbInterface"))
-				{
-					LOG_CONTROLLER_ENTITY_INFO(entityID, "Entity 'main' (first discovered) AvbInterface timed out, forcing it offline/online");
-					// Fallback to EntityOffline then EntityOnline
-					action = Action::ForwardOfflineOnline;
-				}
-				else
-				{
-					LOG_CONTROLLER_ENTITY_INFO(entityID, "Entity 'main' (first discovered) AvbInterface timed out but no other interface (should not happen), forcing it offline");
-					// Fallback to EntityOffline
-					action = Action::ForwardOffline;
-				}
-			}
-		}
-		else
+	// To everything else outside the lock
+	dispatchEntityUpdate(pi, action, entity);
+}
+
+void CapabilityDelegate::onRemoteEntitiesUpdated(protocol::ProtocolInterface* const pi, protocol::ProtocolInterface::EntityReferences const& entities) noexcept
+{
+	auto actions = std::vector<UpdateAction>{};
+	actions.reserve(entities.size());
+	{
+		// Lock ProtocolInterface only once for the whole batch
+		std::lock_guard<decltype(*pi)> const lg(*pi);
+
+		for (auto const& entity : entities)
 		{
-			// Fallback to EntityOnline
-			action = Action::ForwardOnline;
+			actions.push_back(updateDiscoveredEntity(entity));
 		}
 	}
 
 	// To everything else outside the lock
-	switch (action)
+	for (auto index = size_t{ 0u }; index < entities.size(); ++index)
 	{
-		case Action::NotifyUpdate:
-			utils::invokeProtectedMethod(&controller::Delegate::onEntityUpdate, _controllerDelegate, &_controllerInterface, entityID, entity);
-			break;
-		case Action::ForwardOnline:
-			onRemoteEntityOnline(pi, entity);
-			break;
-		case Action::ForwardOffline:
-			onRemoteEntityOffline(pi, entityID);
-			break;
-		case Action::ForwardOfflineOnline:
-			onRemoteEntityOffline(pi, entityID);
-			onRemoteEntityOnline(pi, entity);
-			break;
-		default:
-			AVDECC_ASSERT(false, "Unhandled Action");
-			break;
+		dispatchEntityUpdate(pi, actions[index], entities[index]);
 	}
 }
 
@@ -1778,6 +1773,61 @@ void CapabilityDelegate::onAecpResponseTime(protocol::ProtocolInterface* const /
 /* ************************************************************************** */
 /* Internal methods                                                           */
 /* ************************************************************************** */
+CapabilityDelegate::UpdateAction CapabilityDelegate::updateDiscoveredEntity(Entity const& entity) noexcept
+{
+	auto const entityID = entity.getEntityID();
+	auto discoveredEntityIt = _discoveredEntities.find(entityID);
+	if (AVDECC_ASSERT_WITH_RET(discoveredEntityIt != _discoveredEntities.end(), "CapabilityDelegate::onRemoteEntityUpdated: Entity not found"))
+	{
+		auto& discoveredEntity = discoveredEntityIt->second;
+
+		// Entity still has its "main" interface index, we can proceed with the update
+		if (entity.hasInterfaceIndex(discoveredEntity.mainInterfaceIndex))
+		{
+			discoveredEntity.entity = entity;
+			return UpdateAction::NotifyUpdate;
+		}
+
+		if (AVDECC_ASSERT_WITH_RET(!entity.getInterfacesInformation().empty(), "CapabilityDelegate::onRemoteEntityUpdated called but entity has no valid AvbInterface"))
+		{
+			LOG_CONTROLLER_ENTITY_INFO(entityID, "Entity 'main' (first discovered) AvbInterface timed out, forcing it offline/online");
+			// Fallback to EntityOffline then EntityOnline
+			return UpdateAction::ForwardOfflineOnline;
+		}
+
+		LOG_CONTROLLER_ENTITY_INFO(entityID, "Entity 'main' (first discovered) AvbInterface timed out but no other interface (should not happen), forcing it offline");
+		// Fallback to EntityOffline
+		return UpdateAction::ForwardOffline;
+	}
+
+	// Fallback to EntityOnline
+	return UpdateAction::ForwardOnline;
+}
+
+void CapabilityDelegate::dispatchEntityUpdate(protocol::ProtocolInterface* const pi, UpdateAction const action, Entity const& entity) noexcept
+{
+	auto const entityID = entity.getEntityID();
+	switch (action)
+	{
+		case UpdateAction::NotifyUpdate:
+			utils::invokeProtectedMethod(&controller::Delegate::onEntityUpdate, _controllerDelegate, &_controllerInterface, entityID, entity);
+			break;
+		case UpdateAction::ForwardOnline:
+			onRemoteEntityOnline(pi, entity);
+			break;
+		case UpdateAction::ForwardOffline:
+			onRemoteEntityOffline(pi, entityID);
+			break;
+		case UpdateAction::ForwardOfflineOnline:
+			onRemoteEntityOffline(pi, entityID);
+			onRemoteEntityOnline(pi, entity);
+			break;
+		default:
+			AVDECC_ASSERT(false, "Unhandled Action");
+			break;
+	}
+}
+
 model::AvbInterfaceIndex CapabilityDelegate::getMainInterfaceIndex(Entity const& entity) const noexcept
 {
 	// Get the "main" avb interface index (ie. the first in the list)
@@ -1817,7 +1867,7 @@ void CapabilityDelegate::sendAemAecpCommand(UniqueIdentifier const targetEntityI
 		return;
 	}
 
-	LocalEntityImpl<>::sendAemAecpCommand(_protocolInterface, _controllerID, targetEntityID, targetMacAddress, commandType, payload, payloadLength,
+	LocalEntityImpl<>::sendAemAecpCommand(_protocolInterface, _controllerID, targetEntityID, targetMacAddress, commandType, payload, payloadLength, getAemCommandPriority(commandType),
 		[this, onErrorCallback, answerCallback](protocol::Aecpdu const* const response, LocalEntity::AemCommandStatus const status)
 		{
 			if (!!status)
@@ -1857,7 +1907,7 @@ void CapabilityDelegate::sendAaAecpCommand(UniqueIdentifier const targetEntityID
 		return;
 	}
 
-	LocalEntityImpl<>::sendAaAecpCommand(_protocolInterface, _controllerID, targetEntityID, targetMacAddress, tlvs,
+	LocalEntityImpl<>::sendAaAecpCommand(_protocolInterface, _controllerID, targetEntityID, targetMacAddress, tlvs, protocol::ProtocolInterface::AecpCommandPriority::Interactive,
 		[this, onErrorCallback, answerCallback](protocol::Aecpdu const* const response, LocalEntity::AaCommandStatus const status)
 		{
 			if (!!status)
@@ -1897,7 +1947,7 @@ void CapabilityDelegate::sendMvuAecpCommand(UniqueIdentifier const targetEntityI
 		return;
 	}
 
-	LocalEntityImpl<>::sendMvuAecpCommand(_protocolInterface, _controllerID, targetEntityID, targetMacAddress, commandType, payload, payloadLength,
+	LocalEntityImpl<>::sendMvuAecpCommand(_protocolInterface, _controllerID, targetEntityID, targetMacAddress, commandType, payload, payloadLength, getMvuCommandPriority(commandType),
 		[this, onErrorCallback, answerCallback](protocol::Aecpdu const* const response, LocalEntity::MvuCommandStatus const status)
 		{
 			if (!!status)
@@ -1932,7 +1982,7 @@ void CapabilityDelegate::processAemAecpResponse(protocol::Aecpdu const* const re
 	auto const& aem = static_cast<protocol::AemAecpdu const&>(*response);
 	auto const status = static_cast<LocalEntity::AemCommandStatus>(aem.getStatus().getValue()); // We have to convert protocol status to our extended status
 
-	static std::unordered_map<protocol::AemCommandType::value_type, std::function<void(controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::AemCommandStatus const status, protocol::AemAecpdu const& aem, LocalEntityImpl<>::AnswerCallback const& answerCallback)>> s_Dispatch
+	static auto const s_Dispatch = DispatchTable<protocol::AemCommandType::value_type, AemCommandTypeDispatchSize, void(controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::AemCommandStatus const status, protocol::AemAecpdu const& aem, LocalEntityImpl<>::AnswerCallback const& answerCallback)>
 	{
 		// Acquire Entity
 		{ protocol::AemCommandType::AcquireEntity.getValue(), [](controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::AemCommandStatus const status, protocol::AemAecpdu const& aem, LocalEntityImpl<>::AnswerCallback const& answerCallback)
@@ -3437,8 +3487,8 @@ void CapabilityDelegate::processAemAecpResponse(protocol::Aecpdu const* const re
 		// Get Stream Backup
 	};
 
-	auto const& it = s_Dispatch.find(aem.getCommandType().getValue());
-	if (it == s_Dispatch.end())
+	auto const handler = s_Dispatch.get(aem.getCommandType().getValue());
+	if (handler == nullptr)
 	{
 		// If this is an unsolicited notification, simply log we do not handle the message
 		if (aem.getUnsolicited())
@@ -3474,7 +3524,7 @@ void CapabilityDelegate::processAemAecpResponse(protocol::Aecpdu const* const re
 
 		try
 		{
-			it->second(_controllerDelegate, &_controllerInterface, status, aem, answerCallback);
+			handler(_controllerDelegate, &_controllerInterface, status, aem, answerCallback);
 		}
 		catch (protocol::aemPayload::IncorrectPayloadSizeException const& e)
 		{
@@ -3515,7 +3565,7 @@ void CapabilityDelegate::processMvuAecpResponse(protocol::Aecpdu const* const re
 	auto const& mvu = static_cast<protocol::MvuAecpdu const&>(*response);
 	auto const status = static_cast<LocalEntity::MvuCommandStatus>(mvu.getStatus().getValue()); // We have to convert protocol status to our extended status
 
-	static std::unordered_map<protocol::MvuCommandType::value_type, std::function<void(controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::MvuCommandStatus const status, protocol::MvuAecpdu const& mvu, LocalEntityImpl<>::AnswerCallback const& answerCallback)>> s_Dispatch{
+	static auto const s_Dispatch = DispatchTable<protocol::MvuCommandType::value_type, MvuCommandTypeDispatchSize, void(controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::MvuCommandStatus const status, protocol::MvuAecpdu const& mvu, LocalEntityImpl<>::AnswerCallback const& answerCallback)>{
 		// Get Milan Info
 		{ protocol::MvuCommandType::GetMilanInfo.getValue(),
 			[](controller::Delegate* const /*delegate*/, Interface const* const controllerInterface, LocalEntity::MvuCommandStatus const status, protocol::MvuAecpdu const& mvu, LocalEntityImpl<>::AnswerCallback const& answerCallback)
@@ -3534,8 +3584,8 @@ void CapabilityDelegate::processMvuAecpResponse(protocol::Aecpdu const* const re
 			} },
 	};
 
-	auto const& it = s_Dispatch.find(mvu.getCommandType().getValue());
-	if (it == s_Dispatch.end())
+	auto const handler = s_Dispatch.get(mvu.getCommandType().getValue());
+	if (handler == nullptr)
 	{
 		// It's an expected response, this is an internal error since we sent a command and didn't implement the code to handle the response
 		LOG_CONTROLLER_ENTITY_ERROR(mvu.getTargetEntityID(), "Failed to process MVU response: Unhandled command type {} ({})", std::string(mvu.getCommandType()), utils::toHexString(mvu.getCommandType().getValue()));
@@ -3545,7 +3595,7 @@ void CapabilityDelegate::processMvuAecpResponse(protocol::Aecpdu const* const re
 	{
 		try
 		{
-			it->second(_controllerDelegate, &_controllerInterface, status, mvu, answerCallback);
+			handler(_controllerDelegate, &_controllerInterface, status, mvu, answerCallback);
 		}
 		catch ([[maybe_unused]] protocol::mvuPayload::IncorrectPayloadSizeException const& e)
 		{
@@ -3573,7 +3623,7 @@ void CapabilityDelegate::processAcmpResponse(protocol::Acmpdu const* const respo
 	auto const& acmp = static_cast<protocol::Acmpdu const&>(*response);
 	auto const status = static_cast<LocalEntity::ControlStatus>(acmp.getStatus().getValue()); // We have to convert protocol status to our extended status
 
-	static std::unordered_map<protocol::AcmpMessageType::value_type, std::function<void(controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::ControlStatus const status, protocol::Acmpdu const& acmp, LocalEntityImpl<>::AnswerCallback const& answerCallback, bool const sniffed)>> s_Dispatch{
+	static auto const s_Dispatch = DispatchTable<protocol::AcmpMessageType::value_type, MessageTypeDispatchSize, void(controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::ControlStatus const status, protocol::Acmpdu const& acmp, LocalEntityImpl<>::AnswerCallback const& answerCallback, bool const sniffed)>{
 		// Connect TX response
 		{ protocol::AcmpMessageType::ConnectTxResponse.getValue(),
 			[](controller::Delegate* const delegate, Interface const* const controllerInterface, LocalEntity::ControlStatus const status, protocol::Acmpdu const& acmp, LocalEntityImpl<>::AnswerCallback const& /*answerCallback*/, bool const sniffed)
@@ -3683,8 +3733,8 @@ void CapabilityDelegate::processAcmpResponse(protocol::Acmpdu const* const respo
 			} },
 	};
 
-	auto const& it = s_Dispatch.find(acmp.getMessageType().getValue());
-	if (it == s_Dispatch.end())
+	auto const handler = s_Dispatch.get(acmp.getMessageType().getValue());
+	if (handler == nullptr)
 	{
 		// If this is a sniffed message, simply log we do not handle the message
 		if (sniffed)
@@ -3702,7 +3752,7 @@ void CapabilityDelegate::processAcmpResponse(protocol::Acmpdu const* const respo
 	{
 		try
 		{
-			it->second(_controllerDelegate, &_controllerInterface, status, acmp, answerCallback, sniffed);
+			handler(_controllerDelegate, &_controllerInterface, status, acmp, answerCallback, sniffed);
 		}
 		catch ([[maybe_unused]] std::exception const& e) // Mainly unpacking errors
 		{
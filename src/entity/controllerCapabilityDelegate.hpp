@@ -200,6 +200,7 @@ private:
 	virtual void onRemoteEntityOnline(protocol::ProtocolInterface* const pi, Entity const& entity) noexcept override;
 	virtual void onRemoteEntityOffline(protocol::ProtocolInterface* const pi, UniqueIdentifier const entityID) noexcept override;
 	virtual void onRemoteEntityUpdated(protocol::ProtocolInterface* const pi, Entity const& entity) noexcept override;
+	virtual void onRemoteEntitiesUpdated(protocol::ProtocolInterface* const pi, protocol::ProtocolInterface::EntityReferences const& entities) noexcept override;
 	/* **** AECP notifications **** */
 	virtual bool onUnhandledAecpCommand(protocol::ProtocolInterface* const pi, protocol::Aecpdu const& aecpdu) noexcept override;
 	virtual void onAecpAemUnsolicitedResponse(protocol::ProtocolInterface* const pi, protocol::AemAecpdu const& aecpdu) noexcept override;
@@ -211,7 +212,16 @@ private:
 	/* ************************************************************************** */
 	/* Internal methods                                                           */
 	/* ************************************************************************** */
+	enum class UpdateAction
+	{
+		NotifyUpdate = 0,
+		ForwardOnline = 1,
+		ForwardOffline = 2,
+		ForwardOfflineOnline = 3,
+	};
 	model::AvbInterfaceIndex getMainInterfaceIndex(Entity const& entity) const noexcept;
+	UpdateAction updateDiscoveredEntity(Entity const& entity) noexcept; // Must be called with the ProtocolInterface locked
+	void dispatchEntityUpdate(protocol::ProtocolInterface* const pi, UpdateAction const action, Entity const& entity) noexcept; // Must be called without the ProtocolInterface locked
 	bool isResponseForController(protocol::AcmpMessageType const messageType) const noexcept;
 	void sendAemAecpCommand(UniqueIdentifier const targetEntityID, protocol::AemCommandType const commandType, void const* const payload, size_t const payloadLength, LocalEntityImpl<>::OnAemAECPErrorCallback const& onErrorCallback, LocalEntityImpl<>::AnswerCallback const& answerCallback) const noexcept;
 	void sendAaAecpCommand(UniqueIdentifier const targetEntityID, addressAccess::Tlvs const& tlvs, LocalEntityImpl<>::OnAaAECPErrorCallback const& onErrorCallback, LocalEntityImpl<>::AnswerCallback const& answerCallback) const noexcept;
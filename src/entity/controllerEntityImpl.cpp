@@ -643,6 +643,11 @@ void ControllerEntityImpl::onRemoteEntityUpdated(protocol::ProtocolInterface* co
 	_controllerCapabilityDelegate->onRemoteEntityUpdated(pi, entity);
 }
 
+void ControllerEntityImpl::onRemoteEntitiesUpdated(protocol::ProtocolInterface* const pi, protocol::ProtocolInterface::EntityReferences const& entities) noexcept
+{
+	_controllerCapabilityDelegate->onRemoteEntitiesUpdated(pi, entities);
+}
+
 /* **** AECP notifications **** */
 void ControllerEntityImpl::onAecpAemUnsolicitedResponse(protocol::ProtocolInterface* const pi, protocol::AemAecpdu const& aecpdu) noexcept
 {
@@ -0,0 +1,1317 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file entityFarm.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/entityFarm.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolMvuAecpdu.hpp"
+#include "la/avdecc/internals/protocolAcmpdu.hpp"
+#include "la/avdecc/internals/protocolAdpdu.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "protocol/protocolAemPayloads.hpp"
+#include "logHelper.hpp"
+#if defined(HAVE_PROTOCOL_INTERFACE_VIRTUAL)
+#	include "protocolInterface/protocolInterface_virtual.hpp"
+#endif // HAVE_PROTOCOL_INTERFACE_VIRTUAL
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace la
+{
+namespace avdecc
+{
+namespace entity
+{
+#if defined(HAVE_PROTOCOL_INTERFACE_VIRTUAL)
+class EntityFarmImpl final : public EntityFarm, private protocol::ProtocolInterface::Observer, private protocol::ProtocolInterface::VendorUniqueDelegate
+{
+public:
+	static constexpr auto MinimumAdvertisePeriod = std::chrono::milliseconds{ 1000u };
+	static constexpr auto NotificationsTick = std::chrono::milliseconds{ 10u };
+	static constexpr auto MaximumMappingsPerMap = (protocol::AemAecpdu::MaximumSendPayloadBufferLength - protocol::aemPayload::AecpAemGetAudioMapResponsePayloadMinSize) / 8u;
+	static constexpr auto EntityIDPayloadOffset = size_t{ 8u }; // ENTITY descriptor: entity_id follows the configuration/reserved/type/index header of the READ_DESCRIPTOR response
+
+	/** Constructor */
+	EntityFarmImpl(std::string const& networkInterfaceName, Entity::CommonInformation const& commonInformation, model::EntityTree const& entityTree, Configuration const& configuration)
+		: _commonInformation{ commonInformation }
+		, _configuration{ configuration }
+		, _entities(configuration.numberOfEntities)
+	{
+		if (_configuration.numberOfEntities == 0u)
+		{
+			throw std::invalid_argument("EntityFarm requires at least one entity");
+		}
+		auto const configIt = entityTree.configurationTrees.find(entityTree.dynamicModel.currentConfiguration);
+		if (configIt == entityTree.configurationTrees.end())
+		{
+			throw std::invalid_argument("EntityFarm template EntityTree does not contain its current configuration");
+		}
+
+		// Serialize all the responses once, shared by all the entities
+		buildResponses(entityTree);
+
+		// Keep what is needed for ACMP and ADP
+		for (auto const& [streamIndex, streamNode] : configIt->second.streamInputModels)
+		{
+			_streamInputConnections[streamIndex] = streamNode.dynamicModel.connectionInfo;
+		}
+		for (auto const& [streamIndex, streamNode] : configIt->second.streamOutputModels)
+		{
+			(void)streamNode;
+			_streamOutputs.push_back(streamIndex);
+		}
+		if (auto const avbIt = configIt->second.avbInterfaceModels.find(model::AvbInterfaceIndex{ 0u }); avbIt != configIt->second.avbInterfaceModels.end())
+		{
+			_avbInterfaceIndex = avbIt->first;
+			_gptpGrandmasterID = avbIt->second.dynamicModel.gptpGrandmasterID;
+			_gptpDomainNumber = avbIt->second.dynamicModel.gptpDomainNumber;
+		}
+
+		// Create the ProtocolInterface the entities are simulated on
+		_protocolInterface = std::unique_ptr<protocol::ProtocolInterfaceVirtual>(protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkInterfaceName, _configuration.macAddress));
+		_protocolInterface->registerObserver(this);
+		_protocolInterface->registerVendorUniqueDelegate(protocol::MvuAecpdu::ProtocolID, this);
+
+		// Start the thread sending the responses, advertisements and notifications
+		_thread = std::thread(
+			[this]
+			{
+				utils::setCurrentThreadName("avdecc::EntityFarm");
+				run();
+			});
+	}
+
+	/** Destructor */
+	virtual ~EntityFarmImpl() noexcept override
+	{
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_shouldTerminate = true;
+		}
+		_condition.notify_all();
+		if (_thread.joinable())
+		{
+			_thread.join();
+		}
+
+		// Entities are leaving
+		for (auto index = std::size_t{ 0u }; index < _entities.size(); ++index)
+		{
+			_protocolInterface->sendAdpMessage(makeEntityDepartingMessage(index));
+		}
+
+		_protocolInterface->unregisterVendorUniqueDelegate(protocol::MvuAecpdu::ProtocolID);
+		_protocolInterface->unregisterObserver(this);
+		_protocolInterface->shutdown();
+	}
+
+	// Deleted compiler auto-generated methods
+	EntityFarmImpl(EntityFarmImpl&&) = delete;
+	EntityFarmImpl(EntityFarmImpl const&) = delete;
+	EntityFarmImpl& operator=(EntityFarmImpl const&) = delete;
+	EntityFarmImpl& operator=(EntityFarmImpl&&) = delete;
+
+private:
+	/** A pre-serialized AEM response */
+	struct Response
+	{
+		std::vector<std::uint8_t> payload{};
+		bool hasEntityID{ false }; /**< The payload contains the EntityID of the entity at EntityIDPayloadOffset, which must be replaced by the targeted one */
+	};
+
+	/** A controller registered for unsolicited notifications */
+	struct RegisteredController
+	{
+		UniqueIdentifier controllerID{};
+		networkInterface::MacAddress macAddress{};
+	};
+
+	/** State of a simulated entity */
+	struct EntityState
+	{
+		std::vector<RegisteredController> controllers{}; /**< Protected by _lock */
+		protocol::AecpSequenceID unsolicitedSequenceID{ 0u }; /**< Only used by the farm thread */
+		std::uint32_t availableIndex{ 0u }; /**< Only used by the farm thread */
+		model::DescriptorCounter notificationCounter{ 0u }; /**< Only used by the farm thread */
+	};
+
+	using ResponseKey = std::string;
+
+	/* ************************************************************ */
+	/* Responses serialization                                      */
+	/* ************************************************************ */
+	template<size_t CommandSize, size_t ResponseSize>
+	void addResponse(protocol::AemCommandType const commandType, Serializer<CommandSize> const& command, Serializer<ResponseSize> const& response, bool const hasEntityID = false)
+	{
+		auto const* const responseData = response.data();
+		_responses[makeKey(commandType, command.data(), command.size())] = Response{ std::vector<std::uint8_t>(responseData, responseData + response.size()), hasEntityID };
+	}
+
+	template<size_t ResponseSize>
+	void addResponse(protocol::AemCommandType const commandType, Serializer<ResponseSize> const& response)
+	{
+		auto const* const responseData = response.data();
+		_responses[makeKey(commandType, nullptr, 0u)] = Response{ std::vector<std::uint8_t>(responseData, responseData + response.size()), false };
+	}
+
+	template<typename FlagType, typename CountersType>
+	void addCountersResponse(model::DescriptorType const descriptorType, model::DescriptorIndex const descriptorIndex, CountersType const& counters)
+	{
+		auto validCounters = utils::EnumBitfield<FlagType>{};
+		auto descriptorCounters = model::DescriptorCounters{};
+		for (auto const& [flag, value] : counters)
+		{
+			validCounters.set(flag);
+			descriptorCounters[validCounters.getPosition(flag)] = value;
+		}
+		addResponse(protocol::AemCommandType::GetCounters, protocol::aemPayload::serializeGetCountersCommand(descriptorType, descriptorIndex), protocol::aemPayload::serializeGetCountersResponse(descriptorType, descriptorIndex, validCounters.value(), descriptorCounters));
+	}
+
+	void addObjectNameResponse(model::ConfigurationIndex const configurationIndex, model::DescriptorType const descriptorType, model::DescriptorIndex const descriptorIndex, model::AvdeccFixedString const& objectName)
+	{
+		addResponse(protocol::AemCommandType::GetName, protocol::aemPayload::serializeGetNameCommand(descriptorType, descriptorIndex, 0u, configurationIndex), protocol::aemPayload::serializeGetNameResponse(descriptorType, descriptorIndex, 0u, configurationIndex, objectName));
+	}
+
+	/** Runs the specified serialization, a failure only removing the corresponding response (answered NOT_IMPLEMENTED) */
+	template<typename Builder>
+	void tryAddResponse(char const* const what, model::DescriptorIndex const descriptorIndex, Builder&& builder) noexcept
+	{
+		try
+		{
+			builder();
+		}
+		catch (la::avdecc::Exception const& e)
+		{
+			LOG_GENERIC_WARN(std::string("EntityFarm: Failed to serialize ") + what + " " + std::to_string(descriptorIndex) + ": " + e.what());
+		}
+		catch (std::exception const& e)
+		{
+			LOG_GENERIC_WARN(std::string("EntityFarm: Failed to serialize ") + what + " " + std::to_string(descriptorIndex) + ": " + e.what());
+		}
+	}
+
+	void buildResponses(model::EntityTree const& entityTree)
+	{
+		namespace aem = protocol::aemPayload;
+		auto const currentConfiguration = entityTree.dynamicModel.currentConfiguration;
+
+		// Entity
+		tryAddResponse("ENTITY descriptor", 0u,
+			[&]
+			{
+				auto descriptor = model::EntityDescriptor{};
+				descriptor.entityID = _configuration.baseEntityID;
+				descriptor.entityModelID = _commonInformation.entityModelID;
+				descriptor.entityCapabilities = _commonInformation.entityCapabilities;
+				descriptor.talkerStreamSources = _commonInformation.talkerStreamSources;
+				descriptor.talkerCapabilities = _commonInformation.talkerCapabilities;
+				descriptor.listenerStreamSinks = _commonInformation.listenerStreamSinks;
+				descriptor.listenerCapabilities = _commonInformation.listenerCapabilities;
+				descriptor.controllerCapabilities = _commonInformation.controllerCapabilities;
+				descriptor.associationID = _commonInformation.associationID ? *_commonInformation.associationID : UniqueIdentifier{};
+				descriptor.entityName = entityTree.dynamicModel.entityName;
+				descriptor.vendorNameString = entityTree.staticModel.vendorNameString;
+				descriptor.modelNameString = entityTree.staticModel.modelNameString;
+				descriptor.firmwareVersion = entityTree.dynamicModel.firmwareVersion;
+				descriptor.groupName = entityTree.dynamicModel.groupName;
+				descriptor.serialNumber = entityTree.dynamicModel.serialNumber;
+				descriptor.configurationsCount = static_cast<std::uint16_t>(entityTree.configurationTrees.size());
+				descriptor.currentConfiguration = currentConfiguration;
+				addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(0u, model::DescriptorType::Entity, 0u), aem::serializeReadEntityDescriptorResponse(descriptor), true);
+				addResponse(protocol::AemCommandType::GetConfiguration, aem::serializeGetConfigurationResponse(currentConfiguration));
+				addResponse(protocol::AemCommandType::GetName, aem::serializeGetNameCommand(model::DescriptorType::Entity, 0u, 0u, 0u), aem::serializeGetNameResponse(model::DescriptorType::Entity, 0u, 0u, 0u, descriptor.entityName));
+				addResponse(protocol::AemCommandType::GetName, aem::serializeGetNameCommand(model::DescriptorType::Entity, 0u, 1u, 0u), aem::serializeGetNameResponse(model::DescriptorType::Entity, 0u, 1u, 0u, descriptor.groupName));
+				if (entityTree.dynamicModel.counters)
+				{
+					addCountersResponse<EntityCounterValidFlag>(model::DescriptorType::Entity, 0u, *entityTree.dynamicModel.counters);
+				}
+			});
+
+		for (auto const& [cfgIndex, configTree] : entityTree.configurationTrees)
+		{
+			// Dynamic information is only requested for the current configuration
+			auto const isCurrent = cfgIndex == currentConfiguration;
+			auto const configurationIndex = cfgIndex;
+
+			tryAddResponse("CONFIGURATION descriptor", configurationIndex,
+				[&]
+				{
+					auto descriptor = model::ConfigurationDescriptor{};
+					descriptor.objectName = configTree.dynamicModel.objectName;
+					descriptor.localizedDescription = configTree.staticModel.localizedDescription;
+					descriptor.descriptorCounts = configTree.staticModel.descriptorCounts;
+					addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(0u, model::DescriptorType::Configuration, configurationIndex), aem::serializeReadConfigurationDescriptorResponse(configurationIndex, descriptor));
+					addResponse(protocol::AemCommandType::GetName, aem::serializeGetNameCommand(model::DescriptorType::Configuration, configurationIndex, 0u, 0u), aem::serializeGetNameResponse(model::DescriptorType::Configuration, configurationIndex, 0u, 0u, descriptor.objectName));
+				});
+
+			for (auto const& [index, node] : configTree.audioUnitModels)
+			{
+				tryAddResponse("AUDIO_UNIT descriptor", index,
+					[&, audioUnitIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::AudioUnitDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.clockDomainIndex = s.clockDomainIndex;
+						descriptor.numberOfStreamInputPorts = s.numberOfStreamInputPorts;
+						descriptor.baseStreamInputPort = s.baseStreamInputPort;
+						descriptor.numberOfStreamOutputPorts = s.numberOfStreamOutputPorts;
+						descriptor.baseStreamOutputPort = s.baseStreamOutputPort;
+						descriptor.numberOfExternalInputPorts = s.numberOfExternalInputPorts;
+						descriptor.baseExternalInputPort = s.baseExternalInputPort;
+						descriptor.numberOfExternalOutputPorts = s.numberOfExternalOutputPorts;
+						descriptor.baseExternalOutputPort = s.baseExternalOutputPort;
+						descriptor.numberOfInternalInputPorts = s.numberOfInternalInputPorts;
+						descriptor.baseInternalInputPort = s.baseInternalInputPort;
+						descriptor.numberOfInternalOutputPorts = s.numberOfInternalOutputPorts;
+						descriptor.baseInternalOutputPort = s.baseInternalOutputPort;
+						descriptor.numberOfControls = s.numberOfControls;
+						descriptor.baseControl = s.baseControl;
+						descriptor.numberOfSignalSelectors = s.numberOfSignalSelectors;
+						descriptor.baseSignalSelector = s.baseSignalSelector;
+						descriptor.numberOfMixers = s.numberOfMixers;
+						descriptor.baseMixer = s.baseMixer;
+						descriptor.numberOfMatrices = s.numberOfMatrices;
+						descriptor.baseMatrix = s.baseMatrix;
+						descriptor.numberOfSplitters = s.numberOfSplitters;
+						descriptor.baseSplitter = s.baseSplitter;
+						descriptor.numberOfCombiners = s.numberOfCombiners;
+						descriptor.baseCombiner = s.baseCombiner;
+						descriptor.numberOfDemultiplexers = s.numberOfDemultiplexers;
+						descriptor.baseDemultiplexer = s.baseDemultiplexer;
+						descriptor.numberOfMultiplexers = s.numberOfMultiplexers;
+						descriptor.baseMultiplexer = s.baseMultiplexer;
+						descriptor.numberOfTranscoders = s.numberOfTranscoders;
+						descriptor.baseTranscoder = s.baseTranscoder;
+						descriptor.numberOfControlBlocks = s.numberOfControlBlocks;
+						descriptor.baseControlBlock = s.baseControlBlock;
+						descriptor.currentSamplingRate = d.currentSamplingRate;
+						descriptor.samplingRates = s.samplingRates;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::AudioUnit, audioUnitIndex), aem::serializeReadAudioUnitDescriptorResponse(configurationIndex, audioUnitIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::AudioUnit, audioUnitIndex, d.objectName);
+							addResponse(protocol::AemCommandType::GetSamplingRate, aem::serializeGetSamplingRateCommand(model::DescriptorType::AudioUnit, audioUnitIndex), aem::serializeGetSamplingRateResponse(model::DescriptorType::AudioUnit, audioUnitIndex, d.currentSamplingRate));
+						}
+					});
+			}
+
+			auto const addStream = [&](model::DescriptorType const descriptorType, model::StreamIndex const streamIndex, model::StreamNodeStaticModel const& s, model::StreamNodeDynamicModel const& d)
+			{
+				auto descriptor = model::StreamDescriptor{};
+				descriptor.objectName = d.objectName;
+				descriptor.localizedDescription = s.localizedDescription;
+				descriptor.clockDomainIndex = s.clockDomainIndex;
+				descriptor.streamFlags = s.streamFlags;
+				descriptor.currentFormat = d.streamFormat;
+				descriptor.backupTalkerEntityID_0 = s.backupTalkerEntityID_0;
+				descriptor.backupTalkerUniqueID_0 = s.backupTalkerUniqueID_0;
+				descriptor.backupTalkerEntityID_1 = s.backupTalkerEntityID_1;
+				descriptor.backupTalkerUniqueID_1 = s.backupTalkerUniqueID_1;
+				descriptor.backupTalkerEntityID_2 = s.backupTalkerEntityID_2;
+				descriptor.backupTalkerUniqueID_2 = s.backupTalkerUniqueID_2;
+				descriptor.backedupTalkerEntityID = s.backedupTalkerEntityID;
+				descriptor.backedupTalkerUnique = s.backedupTalkerUnique;
+				descriptor.avbInterfaceIndex = s.avbInterfaceIndex;
+				descriptor.bufferLength = s.bufferLength;
+				descriptor.formats = s.formats;
+#	ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+				descriptor.redundantStreams = s.redundantStreams;
+#	endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+				addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, descriptorType, streamIndex), aem::serializeReadStreamDescriptorResponse(configurationIndex, descriptorType, streamIndex, descriptor));
+				if (isCurrent)
+				{
+					addObjectNameResponse(configurationIndex, descriptorType, streamIndex, d.objectName);
+					addResponse(protocol::AemCommandType::GetStreamFormat, aem::serializeGetStreamFormatCommand(descriptorType, streamIndex), aem::serializeGetStreamFormatResponse(descriptorType, streamIndex, d.streamFormat));
+					addResponse(protocol::AemCommandType::GetStreamInfo, aem::serializeGetStreamInfoCommand(descriptorType, streamIndex), aem::serializeGetStreamInfoResponse(descriptorType, streamIndex, makeStreamInfo(d)));
+				}
+			};
+			for (auto const& [index, node] : configTree.streamInputModels)
+			{
+				tryAddResponse("STREAM_INPUT descriptor", index,
+					[&, streamIndex = index, &n = node]
+					{
+						addStream(model::DescriptorType::StreamInput, streamIndex, n.staticModel, n.dynamicModel);
+						if (isCurrent && n.dynamicModel.counters)
+						{
+							addCountersResponse<StreamInputCounterValidFlag>(model::DescriptorType::StreamInput, streamIndex, *n.dynamicModel.counters);
+						}
+					});
+			}
+			for (auto const& [index, node] : configTree.streamOutputModels)
+			{
+				tryAddResponse("STREAM_OUTPUT descriptor", index,
+					[&, streamIndex = index, &n = node]
+					{
+						addStream(model::DescriptorType::StreamOutput, streamIndex, n.staticModel, n.dynamicModel);
+						if (isCurrent && n.dynamicModel.counters)
+						{
+							addCountersResponse<StreamOutputCounterValidFlag>(model::DescriptorType::StreamOutput, streamIndex, *n.dynamicModel.counters);
+						}
+					});
+			}
+
+			for (auto const& [index, node] : configTree.avbInterfaceModels)
+			{
+				tryAddResponse("AVB_INTERFACE descriptor", index,
+					[&, avbInterfaceIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::AvbInterfaceDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.macAddress = s.macAddress;
+						descriptor.interfaceFlags = s.interfaceFlags;
+						descriptor.clockIdentity = s.clockIdentity;
+						descriptor.priority1 = s.priority1;
+						descriptor.clockClass = s.clockClass;
+						descriptor.offsetScaledLogVariance = s.offsetScaledLogVariance;
+						descriptor.clockAccuracy = s.clockAccuracy;
+						descriptor.priority2 = s.priority2;
+						descriptor.domainNumber = s.domainNumber;
+						descriptor.logSyncInterval = s.logSyncInterval;
+						descriptor.logAnnounceInterval = s.logAnnounceInterval;
+						descriptor.logPDelayInterval = s.logPDelayInterval;
+						descriptor.portNumber = s.portNumber;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::AvbInterface, avbInterfaceIndex), aem::serializeReadAvbInterfaceDescriptorResponse(configurationIndex, avbInterfaceIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::AvbInterface, avbInterfaceIndex, d.objectName);
+							if (d.avbInterfaceInfo)
+							{
+								auto const avbInfo = model::AvbInfo{ d.gptpGrandmasterID, d.avbInterfaceInfo->propagationDelay, d.gptpDomainNumber, d.avbInterfaceInfo->flags, d.avbInterfaceInfo->mappings };
+								addResponse(protocol::AemCommandType::GetAvbInfo, aem::serializeGetAvbInfoCommand(model::DescriptorType::AvbInterface, avbInterfaceIndex), aem::serializeGetAvbInfoResponse(model::DescriptorType::AvbInterface, avbInterfaceIndex, avbInfo));
+							}
+							if (d.asPath)
+							{
+								addResponse(protocol::AemCommandType::GetAsPath, aem::serializeGetAsPathCommand(avbInterfaceIndex), aem::serializeGetAsPathResponse(avbInterfaceIndex, *d.asPath));
+							}
+							if (d.counters)
+							{
+								addCountersResponse<AvbInterfaceCounterValidFlag>(model::DescriptorType::AvbInterface, avbInterfaceIndex, *d.counters);
+							}
+						}
+					});
+			}
+
+			for (auto const& [index, node] : configTree.clockSourceModels)
+			{
+				tryAddResponse("CLOCK_SOURCE descriptor", index,
+					[&, clockSourceIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::ClockSourceDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.clockSourceFlags = d.clockSourceFlags;
+						descriptor.clockSourceType = s.clockSourceType;
+						descriptor.clockSourceIdentifier = d.clockSourceIdentifier;
+						descriptor.clockSourceLocationType = s.clockSourceLocationType;
+						descriptor.clockSourceLocationIndex = s.clockSourceLocationIndex;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::ClockSource, clockSourceIndex), aem::serializeReadClockSourceDescriptorResponse(configurationIndex, clockSourceIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::ClockSource, clockSourceIndex, d.objectName);
+						}
+					});
+			}
+
+			for (auto const& [index, node] : configTree.memoryObjectModels)
+			{
+				tryAddResponse("MEMORY_OBJECT descriptor", index,
+					[&, memoryObjectIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::MemoryObjectDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.memoryObjectType = s.memoryObjectType;
+						descriptor.targetDescriptorType = s.targetDescriptorType;
+						descriptor.targetDescriptorIndex = s.targetDescriptorIndex;
+						descriptor.startAddress = s.startAddress;
+						descriptor.maximumLength = s.maximumLength;
+						descriptor.length = d.length;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::MemoryObject, memoryObjectIndex), aem::serializeReadMemoryObjectDescriptorResponse(configurationIndex, memoryObjectIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::MemoryObject, memoryObjectIndex, d.objectName);
+							addResponse(protocol::AemCommandType::GetMemoryObjectLength, aem::serializeGetMemoryObjectLengthCommand(configurationIndex, memoryObjectIndex), aem::serializeGetMemoryObjectLengthResponse(configurationIndex, memoryObjectIndex, d.length));
+						}
+					});
+			}
+
+			for (auto const& [index, node] : configTree.localeModels)
+			{
+				tryAddResponse("LOCALE descriptor", index,
+					[&, localeIndex = index, &s = node.staticModel]
+					{
+						auto descriptor = model::LocaleDescriptor{};
+						descriptor.localeID = s.localeID;
+						descriptor.numberOfStringDescriptors = s.numberOfStringDescriptors;
+						descriptor.baseStringDescriptorIndex = s.baseStringDescriptorIndex;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::Locale, localeIndex), aem::serializeReadLocaleDescriptorResponse(configurationIndex, localeIndex, descriptor));
+					});
+			}
+
+			for (auto const& [index, node] : configTree.stringsModels)
+			{
+				tryAddResponse("STRINGS descriptor", index,
+					[&, stringsIndex = index, &s = node.staticModel]
+					{
+						auto descriptor = model::StringsDescriptor{};
+						descriptor.strings = s.strings;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::Strings, stringsIndex), aem::serializeReadStringsDescriptorResponse(configurationIndex, stringsIndex, descriptor));
+					});
+			}
+
+			auto const addStreamPort = [&](model::DescriptorType const descriptorType, model::StreamPortIndex const streamPortIndex, model::StreamPortNodeModels const& node)
+			{
+				auto const& s = node.staticModel;
+				auto descriptor = model::StreamPortDescriptor{};
+				descriptor.clockDomainIndex = s.clockDomainIndex;
+				descriptor.portFlags = s.portFlags;
+				descriptor.numberOfControls = s.numberOfControls;
+				descriptor.baseControl = s.baseControl;
+				descriptor.numberOfClusters = s.numberOfClusters;
+				descriptor.baseCluster = s.baseCluster;
+				descriptor.numberOfMaps = s.numberOfMaps;
+				descriptor.baseMap = s.baseMap;
+				addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, descriptorType, streamPortIndex), aem::serializeReadStreamPortDescriptorResponse(configurationIndex, descriptorType, streamPortIndex, descriptor));
+
+				if (isCurrent && s.hasDynamicAudioMap)
+				{
+					// Split the dynamic mappings the same way an entity would, to fit each response in a single AECPDU
+					auto const& mappings = node.dynamicModel.dynamicAudioMap;
+					auto const numberOfMaps = static_cast<model::MapIndex>(std::max<size_t>(1u, (mappings.size() + MaximumMappingsPerMap - 1u) / MaximumMappingsPerMap));
+					for (auto mapIndex = model::MapIndex{ 0u }; mapIndex < numberOfMaps; ++mapIndex)
+					{
+						auto const first = mappings.begin() + std::min<size_t>(mappings.size(), mapIndex * MaximumMappingsPerMap);
+						auto const last = mappings.begin() + std::min<size_t>(mappings.size(), (mapIndex + 1u) * MaximumMappingsPerMap);
+						addResponse(protocol::AemCommandType::GetAudioMap, aem::serializeGetAudioMapCommand(descriptorType, streamPortIndex, mapIndex), aem::serializeGetAudioMapResponse(descriptorType, streamPortIndex, mapIndex, numberOfMaps, model::AudioMappings(first, last)));
+					}
+				}
+			};
+			for (auto const& [index, node] : configTree.streamPortInputModels)
+			{
+				tryAddResponse("STREAM_PORT_INPUT descriptor", index,
+					[&, streamPortIndex = index, &n = node]
+					{
+						addStreamPort(model::DescriptorType::StreamPortInput, streamPortIndex, n);
+					});
+			}
+			for (auto const& [index, node] : configTree.streamPortOutputModels)
+			{
+				tryAddResponse("STREAM_PORT_OUTPUT descriptor", index,
+					[&, streamPortIndex = index, &n = node]
+					{
+						addStreamPort(model::DescriptorType::StreamPortOutput, streamPortIndex, n);
+					});
+			}
+
+			for (auto const& [index, node] : configTree.audioClusterModels)
+			{
+				tryAddResponse("AUDIO_CLUSTER descriptor", index,
+					[&, clusterIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::AudioClusterDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.signalType = s.signalType;
+						descriptor.signalIndex = s.signalIndex;
+						descriptor.signalOutput = s.signalOutput;
+						descriptor.pathLatency = s.pathLatency;
+						descriptor.blockLatency = s.blockLatency;
+						descriptor.channelCount = s.channelCount;
+						descriptor.format = s.format;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::AudioCluster, clusterIndex), aem::serializeReadAudioClusterDescriptorResponse(configurationIndex, clusterIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::AudioCluster, clusterIndex, d.objectName);
+						}
+					});
+			}
+
+			for (auto const& [index, node] : configTree.audioMapModels)
+			{
+				tryAddResponse("AUDIO_MAP descriptor", index,
+					[&, mapIndex = index, &s = node.staticModel]
+					{
+						auto descriptor = model::AudioMapDescriptor{};
+						descriptor.mappings = s.mappings;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::AudioMap, mapIndex), aem::serializeReadAudioMapDescriptorResponse(configurationIndex, mapIndex, descriptor));
+					});
+			}
+
+			for (auto const& [index, node] : configTree.controlModels)
+			{
+				tryAddResponse("CONTROL descriptor", index,
+					[&, controlIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::ControlDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.blockLatency = s.blockLatency;
+						descriptor.controlLatency = s.controlLatency;
+						descriptor.controlDomain = s.controlDomain;
+						descriptor.controlType = s.controlType;
+						descriptor.resetTime = s.resetTime;
+						descriptor.signalType = s.signalType;
+						descriptor.signalIndex = s.signalIndex;
+						descriptor.signalOutput = s.signalOutput;
+						descriptor.controlValueType = s.controlValueType;
+						descriptor.valuesStatic = s.values;
+						descriptor.valuesDynamic = d.values;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::Control, controlIndex), aem::serializeReadControlDescriptorResponse(configurationIndex, controlIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::Control, controlIndex, d.objectName);
+							addResponse(protocol::AemCommandType::GetControl, aem::serializeGetControlCommand(model::DescriptorType::Control, controlIndex), aem::serializeGetControlResponse(model::DescriptorType::Control, controlIndex, d.values));
+						}
+					});
+			}
+
+			for (auto const& [index, node] : configTree.clockDomainModels)
+			{
+				tryAddResponse("CLOCK_DOMAIN descriptor", index,
+					[&, clockDomainIndex = index, &s = node.staticModel, &d = node.dynamicModel]
+					{
+						auto descriptor = model::ClockDomainDescriptor{};
+						descriptor.objectName = d.objectName;
+						descriptor.localizedDescription = s.localizedDescription;
+						descriptor.clockSourceIndex = d.clockSourceIndex;
+						descriptor.clockSources = s.clockSources;
+						addResponse(protocol::AemCommandType::ReadDescriptor, aem::serializeReadDescriptorCommand(configurationIndex, model::DescriptorType::ClockDomain, clockDomainIndex), aem::serializeReadClockDomainDescriptorResponse(configurationIndex, clockDomainIndex, descriptor));
+						if (isCurrent)
+						{
+							addObjectNameResponse(configurationIndex, model::DescriptorType::ClockDomain, clockDomainIndex, d.objectName);
+							addResponse(protocol::AemCommandType::GetClockSource, aem::serializeGetClockSourceCommand(model::DescriptorType::ClockDomain, clockDomainIndex), aem::serializeGetClockSourceResponse(model::DescriptorType::ClockDomain, clockDomainIndex, d.clockSourceIndex));
+							if (d.counters)
+							{
+								addCountersResponse<ClockDomainCounterValidFlag>(model::DescriptorType::ClockDomain, clockDomainIndex, *d.counters);
+							}
+						}
+					});
+			}
+		}
+	}
+
+	static model::StreamInfo makeStreamInfo(model::StreamNodeDynamicModel const& dynamicModel) noexcept
+	{
+		auto streamInfo = model::StreamInfo{};
+		streamInfo.streamFormat = dynamicModel.streamFormat;
+		streamInfo.streamInfoFlags.set(StreamInfoFlag::StreamFormatValid);
+		if (dynamicModel.streamDynamicInfo)
+		{
+			auto const& info = *dynamicModel.streamDynamicInfo;
+			streamInfo.streamInfoFlags |= info._streamInfoFlags;
+			if (info.streamID)
+			{
+				streamInfo.streamInfoFlags.set(StreamInfoFlag::StreamIDValid);
+				streamInfo.streamID = *info.streamID;
+			}
+			if (info.msrpAccumulatedLatency)
+			{
+				streamInfo.streamInfoFlags.set(StreamInfoFlag::MsrpAccLatValid);
+				streamInfo.msrpAccumulatedLatency = *info.msrpAccumulatedLatency;
+			}
+			if (info.streamDestMac)
+			{
+				streamInfo.streamInfoFlags.set(StreamInfoFlag::StreamDestMacValid);
+				streamInfo.streamDestMac = *info.streamDestMac;
+			}
+			if (info.msrpFailureCode && info.msrpFailureBridgeID)
+			{
+				streamInfo.streamInfoFlags.set(StreamInfoFlag::MsrpFailureValid);
+				streamInfo.msrpFailureCode = *info.msrpFailureCode;
+				streamInfo.msrpFailureBridgeID = *info.msrpFailureBridgeID;
+			}
+			if (info.streamVlanID)
+			{
+				streamInfo.streamInfoFlags.set(StreamInfoFlag::StreamVlanIDValid);
+				streamInfo.streamVlanID = *info.streamVlanID;
+			}
+			streamInfo.streamInfoFlagsEx = info.streamInfoFlagsEx;
+			streamInfo.probingStatus = info.probingStatus;
+			streamInfo.acmpStatus = info.acmpStatus;
+		}
+		return streamInfo;
+	}
+
+	static ResponseKey makeKey(protocol::AemCommandType const commandType, void const* const payload, size_t const payloadLength) noexcept
+	{
+		auto const type = commandType.getValue();
+		auto key = ResponseKey{};
+		key.reserve(sizeof(type) + payloadLength);
+		key.push_back(static_cast<char>(type >> 8));
+		key.push_back(static_cast<char>(type & 0xff));
+		if (payloadLength != 0u)
+		{
+			key.append(static_cast<char const*>(payload), payloadLength);
+		}
+		return key;
+	}
+
+	/* ************************************************************ */
+	/* Entities                                                     */
+	/* ************************************************************ */
+	/** Returns the index of the simulated entity with the specified EntityID, or getNumberOfEntities() if it's not one of ours */
+	std::size_t getEntityIndex(UniqueIdentifier const entityID) const noexcept
+	{
+		auto const base = _configuration.baseEntityID.getValue();
+		auto const value = entityID.getValue();
+		if (value < base || (value - base) >= _entities.size())
+		{
+			return _entities.size();
+		}
+		return static_cast<std::size_t>(value - base);
+	}
+
+	protocol::Adpdu makeEntityAvailableMessage(std::size_t const index) noexcept
+	{
+		auto entityCaps{ _commonInformation.entityCapabilities };
+		auto identifyControlIndex{ model::ControlIndex{ 0u } };
+		auto avbInterfaceIndex{ model::AvbInterfaceIndex{ 0u } };
+		auto associationID{ UniqueIdentifier::getNullUniqueIdentifier() };
+		auto gptpGrandmasterID{ UniqueIdentifier::getNullUniqueIdentifier() };
+		auto gptpDomainNumber{ std::uint8_t{ 0u } };
+
+		if (_commonInformation.identifyControlIndex)
+		{
+			entityCaps.set(EntityCapability::AemIdentifyControlIndexValid);
+			identifyControlIndex = *_commonInformation.identifyControlIndex;
+		}
+		else
+		{
+			entityCaps.reset(EntityCapability::AemIdentifyControlIndexValid);
+		}
+
+		if (_avbInterfaceIndex)
+		{
+			entityCaps.set(EntityCapability::AemInterfaceIndexValid);
+			avbInterfaceIndex = *_avbInterfaceIndex;
+		}
+		else
+		{
+			entityCaps.reset(EntityCapability::AemInterfaceIndexValid);
+		}
+
+		if (_commonInformation.associationID)
+		{
+			entityCaps.set(EntityCapability::AssociationIDValid);
+			associationID = *_commonInformation.associationID;
+		}
+		else
+		{
+			entityCaps.reset(EntityCapability::AssociationIDValid);
+		}
+
+		if (_gptpGrandmasterID)
+		{
+			entityCaps.set(EntityCapability::GptpSupported);
+			gptpGrandmasterID = _gptpGrandmasterID;
+			gptpDomainNumber = _gptpDomainNumber;
+		}
+		else
+		{
+			entityCaps.reset(EntityCapability::GptpSupported);
+		}
+
+		auto frame = protocol::Adpdu{};
+		// Set Ether2 fields
+		frame.setSrcAddress(_configuration.macAddress);
+		frame.setDestAddress(protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		frame.setMessageType(protocol::AdpMessageType::EntityAvailable);
+		frame.setValidTime(_configuration.validTime);
+		frame.setEntityID(getEntityID(index));
+		frame.setEntityModelID(_commonInformation.entityModelID);
+		frame.setEntityCapabilities(entityCaps);
+		frame.setTalkerStreamSources(_commonInformation.talkerStreamSources);
+		frame.setTalkerCapabilities(_commonInformation.talkerCapabilities);
+		frame.setListenerStreamSinks(_commonInformation.listenerStreamSinks);
+		frame.setListenerCapabilities(_commonInformation.listenerCapabilities);
+		frame.setControllerCapabilities(_commonInformation.controllerCapabilities);
+		frame.setAvailableIndex(_entities[index].availableIndex++);
+		frame.setGptpGrandmasterID(gptpGrandmasterID);
+		frame.setGptpDomainNumber(gptpDomainNumber);
+		frame.setIdentifyControlIndex(identifyControlIndex);
+		frame.setInterfaceIndex(avbInterfaceIndex);
+		frame.setAssociationID(associationID);
+
+		return frame;
+	}
+
+	protocol::Adpdu makeEntityDepartingMessage(std::size_t const index) noexcept
+	{
+		auto frame = protocol::Adpdu{};
+		// Set Ether2 fields
+		frame.setSrcAddress(_configuration.macAddress);
+		frame.setDestAddress(protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		frame.setMessageType(protocol::AdpMessageType::EntityDeparting);
+		frame.setValidTime(0);
+		frame.setEntityID(getEntityID(index));
+		frame.setEntityModelID(UniqueIdentifier::getNullUniqueIdentifier());
+		frame.setEntityCapabilities(EntityCapabilities{});
+		frame.setTalkerStreamSources(0u);
+		frame.setTalkerCapabilities(TalkerCapabilities{});
+		frame.setListenerStreamSinks(0u);
+		frame.setListenerCapabilities(ListenerCapabilities{});
+		frame.setControllerCapabilities(ControllerCapabilities{});
+		frame.setAvailableIndex(_entities[index].availableIndex);
+		frame.setGptpGrandmasterID(UniqueIdentifier::getNullUniqueIdentifier());
+		frame.setGptpDomainNumber(0u);
+		frame.setIdentifyControlIndex(0u);
+		frame.setInterfaceIndex(0u);
+		frame.setAssociationID(UniqueIdentifier::getNullUniqueIdentifier());
+
+		return frame;
+	}
+
+	/* ************************************************************ */
+	/* Commands handling (called from the ProtocolInterface thread)  */
+	/* ************************************************************ */
+	void queueAecpResponse(protocol::Aecpdu::UniquePointer&& response) noexcept
+	{
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_pendingAecpdus.push_back(std::move(response));
+		}
+		_condition.notify_one();
+	}
+
+	void queueAcmpResponse(protocol::Acmpdu::UniquePointer&& response) noexcept
+	{
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_pendingAcmpdus.push_back(std::move(response));
+		}
+		_condition.notify_one();
+	}
+
+	void reflectAecpCommand(protocol::Aecpdu const& command, protocol::AecpStatus const status) noexcept
+	{
+		try
+		{
+			auto response = command.responseCopy();
+			if (response)
+			{
+				auto& frame = static_cast<protocol::Aecpdu&>(*response);
+				frame.setSrcAddress(_configuration.macAddress);
+				frame.setDestAddress(command.getSrcAddress());
+				frame.setStatus(status);
+				if (status == protocol::AecpStatus::NotImplemented)
+				{
+					++_notImplementedResponses;
+				}
+				queueAecpResponse(std::move(response));
+			}
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void sendAemResponse(protocol::AemAecpdu const& command, protocol::AecpStatus const status, void const* const payload, size_t const payloadLength, std::size_t const entityIndex, bool const hasEntityID) noexcept
+	{
+		try
+		{
+			auto frame = protocol::AemAecpdu::create(true);
+			auto& aem = static_cast<protocol::AemAecpdu&>(*frame);
+
+			// Set Ether2 fields
+			aem.setSrcAddress(_configuration.macAddress);
+			aem.setDestAddress(command.getSrcAddress());
+			// Set AECP fields
+			aem.setStatus(status);
+			aem.setTargetEntityID(command.getTargetEntityID());
+			aem.setControllerEntityID(command.getControllerEntityID());
+			aem.setSequenceID(command.getSequenceID());
+			// Set AEM fields
+			aem.setUnsolicited(false);
+			aem.setCommandType(command.getCommandType());
+			if (hasEntityID)
+			{
+				// Patch the shared payload with the EntityID of the targeted entity
+				auto patched = std::vector<std::uint8_t>(static_cast<std::uint8_t const*>(payload), static_cast<std::uint8_t const*>(payload) + payloadLength);
+				auto const entityID = getEntityID(entityIndex).getValue();
+				for (auto i = size_t{ 0u }; i < sizeof(entityID); ++i)
+				{
+					patched[EntityIDPayloadOffset + i] = static_cast<std::uint8_t>(entityID >> (8u * (sizeof(entityID) - 1u - i)));
+				}
+				aem.setCommandSpecificData(patched.data(), patched.size());
+			}
+			else
+			{
+				aem.setCommandSpecificData(payload, payloadLength);
+			}
+
+			queueAecpResponse(std::move(frame));
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void handleAemCommand(protocol::AemAecpdu const& aem, std::size_t const entityIndex) noexcept
+	{
+		auto const commandType = aem.getCommandType();
+
+		if (commandType == protocol::AemCommandType::RegisterUnsolicitedNotification || commandType == protocol::AemCommandType::DeregisterUnsolicitedNotification)
+		{
+			{
+				auto const lg = std::lock_guard{ _lock };
+				auto& controllers = _entities[entityIndex].controllers;
+				auto const controllerID = aem.getControllerEntityID();
+				auto const wasRegistered = !controllers.empty();
+				controllers.erase(std::remove_if(controllers.begin(), controllers.end(),
+														[controllerID](auto const& controller)
+														{
+															return controller.controllerID == controllerID;
+														}),
+					controllers.end());
+				if (commandType == protocol::AemCommandType::RegisterUnsolicitedNotification)
+				{
+					controllers.push_back(RegisteredController{ controllerID, aem.getSrcAddress() });
+				}
+				if (wasRegistered != !controllers.empty())
+				{
+					if (controllers.empty())
+					{
+						_registeredEntities.erase(std::remove(_registeredEntities.begin(), _registeredEntities.end(), entityIndex), _registeredEntities.end());
+					}
+					else
+					{
+						_registeredEntities.push_back(entityIndex);
+					}
+				}
+			}
+			sendAemResponse(aem, protocol::AecpStatus::Success, nullptr, 0u, entityIndex, false);
+			return;
+		}
+
+		if (commandType == protocol::AemCommandType::EntityAvailable)
+		{
+			sendAemResponse(aem, protocol::AecpStatus::Success, nullptr, 0u, entityIndex, false);
+			return;
+		}
+
+		auto const [payload, payloadLength] = aem.getPayload();
+		auto const it = _responses.find(makeKey(commandType, payload, payloadLength));
+		if (it == _responses.end())
+		{
+			reflectAecpCommand(aem, protocol::AecpStatus::NotImplemented);
+			return;
+		}
+
+		auto const& response = it->second;
+		sendAemResponse(aem, protocol::AecpStatus::Success, response.payload.data(), response.payload.size(), entityIndex, response.hasEntityID);
+	}
+
+	protocol::AcmpStatus handleAcmpCommand(protocol::Acmpdu const& acmpdu, protocol::Acmpdu& response) const noexcept
+	{
+		auto const messageType = acmpdu.getMessageType();
+
+		if (messageType == protocol::AcmpMessageType::GetRxStateCommand)
+		{
+			auto const it = _streamInputConnections.find(acmpdu.getListenerUniqueID());
+			if (it == _streamInputConnections.end())
+			{
+				return protocol::AcmpStatus::ListenerUnknownID;
+			}
+			auto const& connectionInfo = it->second;
+			if (connectionInfo.state == model::StreamInputConnectionInfo::State::NotConnected)
+			{
+				response.setTalkerEntityID(UniqueIdentifier::getNullUniqueIdentifier());
+				response.setTalkerUniqueID(0u);
+				response.setConnectionCount(0u);
+				response.setFlags(ConnectionFlags{});
+			}
+			else
+			{
+				response.setTalkerEntityID(connectionInfo.talkerStream.entityID);
+				response.setTalkerUniqueID(connectionInfo.talkerStream.streamIndex);
+				if (connectionInfo.state == model::StreamInputConnectionInfo::State::Connected)
+				{
+					response.setConnectionCount(1u);
+					response.setFlags(ConnectionFlags{});
+				}
+				else
+				{
+					response.setConnectionCount(0u);
+					response.setFlags(ConnectionFlags{ ConnectionFlag::FastConnect });
+				}
+			}
+			return protocol::AcmpStatus::Success;
+		}
+
+		if (messageType == protocol::AcmpMessageType::GetTxStateCommand || messageType == protocol::AcmpMessageType::GetTxConnectionCommand)
+		{
+			if (std::find(_streamOutputs.begin(), _streamOutputs.end(), acmpdu.getTalkerUniqueID()) == _streamOutputs.end())
+			{
+				return protocol::AcmpStatus::TalkerUnknownID;
+			}
+			// Simulated talkers are never streaming
+			response.setConnectionCount(0u);
+			return messageType == protocol::AcmpMessageType::GetTxStateCommand ? protocol::AcmpStatus::Success : protocol::AcmpStatus::NoSuchConnection;
+		}
+
+		return protocol::AcmpStatus::NotSupported;
+	}
+
+	/* ************************************************************ */
+	/* Farm thread                                                  */
+	/* ************************************************************ */
+	void sendUnsolicitedNotification(std::size_t const entityIndex, std::vector<RegisteredController> const& controllers) noexcept
+	{
+		auto& entity = _entities[entityIndex];
+		auto validCounters = EntityCounterValidFlags{ EntityCounterValidFlag::EntitySpecific1 };
+		auto counters = model::DescriptorCounters{};
+		counters[validCounters.getPosition(EntityCounterValidFlag::EntitySpecific1)] = ++entity.notificationCounter;
+
+		try
+		{
+			auto const ser = protocol::aemPayload::serializeGetCountersResponse(model::DescriptorType::Entity, 0u, validCounters.value(), counters);
+			for (auto const& controller : controllers)
+			{
+				auto frame = protocol::AemAecpdu::create(true);
+				auto& aem = static_cast<protocol::AemAecpdu&>(*frame);
+
+				// Set Ether2 fields
+				aem.setSrcAddress(_configuration.macAddress);
+				aem.setDestAddress(controller.macAddress);
+				// Set AECP fields
+				aem.setStatus(protocol::AecpStatus::Success);
+				aem.setTargetEntityID(getEntityID(entityIndex));
+				aem.setControllerEntityID(controller.controllerID);
+				aem.setSequenceID(entity.unsolicitedSequenceID++);
+				// Set AEM fields
+				aem.setUnsolicited(true);
+				aem.setCommandType(protocol::AemCommandType::GetCounters);
+				aem.setCommandSpecificData(ser.data(), ser.size());
+
+				if (!_protocolInterface->sendAecpMessage(aem))
+				{
+					++_sentUnsolicitedNotifications;
+				}
+			}
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void run() noexcept
+	{
+		auto const advertisePeriod = std::max<std::chrono::milliseconds>(MinimumAdvertisePeriod, std::chrono::milliseconds{ _configuration.validTime * 1000u });
+		auto const notificationsPerSecond = static_cast<double>(_configuration.unsolicitedNotificationsPerSecond);
+		auto nextAdvertisement = std::chrono::steady_clock::now();
+		auto lastNotificationsTime = nextAdvertisement;
+		auto notificationsCredit = 0.0;
+		auto nextRegisteredEntity = std::size_t{ 0u };
+
+		while (true)
+		{
+			auto aecpdus = decltype(_pendingAecpdus){};
+			auto acmpdus = decltype(_pendingAcmpdus){};
+			auto advertiseAll = false;
+			auto advertisements = decltype(_pendingAdvertisements){};
+
+			// Wait for something to do
+			{
+				auto const nextWakeUp = notificationsPerSecond > 0.0 ? std::min(nextAdvertisement, std::chrono::steady_clock::now() + NotificationsTick) : nextAdvertisement;
+				auto lock = std::unique_lock{ _lock };
+				_condition.wait_until(lock, nextWakeUp,
+					[this]
+					{
+						return _shouldTerminate || !_pendingAecpdus.empty() || !_pendingAcmpdus.empty() || _advertiseAll || !_pendingAdvertisements.empty();
+					});
+				if (_shouldTerminate)
+				{
+					break;
+				}
+				aecpdus.swap(_pendingAecpdus);
+				acmpdus.swap(_pendingAcmpdus);
+				advertisements.swap(_pendingAdvertisements);
+				std::swap(advertiseAll, _advertiseAll);
+			}
+
+			// Send the responses
+			for (auto const& aecpdu : aecpdus)
+			{
+				if (!_protocolInterface->sendAecpMessage(*aecpdu))
+				{
+					++_sentResponses;
+				}
+			}
+			for (auto const& acmpdu : acmpdus)
+			{
+				if (!_protocolInterface->sendAcmpMessage(*acmpdu))
+				{
+					++_sentResponses;
+				}
+			}
+
+			// Advertise the entities
+			auto const now = std::chrono::steady_clock::now();
+			if (advertiseAll || now >= nextAdvertisement)
+			{
+				for (auto index = std::size_t{ 0u }; index < _entities.size(); ++index)
+				{
+					if (!_protocolInterface->sendAdpMessage(makeEntityAvailableMessage(index)))
+					{
+						++_sentAdvertisements;
+					}
+				}
+				nextAdvertisement = now + advertisePeriod;
+			}
+			else
+			{
+				for (auto const index : advertisements)
+				{
+					if (!_protocolInterface->sendAdpMessage(makeEntityAvailableMessage(index)))
+					{
+						++_sentAdvertisements;
+					}
+				}
+			}
+
+			// Send the unsolicited notifications, spread over time at the configured rate
+			if (notificationsPerSecond > 0.0)
+			{
+				notificationsCredit = std::min(notificationsPerSecond, notificationsCredit + std::chrono::duration<double>(now - lastNotificationsTime).count() * notificationsPerSecond);
+				lastNotificationsTime = now;
+				while (notificationsCredit >= 1.0)
+				{
+					auto entityIndex = std::size_t{ 0u };
+					auto controllers = std::vector<RegisteredController>{};
+					{
+						auto const lg = std::lock_guard{ _lock };
+						if (_registeredEntities.empty())
+						{
+							break;
+						}
+						nextRegisteredEntity %= _registeredEntities.size();
+						entityIndex = _registeredEntities[nextRegisteredEntity++];
+						controllers = _entities[entityIndex].controllers;
+					}
+					sendUnsolicitedNotification(entityIndex, controllers);
+					notificationsCredit -= static_cast<double>(std::max<size_t>(1u, controllers.size()));
+				}
+			}
+		}
+	}
+
+	/* ************************************************************ */
+	/* EntityFarm overrides                                         */
+	/* ************************************************************ */
+	virtual protocol::ProtocolInterface& getProtocolInterface() noexcept override
+	{
+		return *_protocolInterface;
+	}
+
+	virtual std::size_t getNumberOfEntities() const noexcept override
+	{
+		return _entities.size();
+	}
+
+	virtual UniqueIdentifier getEntityID(std::size_t const index) const noexcept override
+	{
+		return UniqueIdentifier{ _configuration.baseEntityID.getValue() + index };
+	}
+
+	virtual Statistics getStatistics() const noexcept override
+	{
+		auto statistics = Statistics{};
+		statistics.receivedCommands = _receivedCommands;
+		statistics.sentResponses = _sentResponses;
+		statistics.notImplementedResponses = _notImplementedResponses;
+		statistics.sentUnsolicitedNotifications = _sentUnsolicitedNotifications;
+		statistics.sentAdvertisements = _sentAdvertisements;
+		return statistics;
+	}
+
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+
+	/* ************************************************************ */
+	/* protocol::ProtocolInterface::Observer overrides              */
+	/* ************************************************************ */
+	virtual void onAdpduReceived(protocol::ProtocolInterface* const /*pi*/, protocol::Adpdu const& adpdu) noexcept override
+	{
+		if (adpdu.getMessageType() != protocol::AdpMessageType::EntityDiscover)
+		{
+			return;
+		}
+
+		auto const entityID = adpdu.getEntityID();
+		if (!entityID)
+		{
+			{
+				auto const lg = std::lock_guard{ _lock };
+				_advertiseAll = true;
+			}
+			_condition.notify_one();
+		}
+		else if (auto const index = getEntityIndex(entityID); index < _entities.size())
+		{
+			{
+				auto const lg = std::lock_guard{ _lock };
+				_pendingAdvertisements.push_back(index);
+			}
+			_condition.notify_one();
+		}
+	}
+
+	virtual void onAecpduReceived(protocol::ProtocolInterface* const /*pi*/, protocol::Aecpdu const& aecpdu) noexcept override
+	{
+		auto const messageType = aecpdu.getMessageType();
+		auto const isResponse = (messageType.getValue() % 2) == 1; // Odd numbers are responses (see Clause 9.2.1.1.5)
+		if (isResponse)
+		{
+			return;
+		}
+
+		// Only process commands targeted to one of our entities (VendorUnique ones are handled by onVuAecpCommand)
+		auto const entityIndex = getEntityIndex(aecpdu.getTargetEntityID());
+		if (entityIndex >= _entities.size() || messageType == protocol::AecpMessageType::VendorUniqueCommand)
+		{
+			return;
+		}
+
+		++_receivedCommands;
+		if (messageType == protocol::AecpMessageType::AemCommand)
+		{
+			handleAemCommand(static_cast<protocol::AemAecpdu const&>(aecpdu), entityIndex);
+		}
+		else
+		{
+			reflectAecpCommand(aecpdu, protocol::AecpStatus::NotImplemented);
+		}
+	}
+
+	virtual void onAcmpCommand(protocol::ProtocolInterface* const /*pi*/, protocol::Acmpdu const& acmpdu) noexcept override
+	{
+		auto const messageType = acmpdu.getMessageType();
+		auto const isListenerCommand = messageType == protocol::AcmpMessageType::ConnectRxCommand || messageType == protocol::AcmpMessageType::DisconnectRxCommand || messageType == protocol::AcmpMessageType::GetRxStateCommand;
+		auto const targetID = isListenerCommand ? acmpdu.getListenerEntityID() : acmpdu.getTalkerEntityID();
+
+		// Only process commands targeted to one of our entities
+		if (getEntityIndex(targetID) >= _entities.size())
+		{
+			return;
+		}
+
+		++_receivedCommands;
+		try
+		{
+			auto response = acmpdu.copy();
+			auto& frame = static_cast<protocol::Acmpdu&>(*response);
+			frame.setSrcAddress(_configuration.macAddress);
+			frame.setMessageType(protocol::AcmpMessageType(messageType.getValue() + 1)); // Based on Clause 8.2.1.5, responses are always Command + 1
+			frame.setStatus(handleAcmpCommand(acmpdu, frame));
+			queueAcmpResponse(std::move(response));
+		}
+		catch (...)
+		{
+		}
+	}
+
+	/* ************************************************************ */
+	/* protocol::ProtocolInterface::VendorUniqueDelegate overrides  */
+	/* ************************************************************ */
+	virtual protocol::Aecpdu::UniquePointer createAecpdu(protocol::VuAecpdu::ProtocolIdentifier const& /*protocolIdentifier*/, bool const isResponse) noexcept override
+	{
+		return protocol::MvuAecpdu::create(isResponse);
+	}
+
+	virtual void onVuAecpCommand(protocol::ProtocolInterface* const /*pi*/, protocol::VuAecpdu::ProtocolIdentifier const& /*protocolIdentifier*/, protocol::VuAecpdu const& aecpdu) noexcept override
+	{
+		// Ignore messages not for one of our entities
+		if (getEntityIndex(aecpdu.getTargetEntityID()) >= _entities.size())
+		{
+			return;
+		}
+
+		++_receivedCommands;
+		// Reflect back the command, and return a NotImplemented error code (there is no "NotSupported" code for MVU)
+		reflectAecpCommand(aecpdu, protocol::AecpStatus::NotImplemented);
+	}
+
+	// Private members
+	Entity::CommonInformation const _commonInformation{};
+	Configuration const _configuration{};
+	std::unordered_map<ResponseKey, Response> _responses{}; // Built once in the constructor, then read only
+	std::map<model::StreamIndex, model::StreamInputConnectionInfo> _streamInputConnections{};
+	std::vector<model::StreamIndex> _streamOutputs{};
+	std::optional<model::AvbInterfaceIndex> _avbInterfaceIndex{ std::nullopt };
+	UniqueIdentifier _gptpGrandmasterID{};
+	std::uint8_t _gptpDomainNumber{ 0u };
+	std::unique_ptr<protocol::ProtocolInterfaceVirtual> _protocolInterface{ nullptr };
+	std::vector<EntityState> _entities{};
+	std::mutex _lock{};
+	std::condition_variable _condition{};
+	bool _shouldTerminate{ false };
+	std::vector<protocol::Aecpdu::UniquePointer> _pendingAecpdus{};
+	std::vector<protocol::Acmpdu::UniquePointer> _pendingAcmpdus{};
+	std::vector<std::size_t> _pendingAdvertisements{};
+	bool _advertiseAll{ false };
+	std::vector<std::size_t> _registeredEntities{}; // Indexes of the entities with at least one registered controller
+	std::atomic<std::uint64_t> _receivedCommands{ 0u };
+	std::atomic<std::uint64_t> _sentResponses{ 0u };
+	std::atomic<std::uint64_t> _notImplementedResponses{ 0u };
+	std::atomic<std::uint64_t> _sentUnsolicitedNotifications{ 0u };
+	std::atomic<std::uint64_t> _sentAdvertisements{ 0u };
+	std::thread _thread{};
+};
+#endif // HAVE_PROTOCOL_INTERFACE_VIRTUAL
+
+/** Entry point */
+EntityFarm* LA_AVDECC_CALL_CONVENTION EntityFarm::createRawEntityFarm(std::string const& networkInterfaceName, Entity::CommonInformation const& commonInformation, model::EntityTree const& entityTree, Configuration const& configuration)
+{
+#if defined(HAVE_PROTOCOL_INTERFACE_VIRTUAL)
+	return new EntityFarmImpl(networkInterfaceName, commonInformation, entityTree, configuration);
+#else // !HAVE_PROTOCOL_INTERFACE_VIRTUAL
+	(void)networkInterfaceName;
+	(void)commonInformation;
+	(void)entityTree;
+	(void)configuration;
+	throw protocol::ProtocolInterface::Exception(protocol::ProtocolInterface::Error::InterfaceNotSupported, "Virtual ProtocolInterface not compiled in this library");
+#endif // HAVE_PROTOCOL_INTERFACE_VIRTUAL
+}
+
+} // namespace entity
+} // namespace avdecc
+} // namespace la
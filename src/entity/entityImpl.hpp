@@ -32,6 +32,7 @@
 #include "la/avdecc/internals/protocolMvuAecpdu.hpp"
 
 #include "logHelper.hpp"
+#include "dispatchTable.hpp"
 
 #include <cstdint>
 #include <algorithm>
@@ -251,7 +252,7 @@ public:
 	static LocalEntity::MvuCommandStatus convertErrorToMvuCommandStatus(protocol::ProtocolInterface::Error const error) noexcept;
 	static LocalEntity::ControlStatus convertErrorToControlStatus(protocol::ProtocolInterface::Error const error) noexcept;
 
-	static void sendAemAecpCommand(protocol::ProtocolInterface const* const pi, UniqueIdentifier const controllerEntityID, UniqueIdentifier const targetEntityID, networkInterface::MacAddress targetMacAddress, protocol::AemCommandType const commandType, void const* const payload, size_t const payloadLength, std::function<void(protocol::Aecpdu const*, LocalEntity::AemCommandStatus)> const& onResult) noexcept
+	static void sendAemAecpCommand(protocol::ProtocolInterface const* const pi, UniqueIdentifier const controllerEntityID, UniqueIdentifier const targetEntityID, networkInterface::MacAddress targetMacAddress, protocol::AemCommandType const commandType, void const* const payload, size_t const payloadLength, protocol::ProtocolInterface::AecpCommandPriority const priority, std::function<void(protocol::Aecpdu const*, LocalEntity::AemCommandStatus)> const& onResult) noexcept
 	{
 		try
 		{
@@ -276,7 +277,8 @@ public:
 				[onResult](protocol::Aecpdu const* response, protocol::ProtocolInterface::Error const error) noexcept
 				{
 					utils::invokeProtectedHandler(onResult, response, convertErrorToAemCommandStatus(error));
-				});
+				},
+				priority);
 			if (!!error)
 			{
 				utils::invokeProtectedHandler(onResult, nullptr, convertErrorToAemCommandStatus(error));
@@ -292,7 +294,7 @@ public:
 		}
 	}
 
-	static void sendAaAecpCommand(protocol::ProtocolInterface const* const pi, UniqueIdentifier const controllerEntityID, UniqueIdentifier const targetEntityID, networkInterface::MacAddress targetMacAddress, addressAccess::Tlvs const& tlvs, std::function<void(protocol::Aecpdu const*, LocalEntity::AaCommandStatus)> const& onResult) noexcept
+	static void sendAaAecpCommand(protocol::ProtocolInterface const* const pi, UniqueIdentifier const controllerEntityID, UniqueIdentifier const targetEntityID, networkInterface::MacAddress targetMacAddress, addressAccess::Tlvs const& tlvs, protocol::ProtocolInterface::AecpCommandPriority const priority, std::function<void(protocol::Aecpdu const*, LocalEntity::AaCommandStatus)> const& onResult) noexcept
 	{
 		try
 		{
@@ -318,7 +320,8 @@ public:
 				[onResult](protocol::Aecpdu const* response, protocol::ProtocolInterface::Error const error) noexcept
 				{
 					utils::invokeProtectedHandler(onResult, response, convertErrorToAaCommandStatus(error));
-				});
+				},
+				priority);
 			if (!!error)
 			{
 				utils::invokeProtectedHandler(onResult, nullptr, convertErrorToAaCommandStatus(error));
@@ -334,7 +337,7 @@ public:
 		}
 	}
 
-	static void sendMvuAecpCommand(protocol::ProtocolInterface const* const pi, UniqueIdentifier const controllerEntityID, UniqueIdentifier const targetEntityID, networkInterface::MacAddress targetMacAddress, protocol::MvuCommandType const commandType, void const* const payload, size_t const payloadLength, std::function<void(protocol::Aecpdu const*, LocalEntity::MvuCommandStatus)> const& onResult) noexcept
+	static void sendMvuAecpCommand(protocol::ProtocolInterface const* const pi, UniqueIdentifier const controllerEntityID, UniqueIdentifier const targetEntityID, networkInterface::MacAddress targetMacAddress, protocol::MvuCommandType const commandType, void const* const payload, size_t const payloadLength, protocol::ProtocolInterface::AecpCommandPriority const priority, std::function<void(protocol::Aecpdu const*, LocalEntity::MvuCommandStatus)> const& onResult) noexcept
 	{
 		try
 		{
@@ -358,7 +361,8 @@ public:
 				[onResult](protocol::Aecpdu const* response, protocol::ProtocolInterface::Error const error) noexcept
 				{
 					utils::invokeProtectedHandler(onResult, response, convertErrorToMvuCommandStatus(error));
-				});
+				},
+				priority);
 			if (!!error)
 			{
 				utils::invokeProtectedHandler(onResult, nullptr, convertErrorToMvuCommandStatus(error));
@@ -570,6 +574,13 @@ public:
 	virtual void onRemoteEntityOnline(protocol::ProtocolInterface* const /*pi*/, Entity const& /*entity*/) noexcept {}
 	virtual void onRemoteEntityOffline(protocol::ProtocolInterface* const /*pi*/, UniqueIdentifier const /*entityID*/) noexcept {}
 	virtual void onRemoteEntityUpdated(protocol::ProtocolInterface* const /*pi*/, Entity const& /*entity*/) noexcept {}
+	virtual void onRemoteEntitiesUpdated(protocol::ProtocolInterface* const pi, protocol::ProtocolInterface::EntityReferences const& entities) noexcept
+	{
+		for (auto const& entity : entities)
+		{
+			onRemoteEntityUpdated(pi, entity);
+		}
+	}
 	/* **** AECP notifications **** */
 	virtual bool onUnhandledAecpCommand(protocol::ProtocolInterface* const /*pi*/, protocol::Aecpdu const& /*aecpdu*/) noexcept
 	{
@@ -153,7 +153,7 @@ void LocalEntityImpl<SuperClass>::onAecpCommand(protocol::ProtocolInterface* con
 	{
 		auto const& aem = static_cast<protocol::AemAecpdu const&>(aecpdu);
 
-		static std::unordered_map<protocol::AemCommandType::value_type, std::function<void(protocol::ProtocolInterface* const pi, LocalEntityImpl const* const entity, protocol::AemAecpdu const& aem)>> s_Dispatch{
+		static auto const s_Dispatch = DispatchTable<protocol::AemCommandType::value_type, AemCommandTypeDispatchSize, void(protocol::ProtocolInterface* const pi, LocalEntityImpl const* const entity, protocol::AemAecpdu const& aem)>{
 			// Entity Available
 			{ protocol::AemCommandType::EntityAvailable.getValue(),
 				[](protocol::ProtocolInterface* const pi, auto const* const entity, protocol::AemAecpdu const& aem)
@@ -163,10 +163,10 @@ void LocalEntityImpl<SuperClass>::onAecpCommand(protocol::ProtocolInterface* con
 				} },
 		};
 
-		auto const& it = s_Dispatch.find(aem.getCommandType().getValue());
-		if (it != s_Dispatch.end())
+		auto const handler = s_Dispatch.get(aem.getCommandType().getValue());
+		if (handler != nullptr)
 		{
-			invokeProtectedHandler(it->second, pi, this, aem);
+			invokeProtectedHandler(handler, pi, this, aem);
 			return;
 		}
 	}
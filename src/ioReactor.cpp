@@ -0,0 +1,301 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file ioReactor.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/utils.hpp"
+#include "ioReactor.hpp"
+#include "logHelper.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <array>
+#include <limits>
+
+namespace la
+{
+namespace avdecc
+{
+static constexpr auto MaxEventsPerWait = 64;
+static constexpr auto WakeUpHandle = std::numeric_limits<IoReactor::Handle>::max();
+
+IoReactor::SharedPointer IoReactor::getInstance() noexcept
+{
+	// Cannot use make_shared, the constructor is private
+	static auto s_Instance = SharedPointer{ new IoReactor };
+
+	return s_Instance;
+}
+
+IoReactor::IoReactor() noexcept
+{
+	_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	_wakeUpFd = eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_epollFd == -1 || _wakeUpFd == -1)
+	{
+		LOG_GENERIC_ERROR(std::string("IoReactor: Failed to create epoll descriptors: ") + std::strerror(errno));
+		return;
+	}
+
+	auto event = epoll_event{};
+	event.events = EPOLLIN;
+	event.data.u64 = WakeUpHandle;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeUpFd, &event) == -1)
+	{
+		LOG_GENERIC_ERROR(std::string("IoReactor: Failed to register wake up descriptor: ") + std::strerror(errno));
+		close(_epollFd);
+		_epollFd = -1;
+		return;
+	}
+
+	_thread = std::thread(
+		[this]
+		{
+			utils::setCurrentThreadName("avdecc::IoReactor");
+			run();
+		});
+}
+
+IoReactor::~IoReactor() noexcept
+{
+	// Notify the thread we are shutting down
+	if (_thread.joinable())
+	{
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_shouldTerminate = true;
+		}
+		auto const value = std::uint64_t{ 1u };
+		[[maybe_unused]] auto const ret = write(_wakeUpFd, &value, sizeof(value));
+		_thread.join();
+	}
+
+	// Release remaining sources (should be none)
+	for (auto const& [handle, source] : _sources)
+	{
+		if (source->isTimer)
+		{
+			close(source->fd);
+		}
+	}
+	_sources.clear();
+
+	if (_wakeUpFd != -1)
+	{
+		close(_wakeUpFd);
+	}
+	if (_epollFd != -1)
+	{
+		close(_epollFd);
+	}
+
+	_watchDog.unregisterHeartbeat(_dispatchHeartbeat);
+}
+
+IoReactor::Handle IoReactor::addReader(int const fd, ReadHandler&& handler) noexcept
+{
+	auto source = std::make_shared<Source>();
+	source->fd = fd;
+	source->readHandler = std::move(handler);
+
+	return addSource(fd, std::move(source));
+}
+
+IoReactor::Handle IoReactor::addTimer(std::chrono::milliseconds const period, TimerHandler&& handler) noexcept
+{
+	auto const fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (fd == -1)
+	{
+		LOG_GENERIC_ERROR(std::string("IoReactor: Failed to create timer: ") + std::strerror(errno));
+		return InvalidHandle;
+	}
+
+	auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(period);
+	auto const nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(period - seconds);
+	auto spec = itimerspec{};
+	spec.it_interval.tv_sec = static_cast<decltype(spec.it_interval.tv_sec)>(seconds.count());
+	spec.it_interval.tv_nsec = static_cast<decltype(spec.it_interval.tv_nsec)>(nanoseconds.count());
+	spec.it_value = spec.it_interval;
+	if (timerfd_settime(fd, 0, &spec, nullptr) == -1)
+	{
+		LOG_GENERIC_ERROR(std::string("IoReactor: Failed to arm timer: ") + std::strerror(errno));
+		close(fd);
+		return InvalidHandle;
+	}
+
+	auto source = std::make_shared<Source>();
+	source->fd = fd;
+	source->isTimer = true;
+	source->timerHandler = std::move(handler);
+
+	auto const handle = addSource(fd, std::move(source));
+	if (handle == InvalidHandle)
+	{
+		close(fd);
+	}
+	return handle;
+}
+
+void IoReactor::remove(Handle const handle) noexcept
+{
+	auto lock = std::unique_lock{ _lock };
+
+	auto const it = _sources.find(handle);
+	if (it == _sources.end())
+	{
+		return;
+	}
+
+	auto const& source = it->second;
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, source->fd, nullptr);
+	if (source->isTimer)
+	{
+		// The reactor thread only reads the timer with the lock taken, so it can be closed right away
+		close(source->fd);
+	}
+
+	_sources.erase(it);
+
+	// Wait for the handler to complete, if it's currently running in the reactor thread (and we are not called from the handler itself)
+	if (std::this_thread::get_id() != _thread.get_id())
+	{
+		_handlerCompleted.wait(lock,
+			[this, handle]
+			{
+				return _runningHandle != handle;
+			});
+	}
+}
+
+IoReactor::Handle IoReactor::addSource(int const fd, std::shared_ptr<Source>&& source) noexcept
+{
+	if (_epollFd == -1)
+	{
+		return InvalidHandle;
+	}
+
+	auto const lg = std::lock_guard{ _lock };
+
+	auto const handle = _nextHandle++;
+
+	auto event = epoll_event{};
+	event.events = EPOLLIN;
+	event.data.u64 = handle;
+	if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+	{
+		LOG_GENERIC_ERROR(std::string("IoReactor: Failed to register descriptor: ") + std::strerror(errno));
+		return InvalidHandle;
+	}
+
+	_sources[handle] = std::move(source);
+
+	return handle;
+}
+
+void IoReactor::run() noexcept
+{
+	auto events = std::array<epoll_event, MaxEventsPerWait>{};
+
+	while (true)
+	{
+		auto const count = epoll_wait(_epollFd, events.data(), MaxEventsPerWait, -1);
+		if (count == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			LOG_GENERIC_ERROR(std::string("IoReactor: epoll_wait failed: ") + std::strerror(errno));
+			return;
+		}
+
+		for (auto i = 0; i < count; ++i)
+		{
+			auto const& event = events[i];
+			auto const handle = event.data.u64;
+
+			if (handle == WakeUpHandle)
+			{
+				auto value = std::uint64_t{ 0u };
+				[[maybe_unused]] auto const ret = read(_wakeUpFd, &value, sizeof(value));
+				auto const lg = std::lock_guard{ _lock };
+				if (_shouldTerminate)
+				{
+					return;
+				}
+				continue;
+			}
+
+			// Keep a reference on the source (the handler is allowed to remove it), and mark it as running so remove waits for the handler to complete
+			auto source = std::shared_ptr<Source>{};
+			{
+				auto const lg = std::lock_guard{ _lock };
+
+				auto const it = _sources.find(handle);
+				if (it == _sources.end())
+				{
+					// Removed since epoll_wait returned (by another thread, or by a handler called earlier in this batch)
+					continue;
+				}
+				source = it->second;
+
+				if (source->isTimer)
+				{
+					// Acknowledge the expiration (missed expirations are coalesced), with the lock taken as remove closes the timer
+					auto expirations = std::uint64_t{ 0u };
+					if (read(source->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+					{
+						continue;
+					}
+				}
+
+				_runningHandle = handle;
+			}
+
+			// Call the handler without the lock, it may take other locks that a thread calling remove (for another source) holds
+			_watchDog.armHeartbeat(_dispatchHeartbeat);
+			if (source->isTimer)
+			{
+				utils::invokeProtectedHandler(source->timerHandler);
+			}
+			else
+			{
+				auto const hasError = (event.events & (EPOLLERR | EPOLLHUP)) != 0;
+				utils::invokeProtectedHandler(source->readHandler, hasError);
+			}
+			_watchDog.disarmHeartbeat(_dispatchHeartbeat);
+
+			{
+				auto const lg = std::lock_guard{ _lock };
+				_runningHandle = InvalidHandle;
+			}
+			_handlerCompleted.notify_all();
+		}
+	}
+}
+
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,114 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file ioReactor.hpp
+* @author Christophe Calmejane
+* @brief Single epoll thread serving the file descriptors and timers of all the ProtocolInterfaces and state machines (linux only).
+*/
+
+#pragma once
+
+#include "la/avdecc/watchDog.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace la
+{
+namespace avdecc
+{
+/**
+* @brief Shared I/O reactor, so the number of threads does not grow with the number of network interfaces.
+* @details Readers and timers are registered with a handler, which is called from the reactor thread when the file descriptor becomes readable (level triggered) or when the timer expires.
+*          Handlers are called one at a time, they must not block and should process as much pending data as possible before returning.
+*          No lock of the reactor is held while a handler runs, so handlers can take other locks (the state machines one) while other threads add or remove sources.
+*          The class is implemented as a shared_ptr singleton, like the WatchDog.
+*/
+class IoReactor final
+{
+public:
+	using SharedPointer = std::shared_ptr<IoReactor>;
+	using Handle = std::uint64_t;
+	using ReadHandler = std::function<void(bool const hasError)>;
+	using TimerHandler = std::function<void()>;
+
+	static constexpr Handle InvalidHandle = 0u;
+
+	static SharedPointer getInstance() noexcept;
+
+	/** Calls handler each time fd is readable, or in error (hasError set). The file descriptor is not owned by the reactor. Returns InvalidHandle on failure. */
+	Handle addReader(int const fd, ReadHandler&& handler) noexcept;
+
+	/** Calls handler every period. Returns InvalidHandle on failure. */
+	Handle addTimer(std::chrono::milliseconds const period, TimerHandler&& handler) noexcept;
+
+	/**
+	* @brief Removes a reader or a timer. Unknown handles are ignored.
+	* @details Once this method returns, the handler is not running and will never be called again (unless called from the handler itself).
+	*          Only waits for the handler of this source, if it's currently running: must not be called with a lock its handler takes.
+	*/
+	void remove(Handle const handle) noexcept;
+
+	/** Destructor. Stops the reactor thread. */
+	~IoReactor() noexcept;
+
+	// Deleted compiler auto-generated methods
+	IoReactor(IoReactor&&) = delete;
+	IoReactor(IoReactor const&) = delete;
+	IoReactor& operator=(IoReactor const&) = delete;
+	IoReactor& operator=(IoReactor&&) = delete;
+
+private:
+	struct Source
+	{
+		int fd{ -1 };
+		bool isTimer{ false };
+		ReadHandler readHandler{};
+		TimerHandler timerHandler{};
+	};
+
+	IoReactor() noexcept;
+
+	Handle addSource(int const fd, std::shared_ptr<Source>&& source) noexcept;
+	void run() noexcept;
+
+	// Private variables
+	watchDog::WatchDog::SharedPointer _watchDogSharedPointer{ watchDog::WatchDog::getInstance() };
+	watchDog::WatchDog& _watchDog{ *_watchDogSharedPointer };
+	watchDog::WatchDog::HeartbeatHandle _dispatchHeartbeat{ _watchDog.registerHeartbeat("avdecc::IoReactor::dispatch", std::chrono::milliseconds{ 1000u }) };
+	int _epollFd{ -1 };
+	int _wakeUpFd{ -1 };
+	bool _shouldTerminate{ false };
+	std::mutex _lock{}; // Protects _sources, _nextHandle and _runningHandle (never held while calling the handlers)
+	std::condition_variable _handlerCompleted{}; // Notified each time a handler returns, so remove can wait for the handler of its source
+	std::unordered_map<Handle, std::shared_ptr<Source>> _sources{};
+	Handle _nextHandle{ InvalidHandle + 1u };
+	Handle _runningHandle{ InvalidHandle }; // Source whose handler is currently running in the reactor thread
+	std::thread _thread{};
+};
+
+} // namespace avdecc
+} // namespace la
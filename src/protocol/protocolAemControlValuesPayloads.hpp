@@ -59,6 +59,10 @@ struct control_values_payload_traits
 	{
 		throw std::invalid_argument("No template specialization found for this ControlValueType");
 	}
+	static void packFullControlValues(Serializer<AemAecpdu::MaximumSendPayloadBufferLength>& /*ser*/, entity::model::ControlValues const& /*staticValues*/, entity::model::ControlValues const& /*dynamicValues*/)
+	{
+		throw std::invalid_argument("No template specialization found for this ControlValueType");
+	}
 	static std::optional<std::string> validateControlValues(entity::model::ControlValues const& /*staticValues*/, entity::model::ControlValues const& /*dynamicValues*/) noexcept
 	{
 		return "No template specialization found for this ControlValueType";
@@ -124,6 +128,27 @@ struct LinearValuesPayloadTraits : BaseValuesPayloadTraits<StaticValueType, Dyna
 		}
 	}
 
+	static void packFullControlValues(Serializer<AemAecpdu::MaximumSendPayloadBufferLength>& ser, entity::model::ControlValues const& staticValues, entity::model::ControlValues const& dynamicValues)
+	{
+		auto const staticLinearValues = staticValues.getValues<StaticValueType>(); // We have to store the copy or it will go out of scope if using it directly in the range-based loop
+		auto const dynamicLinearValues = dynamicValues.getValues<DynamicValueType>(); // We have to store the copy or it will go out of scope
+
+		if (staticLinearValues.countValues() != dynamicLinearValues.countValues())
+		{
+			throw std::invalid_argument("Static and Dynamic values count mismatch");
+		}
+
+		auto pos = size_t{ 0u };
+		for (auto const& valueStatic : staticLinearValues.getValues())
+		{
+			auto const& valueDynamic = dynamicLinearValues.getValues()[pos];
+
+			ser << valueStatic.minimum << valueStatic.maximum << valueStatic.step << valueStatic.defaultValue << valueDynamic.currentValue << valueStatic.unit << valueStatic.localizedName;
+
+			++pos;
+		}
+	}
+
 	static std::optional<std::string> validateControlValues(entity::model::ControlValues const& staticValues, entity::model::ControlValues const& dynamicValues) noexcept
 	{
 		using value_size = typename DynamicValueType::control_value_details_traits::size_type;
@@ -278,6 +303,12 @@ struct control_values_payload_traits<entity::model::ControlValueType::Type::Cont
 		ser.packBuffer(linearValues.currentValue.data(), length);
 	}
 
+	static void packFullControlValues(Serializer<AemAecpdu::MaximumSendPayloadBufferLength>& ser, entity::model::ControlValues const& /*staticValues*/, entity::model::ControlValues const& dynamicValues)
+	{
+		// No static part for CONTROL_UTF8
+		packDynamicControlValues(ser, dynamicValues);
+	}
+
 	static std::optional<std::string> validateControlValues(entity::model::ControlValues const& /*staticValues*/, entity::model::ControlValues const& /*dynamicValues*/) noexcept
 	{
 		return std::nullopt;
@@ -180,10 +180,429 @@ std::tuple<entity::model::ConfigurationIndex, entity::model::DescriptorType, ent
 }
 
 /** READ_DESCRIPTOR Response - Clause 7.4.5.2 */
-//Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadDescriptorResponse(entity::model::ConfigurationIndex const /*configurationIndex*/, entity::model::DescriptorType const /*descriptorType*/, entity::model::DescriptorIndex const /*descriptorIndex*/)
-//{
-//	return {};
-//}
+static inline void serializeReadDescriptorCommonResponse(Serializer<AemAecpdu::MaximumSendPayloadBufferLength>& ser, entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex)
+{
+	std::uint16_t const reserved{ 0u };
+
+	ser << configurationIndex << reserved;
+	ser << descriptorType << descriptorIndex;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadCommonDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadEntityDescriptorResponse(entity::model::EntityDescriptor const& entityDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, entity::model::ConfigurationIndex{ 0u }, entity::model::DescriptorType::Entity, entity::model::DescriptorIndex{ 0u });
+
+	// Entity descriptor - Clause 7.2.1
+	ser << entityDescriptor.entityID << entityDescriptor.entityModelID << entityDescriptor.entityCapabilities;
+	ser << entityDescriptor.talkerStreamSources << entityDescriptor.talkerCapabilities;
+	ser << entityDescriptor.listenerStreamSinks << entityDescriptor.listenerCapabilities;
+	ser << entityDescriptor.controllerCapabilities;
+	ser << entityDescriptor.availableIndex;
+	ser << entityDescriptor.associationID;
+	ser << entityDescriptor.entityName;
+	ser << entityDescriptor.vendorNameString << entityDescriptor.modelNameString;
+	ser << entityDescriptor.firmwareVersion;
+	ser << entityDescriptor.groupName;
+	ser << entityDescriptor.serialNumber;
+	ser << entityDescriptor.configurationsCount << entityDescriptor.currentConfiguration;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadEntityDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadConfigurationDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ConfigurationDescriptor const& configurationDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+	auto const descriptorCountsCount = static_cast<std::uint16_t>(configurationDescriptor.descriptorCounts.size());
+	// Clause 7.2.2 says the descriptor_counts_offset field is from the base of the descriptor, which is not where our serializer buffer starts
+	auto const descriptorCountsOffset = static_cast<std::uint16_t>(AecpAemReadConfigurationDescriptorResponsePayloadMinSize - sizeof(entity::model::ConfigurationIndex) - sizeof(std::uint16_t));
+
+	serializeReadDescriptorCommonResponse(ser, entity::model::ConfigurationIndex{ 0u }, entity::model::DescriptorType::Configuration, configurationIndex);
+
+	// Configuration descriptor - Clause 7.2.2
+	ser << configurationDescriptor.objectName;
+	ser << configurationDescriptor.localizedDescription;
+	ser << descriptorCountsCount << descriptorCountsOffset;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadConfigurationDescriptorResponsePayloadMinSize, "Used bytes do not match the protocol constant");
+
+	for (auto const& [type, count] : configurationDescriptor.descriptorCounts)
+	{
+		ser << type << count;
+	}
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAudioUnitDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::AudioUnitIndex const audioUnitIndex, entity::model::AudioUnitDescriptor const& audioUnitDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+	// Clause 7.2.3 says the sampling_rates_offset field is from the base of the descriptor, which is not where our serializer buffer starts
+	auto const samplingRatesOffset = static_cast<std::uint16_t>(AecpAemReadAudioUnitDescriptorResponsePayloadMinSize - sizeof(entity::model::ConfigurationIndex) - sizeof(std::uint16_t));
+	auto const numberOfSamplingRates = static_cast<std::uint16_t>(audioUnitDescriptor.samplingRates.size());
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::AudioUnit, audioUnitIndex);
+
+	// Audio unit descriptor - Clause 7.2.3
+	ser << audioUnitDescriptor.objectName;
+	ser << audioUnitDescriptor.localizedDescription << audioUnitDescriptor.clockDomainIndex;
+	ser << audioUnitDescriptor.numberOfStreamInputPorts << audioUnitDescriptor.baseStreamInputPort;
+	ser << audioUnitDescriptor.numberOfStreamOutputPorts << audioUnitDescriptor.baseStreamOutputPort;
+	ser << audioUnitDescriptor.numberOfExternalInputPorts << audioUnitDescriptor.baseExternalInputPort;
+	ser << audioUnitDescriptor.numberOfExternalOutputPorts << audioUnitDescriptor.baseExternalOutputPort;
+	ser << audioUnitDescriptor.numberOfInternalInputPorts << audioUnitDescriptor.baseInternalInputPort;
+	ser << audioUnitDescriptor.numberOfInternalOutputPorts << audioUnitDescriptor.baseInternalOutputPort;
+	ser << audioUnitDescriptor.numberOfControls << audioUnitDescriptor.baseControl;
+	ser << audioUnitDescriptor.numberOfSignalSelectors << audioUnitDescriptor.baseSignalSelector;
+	ser << audioUnitDescriptor.numberOfMixers << audioUnitDescriptor.baseMixer;
+	ser << audioUnitDescriptor.numberOfMatrices << audioUnitDescriptor.baseMatrix;
+	ser << audioUnitDescriptor.numberOfSplitters << audioUnitDescriptor.baseSplitter;
+	ser << audioUnitDescriptor.numberOfCombiners << audioUnitDescriptor.baseCombiner;
+	ser << audioUnitDescriptor.numberOfDemultiplexers << audioUnitDescriptor.baseDemultiplexer;
+	ser << audioUnitDescriptor.numberOfMultiplexers << audioUnitDescriptor.baseMultiplexer;
+	ser << audioUnitDescriptor.numberOfTranscoders << audioUnitDescriptor.baseTranscoder;
+	ser << audioUnitDescriptor.numberOfControlBlocks << audioUnitDescriptor.baseControlBlock;
+	ser << audioUnitDescriptor.currentSamplingRate << samplingRatesOffset << numberOfSamplingRates;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadAudioUnitDescriptorResponsePayloadMinSize, "Used bytes do not match the protocol constant");
+
+	for (auto const& rate : audioUnitDescriptor.samplingRates)
+	{
+		ser << rate;
+	}
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadStreamDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::StreamIndex const streamIndex, entity::model::StreamDescriptor const& streamDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+	auto formatsOffset = static_cast<std::uint16_t>(AecpAemReadStreamDescriptorResponsePayloadMinSize - sizeof(entity::model::ConfigurationIndex) - sizeof(std::uint16_t));
+	auto const numberOfFormats = static_cast<std::uint16_t>(streamDescriptor.formats.size());
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	// AVnu Alliance 'Network Redundancy' extension fields are placed right after the static part, formats being pushed further
+	formatsOffset += static_cast<std::uint16_t>(2 * sizeof(std::uint16_t));
+	auto const redundantOffset = static_cast<std::uint16_t>(formatsOffset + numberOfFormats * sizeof(std::uint64_t));
+	auto const numberOfRedundantStreams = static_cast<std::uint16_t>(streamDescriptor.redundantStreams.size());
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, descriptorType, streamIndex);
+
+	// Stream descriptor - Clause 7.2.6
+	ser << streamDescriptor.objectName;
+	ser << streamDescriptor.localizedDescription << streamDescriptor.clockDomainIndex << streamDescriptor.streamFlags;
+	ser << streamDescriptor.currentFormat << formatsOffset << numberOfFormats;
+	ser << streamDescriptor.backupTalkerEntityID_0 << streamDescriptor.backupTalkerUniqueID_0;
+	ser << streamDescriptor.backupTalkerEntityID_1 << streamDescriptor.backupTalkerUniqueID_1;
+	ser << streamDescriptor.backupTalkerEntityID_2 << streamDescriptor.backupTalkerUniqueID_2;
+	ser << streamDescriptor.backedupTalkerEntityID << streamDescriptor.backedupTalkerUnique;
+	ser << streamDescriptor.avbInterfaceIndex << streamDescriptor.bufferLength;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadStreamDescriptorResponsePayloadMinSize, "Used bytes do not match the protocol constant");
+
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	ser << redundantOffset << numberOfRedundantStreams;
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+
+	for (auto const& format : streamDescriptor.formats)
+	{
+		ser << format;
+	}
+
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	for (auto const redundantStreamIndex : streamDescriptor.redundantStreams)
+	{
+		ser << redundantStreamIndex;
+	}
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadJackDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::JackIndex const jackIndex, entity::model::JackDescriptor const& jackDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, descriptorType, jackIndex);
+
+	// Jack descriptor - Clause 7.2.7
+	ser << jackDescriptor.objectName;
+	ser << jackDescriptor.localizedDescription;
+	ser << jackDescriptor.jackFlags << jackDescriptor.jackType;
+	ser << jackDescriptor.numberOfControls << jackDescriptor.baseControl;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadJackDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAvbInterfaceDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::AvbInterfaceIndex const avbInterfaceIndex, entity::model::AvbInterfaceDescriptor const& avbInterfaceDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::AvbInterface, avbInterfaceIndex);
+
+	// Avb interface descriptor - Clause 7.2.8
+	ser << avbInterfaceDescriptor.objectName;
+	ser << avbInterfaceDescriptor.localizedDescription;
+	ser << avbInterfaceDescriptor.macAddress;
+	ser << avbInterfaceDescriptor.interfaceFlags;
+	ser << avbInterfaceDescriptor.clockIdentity;
+	ser << avbInterfaceDescriptor.priority1 << avbInterfaceDescriptor.clockClass;
+	ser << avbInterfaceDescriptor.offsetScaledLogVariance << avbInterfaceDescriptor.clockAccuracy;
+	ser << avbInterfaceDescriptor.priority2 << avbInterfaceDescriptor.domainNumber;
+	ser << avbInterfaceDescriptor.logSyncInterval << avbInterfaceDescriptor.logAnnounceInterval << avbInterfaceDescriptor.logPDelayInterval;
+	ser << avbInterfaceDescriptor.portNumber;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadAvbInterfaceDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadClockSourceDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClockSourceIndex const clockSourceIndex, entity::model::ClockSourceDescriptor const& clockSourceDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::ClockSource, clockSourceIndex);
+
+	// Clock source descriptor - Clause 7.2.9
+	ser << clockSourceDescriptor.objectName;
+	ser << clockSourceDescriptor.localizedDescription;
+	ser << clockSourceDescriptor.clockSourceFlags << clockSourceDescriptor.clockSourceType;
+	ser << clockSourceDescriptor.clockSourceIdentifier;
+	ser << clockSourceDescriptor.clockSourceLocationType << clockSourceDescriptor.clockSourceLocationIndex;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadClockSourceDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadMemoryObjectDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::MemoryObjectIndex const memoryObjectIndex, entity::model::MemoryObjectDescriptor const& memoryObjectDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::MemoryObject, memoryObjectIndex);
+
+	// Memory object descriptor - Clause 7.2.10
+	ser << memoryObjectDescriptor.objectName;
+	ser << memoryObjectDescriptor.localizedDescription;
+	ser << memoryObjectDescriptor.memoryObjectType;
+	ser << memoryObjectDescriptor.targetDescriptorType << memoryObjectDescriptor.targetDescriptorIndex;
+	ser << memoryObjectDescriptor.startAddress << memoryObjectDescriptor.maximumLength << memoryObjectDescriptor.length;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadMemoryObjectDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadLocaleDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::LocaleIndex const localeIndex, entity::model::LocaleDescriptor const& localeDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::Locale, localeIndex);
+
+	// Locale descriptor - Clause 7.2.11
+	ser << localeDescriptor.localeID;
+	ser << localeDescriptor.numberOfStringDescriptors << localeDescriptor.baseStringDescriptorIndex;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadLocaleDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadStringsDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::StringsIndex const stringsIndex, entity::model::StringsDescriptor const& stringsDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::Strings, stringsIndex);
+
+	// Strings descriptor - Clause 7.2.12
+	for (auto const& str : stringsDescriptor.strings)
+	{
+		ser << str;
+	}
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadStringsDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadStreamPortDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::StreamPortIndex const streamPortIndex, entity::model::StreamPortDescriptor const& streamPortDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, descriptorType, streamPortIndex);
+
+	// Stream port descriptor - Clause 7.2.13
+	ser << streamPortDescriptor.clockDomainIndex << streamPortDescriptor.portFlags;
+	ser << streamPortDescriptor.numberOfControls << streamPortDescriptor.baseControl;
+	ser << streamPortDescriptor.numberOfClusters << streamPortDescriptor.baseCluster;
+	ser << streamPortDescriptor.numberOfMaps << streamPortDescriptor.baseMap;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadStreamPortDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadExternalPortDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::ExternalPortIndex const externalPortIndex, entity::model::ExternalPortDescriptor const& externalPortDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, descriptorType, externalPortIndex);
+
+	// External port descriptor - Clause 7.2.14
+	ser << externalPortDescriptor.clockDomainIndex << externalPortDescriptor.portFlags;
+	ser << externalPortDescriptor.numberOfControls << externalPortDescriptor.baseControl;
+	ser << externalPortDescriptor.signalType << externalPortDescriptor.signalIndex << externalPortDescriptor.signalOutput;
+	ser << externalPortDescriptor.blockLatency << externalPortDescriptor.jackIndex;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadExternalPortDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadInternalPortDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::InternalPortIndex const internalPortIndex, entity::model::InternalPortDescriptor const& internalPortDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, descriptorType, internalPortIndex);
+
+	// Internal port descriptor - Clause 7.2.15
+	ser << internalPortDescriptor.clockDomainIndex << internalPortDescriptor.portFlags;
+	ser << internalPortDescriptor.numberOfControls << internalPortDescriptor.baseControl;
+	ser << internalPortDescriptor.signalType << internalPortDescriptor.signalIndex << internalPortDescriptor.signalOutput;
+	ser << internalPortDescriptor.blockLatency << internalPortDescriptor.internalIndex;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadInternalPortDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAudioClusterDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClusterIndex const clusterIndex, entity::model::AudioClusterDescriptor const& audioClusterDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::AudioCluster, clusterIndex);
+
+	// Audio cluster descriptor - Clause 7.2.16
+	ser << audioClusterDescriptor.objectName;
+	ser << audioClusterDescriptor.localizedDescription;
+	ser << audioClusterDescriptor.signalType << audioClusterDescriptor.signalIndex << audioClusterDescriptor.signalOutput;
+	ser << audioClusterDescriptor.pathLatency << audioClusterDescriptor.blockLatency;
+	ser << audioClusterDescriptor.channelCount << audioClusterDescriptor.format;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadAudioClusterDescriptorResponsePayloadSize, "Used bytes do not match the protocol constant");
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAudioMapDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::MapIndex const mapIndex, entity::model::AudioMapDescriptor const& audioMapDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+	// Clause 7.2.19 says the mappings_offset field is from the base of the descriptor, which is not where our serializer buffer starts
+	auto const mappingsOffset = static_cast<std::uint16_t>(AecpAemReadAudioMapDescriptorResponsePayloadMinSize - sizeof(entity::model::ConfigurationIndex) - sizeof(std::uint16_t));
+	auto const numberOfMappings = static_cast<std::uint16_t>(audioMapDescriptor.mappings.size());
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::AudioMap, mapIndex);
+
+	// Audio map descriptor - Clause 7.2.19
+	ser << mappingsOffset << numberOfMappings;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadAudioMapDescriptorResponsePayloadMinSize, "Used bytes do not match the protocol constant");
+
+	for (auto const& mapping : audioMapDescriptor.mappings)
+	{
+		ser << mapping.streamIndex << mapping.streamChannel << mapping.clusterOffset << mapping.clusterChannel;
+	}
+
+	return ser;
+}
+
+static inline void createPackFullControlValuesDispatchTable(std::unordered_map<entity::model::ControlValueType::Type, std::function<void(Serializer<AemAecpdu::MaximumSendPayloadBufferLength>&, entity::model::ControlValues const&, entity::model::ControlValues const&)>>& dispatchTable)
+{
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearInt8] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearInt8>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearUInt8] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearUInt8>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearInt16] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearInt16>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearUInt16] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearUInt16>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearInt32] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearInt32>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearUInt32] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearUInt32>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearInt64] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearInt64>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearUInt64] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearUInt64>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearFloat] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearFloat>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlLinearDouble] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlLinearDouble>::packFullControlValues;
+	dispatchTable[entity::model::ControlValueType::Type::ControlUtf8] = control_values_payload_traits<entity::model::ControlValueType::Type::ControlUtf8>::packFullControlValues;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadControlDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ControlIndex const controlIndex, entity::model::ControlDescriptor const& controlDescriptor)
+{
+	static auto s_Dispatch = std::unordered_map<entity::model::ControlValueType::Type, std::function<void(Serializer<AemAecpdu::MaximumSendPayloadBufferLength>&, entity::model::ControlValues const&, entity::model::ControlValues const&)>>{};
+
+	if (s_Dispatch.empty())
+	{
+		// Create the dispatch table
+		createPackFullControlValuesDispatchTable(s_Dispatch);
+	}
+
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+	// Clause 7.2.22 says the values_offset field is from the base of the descriptor, which is not where our serializer buffer starts
+	auto const valuesOffset = static_cast<std::uint16_t>(AecpAemReadControlDescriptorResponsePayloadMinSize - sizeof(entity::model::ConfigurationIndex) - sizeof(std::uint16_t));
+	auto const numberOfValues = static_cast<std::uint16_t>(controlDescriptor.valuesStatic.size());
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::Control, controlIndex);
+
+	// Control descriptor - Clause 7.2.22
+	ser << controlDescriptor.objectName << controlDescriptor.localizedDescription;
+	ser << controlDescriptor.blockLatency << controlDescriptor.controlLatency << controlDescriptor.controlDomain;
+	ser << controlDescriptor.controlValueType << controlDescriptor.controlType << controlDescriptor.resetTime;
+	ser << valuesOffset << numberOfValues;
+	ser << controlDescriptor.signalType << controlDescriptor.signalIndex << controlDescriptor.signalOutput;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadControlDescriptorResponsePayloadMinSize, "Used bytes do not match the protocol constant");
+
+	// Pack Control Values based on ControlValueType
+	auto const valueType = controlDescriptor.controlValueType.getType();
+	if (auto const& it = s_Dispatch.find(valueType); it != s_Dispatch.end())
+	{
+		it->second(ser, controlDescriptor.valuesStatic, controlDescriptor.valuesDynamic);
+	}
+	else
+	{
+		LOG_AEM_PAYLOAD_TRACE("serializeReadControlDescriptorResponse warning: Unsupported ControlValueType: {}", valueType);
+		throw UnsupportedValueException();
+	}
+
+	return ser;
+}
+
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadClockDomainDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClockDomainIndex const clockDomainIndex, entity::model::ClockDomainDescriptor const& clockDomainDescriptor)
+{
+	Serializer<AemAecpdu::MaximumSendPayloadBufferLength> ser;
+	// Clause 7.2.32 says the clock_sources_offset field is from the base of the descriptor, which is not where our serializer buffer starts
+	auto const clockSourcesOffset = static_cast<std::uint16_t>(AecpAemReadClockDomainDescriptorResponsePayloadMinSize - sizeof(entity::model::ConfigurationIndex) - sizeof(std::uint16_t));
+	auto const numberOfClockSources = static_cast<std::uint16_t>(clockDomainDescriptor.clockSources.size());
+
+	serializeReadDescriptorCommonResponse(ser, configurationIndex, entity::model::DescriptorType::ClockDomain, clockDomainIndex);
+
+	// Clock domain descriptor - Clause 7.2.32
+	ser << clockDomainDescriptor.objectName;
+	ser << clockDomainDescriptor.localizedDescription;
+	ser << clockDomainDescriptor.clockSourceIndex;
+	ser << clockSourcesOffset << numberOfClockSources;
+
+	AVDECC_ASSERT(ser.usedBytes() == AecpAemReadClockDomainDescriptorResponsePayloadMinSize, "Used bytes do not match the protocol constant");
+
+	for (auto const clockSourceIndex : clockDomainDescriptor.clockSources)
+	{
+		ser << clockSourceIndex;
+	}
+
+	return ser;
+}
 
 std::tuple<size_t, entity::model::ConfigurationIndex, entity::model::DescriptorType, entity::model::DescriptorIndex> deserializeReadDescriptorCommonResponse(AemAecpdu::Payload const& payload)
 {
@@ -95,7 +95,23 @@ Serializer<AecpAemReadDescriptorCommandPayloadSize> serializeReadDescriptorComma
 std::tuple<entity::model::ConfigurationIndex, entity::model::DescriptorType, entity::model::DescriptorIndex> deserializeReadDescriptorCommand(AemAecpdu::Payload const& payload);
 
 /** READ_DESCRIPTOR Response - Clause 7.4.5.2 */
-//Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::DescriptorIndex const descriptorIndex);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadEntityDescriptorResponse(entity::model::EntityDescriptor const& entityDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadConfigurationDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ConfigurationDescriptor const& configurationDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAudioUnitDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::AudioUnitIndex const audioUnitIndex, entity::model::AudioUnitDescriptor const& audioUnitDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadStreamDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::StreamIndex const streamIndex, entity::model::StreamDescriptor const& streamDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadJackDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::JackIndex const jackIndex, entity::model::JackDescriptor const& jackDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAvbInterfaceDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::AvbInterfaceIndex const avbInterfaceIndex, entity::model::AvbInterfaceDescriptor const& avbInterfaceDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadClockSourceDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClockSourceIndex const clockSourceIndex, entity::model::ClockSourceDescriptor const& clockSourceDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadMemoryObjectDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::MemoryObjectIndex const memoryObjectIndex, entity::model::MemoryObjectDescriptor const& memoryObjectDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadLocaleDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::LocaleIndex const localeIndex, entity::model::LocaleDescriptor const& localeDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadStringsDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::StringsIndex const stringsIndex, entity::model::StringsDescriptor const& stringsDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadStreamPortDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::StreamPortIndex const streamPortIndex, entity::model::StreamPortDescriptor const& streamPortDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadExternalPortDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::ExternalPortIndex const externalPortIndex, entity::model::ExternalPortDescriptor const& externalPortDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadInternalPortDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::DescriptorType const descriptorType, entity::model::InternalPortIndex const internalPortIndex, entity::model::InternalPortDescriptor const& internalPortDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAudioClusterDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClusterIndex const clusterIndex, entity::model::AudioClusterDescriptor const& audioClusterDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadAudioMapDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::MapIndex const mapIndex, entity::model::AudioMapDescriptor const& audioMapDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadControlDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ControlIndex const controlIndex, entity::model::ControlDescriptor const& controlDescriptor);
+Serializer<AemAecpdu::MaximumSendPayloadBufferLength> serializeReadClockDomainDescriptorResponse(entity::model::ConfigurationIndex const configurationIndex, entity::model::ClockDomainIndex const clockDomainIndex, entity::model::ClockDomainDescriptor const& clockDomainDescriptor);
 std::tuple<size_t, entity::model::ConfigurationIndex, entity::model::DescriptorType, entity::model::DescriptorIndex> deserializeReadDescriptorCommonResponse(AemAecpdu::Payload const& payload);
 entity::model::EntityDescriptor deserializeReadEntityDescriptorResponse(AemAecpdu::Payload const& payload, size_t const commonSize, AemAecpStatus const status);
 entity::model::ConfigurationDescriptor deserializeReadConfigurationDescriptorResponse(AemAecpdu::Payload const& payload, size_t const commonSize, AemAecpStatus const status);
@@ -0,0 +1,241 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file entityFilter.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/protocolAvtpdu.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolDefines.hpp"
+#include "entityFilter.hpp"
+
+#include <limits>
+#include <optional>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace entityFilter
+{
+namespace
+{
+constexpr auto AcceptedLength = std::uint32_t{ 0x0000FFFF };
+constexpr auto EtherTypeOffset = std::uint32_t{ 12u };
+constexpr auto SubTypeOffset = static_cast<std::uint32_t>(EtherLayer2::HeaderLength); // CD + SubType
+constexpr auto TargetEntityIDOffset = SubTypeOffset + 4u; // StreamID field of the AVTP control header
+constexpr auto ControllerEntityIDOffset = static_cast<std::uint32_t>(EtherLayer2::HeaderLength + AvtpduControl::HeaderLength);
+constexpr auto ControlFrameBit = std::uint32_t{ 0x80 };
+constexpr auto MulticastBit = std::uint32_t{ 0x01 };
+
+/** Generates a program with symbolic jumps to the final 'accept' and 'drop' instructions */
+class ProgramBuilder final
+{
+public:
+	// Jump targets: a non-negative value is the number of instructions to skip
+	static constexpr auto Accept = -1;
+	static constexpr auto Drop = -2;
+
+	void load(std::uint16_t const code, std::uint32_t const offset)
+	{
+		_program.push_back(Instruction{ code, 0u, 0u, offset });
+		_targets.push_back({ 0, 0 });
+	}
+
+	void jump(std::uint16_t const code, std::uint32_t const value, int const targetIfTrue, int const targetIfFalse)
+	{
+		_program.push_back(Instruction{ code, 0u, 0u, value });
+		_targets.push_back({ targetIfTrue, targetIfFalse });
+	}
+
+	/** Jumps to 'accept' if the 64 bits value at offset equals entityID, continues otherwise */
+	void acceptEntityID(std::uint32_t const offset, UniqueIdentifier const entityID)
+	{
+		auto const value = entityID.getValue();
+		load(LoadWordAbsolute, offset);
+		jump(JumpIfEqual, static_cast<std::uint32_t>(value >> 32), 0, 2);
+		load(LoadWordAbsolute, offset + 4u);
+		jump(JumpIfEqual, static_cast<std::uint32_t>(value & 0xFFFFFFFF), Accept, 0);
+	}
+
+	/** Terminates the program (falling through to 'drop') and resolves the jumps. Returns nothing if a jump is too far for a classic BPF relative jump. */
+	std::optional<Program> build()
+	{
+		auto const dropIndex = _program.size();
+		auto const acceptIndex = dropIndex + 1u;
+		_program.push_back(Instruction{ Return, 0u, 0u, 0u });
+		_program.push_back(Instruction{ Return, 0u, 0u, AcceptedLength });
+
+		auto const resolve = [dropIndex, acceptIndex](std::size_t const index, int const target, std::uint8_t& offset)
+		{
+			auto distance = static_cast<std::size_t>(target);
+			if (target == Accept)
+			{
+				distance = acceptIndex - index - 1u;
+			}
+			else if (target == Drop)
+			{
+				distance = dropIndex - index - 1u;
+			}
+			if (distance > std::numeric_limits<std::uint8_t>::max())
+			{
+				return false;
+			}
+			offset = static_cast<std::uint8_t>(distance);
+			return true;
+		};
+
+		for (auto index = std::size_t{ 0u }; index < _targets.size(); ++index)
+		{
+			auto& instruction = _program[index];
+			auto const& [targetIfTrue, targetIfFalse] = _targets[index];
+			if (!resolve(index, targetIfTrue, instruction.jt) || !resolve(index, targetIfFalse, instruction.jf))
+			{
+				return std::nullopt;
+			}
+		}
+
+		return std::move(_program);
+	}
+
+private:
+	Program _program{};
+	std::vector<std::pair<int, int>> _targets{};
+};
+
+/** Only lets AVTP control frames go through, then jumps to targetIfAvdecc */
+void filterAvdeccFrames(ProgramBuilder& builder, int const targetIfAvdecc)
+{
+	builder.load(LoadHalfAbsolute, EtherTypeOffset);
+	builder.jump(JumpIfEqual, AvtpEtherType, 0, ProgramBuilder::Drop);
+	builder.load(LoadByteAbsolute, SubTypeOffset);
+	builder.jump(JumpIfSet, ControlFrameBit, targetIfAvdecc, ProgramBuilder::Drop);
+}
+} // namespace
+
+Program makeAvdeccProgram()
+{
+	auto builder = ProgramBuilder{};
+
+	filterAvdeccFrames(builder, ProgramBuilder::Accept);
+
+	// Cannot fail, all jumps are short
+	return *builder.build();
+}
+
+Program makeLocalEntitiesProgram(std::vector<UniqueIdentifier> const& entityIDs)
+{
+	auto builder = ProgramBuilder{};
+
+	filterAvdeccFrames(builder, 0);
+
+	// Accept everything but AECP (the SubType is still in the accumulator)
+	builder.jump(JumpIfEqual, ControlFrameBit | AvtpSubType_Aecp, 0, ProgramBuilder::Accept);
+
+	// Accept multicast AECP (IDENTIFY notifications, ...)
+	builder.load(LoadByteAbsolute, 0u);
+	builder.jump(JumpIfSet, MulticastBit, ProgramBuilder::Accept, 0);
+
+	// Accept commands targeting one of our entities
+	for (auto const& entityID : entityIDs)
+	{
+		builder.acceptEntityID(TargetEntityIDOffset, entityID);
+	}
+
+	// Accept responses to commands sent by one of our entities
+	for (auto const& entityID : entityIDs)
+	{
+		builder.acceptEntityID(ControllerEntityIDOffset, entityID);
+	}
+	builder.acceptEntityID(ControllerEntityIDOffset, AemAecpdu::Identify_ControllerEntityID);
+
+	if (auto program = builder.build())
+	{
+		return std::move(*program);
+	}
+
+	// Too many entities, only filter AVDECC frames
+	return makeAvdeccProgram();
+}
+
+bool accepts(Program const& program, std::uint8_t const* const frame, std::size_t const length) noexcept
+{
+	auto accumulator = std::uint32_t{ 0u };
+	auto const load = [frame, length, &accumulator](std::uint32_t const offset, std::size_t const size)
+	{
+		if (offset + size > length)
+		{
+			return false;
+		}
+		accumulator = 0u;
+		for (auto i = std::size_t{ 0u }; i < size; ++i)
+		{
+			accumulator = (accumulator << 8) | frame[offset + i];
+		}
+		return true;
+	};
+
+	// Jumps are always forward, the program cannot loop
+	for (auto pc = std::size_t{ 0u }; pc < program.size(); ++pc)
+	{
+		auto const& instruction = program[pc];
+		switch (instruction.code)
+		{
+			case LoadWordAbsolute:
+				if (!load(instruction.k, 4u))
+				{
+					return false;
+				}
+				break;
+			case LoadHalfAbsolute:
+				if (!load(instruction.k, 2u))
+				{
+					return false;
+				}
+				break;
+			case LoadByteAbsolute:
+				if (!load(instruction.k, 1u))
+				{
+					return false;
+				}
+				break;
+			case JumpIfEqual:
+				pc += (accumulator == instruction.k) ? instruction.jt : instruction.jf;
+				break;
+			case JumpIfSet:
+				pc += ((accumulator & instruction.k) != 0u) ? instruction.jt : instruction.jf;
+				break;
+			case Return:
+				return instruction.k != 0u;
+			default:
+				return false;
+		}
+	}
+
+	return false;
+}
+
+} // namespace entityFilter
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,86 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file entityFilter.hpp
+* @author Christophe Calmejane
+* @brief Kernel (classic BPF) filter programs dropping the AVDECC frames not relevant to the registered local entities.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/uniqueIdentifier.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace entityFilter
+{
+/** Classic BPF instruction, same layout than linux 'struct sock_filter' and libpcap 'struct bpf_insn' */
+struct Instruction
+{
+	std::uint16_t code{ 0u };
+	std::uint8_t jt{ 0u };
+	std::uint8_t jf{ 0u };
+	std::uint32_t k{ 0u };
+};
+
+using Program = std::vector<Instruction>;
+
+/** Classic BPF opcodes used by the generated programs */
+static constexpr auto LoadWordAbsolute = std::uint16_t{ 0x20 }; // BPF_LD | BPF_W | BPF_ABS
+static constexpr auto LoadHalfAbsolute = std::uint16_t{ 0x28 }; // BPF_LD | BPF_H | BPF_ABS
+static constexpr auto LoadByteAbsolute = std::uint16_t{ 0x30 }; // BPF_LD | BPF_B | BPF_ABS
+static constexpr auto JumpIfEqual = std::uint16_t{ 0x15 }; // BPF_JMP | BPF_JEQ | BPF_K
+static constexpr auto JumpIfSet = std::uint16_t{ 0x45 }; // BPF_JMP | BPF_JSET | BPF_K
+static constexpr auto Return = std::uint16_t{ 0x06 }; // BPF_RET | BPF_K
+
+/** Returns a program accepting all AVDECC frames (AVTP control frames), and nothing else. */
+Program makeAvdeccProgram();
+
+/**
+* @brief Returns a program only accepting the AVDECC frames relevant to the specified local entities.
+* @details All AVDECC frames but AECP ones are accepted (ADP, ACMP, ...). AECP frames are only accepted if sent to a multicast address,
+*          or if their target_entity_id or controller_entity_id is one of the specified entities (the controller_entity_id is also accepted if it's the IDENTIFY notification one).
+*          If there are too many entities for the program to be expressed with classic BPF relative jumps, the program returned by makeAvdeccProgram is returned.
+* @param[in] entityIDs The EntityIDs of the local entities.
+*/
+Program makeLocalEntitiesProgram(std::vector<UniqueIdentifier> const& entityIDs);
+
+/**
+* @brief Runs a program generated by this module on a frame, in userland (for transports without kernel filtering, like the proxy server).
+* @details Only the opcodes used by the generated programs are supported, any other opcode (as well as an out of bounds load) drops the frame.
+* @param[in] program The program to run.
+* @param[in] frame The ethernet frame, starting with the ethernet header.
+* @param[in] length The length of the frame.
+* @return True if the frame is accepted by the program.
+*/
+bool accepts(Program const& program, std::uint8_t const* const frame, std::size_t const length) noexcept;
+
+} // namespace entityFilter
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,384 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameDecoder.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/serialization.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolAaAecpdu.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "frameDecoder.hpp"
+#include "logHelper.hpp"
+#include "dispatchTable.hpp"
+
+#include <stdexcept>
+#include <cstring>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+static void deserializeAecpMessage(EtherLayer2 const& etherLayer2, DeserializationBuffer& des, Aecpdu& aecp)
+{
+	// Fill EtherLayer2
+	aecp.setSrcAddress(etherLayer2.getSrcAddress());
+	aecp.setDestAddress(etherLayer2.getDestAddress());
+	// Then deserialize Avtp control
+	deserialize<AvtpduControl>(&aecp, des);
+	// Then deserialize Aecp
+	deserialize<Aecpdu>(&aecp, des);
+}
+
+static bool getVendorUniqueProtocolIdentifier(std::uint8_t const* const avtpdu, std::size_t const avtpduLength, VuAecpdu::ProtocolIdentifier& protocolIdentifier) noexcept
+{
+	auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
+	if (avtpduLength < (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifier::Size))
+	{
+		return false;
+	}
+
+	auto identifier = VuAecpdu::ProtocolIdentifier::ArrayType{};
+	std::memcpy(identifier.data(), avtpdu + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifier::Size);
+	protocolIdentifier = VuAecpdu::ProtocolIdentifier{ identifier };
+	return true;
+}
+
+FrameDecoder::FrameDecoder(ProtocolInterface& protocolInterface, Delegate& delegate, stateMachine::Manager& stateMachineManager) noexcept
+	: _protocolInterface{ protocolInterface }
+	, _delegate{ delegate }
+	, _stateMachineManager{ stateMachineManager }
+{
+}
+
+FrameDecoder::Timestamp FrameDecoder::fromKernelTimestamp(std::chrono::nanoseconds const realTime) noexcept
+{
+	auto const steadyNow = std::chrono::steady_clock::now();
+	auto const frameAge = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()) - realTime;
+
+	if (realTime.count() == 0 || frameAge.count() < 0 || frameAge > MaximumFrameAge)
+	{
+		return steadyNow;
+	}
+
+	return steadyNow - std::chrono::duration_cast<std::chrono::steady_clock::duration>(frameAge);
+}
+
+FrameDecoder::DecodedFrame FrameDecoder::decode(std::uint8_t const* const frame, std::size_t const length, Timestamp const receiveTime) noexcept
+{
+	auto decodedFrame = DecodedFrame{};
+	decodedFrame.receiveTime = receiveTime;
+
+	_protocolInterface.recordReceivedFrame(frame, length);
+
+	// Frame forwarded as is (proxy server)
+	if (_protocolInterface.tapReceivedFrame(frame, length))
+	{
+		return decodedFrame;
+	}
+
+	// Not enough bytes for an AVTP control frame, or too many for an AVDECC one
+	if (length <= EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+	{
+		return decodedFrame;
+	}
+
+	try
+	{
+		auto des = DeserializationBuffer(frame, length);
+		auto etherLayer2 = EtherLayer2{};
+		deserialize<EtherLayer2>(&etherLayer2, des);
+
+		// Don't ignore self mac, another entity might be on the computer
+
+		// Check ether type (shouldn't be needed if the transport filters frames)
+		if (etherLayer2.getEtherType() != AvtpEtherType)
+		{
+			return decodedFrame;
+		}
+
+		auto const* const avtpdu = frame + EtherLayer2::HeaderLength; // Start of AVB Transport Protocol
+		auto const avtpduLength = length - EtherLayer2::HeaderLength;
+
+		// Check AVTP control bit (meaning AVDECC packet)
+		if ((avtpdu[0] & 0xF0) == 0)
+		{
+			return decodedFrame;
+		}
+
+		// Read Avtpdu SubType and ControlData (which is remapped to MessageType for all 1722.1 messages)
+		auto const subType = static_cast<std::uint8_t>(avtpdu[0] & 0x7f);
+		auto const controlData = static_cast<std::uint8_t>(avtpdu[1] & 0x7f);
+
+		switch (subType)
+		{
+			/* ADP Message */
+			case AvtpSubType_Adp:
+			{
+				auto adpdu = _pduPools.adpdu.acquire();
+				auto& adp = static_cast<Adpdu&>(*adpdu);
+
+				// Fill EtherLayer2
+				adp.setSrcAddress(etherLayer2.getSrcAddress());
+				adp.setDestAddress(etherLayer2.getDestAddress());
+				// Then deserialize Avtp control
+				deserialize<AvtpduControl>(&adp, des);
+				// Then deserialize Adp
+				deserialize<Adpdu>(&adp, des);
+
+				decodedFrame.adpdu = std::move(adpdu);
+				decodedFrame.route = Route::StateMachine;
+				break;
+			}
+
+			/* AECP Message */
+			case AvtpSubType_Aecp:
+			{
+				// Create aecpdu frame based on message type
+				auto aecpdu = createAecpdu(AecpMessageType{ controlData }, avtpdu, avtpduLength, decodedFrame);
+				if (aecpdu != nullptr)
+				{
+					// Deserialize the aecp message
+					deserializeAecpMessage(etherLayer2, des, *aecpdu);
+
+					decodedFrame.aecpdu = std::move(aecpdu);
+				}
+				else
+				{
+					decodedFrame = DecodedFrame{};
+				}
+				break;
+			}
+
+			/* ACMP Message */
+			case AvtpSubType_Acmp:
+			{
+				auto acmpdu = _pduPools.acmpdu.acquire();
+				auto& acmp = static_cast<Acmpdu&>(*acmpdu);
+
+				// Fill EtherLayer2
+				acmp.setSrcAddress(etherLayer2.getSrcAddress());
+				static_cast<EtherLayer2&>(acmp).setDestAddress(etherLayer2.getDestAddress()); // Fill dest address, even if we know it's always the MultiCast address
+				// Then deserialize Avtp control
+				deserialize<AvtpduControl>(&acmp, des);
+				// Then deserialize Acmp
+				deserialize<Acmpdu>(&acmp, des);
+
+				decodedFrame.acmpdu = std::move(acmpdu);
+				decodedFrame.route = Route::StateMachine;
+				break;
+			}
+
+			/* MAAP Message */
+			case AvtpSubType_Maap:
+			default:
+				break;
+		}
+	}
+	catch ([[maybe_unused]] std::invalid_argument const& e)
+	{
+		LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, std::string("FrameDecoder: Packet dropped: ") + e.what());
+		decodedFrame = DecodedFrame{};
+	}
+	catch (...)
+	{
+		AVDECC_ASSERT(false, "Unknown exception");
+		LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "FrameDecoder: Packet dropped due to unknown exception");
+		decodedFrame = DecodedFrame{};
+	}
+
+	return decodedFrame;
+}
+
+void FrameDecoder::route(DecodedFrame&& decodedFrame) noexcept
+{
+	switch (decodedFrame.route)
+	{
+		case Route::StateMachine:
+		{
+			if (decodedFrame.adpdu)
+			{
+				// Low level notification
+				_delegate.onAdpduDecoded(*decodedFrame.adpdu);
+
+				// Forward to our state machine
+				_stateMachineManager.processAdpdu(*decodedFrame.adpdu);
+			}
+			else if (decodedFrame.aecpdu)
+			{
+				// Low level notification
+				_delegate.onAecpduDecoded(*decodedFrame.aecpdu);
+
+				// Forward to our state machine
+				_stateMachineManager.processAecpdu(*decodedFrame.aecpdu, decodedFrame.receiveTime);
+			}
+			else if (decodedFrame.acmpdu)
+			{
+				// Low level notification
+				_delegate.onAcmpduDecoded(*decodedFrame.acmpdu);
+
+				// Forward to our state machine
+				_stateMachineManager.processAcmpdu(*decodedFrame.acmpdu);
+			}
+			break;
+		}
+		case Route::VendorUniqueDelegate:
+		{
+			AVDECC_ASSERT(decodedFrame.aecpdu && decodedFrame.vuDelegate, "VendorUniqueDelegate route requires an aecpdu and a delegate");
+			if (decodedFrame.aecpdu && decodedFrame.vuDelegate)
+			{
+				auto& vuAecp = static_cast<VuAecpdu&>(*decodedFrame.aecpdu);
+
+				// Low level notification
+				_delegate.onAecpduDecoded(vuAecp);
+
+				// Forward to the delegate
+				if (vuAecp.getMessageType() == AecpMessageType::VendorUniqueResponse)
+				{
+					decodedFrame.vuDelegate->onVuAecpResponse(&_protocolInterface, decodedFrame.vuProtocolIdentifier, vuAecp);
+				}
+				else
+				{
+					decodedFrame.vuDelegate->onVuAecpCommand(&_protocolInterface, decodedFrame.vuProtocolIdentifier, vuAecp);
+				}
+			}
+			break;
+		}
+		case Route::Drop:
+		default:
+			break;
+	}
+}
+
+void FrameDecoder::processFrame(std::uint8_t const* const frame, std::size_t const length, Timestamp const receiveTime) noexcept
+{
+	route(decode(frame, length, receiveTime));
+}
+
+void FrameDecoder::completeBatch() noexcept
+{
+	_protocolInterface.completeTapBatch();
+}
+
+ProtocolInterface::PduPoolStatistics FrameDecoder::getPduPoolStatistics() const noexcept
+{
+	return _pduPools.getStatistics();
+}
+
+Aecpdu::UniquePointer FrameDecoder::createAecpdu(AecpMessageType const messageType, std::uint8_t const* const avtpdu, std::size_t const avtpduLength, DecodedFrame& decodedFrame) noexcept
+{
+	static auto const s_Dispatch = DispatchTable<AecpMessageType::value_type, MessageTypeDispatchSize, Aecpdu::UniquePointer(FrameDecoder* const decoder, std::uint8_t const* const avtpdu, std::size_t const avtpduLength, DecodedFrame& decodedFrame)>{
+		{ AecpMessageType::AemCommand.getValue(),
+			[](FrameDecoder* const decoder, std::uint8_t const* const /*avtpdu*/, std::size_t const /*avtpduLength*/, DecodedFrame& decodedFrame)
+			{
+				decodedFrame.route = Route::StateMachine;
+				return decoder->_pduPools.aemAecpdu.acquire(false);
+			} },
+		{ AecpMessageType::AemResponse.getValue(),
+			[](FrameDecoder* const decoder, std::uint8_t const* const /*avtpdu*/, std::size_t const /*avtpduLength*/, DecodedFrame& decodedFrame)
+			{
+				decodedFrame.route = Route::StateMachine;
+				return decoder->_pduPools.aemAecpdu.acquire(true);
+			} },
+		{ AecpMessageType::AddressAccessCommand.getValue(),
+			[](FrameDecoder* const decoder, std::uint8_t const* const /*avtpdu*/, std::size_t const /*avtpduLength*/, DecodedFrame& decodedFrame)
+			{
+				decodedFrame.route = Route::StateMachine;
+				return decoder->_pduPools.aaAecpdu.acquire(false);
+			} },
+		{ AecpMessageType::AddressAccessResponse.getValue(),
+			[](FrameDecoder* const decoder, std::uint8_t const* const /*avtpdu*/, std::size_t const /*avtpduLength*/, DecodedFrame& decodedFrame)
+			{
+				decodedFrame.route = Route::StateMachine;
+				return decoder->_pduPools.aaAecpdu.acquire(true);
+			} },
+		{ AecpMessageType::VendorUniqueCommand.getValue(),
+			[](FrameDecoder* const decoder, std::uint8_t const* const avtpdu, std::size_t const avtpduLength, DecodedFrame& decodedFrame)
+			{
+				// We have to retrieve the ProtocolID to dispatch
+				auto vuProtocolID = VuAecpdu::ProtocolIdentifier{};
+				if (!getVendorUniqueProtocolIdentifier(avtpdu, avtpduLength, vuProtocolID))
+				{
+					LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Invalid VendorUnique Command received. Not enough bytes in the message to hold ProtocolIdentifier");
+					return Aecpdu::UniquePointer{ nullptr, nullptr };
+				}
+
+				auto* const vuDelegate = decoder->_delegate.findVendorUniqueDelegate(vuProtocolID);
+				if (!vuDelegate)
+				{
+					LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Unhandled VendorUnique Command for ProtocolIdentifier {}", utils::toHexString(static_cast<VuAecpdu::ProtocolIdentifier::IntegralType>(vuProtocolID), true));
+					return Aecpdu::UniquePointer{ nullptr, nullptr };
+				}
+
+				// VendorUnique Commands are always handled by the VendorUniqueDelegate
+				decodedFrame.route = Route::VendorUniqueDelegate;
+				decodedFrame.vuDelegate = vuDelegate;
+				decodedFrame.vuProtocolIdentifier = vuProtocolID;
+				return vuDelegate->createAecpdu(vuProtocolID, false);
+			} },
+		{ AecpMessageType::VendorUniqueResponse.getValue(),
+			[](FrameDecoder* const decoder, std::uint8_t const* const avtpdu, std::size_t const avtpduLength, DecodedFrame& decodedFrame)
+			{
+				// We have to retrieve the ProtocolID to dispatch
+				auto vuProtocolID = VuAecpdu::ProtocolIdentifier{};
+				if (!getVendorUniqueProtocolIdentifier(avtpdu, avtpduLength, vuProtocolID))
+				{
+					LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Invalid VendorUnique Response received. Not enough bytes in the message to hold ProtocolIdentifier");
+					return Aecpdu::UniquePointer{ nullptr, nullptr };
+				}
+
+				auto* const vuDelegate = decoder->_delegate.findVendorUniqueDelegate(vuProtocolID);
+				if (!vuDelegate)
+				{
+					LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Unhandled VendorUnique Response for ProtocolIdentifier {}", utils::toHexString(static_cast<VuAecpdu::ProtocolIdentifier::IntegralType>(vuProtocolID), true));
+					return Aecpdu::UniquePointer{ nullptr, nullptr };
+				}
+
+				// Are the messages handled by the VendorUniqueDelegate itself, or by the state machines
+				if (vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+				{
+					decodedFrame.route = Route::StateMachine;
+				}
+				else
+				{
+					decodedFrame.route = Route::VendorUniqueDelegate;
+					decodedFrame.vuDelegate = vuDelegate;
+					decodedFrame.vuProtocolIdentifier = vuProtocolID;
+				}
+				return vuDelegate->createAecpdu(vuProtocolID, true);
+			} },
+	};
+
+	auto const handler = s_Dispatch.get(messageType.getValue());
+	if (handler == nullptr)
+	{
+		return Aecpdu::UniquePointer{ nullptr, nullptr }; // Unsupported AECP message type
+	}
+
+	return handler(this, avtpdu, avtpduLength, decodedFrame);
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,141 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameDecoder.hpp
+* @author Christophe Calmejane
+* @brief Decoding and routing of received AVDECC frames, shared by all ProtocolInterface transports.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+#include "la/avdecc/internals/protocolAdpdu.hpp"
+#include "la/avdecc/internals/protocolAecpdu.hpp"
+#include "la/avdecc/internals/protocolAcmpdu.hpp"
+#include "la/avdecc/internals/protocolVuAecpdu.hpp"
+
+#include "stateMachine/stateMachineManager.hpp"
+#include "pduPool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Receive stage of a ProtocolInterface.
+* @details Takes raw ethernet frames as received by the transport, decodes them into typed PDUs (taken from the decoder's pools)
+*          and decides where they have to be routed (state machines or VendorUniqueDelegate). Decoding and routing are two separate
+*          steps so a transport can decode a batch of frames first and route it afterwards.
+*          To amortize the locking cost of a batch, the state machines lock can be taken by the caller for the whole batch, routing being reentrant.
+*/
+class FrameDecoder final
+{
+public:
+	enum class Route
+	{
+		Drop = 0, /**< Frame is not for us, or could not be decoded */
+		StateMachine = 1, /**< PDU must be processed by the state machines */
+		VendorUniqueDelegate = 2, /**< VendorUnique PDU must be processed by its VendorUniqueDelegate */
+	};
+
+	/** Time at which a frame was received, in the clock used by the state machines */
+	using Timestamp = std::chrono::steady_clock::time_point;
+
+	struct DecodedFrame
+	{
+		Route route{ Route::Drop };
+		Timestamp receiveTime{};
+		Adpdu::UniquePointer adpdu{ nullptr, nullptr };
+		Aecpdu::UniquePointer aecpdu{ nullptr, nullptr };
+		Acmpdu::UniquePointer acmpdu{ nullptr, nullptr };
+		ProtocolInterface::VendorUniqueDelegate* vuDelegate{ nullptr }; /**< Only set for Route::VendorUniqueDelegate */
+		VuAecpdu::ProtocolIdentifier vuProtocolIdentifier{}; /**< Only set for Route::VendorUniqueDelegate */
+	};
+
+	class Delegate
+	{
+	public:
+		virtual ~Delegate() noexcept = default;
+
+		/** Returns the VendorUniqueDelegate handling the specified protocolIdentifier, or nullptr if none has been registered. */
+		virtual ProtocolInterface::VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept = 0;
+		/** Low level notification of a decoded ADPDU, before it's routed. */
+		virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept = 0;
+		/** Low level notification of a decoded AECPDU, before it's routed. */
+		virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept = 0;
+		/** Low level notification of a decoded ACMPDU, before it's routed. */
+		virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept = 0;
+	};
+
+	/**
+	* @brief Constructor.
+	* @param[in] protocolInterface The ProtocolInterface owning this decoder (passed to the VendorUniqueDelegates).
+	* @param[in] delegate The delegate used for VendorUniqueDelegate lookup and low level notifications.
+	* @param[in] stateMachineManager The state machines routed PDUs are forwarded to.
+	* @note Only references are kept, the objects can be constructed after the decoder (but must be destroyed after the last call to the decoder).
+	*/
+	FrameDecoder(ProtocolInterface& protocolInterface, Delegate& delegate, stateMachine::Manager& stateMachineManager) noexcept;
+
+	/** Maximum time a frame can wait before being decoded, older kernel timestamps are considered invalid (system clock adjusted in between) */
+	static constexpr auto MaximumFrameAge = std::chrono::seconds{ 1 };
+
+	/** Converts a kernel receive timestamp (CLOCK_REALTIME, as found in pcap headers and TPACKET rings) to a Timestamp. Returns the current time if the kernel timestamp is not valid (null, in the future, or older than MaximumFrameAge). */
+	static Timestamp fromKernelTimestamp(std::chrono::nanoseconds const realTime) noexcept;
+
+	/** Decodes an ethernet frame (starting with the ethernet header), received at receiveTime. Frames that are not AVDECC ones, cannot be decoded, or are consumed by a frame tap, are returned with Route::Drop. */
+	DecodedFrame decode(std::uint8_t const* const frame, std::size_t const length, Timestamp const receiveTime) noexcept;
+
+	/** Notifies the delegate of the decoded PDU then forwards it according to its route. */
+	void route(DecodedFrame&& decodedFrame) noexcept;
+
+	/** Decodes and routes an ethernet frame (starting with the ethernet header), received at receiveTime. */
+	void processFrame(std::uint8_t const* const frame, std::size_t const length, Timestamp const receiveTime) noexcept;
+
+	/** Notifies the end of a batch of frames passed to decode or processFrame (must be called by the transports before releasing the state machines lock). */
+	void completeBatch() noexcept;
+
+	/** Returns the statistics of the PDU pools used by the decoder. */
+	ProtocolInterface::PduPoolStatistics getPduPoolStatistics() const noexcept;
+
+	// Deleted compiler auto-generated methods
+	FrameDecoder(FrameDecoder&&) = delete;
+	FrameDecoder(FrameDecoder const&) = delete;
+	FrameDecoder& operator=(FrameDecoder const&) = delete;
+	FrameDecoder& operator=(FrameDecoder&&) = delete;
+
+private:
+	Aecpdu::UniquePointer createAecpdu(AecpMessageType const messageType, std::uint8_t const* const avtpdu, std::size_t const avtpduLength, DecodedFrame& decodedFrame) noexcept;
+
+	// Private variables
+	ReceivePduPools _pduPools{};
+	ProtocolInterface& _protocolInterface;
+	Delegate& _delegate;
+	stateMachine::Manager& _stateMachineManager;
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,264 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameRecorder.cpp
+* @author Christophe Calmejane
+*/
+
+#include "frameRecorder.hpp"
+#include "logHelper.hpp"
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <vector>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace
+{
+constexpr auto MinimumBufferSize = std::size_t{ 64u * 1024u };
+
+// pcapng blocks and options (https://www.ietf.org/archive/id/draft-tuexen-opsawg-pcapng-03.html)
+constexpr auto SectionHeaderBlockType = std::uint32_t{ 0x0A0D0D0A };
+constexpr auto InterfaceDescriptionBlockType = std::uint32_t{ 0x00000001 };
+constexpr auto EnhancedPacketBlockType = std::uint32_t{ 0x00000006 };
+constexpr auto ByteOrderMagic = std::uint32_t{ 0x1A2B3C4D };
+constexpr auto LinkTypeEthernet = std::uint16_t{ 1u };
+constexpr auto OptionEndOfOptions = std::uint16_t{ 0u };
+constexpr auto OptionInterfaceTimestampResolution = std::uint16_t{ 9u };
+constexpr auto OptionPacketFlags = std::uint16_t{ 2u };
+constexpr auto TimestampResolutionNanoseconds = std::uint8_t{ 9u };
+
+std::size_t roundUpToPowerOfTwo(std::size_t const value) noexcept
+{
+	auto result = std::size_t{ 1u };
+	while (result < value)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+
+/** Writes pcapng blocks in native byte order (readers detect it using the ByteOrderMagic) */
+class PcapngWriter final
+{
+public:
+	explicit PcapngWriter(std::string const& filePath)
+		: _stream{ filePath, std::ios::binary | std::ios::trunc }
+	{
+	}
+
+	bool isValid() const noexcept
+	{
+		return _stream.good();
+	}
+
+	void writeSectionHeader()
+	{
+		beginBlock(SectionHeaderBlockType);
+		appendValue(ByteOrderMagic);
+		appendValue(std::uint16_t{ 1u }); // Major version
+		appendValue(std::uint16_t{ 0u }); // Minor version
+		appendValue(std::int64_t{ -1 }); // Section length not specified
+		endBlock();
+	}
+
+	void writeInterfaceDescription()
+	{
+		beginBlock(InterfaceDescriptionBlockType);
+		appendValue(LinkTypeEthernet);
+		appendValue(std::uint16_t{ 0u }); // Reserved
+		appendValue(static_cast<std::uint32_t>(EthernetMaxFrameSize)); // SnapLen
+		appendOption(OptionInterfaceTimestampResolution, &TimestampResolutionNanoseconds, sizeof(TimestampResolutionNanoseconds));
+		appendValue(OptionEndOfOptions);
+		appendValue(std::uint16_t{ 0u });
+		endBlock();
+	}
+
+	void writePacket(std::int64_t const timestamp, FrameRecorder::Direction const direction, std::uint8_t const* const frame, std::size_t const length)
+	{
+		auto const flags = static_cast<std::uint32_t>(direction);
+
+		beginBlock(EnhancedPacketBlockType);
+		appendValue(std::uint32_t{ 0u }); // InterfaceID
+		appendValue(static_cast<std::uint32_t>(static_cast<std::uint64_t>(timestamp) >> 32));
+		appendValue(static_cast<std::uint32_t>(static_cast<std::uint64_t>(timestamp) & 0xFFFFFFFF));
+		appendValue(static_cast<std::uint32_t>(length)); // Captured length
+		appendValue(static_cast<std::uint32_t>(length)); // Original length
+		appendPadded(frame, length);
+		appendOption(OptionPacketFlags, &flags, sizeof(flags));
+		appendValue(OptionEndOfOptions);
+		appendValue(std::uint16_t{ 0u });
+		endBlock();
+	}
+
+private:
+	void beginBlock(std::uint32_t const blockType)
+	{
+		_block.clear();
+		appendValue(blockType);
+		appendValue(std::uint32_t{ 0u }); // Block total length, set by endBlock
+	}
+
+	void endBlock()
+	{
+		auto const totalLength = static_cast<std::uint32_t>(_block.size() + sizeof(std::uint32_t));
+		std::memcpy(_block.data() + sizeof(std::uint32_t), &totalLength, sizeof(totalLength));
+		appendValue(totalLength);
+		_stream.write(reinterpret_cast<char const*>(_block.data()), static_cast<std::streamsize>(_block.size()));
+	}
+
+	template<typename T>
+	void appendValue(T const value)
+	{
+		auto const* const bytes = reinterpret_cast<std::uint8_t const*>(&value);
+		_block.insert(_block.end(), bytes, bytes + sizeof(value));
+	}
+
+	void appendPadded(void const* const data, std::size_t const length)
+	{
+		auto const* const bytes = static_cast<std::uint8_t const*>(data);
+		_block.insert(_block.end(), bytes, bytes + length);
+		_block.resize(_block.size() + ((4u - (length % 4u)) % 4u), 0u);
+	}
+
+	void appendOption(std::uint16_t const code, void const* const value, std::size_t const length)
+	{
+		appendValue(code);
+		appendValue(static_cast<std::uint16_t>(length));
+		appendPadded(value, length);
+	}
+
+	std::ofstream _stream{};
+	std::vector<std::uint8_t> _block{};
+};
+} // namespace
+
+FrameRecorder::FrameRecorder(std::size_t const bufferSize)
+	: _bufferSize{ bufferSize }
+	, _dataSize{ roundUpToPowerOfTwo(std::max(bufferSize, MinimumBufferSize)) }
+	, _dataMask{ _dataSize - 1u }
+	, _recordsMask{ (_dataSize / AverageFrameSize) - 1u }
+	, _data{ std::make_unique<std::uint8_t[]>(_dataSize) }
+	, _records{ std::make_unique<Record[]>(_dataSize / AverageFrameSize) }
+{
+}
+
+ProtocolInterface::Error FrameRecorder::dump(std::string const& filePath) const noexcept
+{
+	try
+	{
+		auto writer = PcapngWriter{ filePath };
+		if (!writer.isValid())
+		{
+			return ProtocolInterface::Error::InvalidParameters;
+		}
+
+		writer.writeSectionHeader();
+		writer.writeInterfaceDescription();
+
+		// Only the most recent records are still in the ring
+		auto const recordsCount = _recordsMask + 1u;
+		auto const endIndex = _recordPosition.load(std::memory_order_acquire);
+		auto const beginIndex = endIndex > recordsCount ? endIndex - recordsCount : std::uint64_t{ 0u };
+		auto frame = std::array<std::uint8_t, EthernetMaxFrameSize>{};
+
+		for (auto index = beginIndex; index < endIndex; ++index)
+		{
+			auto const& entry = _records[index & _recordsMask];
+			auto const sequence = entry.sequence.load(std::memory_order_acquire);
+			// Not yet committed, or already overwritten by a more recent frame
+			if (sequence != committedSequence(index))
+			{
+				continue;
+			}
+
+			auto const dataPosition = entry.dataPosition.load(std::memory_order_relaxed);
+			auto const timestamp = entry.timestamp.load(std::memory_order_relaxed);
+			auto const length = static_cast<std::size_t>(entry.length.load(std::memory_order_relaxed));
+			auto const direction = entry.direction.load(std::memory_order_relaxed);
+			if (length > frame.size())
+			{
+				continue;
+			}
+
+			auto const offset = static_cast<std::size_t>(dataPosition & _dataMask);
+			auto const firstPartLength = std::min(length, _dataSize - offset);
+			std::memcpy(frame.data(), _data.get() + offset, firstPartLength);
+			std::memcpy(frame.data() + firstPartLength, _data.get(), length - firstPartLength);
+
+			// Check the record and its data have not been overwritten while we were copying them
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (entry.sequence.load(std::memory_order_relaxed) != sequence || _dataPosition.load(std::memory_order_relaxed) > dataPosition + _dataSize)
+			{
+				continue;
+			}
+
+			writer.writePacket(timestamp, direction, frame.data(), length);
+		}
+
+		return writer.isValid() ? ProtocolInterface::Error::NoError : ProtocolInterface::Error::InternalError;
+	}
+	catch (...)
+	{
+		return ProtocolInterface::Error::InternalError;
+	}
+}
+
+void FrameRecorder::setTransportErrorDumpFilePath(std::string const& filePath) noexcept
+{
+	auto const lg = std::lock_guard{ _lock };
+	_transportErrorDumpFilePath = filePath;
+}
+
+std::int64_t FrameRecorder::getCurrentTimestamp() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void FrameRecorder::onTransportError(ProtocolInterface* const /*pi*/) noexcept
+{
+	auto filePath = std::string{};
+	{
+		auto const lg = std::lock_guard{ _lock };
+		filePath = _transportErrorDumpFilePath;
+	}
+
+	if (!filePath.empty())
+	{
+		if (dump(filePath) != ProtocolInterface::Error::NoError)
+		{
+			LOG_GENERIC_ERROR(std::string("Failed to dump recorded frames to ") + filePath);
+		}
+		else
+		{
+			LOG_GENERIC_INFO(std::string("Transport error, recorded frames dumped to ") + filePath);
+		}
+	}
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,170 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameRecorder.hpp
+* @author Christophe Calmejane
+* @brief Continuous recorder of the raw frames of a ProtocolInterface, for post-mortem analysis.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Fixed-size ring of the last frames received and sent by a ProtocolInterface, that can be dumped to a pcapng file.
+* @details Frames are stored back to back in a preallocated data ring, described by a second ring of small records (timestamp, direction, position in the data ring).
+*          Recording a frame reserves its space with two atomic increments then copies it, it never blocks nor allocates, and the oldest frames are silently overwritten.
+*          Each record is protected by a sequence number, so dumping can happen at any time, concurrently with the recording threads (frames overwritten while being dumped are skipped).
+*          The recorder is registered as an observer of the ProtocolInterface, and automatically dumps the ring on transport error when a dump file has been specified.
+*/
+class FrameRecorder final : public ProtocolInterface::Observer
+{
+public:
+	enum class Direction : std::uint8_t
+	{
+		Received = 1, /**< Same value than the pcapng 'inbound' packet flag */
+		Sent = 2, /**< Same value than the pcapng 'outbound' packet flag */
+	};
+
+	/** Constructor. bufferSize is rounded up to the next power of 2 (the records ring adds about half of that size). */
+	explicit FrameRecorder(std::size_t const bufferSize);
+
+	/** Stores a copy of the frame, with the current time. Can be called from any thread. */
+	void record(Direction const direction, std::uint8_t const* const frame, std::size_t const length) noexcept
+	{
+		if (length == 0u || length > EthernetMaxFrameSize)
+		{
+			return;
+		}
+
+		auto const timestamp = getCurrentTimestamp();
+		auto const dataPosition = _dataPosition.fetch_add(length, std::memory_order_relaxed);
+		auto const index = _recordPosition.fetch_add(1u, std::memory_order_relaxed);
+		auto& entry = _records[index & _recordsMask];
+
+		// Mark the record as being written, so a concurrent dump detects the overwrite
+		entry.sequence.store(writingSequence(index), std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		// The frame might wrap around the end of the data ring
+		auto const offset = static_cast<std::size_t>(dataPosition & _dataMask);
+		auto const firstPartLength = std::min(length, _dataSize - offset);
+		std::memcpy(_data.get() + offset, frame, firstPartLength);
+		std::memcpy(_data.get(), frame + firstPartLength, length - firstPartLength);
+
+		entry.dataPosition.store(dataPosition, std::memory_order_relaxed);
+		entry.timestamp.store(timestamp, std::memory_order_relaxed);
+		entry.length.store(static_cast<std::uint16_t>(length), std::memory_order_relaxed);
+		entry.direction.store(direction, std::memory_order_relaxed);
+		entry.sequence.store(committedSequence(index), std::memory_order_release);
+	}
+
+	/** Writes all the frames currently in the ring, oldest first, to a pcapng file. Can be called from any thread. */
+	ProtocolInterface::Error dump(std::string const& filePath) const noexcept;
+
+	/** Sets the file the ring is dumped to when the observed ProtocolInterface reports a transport error (empty for no automatic dump). */
+	void setTransportErrorDumpFilePath(std::string const& filePath) noexcept;
+
+	/** Returns the bufferSize the recorder has been constructed with. */
+	std::size_t getBufferSize() const noexcept
+	{
+		return _bufferSize;
+	}
+
+	/** Enables or disables recording (frames already recorded are kept). */
+	void setEnabled(bool const enabled) noexcept
+	{
+		_isEnabled.store(enabled, std::memory_order_release);
+	}
+
+	/** Returns true if recording is enabled. */
+	bool isEnabled() const noexcept
+	{
+		return _isEnabled.load(std::memory_order_acquire);
+	}
+
+	// Deleted compiler auto-generated methods
+	FrameRecorder(FrameRecorder&&) = delete;
+	FrameRecorder(FrameRecorder const&) = delete;
+	FrameRecorder& operator=(FrameRecorder const&) = delete;
+	FrameRecorder& operator=(FrameRecorder&&) = delete;
+
+private:
+	static constexpr auto AverageFrameSize = std::size_t{ 64u }; // Minimum ethernet frame size (plus FCS), used to size the records ring
+	static constexpr auto CacheLineSize = std::size_t{ 64u };
+
+	struct Record
+	{
+		std::atomic<std::uint64_t> sequence{ 0u }; // 0: never written, odd: being written, even: committed
+		std::atomic<std::uint64_t> dataPosition{ 0u };
+		std::atomic<std::int64_t> timestamp{ 0 }; // Nanoseconds since epoch
+		std::atomic<std::uint16_t> length{ 0u };
+		std::atomic<Direction> direction{ Direction::Received };
+	};
+
+	static std::uint64_t writingSequence(std::uint64_t const index) noexcept
+	{
+		return index * 2u + 1u;
+	}
+
+	static std::uint64_t committedSequence(std::uint64_t const index) noexcept
+	{
+		return index * 2u + 2u;
+	}
+
+	static std::int64_t getCurrentTimestamp() noexcept;
+
+	/* ProtocolInterface::Observer overrides */
+	virtual void onTransportError(ProtocolInterface* const pi) noexcept override;
+
+	// Private members
+	std::size_t const _bufferSize{ 0u };
+	std::size_t const _dataSize{ 0u };
+	std::size_t const _dataMask{ 0u };
+	std::size_t const _recordsMask{ 0u };
+	std::unique_ptr<std::uint8_t[]> _data{ nullptr };
+	std::unique_ptr<Record[]> _records{ nullptr };
+	alignas(CacheLineSize) std::atomic<std::uint64_t> _dataPosition{ 0u };
+	alignas(CacheLineSize) std::atomic<std::uint64_t> _recordPosition{ 0u };
+	std::atomic_bool _isEnabled{ true };
+	mutable std::mutex _lock{}; // Protects _transportErrorDumpFilePath
+	std::string _transportErrorDumpFilePath{};
+
+	DECLARE_AVDECC_OBSERVER_GUARD(FrameRecorder);
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,176 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameRing.hpp
+* @author Christophe Calmejane
+* @brief Lock-free bounded ring of ethernet frames, with multiple producers and a single consumer.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolDefines.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Bounded MPSC ring of preallocated frame slots.
+* @details Each slot carries a sequence number telling whether it is free for the producer of a given position, or ready for the consumer.
+*          Producers claim a position with a single CAS, copy their frame in the slot then publish it. The consumer reads ready slots in place
+*          (no copy) and only releases them once it's done with them.
+* @warning peek and release must always be called from the same thread (the consumer).
+*/
+class FrameRing final
+{
+public:
+	static constexpr auto Capacity = std::size_t{ 1024u }; /**< Number of slots, must be a power of 2 */
+	static_assert((Capacity & (Capacity - 1u)) == 0u, "Capacity must be a power of 2");
+
+	struct Frame
+	{
+		std::array<std::uint8_t, EthernetMaxFrameSize> data{};
+		std::size_t length{ 0u };
+	};
+
+	FrameRing() noexcept
+	{
+		for (auto index = std::size_t{ 0u }; index < Capacity; ++index)
+		{
+			_slots[index].sequence.store(index, std::memory_order_relaxed);
+		}
+	}
+
+	/** Copies the specified frame to a free slot. Returns false if the ring is full (or the frame too big). Can be called from any thread. */
+	bool tryPush(std::uint8_t const* const data, std::size_t const length) noexcept
+	{
+		if (length > EthernetMaxFrameSize)
+		{
+			return false;
+		}
+
+		auto position = _writePosition.load(std::memory_order_relaxed);
+		auto* slot = static_cast<Slot*>(nullptr);
+		while (true)
+		{
+			slot = &_slots[position & Mask];
+			auto const sequence = slot->sequence.load(std::memory_order_acquire);
+			auto const diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+			// Slot is free for this position, try to claim it
+			if (diff == 0)
+			{
+				if (_writePosition.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			// Slot not yet released by the consumer, the ring is full
+			else if (diff < 0)
+			{
+				return false;
+			}
+			// Another producer claimed this position
+			else
+			{
+				position = _writePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		if (length != 0u)
+		{
+			std::memcpy(slot->frame.data.data(), data, length);
+		}
+		slot->frame.length = length;
+
+		// Publish the slot to the consumer
+		slot->sequence.store(position + 1u, std::memory_order_release);
+		return true;
+	}
+
+	/** Retrieves up to maxFrames ready frames, in order, without releasing them. Returns the number of frames retrieved. Consumer thread only. */
+	std::size_t peek(Frame const** const frames, std::size_t const maxFrames) const noexcept
+	{
+		auto count = std::size_t{ 0u };
+		while (count < maxFrames)
+		{
+			auto const position = _readPosition + count;
+			auto const& slot = _slots[position & Mask];
+			if (slot.sequence.load(std::memory_order_acquire) != position + 1u)
+			{
+				break;
+			}
+			frames[count] = &slot.frame;
+			++count;
+		}
+		return count;
+	}
+
+	/** Releases the specified number of frames previously returned by peek, making their slots available to producers. Consumer thread only. */
+	void release(std::size_t const count) noexcept
+	{
+		for (auto index = std::size_t{ 0u }; index < count; ++index)
+		{
+			auto const position = _readPosition + index;
+			_slots[position & Mask].sequence.store(position + Capacity, std::memory_order_release);
+		}
+		_readPosition += count;
+	}
+
+	/** Returns true if no frame is ready to be read. Consumer thread only. */
+	bool empty() const noexcept
+	{
+		return _slots[_readPosition & Mask].sequence.load(std::memory_order_acquire) != _readPosition + 1u;
+	}
+
+	// Deleted compiler auto-generated methods
+	FrameRing(FrameRing&&) = delete;
+	FrameRing(FrameRing const&) = delete;
+	FrameRing& operator=(FrameRing const&) = delete;
+	FrameRing& operator=(FrameRing&&) = delete;
+
+private:
+	static constexpr auto Mask = Capacity - 1u;
+	static constexpr auto CacheLineSize = std::size_t{ 64u };
+
+	struct alignas(CacheLineSize) Slot
+	{
+		std::atomic<std::size_t> sequence{ 0u };
+		Frame frame{};
+	};
+
+	// Private members
+	std::unique_ptr<Slot[]> _slots{ std::make_unique<Slot[]>(Capacity) };
+	alignas(CacheLineSize) std::atomic<std::size_t> _writePosition{ 0u };
+	alignas(CacheLineSize) std::size_t _readPosition{ 0u };
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
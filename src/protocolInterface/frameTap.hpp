@@ -0,0 +1,56 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameTap.hpp
+* @author Christophe Calmejane
+* @brief Hook receiving the raw frames of a ProtocolInterface before they are decoded.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Receives the raw frames of a ProtocolInterface, from the transport receive thread, before they are decoded.
+* @details Frames are handed in batches (as read from the transport), the state machines lock being held for the whole batch. Methods must not block.
+*/
+class FrameTap
+{
+public:
+	/** Called for each received frame. The frame is only valid during the call. Returns true if the frame has been consumed and must not be decoded by the ProtocolInterface. */
+	virtual bool onFrameReceived(std::uint8_t const* const frame, std::size_t const length) noexcept = 0;
+
+	/** Called once the last frame of a batch has been handed to onFrameReceived. */
+	virtual void onBatchComplete() noexcept = 0;
+
+protected:
+	virtual ~FrameTap() noexcept = default;
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -94,29 +94,39 @@ namespace avdecc
 namespace protocol
 {
 using open_live_t = pcap_t* (*)(const char*, int, int, int, char*);
+using open_offline_t = pcap_t* (*)(const char*, char*);
 using fileno_t = int (*)(pcap_t*);
+using datalink_t = int (*)(pcap_t*);
 using close_t = void (*)(pcap_t*);
 using compile_t = int (*)(pcap_t*, bpf_program*, const char*, int, bpf_u_int32);
 using setfilter_t = int (*)(pcap_t*, bpf_program*);
 using freecode_t = void (*)(bpf_program*);
 using next_ex_t = int (*)(pcap_t*, pcap_pkthdr**, const u_char**);
 using loop_t = int (*)(pcap_t*, int, pcap_handler, u_char*);
+using dispatch_t = int (*)(pcap_t*, int, pcap_handler, u_char*);
+using setnonblock_t = int (*)(pcap_t*, int, char*);
 using breakloop_t = void (*)(pcap_t*);
 using sendpacket_t = int (*)(pcap_t*, const u_char*, int);
+using stats_t = int (*)(pcap_t*, pcap_stat*);
 
 struct PcapInterface::pImpl
 {
 	DL_HANDLE libraryHandle{ nullptr };
 	open_live_t open_live_ptr{ nullptr };
+	open_offline_t open_offline_ptr{ nullptr };
 	fileno_t fileno_ptr{ nullptr };
+	datalink_t datalink_ptr{ nullptr };
 	close_t close_ptr{ nullptr };
 	compile_t compile_ptr{ nullptr };
 	setfilter_t setfilter_ptr{ nullptr };
 	freecode_t freecode_ptr{ nullptr };
 	next_ex_t next_ex_ptr{ nullptr };
 	loop_t loop_ptr{ nullptr };
+	dispatch_t dispatch_ptr{ nullptr };
+	setnonblock_t setnonblock_ptr{ nullptr };
 	breakloop_t breakloop_ptr{ nullptr };
 	sendpacket_t sendpacket_ptr{ nullptr };
+	stats_t stats_ptr{ nullptr };
 };
 
 PcapInterface::PcapInterface()
@@ -132,17 +142,22 @@ PcapInterface::PcapInterface()
 			version = lib_version_ptr();
 
 			_pImpl->open_live_ptr = reinterpret_cast<open_live_t>(DL_SYM(handle, "pcap_open_live"));
+			_pImpl->open_offline_ptr = reinterpret_cast<open_offline_t>(DL_SYM(handle, "pcap_open_offline"));
 			_pImpl->fileno_ptr = reinterpret_cast<fileno_t>(DL_SYM(handle, "pcap_fileno"));
+			_pImpl->datalink_ptr = reinterpret_cast<datalink_t>(DL_SYM(handle, "pcap_datalink"));
 			_pImpl->close_ptr = reinterpret_cast<close_t>(DL_SYM(handle, "pcap_close"));
 			_pImpl->compile_ptr = reinterpret_cast<compile_t>(DL_SYM(handle, "pcap_compile"));
 			_pImpl->setfilter_ptr = reinterpret_cast<setfilter_t>(DL_SYM(handle, "pcap_setfilter"));
 			_pImpl->freecode_ptr = reinterpret_cast<freecode_t>(DL_SYM(handle, "pcap_freecode"));
 			_pImpl->next_ex_ptr = reinterpret_cast<next_ex_t>(DL_SYM(handle, "pcap_next_ex"));
 			_pImpl->loop_ptr = reinterpret_cast<loop_t>(DL_SYM(handle, "pcap_loop"));
+			_pImpl->dispatch_ptr = reinterpret_cast<dispatch_t>(DL_SYM(handle, "pcap_dispatch"));
+			_pImpl->setnonblock_ptr = reinterpret_cast<setnonblock_t>(DL_SYM(handle, "pcap_setnonblock"));
 			_pImpl->breakloop_ptr = reinterpret_cast<breakloop_t>(DL_SYM(handle, "pcap_breakloop"));
 			_pImpl->sendpacket_ptr = reinterpret_cast<sendpacket_t>(DL_SYM(handle, "pcap_sendpacket"));
+			_pImpl->stats_ptr = reinterpret_cast<stats_t>(DL_SYM(handle, "pcap_stats"));
 
-			foundAllFunctions = _pImpl->open_live_ptr && _pImpl->fileno_ptr && _pImpl->close_ptr && _pImpl->compile_ptr && _pImpl->setfilter_ptr && _pImpl->freecode_ptr && _pImpl->next_ex_ptr && _pImpl->loop_ptr && _pImpl->breakloop_ptr && _pImpl->sendpacket_ptr;
+			foundAllFunctions = _pImpl->open_live_ptr && _pImpl->open_offline_ptr && _pImpl->fileno_ptr && _pImpl->datalink_ptr && _pImpl->close_ptr && _pImpl->compile_ptr && _pImpl->setfilter_ptr && _pImpl->freecode_ptr && _pImpl->next_ex_ptr && _pImpl->loop_ptr && _pImpl->dispatch_ptr && _pImpl->setnonblock_ptr && _pImpl->breakloop_ptr && _pImpl->sendpacket_ptr && _pImpl->stats_ptr;
 		}
 
 		if (foundAllFunctions)
@@ -186,12 +201,24 @@ pcap_t* PcapInterface::open_live(const char* device, int snaplen, int promisc, i
 	return _pImpl->open_live_ptr(device, snaplen, promisc, to_ms, ebuf);
 }
 
+pcap_t* PcapInterface::open_offline(const char* fname, char* errbuf) const
+{
+	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->open_offline_ptr != nullptr));
+	return _pImpl->open_offline_ptr(fname, errbuf);
+}
+
 int PcapInterface::fileno(pcap_t* p) const
 {
 	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->fileno_ptr != nullptr));
 	return _pImpl->fileno_ptr(p);
 }
 
+int PcapInterface::datalink(pcap_t* p) const
+{
+	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->datalink_ptr != nullptr));
+	return _pImpl->datalink_ptr(p);
+}
+
 void PcapInterface::close(pcap_t* p) const
 {
 	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->close_ptr != nullptr));
@@ -228,6 +255,18 @@ int PcapInterface::loop(pcap_t* p, int cnt, pcap_handler callback, u_char* user)
 	return _pImpl->loop_ptr(p, cnt, callback, user);
 }
 
+int PcapInterface::dispatch(pcap_t* p, int cnt, pcap_handler callback, u_char* user) const
+{
+	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->dispatch_ptr != nullptr));
+	return _pImpl->dispatch_ptr(p, cnt, callback, user);
+}
+
+int PcapInterface::setnonblock(pcap_t* p, int nonblock, char* errbuf) const
+{
+	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->setnonblock_ptr != nullptr));
+	return _pImpl->setnonblock_ptr(p, nonblock, errbuf);
+}
+
 void PcapInterface::breakloop(pcap_t* p) const
 {
 	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->breakloop_ptr != nullptr));
@@ -240,6 +279,12 @@ int PcapInterface::sendpacket(pcap_t* p, const u_char* buf, int size) const
 	return _pImpl->sendpacket_ptr(p, buf, size);
 }
 
+int PcapInterface::stats(pcap_t* p, struct pcap_stat* ps) const
+{
+	assert((_pImpl != nullptr) && (_pImpl->libraryHandle != nullptr) && (_pImpl->stats_ptr != nullptr));
+	return _pImpl->stats_ptr(p, ps);
+}
+
 } // namespace protocol
 } // namespace avdecc
 } // namespace la
@@ -41,15 +41,20 @@ public:
 
 	bool is_available() const;
 	pcap_t* open_live(const char*, int, int, int, char*) const;
+	pcap_t* open_offline(const char*, char*) const;
 	int fileno(pcap_t*) const;
+	int datalink(pcap_t*) const;
 	void close(pcap_t*) const;
 	int compile(pcap_t*, struct bpf_program*, const char*, int, bpf_u_int32) const;
 	int setfilter(pcap_t*, struct bpf_program*) const;
 	void freecode(struct bpf_program*) const;
 	int next_ex(pcap_t*, struct pcap_pkthdr**, const u_char**) const;
 	int loop(pcap_t*, int, pcap_handler, u_char*) const;
+	int dispatch(pcap_t*, int, pcap_handler, u_char*) const;
+	int setnonblock(pcap_t*, int, char*) const;
 	void breakloop(pcap_t*) const;
 	int sendpacket(pcap_t*, const u_char*, int) const;
+	int stats(pcap_t*, struct pcap_stat*) const;
 
 private:
 	struct pImpl;
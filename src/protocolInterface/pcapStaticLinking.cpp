@@ -42,11 +42,21 @@ pcap_t* PcapInterface::open_live(const char* device, int snaplen, int promisc, i
 	return pcap_open_live(device, snaplen, promisc, to_ms, ebuf);
 }
 
+pcap_t* PcapInterface::open_offline(const char* fname, char* errbuf) const
+{
+	return pcap_open_offline(fname, errbuf);
+}
+
 int PcapInterface::fileno(pcap_t* p) const
 {
 	return pcap_fileno(p);
 }
 
+int PcapInterface::datalink(pcap_t* p) const
+{
+	return pcap_datalink(p);
+}
+
 void PcapInterface::close(pcap_t* p) const
 {
 	pcap_close(p);
@@ -77,6 +87,16 @@ int PcapInterface::loop(pcap_t* p, int cnt, pcap_handler callback, u_char* user)
 	return pcap_loop(p, cnt, callback, user);
 }
 
+int PcapInterface::dispatch(pcap_t* p, int cnt, pcap_handler callback, u_char* user) const
+{
+	return pcap_dispatch(p, cnt, callback, user);
+}
+
+int PcapInterface::setnonblock(pcap_t* p, int nonblock, char* errbuf) const
+{
+	return pcap_setnonblock(p, nonblock, errbuf);
+}
+
 void PcapInterface::breakloop(pcap_t* p) const
 {
 	pcap_breakloop(p);
@@ -87,6 +107,11 @@ int PcapInterface::sendpacket(pcap_t* p, const u_char* buf, int size) const
 	return pcap_sendpacket(p, buf, size);
 }
 
+int PcapInterface::stats(pcap_t* p, struct pcap_stat* ps) const
+{
+	return pcap_stats(p, ps);
+}
+
 } // namespace protocol
 } // namespace avdecc
 } // namespace la
@@ -0,0 +1,186 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file pduPool.hpp
+* @author Christophe Calmejane
+* @brief Recycling pool for the PDUs created on the receive path.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolAdpdu.hpp"
+#include "la/avdecc/internals/protocolAcmpdu.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolAaAecpdu.hpp"
+#include "la/avdecc/internals/protocolInterface.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Recycling pool of PduType objects.
+* @details Memory of released objects is kept in a lock-free free-list and reused by the next acquire, so steady-state receive does not allocate.
+*          The object is destroyed on release and constructed again on acquire, so a recycled object is identical to a newly created one.
+*          The returned UniquePointer uses the same kind of stateless deleter than PduType::create, the pool being retrieved from a header stored in front of the object.
+* @warning acquire must always be called from the same thread (the receive thread), release (through the UniquePointer deleter) can be called from any thread.
+*          All acquired objects must have been released before the pool is destroyed.
+*/
+template<class PduType>
+class PduPool final
+{
+public:
+	using UniquePointer = typename PduType::UniquePointer;
+
+	PduPool() noexcept = default;
+
+	~PduPool() noexcept
+	{
+		AVDECC_ASSERT(_outstanding == 0u, "PduPool destroyed while some PDUs are still in use");
+
+		auto* node = _freeList.load(std::memory_order_acquire);
+		while (node != nullptr)
+		{
+			auto* const next = node->next;
+			::operator delete(node);
+			node = next;
+		}
+	}
+
+	/** Returns a recycled (or newly allocated) PduType, constructed with the specified arguments. */
+	template<typename... Args>
+	UniquePointer acquire(Args&&... args) noexcept
+	{
+		auto deleter = [](typename UniquePointer::element_type* self)
+		{
+			release(static_cast<PduType*>(self));
+		};
+
+		// Pop a node from the free-list (single consumer, so no ABA issue)
+		auto* node = _freeList.load(std::memory_order_acquire);
+		while (node != nullptr && !_freeList.compare_exchange_weak(node, node->next, std::memory_order_acquire, std::memory_order_acquire))
+		{
+		}
+
+		if (node != nullptr)
+		{
+			_hits.fetch_add(1u, std::memory_order_relaxed);
+		}
+		else
+		{
+			_misses.fetch_add(1u, std::memory_order_relaxed);
+			node = static_cast<Node*>(::operator new(NodeSize, std::nothrow));
+			// Allocation failed, fallback to a regular PDU
+			if (node == nullptr)
+			{
+				return PduType::create(std::forward<Args>(args)...);
+			}
+		}
+
+		node->pool = this;
+		node->next = nullptr;
+		++_outstanding;
+
+		return UniquePointer(new (getPdu(node)) PduType(std::forward<Args>(args)...), deleter);
+	}
+
+	/** Returns the number of acquire calls that reused a released object. */
+	std::uint64_t getHits() const noexcept
+	{
+		return _hits.load(std::memory_order_relaxed);
+	}
+
+	/** Returns the number of acquire calls that had to allocate a new object. */
+	std::uint64_t getMisses() const noexcept
+	{
+		return _misses.load(std::memory_order_relaxed);
+	}
+
+	// Deleted compiler auto-generated methods
+	PduPool(PduPool&&) = delete;
+	PduPool(PduPool const&) = delete;
+	PduPool& operator=(PduPool const&) = delete;
+	PduPool& operator=(PduPool&&) = delete;
+
+private:
+	struct alignas(PduType) Node
+	{
+		PduPool* pool{ nullptr };
+		Node* next{ nullptr };
+	};
+	static constexpr auto HeaderSize = sizeof(Node); // Multiple of alignof(PduType) thanks to alignas
+	static constexpr auto NodeSize = HeaderSize + sizeof(PduType);
+
+	static void* getPdu(Node* const node) noexcept
+	{
+		return reinterpret_cast<std::uint8_t*>(node) + HeaderSize;
+	}
+
+	static void release(PduType* const pdu) noexcept
+	{
+		auto* const node = reinterpret_cast<Node*>(reinterpret_cast<std::uint8_t*>(pdu) - HeaderSize);
+		auto* const pool = node->pool;
+
+		pdu->~PduType();
+		--pool->_outstanding;
+
+		// Push the node back to the free-list
+		node->next = pool->_freeList.load(std::memory_order_relaxed);
+		while (!pool->_freeList.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	// Private members
+	std::atomic<Node*> _freeList{ nullptr };
+	std::atomic<std::uint64_t> _hits{ 0u };
+	std::atomic<std::uint64_t> _misses{ 0u };
+	std::atomic<std::size_t> _outstanding{ 0u };
+};
+
+/** Pools for all the PDUs created by the library on the receive path of a ProtocolInterface. */
+struct ReceivePduPools
+{
+	PduPool<Adpdu> adpdu{};
+	PduPool<Acmpdu> acmpdu{};
+	PduPool<AemAecpdu> aemAecpdu{};
+	PduPool<AaAecpdu> aaAecpdu{};
+
+	ProtocolInterface::PduPoolStatistics getStatistics() const noexcept
+	{
+		auto statistics = ProtocolInterface::PduPoolStatistics{};
+		statistics.hits = adpdu.getHits() + acmpdu.getHits() + aemAecpdu.getHits() + aaAecpdu.getHits();
+		statistics.misses = adpdu.getMisses() + acmpdu.getMisses() + aemAecpdu.getMisses() + aaAecpdu.getMisses();
+		return statistics;
+	}
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -23,6 +23,10 @@
 */
 
 #include "la/avdecc/internals/protocolInterface.hpp"
+#include "la/avdecc/internals/proxyServer.hpp"
+
+#include "protocolInterface/frameRecorder.hpp"
+#include "protocolInterface/frameTap.hpp"
 
 // Protocol Interface
 #ifdef HAVE_PROTOCOL_INTERFACE_PCAP
@@ -32,12 +36,20 @@
 #	include "protocolInterface/protocolInterface_macNative.hpp"
 #endif // HAVE_PROTOCOL_INTERFACE_MAC
 #ifdef HAVE_PROTOCOL_INTERFACE_PROXY
-#	error "Not implemented yet"
 #	include "protocolInterface/protocolInterface_proxy.hpp"
 #endif // HAVE_PROTOCOL_INTERFACE_PROXY
 #ifdef HAVE_PROTOCOL_INTERFACE_VIRTUAL
 #	include "protocolInterface/protocolInterface_virtual.hpp"
 #endif // HAVE_PROTOCOL_INTERFACE_VIRTUAL
+#ifdef HAVE_PROTOCOL_INTERFACE_RAWSOCKET
+#	include "protocolInterface/protocolInterface_rawSocket.hpp"
+#endif // HAVE_PROTOCOL_INTERFACE_RAWSOCKET
+#ifdef HAVE_PROTOCOL_INTERFACE_SHARED_MEMORY
+#	include "protocolInterface/protocolInterface_sharedMemory.hpp"
+#endif // HAVE_PROTOCOL_INTERFACE_SHARED_MEMORY
+#ifdef HAVE_PROTOCOL_INTERFACE_PCAP_REPLAY
+#	include "protocolInterface/protocolInterface_pcapReplay.hpp"
+#endif // HAVE_PROTOCOL_INTERFACE_PCAP_REPLAY
 
 namespace la
 {
@@ -78,6 +90,21 @@ ProtocolInterface::ProtocolInterface(std::string const& networkInterfaceName, ne
 		throw Exception(Error::InvalidParameters, "Network interface has an invalid mac address");
 }
 
+ProtocolInterface::~ProtocolInterface() noexcept
+{
+	// Transports have been shut down by the derived class, no thread is recording anymore
+	if (auto* const frameRecorder = _frameRecorder.load(std::memory_order_acquire); frameRecorder != nullptr)
+	{
+		try
+		{
+			unregisterObserver(frameRecorder);
+		}
+		catch (...)
+		{
+		}
+		delete frameRecorder;
+	}
+}
 
 la::avdecc::networkInterface::MacAddress const& LA_AVDECC_CALL_CONVENTION ProtocolInterface::getMacAddress() const noexcept
 {
@@ -114,6 +141,65 @@ ProtocolInterface::Error LA_AVDECC_CALL_CONVENTION ProtocolInterface::unregister
 	return Error::NoError;
 }
 
+ProtocolInterface::Error LA_AVDECC_CALL_CONVENTION ProtocolInterface::enableFrameRecorder(std::size_t const bufferSize, std::string const& transportErrorDumpFilePath) noexcept
+{
+	auto* frameRecorder = _frameRecorder.load(std::memory_order_acquire);
+
+	if (frameRecorder == nullptr)
+	{
+		try
+		{
+			auto newFrameRecorder = std::make_unique<FrameRecorder>(bufferSize);
+
+			// Not taking our lock (observers are notified with the Subject lock taken, which would then be taken in the reverse order), another thread might have created the recorder in the meantime
+			if (_frameRecorder.compare_exchange_strong(frameRecorder, newFrameRecorder.get(), std::memory_order_acq_rel))
+			{
+				frameRecorder = newFrameRecorder.release();
+				frameRecorder->setTransportErrorDumpFilePath(transportErrorDumpFilePath);
+				registerObserver(frameRecorder);
+				return Error::NoError;
+			}
+		}
+		catch (...)
+		{
+			return Error::InternalError;
+		}
+	}
+
+	// The ring has already been allocated
+	if (frameRecorder->getBufferSize() != bufferSize)
+	{
+		return Error::InvalidParameters;
+	}
+
+	frameRecorder->setTransportErrorDumpFilePath(transportErrorDumpFilePath);
+	frameRecorder->setEnabled(true);
+
+	return Error::NoError;
+}
+
+ProtocolInterface::Error LA_AVDECC_CALL_CONVENTION ProtocolInterface::disableFrameRecorder() noexcept
+{
+	if (auto* const frameRecorder = _frameRecorder.load(std::memory_order_acquire); frameRecorder != nullptr)
+	{
+		frameRecorder->setEnabled(false);
+	}
+
+	return Error::NoError;
+}
+
+ProtocolInterface::Error LA_AVDECC_CALL_CONVENTION ProtocolInterface::dumpRecordedFrames(std::string const& filePath) const noexcept
+{
+	auto const* const frameRecorder = _frameRecorder.load(std::memory_order_acquire);
+
+	if (frameRecorder == nullptr)
+	{
+		return Error::InvalidParameters;
+	}
+
+	return frameRecorder->dump(filePath);
+}
+
 bool ProtocolInterface::isAecpResponseMessageType(AecpMessageType const messageType) const noexcept
 {
 	if (messageType == protocol::AecpMessageType::AemResponse || messageType == protocol::AecpMessageType::AddressAccessResponse || messageType == protocol::AecpMessageType::AvcResponse || messageType == protocol::AecpMessageType::VendorUniqueResponse || messageType == protocol::AecpMessageType::HdcpAemResponse || messageType == protocol::AecpMessageType::ExtendedResponse)
@@ -153,6 +239,44 @@ ProtocolInterface::VendorUniqueDelegate* ProtocolInterface::getVendorUniqueDeleg
 	return vudIt->second;
 }
 
+void ProtocolInterface::recordSentFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept
+{
+	if (auto* const frameRecorder = _frameRecorder.load(std::memory_order_acquire); frameRecorder != nullptr && frameRecorder->isEnabled())
+	{
+		frameRecorder->record(FrameRecorder::Direction::Sent, frame, length);
+	}
+}
+
+void ProtocolInterface::recordReceivedFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept
+{
+	if (auto* const frameRecorder = _frameRecorder.load(std::memory_order_acquire); frameRecorder != nullptr && frameRecorder->isEnabled())
+	{
+		frameRecorder->record(FrameRecorder::Direction::Received, frame, length);
+	}
+}
+
+bool ProtocolInterface::tapReceivedFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept
+{
+	if (auto* const frameTap = _frameTap.load(std::memory_order_acquire); frameTap != nullptr)
+	{
+		return frameTap->onFrameReceived(frame, length);
+	}
+	return false;
+}
+
+void ProtocolInterface::completeTapBatch() const noexcept
+{
+	if (auto* const frameTap = _frameTap.load(std::memory_order_acquire); frameTap != nullptr)
+	{
+		frameTap->onBatchComplete();
+	}
+}
+
+ProtocolInterface::Error ProtocolInterface::sendRawFrame(std::uint8_t const* const /*frame*/, std::size_t const /*length*/) const noexcept
+{
+	return Error::MessageNotSupported;
+}
+
 ProtocolInterface* LA_AVDECC_CALL_CONVENTION ProtocolInterface::createRawProtocolInterface(Type const protocolInterfaceType, std::string const& networkInterfaceName)
 {
 	if (!isSupportedProtocolInterfaceType(protocolInterfaceType))
@@ -170,13 +294,24 @@ ProtocolInterface* LA_AVDECC_CALL_CONVENTION ProtocolInterface::createRawProtoco
 #endif // HAVE_PROTOCOL_INTERFACE_MAC
 #if defined(HAVE_PROTOCOL_INTERFACE_PROXY)
 		case Type::Proxy:
-			AVDECC_ASSERT(false, "TODO: Proxy protocol interface to create");
-			break;
+			return ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(networkInterfaceName);
 #endif // HAVE_PROTOCOL_INTERFACE_PROXY
 #if defined(HAVE_PROTOCOL_INTERFACE_VIRTUAL)
 		case Type::Virtual:
 			return ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkInterfaceName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } });
 #endif // HAVE_PROTOCOL_INTERFACE_VIRTUAL
+#if defined(HAVE_PROTOCOL_INTERFACE_RAWSOCKET)
+		case Type::RawSocket:
+			return ProtocolInterfaceRawSocket::createRawProtocolInterfaceRawSocket(networkInterfaceName);
+#endif // HAVE_PROTOCOL_INTERFACE_RAWSOCKET
+#if defined(HAVE_PROTOCOL_INTERFACE_SHARED_MEMORY)
+		case Type::SharedMemory:
+			return ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkInterfaceName, ProtocolInterfaceSharedMemory::generateMacAddress());
+#endif // HAVE_PROTOCOL_INTERFACE_SHARED_MEMORY
+#if defined(HAVE_PROTOCOL_INTERFACE_PCAP_REPLAY)
+		case Type::PcapReplay:
+			return ProtocolInterfacePcapReplay::createRawProtocolInterfacePcapReplay(networkInterfaceName, ProtocolInterfacePcapReplay::DefaultMacAddress, ProtocolInterfacePcapReplay::ReplayMode::OriginalTiming);
+#endif // HAVE_PROTOCOL_INTERFACE_PCAP_REPLAY
 		default:
 			break;
 	}
@@ -203,6 +338,12 @@ std::string LA_AVDECC_CALL_CONVENTION ProtocolInterface::typeToString(Type const
 			return "IEEE Std 1722.1 proxy";
 		case Type::Virtual:
 			return "Virtual interface";
+		case Type::RawSocket:
+			return "Linux raw socket";
+		case Type::SharedMemory:
+			return "Shared memory network";
+		case Type::PcapReplay:
+			return "Packet capture replay";
 		default:
 			return "Unknown protocol interface type";
 	}
@@ -245,11 +386,48 @@ ProtocolInterface::SupportedProtocolInterfaceTypes LA_AVDECC_CALL_CONVENTION Pro
 			s_supportedProtocolInterfaceTypes.set(Type::Virtual);
 		}
 #endif // HAVE_PROTOCOL_INTERFACE_VIRTUAL
+
+		// RawSocket (only supported on linux)
+#if defined(HAVE_PROTOCOL_INTERFACE_RAWSOCKET)
+		if (protocol::ProtocolInterfaceRawSocket::isSupported())
+		{
+			s_supportedProtocolInterfaceTypes.set(Type::RawSocket);
+		}
+#endif // HAVE_PROTOCOL_INTERFACE_RAWSOCKET
+
+		// SharedMemory (only supported on linux)
+#if defined(HAVE_PROTOCOL_INTERFACE_SHARED_MEMORY)
+		if (protocol::ProtocolInterfaceSharedMemory::isSupported())
+		{
+			s_supportedProtocolInterfaceTypes.set(Type::SharedMemory);
+		}
+#endif // HAVE_PROTOCOL_INTERFACE_SHARED_MEMORY
+
+		// PcapReplay
+#if defined(HAVE_PROTOCOL_INTERFACE_PCAP_REPLAY)
+		if (protocol::ProtocolInterfacePcapReplay::isSupported())
+		{
+			s_supportedProtocolInterfaceTypes.set(Type::PcapReplay);
+		}
+#endif // HAVE_PROTOCOL_INTERFACE_PCAP_REPLAY
 	}
 
 	return s_supportedProtocolInterfaceTypes;
 }
 
+#if !defined(HAVE_PROTOCOL_INTERFACE_PROXY)
+/** ProxyServer Entry point (proxy support not compiled) */
+ProxyServer* LA_AVDECC_CALL_CONVENTION ProxyServer::createRawProxyServer(ProtocolInterface::Type const /*protocolInterfaceType*/, std::string const& /*networkInterfaceName*/, std::string const& /*listenAddress*/)
+{
+	throw ProtocolInterface::Exception(ProtocolInterface::Error::InterfaceNotSupported, "Proxy support not compiled in this library");
+}
+
+std::string LA_AVDECC_CALL_CONVENTION ProxyServer::getDefaultAddress(std::string const& /*networkInterfaceName*/) noexcept
+{
+	return {};
+}
+#endif // !HAVE_PROTOCOL_INTERFACE_PROXY
+
 } // namespace protocol
 } // namespace avdecc
 } // namespace la
@@ -382,6 +382,42 @@ public:
 		return [_bridge isSelfLocked];
 	}
 
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override
+	{
+		// PDUs are not created from raw frames, nothing to pool
+		return {};
+	}
+
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override
+	{
+		// Messages are sent through the native API, no transmit queue
+		return {};
+	}
+
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override
+	{
+		// Commands are sent through the native API, which handles their timeout
+		return {};
+	}
+
+	virtual LockStatistics getLockStatistics() const noexcept override
+	{
+		// The lock is provided by the native bridge, which is not instrumented
+		return {};
+	}
+
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override
+	{
+		// Frames are received by the native API, which does not report its statistics
+		return {};
+	}
+
+	virtual Error setSniffingMode(bool const /*enabled*/) noexcept override
+	{
+		// Filtering is done by the native API
+		return Error::NoError;
+	}
+
 	/** Destructor */
 	virtual ~ProtocolInterfaceMacNativeImpl() noexcept
 	{
@@ -482,6 +518,18 @@ private:
 		return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
 	}
 
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const /*delay*/) const noexcept override
+	{
+		// Remote entities updates are directly notified by the native discovery
+		return Error::MessageNotSupported;
+	}
+
+	virtual Error setAutomaticDiscoveryPacing(bool const /*enabled*/) const noexcept override
+	{
+		// Remote entities are discovered by the native API
+		return Error::MessageNotSupported;
+	}
+
 	virtual bool isDirectMessageSupported() const noexcept override
 	{
 		return false;
@@ -505,7 +553,7 @@ private:
 		return Error::MessageNotSupported;
 	}
 
-	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult) const noexcept override
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const /*priority*/) const noexcept override
 	{
 		auto const messageType = aecpdu->getMessageType();
 
@@ -529,6 +577,7 @@ private:
 			}
 		}
 
+		// Commands are queued by the native API, which has no notion of priority
 		return [_bridge sendAecpCommand:std::move(aecpdu) handler:onResult];
 	}
 
@@ -31,10 +31,15 @@
 #include "stateMachine/stateMachineManager.hpp"
 #include "protocolInterface_pcap.hpp"
 #include "pcapInterface.hpp"
+#include "frameDecoder.hpp"
+#include "entityFilter.hpp"
+#include "transmitQueue.hpp"
 #include "logHelper.hpp"
+#ifdef ENABLE_AVDECC_IO_REACTOR
+#	include "ioReactor.hpp"
+#endif // ENABLE_AVDECC_IO_REACTOR
 
 #include <stdexcept>
-#include <sstream>
 #include <array>
 #include <thread>
 #include <string>
@@ -43,6 +48,9 @@
 #include <memory>
 #include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <atomic>
 #ifdef __linux__
 #	include <csignal>
 #endif // __linux__
@@ -53,7 +61,7 @@ namespace avdecc
 {
 namespace protocol
 {
-class ProtocolInterfacePcapImpl final : public ProtocolInterfacePcap, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate
+class ProtocolInterfacePcapImpl final : public ProtocolInterfacePcap, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private FrameDecoder::Delegate, private TransmitQueue::Delegate
 {
 public:
 	/* ************************************************************ */
@@ -80,15 +88,12 @@ public:
 			throw Exception(Error::TransportError, errbuf.data());
 		}
 
-		// Configure pcap filtering to ignore packets of other protocols
-		struct bpf_program fcode;
-		std::stringstream ss;
-		ss << "ether proto 0x" << std::hex << AvtpEtherType;
-		if (_pcapLibrary.compile(pcap, &fcode, ss.str().c_str(), 1, 0xffffffff) < 0)
-			throw Exception(Error::TransportError, "Failed to compile ether filter");
-		if (_pcapLibrary.setfilter(pcap, &fcode) < 0)
+		// Configure pcap filtering to ignore packets of other protocols, and AECP messages not addressed to us (no local entity registered yet)
+		if (!setFilterProgram(pcap, entityFilter::makeLocalEntitiesProgram({})))
+		{
+			_pcapLibrary.close(pcap);
 			throw Exception(Error::TransportError, "Failed to set ether filter");
-		_pcapLibrary.freecode(&fcode);
+		}
 
 		// Get socket descriptor
 		_fd = _pcapLibrary.fileno(pcap);
@@ -103,6 +108,23 @@ public:
 				}
 			} };
 
+#ifdef ENABLE_AVDECC_IO_REACTOR
+		// Capture from the shared I/O reactor thread, the pcap handle must not block it
+		if (_pcapLibrary.setnonblock(_pcap.get(), 1, errbuf.data()) < 0)
+		{
+			throw Exception(Error::TransportError, errbuf.data());
+		}
+		_captureReader = _ioReactor->addReader(_fd,
+			[this](bool const /*hasError*/)
+			{
+				// Errors are reported by pcap_dispatch
+				onCaptureReadable();
+			});
+		if (_captureReader == IoReactor::InvalidHandle)
+		{
+			throw Exception(Error::TransportError, "Failed to register to the I/O reactor");
+		}
+#else // !ENABLE_AVDECC_IO_REACTOR
 		// Start the capture thread
 		_captureThread = std::thread(
 			[this]
@@ -115,15 +137,39 @@ public:
 				std::signal(SIGTERM, [](int){});
 #endif // __linux__
 
-				_pcapLibrary.loop(pcap, -1, &ProtocolInterfacePcapImpl::pcapLoopHandler, reinterpret_cast<u_char*>(this));
+				while (!_shouldTerminate)
+				{
+					// Drain all pending packets (up to MaxBatchSize) into the batch
+					if (_pcapLibrary.dispatch(pcap, static_cast<int>(MaxBatchSize), &ProtocolInterfacePcapImpl::pcapLoopHandler, reinterpret_cast<u_char*>(this)) < 0)
+					{
+						// Either an error or pcap_breakloop has been called
+						break;
+					}
+
+					// Decode the whole batch at once
+					processBatch();
+
+					// Install the new filter between two pcap_dispatch calls (libpcap handles are not thread safe)
+					if (_hasPendingFilterProgram.exchange(false))
+					{
+						applyPendingFilterProgram(pcap);
+					}
+
+					// Same for the capture statistics
+					sampleReceiveStatistics(pcap);
+				}
 
 				// Notify observers if we exited the loop because of an error
 				if (!_shouldTerminate)
 				{
-					// pcap_loop returned but we never asked for termination
+					// pcap_dispatch failed but we never asked for termination
 					notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onTransportError, this);
 				}
 			});
+#endif // ENABLE_AVDECC_IO_REACTOR
+
+		// Start the transmit queue
+		_transmitQueue.start("avdecc::PCapInterface::Send");
 
 		// Start the state machines
 		_stateMachineManager.startStateMachines();
@@ -133,10 +179,9 @@ public:
 	{
 		auto* self = reinterpret_cast<ProtocolInterfacePcapImpl*>(user);
 
-		// Packet received, process it
-		auto des = DeserializationBuffer(pkt_data, header->caplen);
-		EtherLayer2 etherLayer2;
-		deserialize<EtherLayer2>(&etherLayer2, des);
+		// Not enough bytes for an AVTP control frame, or too many for an AVDECC one
+		if (header->caplen <= EtherLayer2::HeaderLength || header->caplen > EthernetMaxFrameSize)
+			return;
 
 		// Don't ignore self mac, another entity might be on the computer
 
@@ -145,19 +190,85 @@ public:
 		if (etherType != AvtpEtherType)
 			return;
 
-		std::uint8_t const* avtpdu = &pkt_data[14]; // Start of AVB Transport Protocol
-		auto avtpdu_size = header->caplen - 14;
 		// Check AVTP control bit (meaning AVDECC packet)
-		std::uint8_t avtp_sub_type_control = avtpdu[0];
+		std::uint8_t avtp_sub_type_control = pkt_data[14];
 		if ((avtp_sub_type_control & 0xF0) == 0)
 			return;
 
+		// Should not happen since pcap_dispatch is called with the size of the batch
+		if (!AVDECC_ASSERT_WITH_RET(self->_batchCount < MaxBatchSize, "Batch is full"))
+			return;
+
+		// pkt_data is only valid during this callback, copy the frame to the batch
+		auto& frame = self->_batch[self->_batchCount];
+		std::memcpy(frame.data.data(), pkt_data, header->caplen);
+		frame.length = header->caplen;
+		frame.kernelTimestamp = std::chrono::seconds{ header->ts.tv_sec } + std::chrono::microseconds{ header->ts.tv_usec };
+		++self->_batchCount;
+	}
+
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	/** Called from the I/O reactor thread when packets are pending */
+	void onCaptureReadable() noexcept
+	{
+		auto* const pcap = _pcap.get();
+
+		// Drain a few batches (the descriptor is level triggered, remaining packets will be processed during the next call)
+		auto result = 0;
+		auto batches = size_t{ 0u };
+		do
+		{
+			result = _pcapLibrary.dispatch(pcap, static_cast<int>(MaxBatchSize), &ProtocolInterfacePcapImpl::pcapLoopHandler, reinterpret_cast<u_char*>(this));
+
+			// Decode the whole batch at once
+			processBatch();
+		} while (result == static_cast<int>(MaxBatchSize) && ++batches < MaxBatchesPerWakeUp);
+
+		// Install the new filter between two pcap_dispatch calls (libpcap handles are not thread safe)
+		if (_hasPendingFilterProgram.exchange(false))
+		{
+			applyPendingFilterProgram(pcap);
+		}
+
+		// Same for the capture statistics
+		sampleReceiveStatistics(pcap);
+
+		if (result < 0)
+		{
+			// pcap_dispatch failed, stop reading from the descriptor
+			_ioReactor->remove(_captureReader.exchange(IoReactor::InvalidHandle));
+			notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onTransportError, this);
+		}
+	}
+#endif // ENABLE_AVDECC_IO_REACTOR
+
+	void processBatch() noexcept
+	{
+		if (_batchCount == 0)
+		{
+			return;
+		}
+
 		// Try to detect possible deadlock
+		_watchDog.armHeartbeat(_dispatchHeartbeat);
+
 		{
-			self->_watchDog.registerWatch("avdecc::PCapInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(self)), std::chrono::milliseconds{ 1000u }, true);
-			self->dispatchAvdeccMessage(avtpdu, avtpdu_size, etherLayer2);
-			self->_watchDog.unregisterWatch("avdecc::PCapInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(self)), true);
+			// Lock the state machines once for the whole batch, instead of once per packet
+			auto const lg = std::lock_guard{ _stateMachineManager };
+
+			for (auto frameIndex = size_t{ 0u }; frameIndex < _batchCount; ++frameIndex)
+			{
+				auto const& frame = _batch[frameIndex];
+
+				// Packet received, process it (using the receive time set by the kernel in the pcap header)
+				_frameDecoder.processFrame(frame.data.data(), frame.length, FrameDecoder::fromKernelTimestamp(frame.kernelTimestamp));
+			}
+			_frameDecoder.completeBatch();
 		}
+
+		_watchDog.disarmHeartbeat(_dispatchHeartbeat);
+
+		_batchCount = 0u;
 	}
 
 	/** Destructor */
@@ -187,9 +298,17 @@ private:
 		// Stop the state machines
 		_stateMachineManager.stopStateMachines();
 
+		// Stop the transmit queue, after the last queued frames have been sent
+		_transmitQueue.stop();
+
 		// Notify the thread we are shutting down
 		_shouldTerminate = true;
 
+#ifdef ENABLE_AVDECC_IO_REACTOR
+		// Waits for the capture handler to complete if it's currently running
+		_ioReactor->remove(_captureReader.exchange(IoReactor::InvalidHandle));
+#endif // ENABLE_AVDECC_IO_REACTOR
+
 		// Wait for the thread to complete its pending tasks
 		if (_captureThread.joinable())
 		{
@@ -207,6 +326,13 @@ private:
 
 		// Release the pcapLibrary
 		_pcap.reset();
+
+		// Release the heartbeat watch
+		if (_dispatchHeartbeat != watchDog::WatchDog::InvalidHeartbeatHandle)
+		{
+			_watchDog.unregisterHeartbeat(_dispatchHeartbeat);
+			_dispatchHeartbeat = watchDog::WatchDog::InvalidHeartbeatHandle;
+		}
 	}
 
 	virtual UniqueIdentifier getDynamicEID() const noexcept override
@@ -244,7 +370,12 @@ private:
 
 		if (index)
 		{
-			return _stateMachineManager.registerLocalEntity(entity);
+			auto const error = _stateMachineManager.registerLocalEntity(entity);
+			if (!error)
+			{
+				updateFilterProgram();
+			}
+			return error;
 		}
 
 		return Error::InvalidParameters;
@@ -252,7 +383,12 @@ private:
 
 	virtual Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept override
 	{
-		return _stateMachineManager.unregisterLocalEntity(entity);
+		auto const error = _stateMachineManager.unregisterLocalEntity(entity);
+		if (!error)
+		{
+			updateFilterProgram();
+		}
+		return error;
 	}
 
 	virtual Error setEntityNeedsAdvertise(entity::LocalEntity const& entity, entity::LocalEntity::AdvertiseFlags const /*flags*/) noexcept override
@@ -285,6 +421,16 @@ private:
 		return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
 	}
 
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setRemoteEntitiesUpdateCoalescingDelay(delay);
+	}
+
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryPacing(enabled);
+	}
+
 	virtual bool isDirectMessageSupported() const noexcept override
 	{
 		return true;
@@ -308,7 +454,7 @@ private:
 		return sendMessage(acmpdu);
 	}
 
-	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult) const noexcept override
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override
 	{
 		auto const messageType = aecpdu->getMessageType();
 
@@ -333,7 +479,7 @@ private:
 		}
 
 		// Command goes through the state machine to handle timeout, retry and response
-		return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult);
+		return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult, priority);
 	}
 
 	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept override
@@ -391,6 +537,56 @@ private:
 		return _stateMachineManager.isSelfLocked();
 	}
 
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override
+	{
+		return _frameDecoder.getPduPoolStatistics();
+	}
+
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override
+	{
+		return _transmitQueue.getStatistics();
+	}
+
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override
+	{
+		return _stateMachineManager.getCommandTimeoutStatistics();
+	}
+
+	virtual LockStatistics getLockStatistics() const noexcept override
+	{
+		return _stateMachineManager.getLockStatistics();
+	}
+
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override
+	{
+		// Counters are sampled by the capture thread (libpcap handles are not thread safe)
+		auto statistics = ReceiveStatistics{};
+		statistics.receivedFrames = _receivedFrames.load(std::memory_order_relaxed);
+		statistics.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+		statistics.interfaceDroppedFrames = _interfaceDroppedFrames.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	virtual Error setSniffingMode(bool const enabled) noexcept override
+	{
+		_isSniffingMode = enabled;
+		updateFilterProgram();
+		return Error::NoError;
+	}
+
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept override
+	{
+		if (length < EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+		{
+			return Error::InvalidParameters;
+		}
+
+		// Short frames are padded the same way serialized messages are
+		auto buffer = SerializationBuffer{};
+		buffer.packBuffer(frame, length);
+		return sendPacket(buffer);
+	}
+
 	/* ************************************************************ */
 	/* stateMachine::ProtocolInterfaceDelegate overrides            */
 	/* ************************************************************ */
@@ -453,8 +649,8 @@ private:
 			// Then with Aecp
 			serialize<Aecpdu>(aecpdu, buffer);
 
-			// Send the message
-			return sendPacket(buffer);
+			// Send the message (a command that cannot be sent after this call returned is reported to the state machines)
+			return sendPacket(buffer, stateMachine::SentCommand::fromMessage(aecpdu));
 		}
 		catch ([[maybe_unused]] std::exception const& e)
 		{
@@ -477,8 +673,8 @@ private:
 			// Then with Acmp
 			serialize<Acmpdu>(acmpdu, buffer);
 
-			// Send the message
-			return sendPacket(buffer);
+			// Send the message (a command that cannot be sent after this call returned is reported to the state machines)
+			return sendPacket(buffer, stateMachine::SentCommand::fromMessage(acmpdu));
 		}
 		catch ([[maybe_unused]] std::exception const& e)
 		{
@@ -536,6 +732,12 @@ private:
 		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
 	}
 
+	virtual void onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntitiesUpdated, this, entities);
+	}
+
 	/* ************************************************************ */
 	/* stateMachine::CommandStateMachine::Delegate overrides        */
 	/* ************************************************************ */
@@ -570,6 +772,68 @@ private:
 		// Notify observers
 		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpResponseTime, this, entityID, responseTime);
 	}
+	virtual bool isReadyToSendCommands() const noexcept override
+	{
+		return _transmitQueue.isReadyForCommands();
+	}
+
+	/* ************************************************************ */
+	/* FrameDecoder::Delegate overrides                             */
+	/* ************************************************************ */
+	virtual VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept override
+	{
+		return getVendorUniqueDelegate(protocolIdentifier);
+	}
+
+	virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adpdu);
+	}
+
+	virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecpdu);
+	}
+
+	virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmpdu);
+	}
+
+	/* ************************************************************ */
+	/* TransmitQueue::Delegate overrides                            */
+	/* ************************************************************ */
+	virtual std::size_t sendFrames(TransmitQueue::Frame const* const* const frames, std::size_t const count) noexcept override
+	{
+		auto* const pcap = _pcap.get();
+		AVDECC_ASSERT(pcap, "Trying to send a message but pcapLibrary has been uninitialized");
+		if (pcap == nullptr)
+		{
+			return 0u;
+		}
+
+		// PCap has no portable batched send, but frames are at least sent outside of the state machines lock
+		auto sentCount = std::size_t{ 0u };
+		for (; sentCount < count; ++sentCount)
+		{
+			auto const& frame = *frames[sentCount];
+			if (_pcapLibrary.sendpacket(pcap, frame.data.data(), static_cast<int>(frame.length)) != 0)
+			{
+				break;
+			}
+		}
+		return sentCount;
+	}
+
+	virtual void onCommandNotSent(stateMachine::SentCommand const& command) noexcept override
+	{
+		_stateMachineManager.notifyCommandNotSent(command);
+	}
+
+	virtual void onReadyForCommands() noexcept override
+	{
+		_stateMachineManager.notifyReadyToSendCommands();
+	}
 
 	/* ************************************************************ */
 	/* la::avdecc::utils::Subject overrides                         */
@@ -600,6 +864,7 @@ private:
 				}
 				virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
 				virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntitiesUpdated(EntityReferences const& /*entities*/) noexcept override {}
 
 				ProtocolInterface& _pi;
 				ProtocolInterface::Observer& _obs;
@@ -613,268 +878,124 @@ private:
 	/* ************************************************************ */
 	/* Private methods                                              */
 	/* ************************************************************ */
-	Error sendPacket(SerializationBuffer const& buffer) const noexcept
+	bool setFilterProgram(pcap_t* const pcap, entityFilter::Program const& filterProgram) const noexcept
 	{
-		auto length = buffer.size();
-		constexpr auto minimumSize = EthernetPayloadMinimumSize + EtherLayer2::HeaderLength;
-
-		/* Check the buffer has enough bytes in it */
-		if (length < minimumSize)
-			length = minimumSize; // No need to resize nor pad the buffer, it has enough capacity and we don't care about the unused bytes. Simply increase the length of the data to send.
+		static_assert(sizeof(bpf_insn) == sizeof(entityFilter::Instruction), "entityFilter::Instruction must have the same layout than bpf_insn");
+		auto program = bpf_program{};
+		program.bf_len = static_cast<decltype(program.bf_len)>(filterProgram.size());
+		program.bf_insns = reinterpret_cast<bpf_insn*>(const_cast<entityFilter::Instruction*>(filterProgram.data()));
+		return _pcapLibrary.setfilter(pcap, &program) >= 0;
+	}
 
+	/** Generates the filter program matching the currently registered local entities, to be installed by the capture thread */
+	void updateFilterProgram() noexcept
+	{
 		try
 		{
-			auto* const pcap = _pcap.get();
-			AVDECC_ASSERT(pcap, "Trying to send a message but pcapLibrary has been uninitialized");
-			if (pcap != nullptr)
+			// Lock the state machines so the local entities cannot change until the program is queued
+			auto const lg = std::lock_guard{ _stateMachineManager };
+			auto filterProgram = _isSniffingMode ? entityFilter::makeAvdeccProgram() : entityFilter::makeLocalEntitiesProgram(_stateMachineManager.getLocalEntityIDs());
 			{
-				if (_pcapLibrary.sendpacket(pcap, buffer.data(), static_cast<int>(length)) == 0)
-					return Error::NoError;
+				auto const filterLg = std::lock_guard{ _filterProgramLock };
+				_pendingFilterProgram = std::move(filterProgram);
 			}
+			_hasPendingFilterProgram = true;
 		}
 		catch (...)
 		{
+			LOG_PROTOCOL_INTERFACE_ERROR(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfacePcap: Failed to generate the kernel filter");
 		}
-		return Error::TransportError;
 	}
 
-	void deserializeAecpMessage(EtherLayer2 const& etherLayer2, Deserializer& des, Aecpdu& aecp) const
+	void applyPendingFilterProgram(pcap_t* const pcap) noexcept
 	{
-		// Fill EtherLayer2
-		aecp.setSrcAddress(etherLayer2.getSrcAddress());
-		aecp.setDestAddress(etherLayer2.getDestAddress());
-		// Then deserialize Avtp control
-		deserialize<AvtpduControl>(&aecp, des);
-		// Then deserialize Aecp
-		deserialize<Aecpdu>(&aecp, des);
+		auto filterProgram = entityFilter::Program{};
+		{
+			auto const lg = std::lock_guard{ _filterProgramLock };
+			filterProgram = std::move(_pendingFilterProgram);
+		}
+
+		if (!setFilterProgram(pcap, filterProgram))
+		{
+			LOG_PROTOCOL_INTERFACE_ERROR(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfacePcap: Failed to set the kernel filter");
+		}
 	}
 
-	void dispatchAvdeccMessage(std::uint8_t const* const pkt_data, size_t const pkt_len, EtherLayer2 const& etherLayer2) noexcept
+	/** Publishes the counters maintained by the capture library since the interface was opened (must be called from the capture thread, between two pcap_dispatch calls) */
+	void sampleReceiveStatistics(pcap_t* const pcap) noexcept
 	{
-		try
+		auto const now = std::chrono::steady_clock::now();
+		if (now < _nextReceiveStatisticsSample)
 		{
-			// Read Avtpdu SubType and ControlData (which is remapped to MessageType for all 1722.1 messages)
-			std::uint8_t const subType = pkt_data[0] & 0x7f;
-			std::uint8_t const controlData = pkt_data[1] & 0x7f;
-
-			// Create a deserialization buffer
-			auto des = DeserializationBuffer(pkt_data, pkt_len);
-
-			switch (subType)
-			{
-				/* ADP Message */
-				case AvtpSubType_Adp:
-				{
-					auto adpdu = Adpdu::create();
-					auto& adp = static_cast<Adpdu&>(*adpdu);
-
-					// Fill EtherLayer2
-					adp.setSrcAddress(etherLayer2.getSrcAddress());
-					adp.setDestAddress(etherLayer2.getDestAddress());
-					// Then deserialize Avtp control
-					deserialize<AvtpduControl>(&adp, des);
-					// Then deserialize Adp
-					deserialize<Adpdu>(&adp, des);
-
-					// Low level notification
-					notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adp);
-
-					// Forward to our state machine
-					_stateMachineManager.processAdpdu(adp);
-					break;
-				}
-
-				/* AECP Message */
-				case AvtpSubType_Aecp:
-				{
-					auto const messageType = static_cast<AecpMessageType>(controlData);
-
-					static std::unordered_map<AecpMessageType, std::function<Aecpdu::UniquePointer(ProtocolInterfacePcapImpl* const pi, EtherLayer2 const& etherLayer2, Deserializer& des, std::uint8_t const* const pkt_data, size_t const pkt_len)>, AecpMessageType::Hash> s_Dispatch{
-						{ AecpMessageType::AemCommand,
-							[](ProtocolInterfacePcapImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AemAecpdu::create(false);
-							} },
-						{ AecpMessageType::AemResponse,
-							[](ProtocolInterfacePcapImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AemAecpdu::create(true);
-							} },
-						{ AecpMessageType::AddressAccessCommand,
-							[](ProtocolInterfacePcapImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AaAecpdu::create(false);
-							} },
-						{ AecpMessageType::AddressAccessResponse,
-							[](ProtocolInterfacePcapImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-							{
-								return AaAecpdu::create(true);
-							} },
-						{ AecpMessageType::VendorUniqueCommand,
-							[](ProtocolInterfacePcapImpl* const pi, EtherLayer2 const& etherLayer2, Deserializer& des, std::uint8_t const* const pkt_data, size_t const pkt_len)
-							{
-								// We have to retrieve the ProtocolID to dispatch
-								auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
-								if (pkt_len >= (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifier::Size))
-								{
-									auto protocolIdentifier = VuAecpdu::ProtocolIdentifier::ArrayType{};
-									std::memcpy(protocolIdentifier.data(), pkt_data + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifier::Size);
-
-									auto const vuProtocolID = VuAecpdu::ProtocolIdentifier{ protocolIdentifier };
-									auto* vuDelegate = pi->getVendorUniqueDelegate(vuProtocolID);
-									if (vuDelegate)
-									{
-										// VendorUnique Commands are always handled by the VendorUniqueDelegate
-										auto aecpdu = vuDelegate->createAecpdu(vuProtocolID, false);
-										auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
-
-										// Deserialize the aecp message
-										pi->deserializeAecpMessage(etherLayer2, des, vuAecp);
-
-										// Low level notification
-										pi->notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, pi, vuAecp);
-
-										// Forward to the delegate
-										vuDelegate->onVuAecpCommand(pi, vuProtocolID, vuAecp);
-
-										// Return empty Aecpdu so that it's not processed by the StateMachineManager
-									}
-									else
-									{
-										LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Unhandled VendorUnique Command for ProtocolIdentifier {}", utils::toHexString(static_cast<VuAecpdu::ProtocolIdentifier::IntegralType>(vuProtocolID), true));
-									}
-								}
-								else
-								{
-									LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Invalid VendorUnique Command received. Not enough bytes in the message to hold ProtocolIdentifier");
-								}
-
-								return Aecpdu::UniquePointer{ nullptr, nullptr };
-							} },
-						{ AecpMessageType::VendorUniqueResponse,
-							[](ProtocolInterfacePcapImpl* const pi, EtherLayer2 const& etherLayer2, Deserializer& des, std::uint8_t const* const pkt_data, size_t const pkt_len)
-							{
-								// We have to retrieve the ProtocolID to dispatch
-								auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
-								if (pkt_len >= (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifier::Size))
-								{
-									auto protocolIdentifier = VuAecpdu::ProtocolIdentifier::ArrayType{};
-									std::memcpy(protocolIdentifier.data(), pkt_data + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifier::Size);
-
-									auto const vuProtocolID = VuAecpdu::ProtocolIdentifier{ protocolIdentifier };
-									auto* vuDelegate = pi->getVendorUniqueDelegate(vuProtocolID);
-									if (vuDelegate)
-									{
-										auto aecpdu = vuDelegate->createAecpdu(vuProtocolID, true);
-
-										// Are the messages handled by the VendorUniqueDelegate itself
-										if (!vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
-										{
-											auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
-
-											// Deserialize the aecp message
-											pi->deserializeAecpMessage(etherLayer2, des, vuAecp);
-
-											// Low level notification
-											pi->notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, pi, vuAecp);
-
-											// Forward to the delegate
-											vuDelegate->onVuAecpResponse(pi, vuProtocolID, vuAecp);
-
-											// Return empty Aecpdu so that it's not processed by the StateMachineManager
-											aecpdu.reset(nullptr);
-										}
-
-										return aecpdu;
-									}
-									else
-									{
-										LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Unhandled VendorUnique Response for ProtocolIdentifier {}", utils::toHexString(static_cast<VuAecpdu::ProtocolIdentifier::IntegralType>(vuProtocolID), true));
-									}
-								}
-								else
-								{
-									LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Invalid VendorUnique Command received. Not enough bytes in the message to hold ProtocolIdentifier");
-								}
-
-								return Aecpdu::UniquePointer{ nullptr, nullptr };
-							} },
-					};
-
-					auto const& it = s_Dispatch.find(messageType);
-					if (it == s_Dispatch.end())
-						return; // Unsupported AECP message type
-
-					// Create aecpdu frame based on message type
-					auto aecpdu = it->second(this, etherLayer2, des, pkt_data, pkt_len);
-
-					if (aecpdu != nullptr)
-					{
-						auto& aecp = static_cast<Aecpdu&>(*aecpdu);
+			return;
+		}
+		_nextReceiveStatisticsSample = now + ReceiveStatisticsSamplingPeriod;
 
-						// Deserialize the aecp message
-						deserializeAecpMessage(etherLayer2, des, aecp);
+		auto stats = pcap_stat{};
+		if (_pcapLibrary.stats(pcap, &stats) == 0)
+		{
+			_receivedFrames.store(stats.ps_recv, std::memory_order_relaxed);
+			_droppedFrames.store(stats.ps_drop, std::memory_order_relaxed);
+			_interfaceDroppedFrames.store(stats.ps_ifdrop, std::memory_order_relaxed);
+		}
+	}
 
-						// Low level notification
-						notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecp);
+	Error sendPacket(SerializationBuffer const& buffer, stateMachine::SentCommand const& command = {}) const noexcept
+	{
+		auto length = buffer.size();
+		constexpr auto minimumSize = EthernetPayloadMinimumSize + EtherLayer2::HeaderLength;
 
-						// Forward to our state machine
-						_stateMachineManager.processAecpdu(aecp);
-					}
-					break;
-				}
+		/* Check the buffer has enough bytes in it */
+		if (length < minimumSize)
+			length = minimumSize; // No need to resize nor pad the buffer, it has enough capacity and we don't care about the unused bytes. Simply increase the length of the data to send.
 
-				/* ACMP Message */
-				case AvtpSubType_Acmp:
-				{
-					auto acmpdu = Acmpdu::create();
-					auto& acmp = static_cast<Acmpdu&>(*acmpdu);
-
-					// Fill EtherLayer2
-					acmp.setSrcAddress(etherLayer2.getSrcAddress());
-					static_cast<EtherLayer2&>(*acmpdu).setDestAddress(etherLayer2.getDestAddress()); // Fill dest address, even if we know it's always the MultiCast address
-					// Then deserialize Avtp control
-					deserialize<AvtpduControl>(&acmp, des);
-					// Then deserialize Acmp
-					deserialize<Acmpdu>(&acmp, des);
-
-					// Low level notification
-					notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmp);
-
-					// Forward to our state machine
-					_stateMachineManager.processAcmpdu(acmp);
-					break;
-				}
+		recordSentFrame(buffer.data(), length);
 
-				/* MAAP Message */
-				case AvtpSubType_Maap:
-				{
-					break;
-				}
-				default:
-					return;
-			}
-		}
-		catch ([[maybe_unused]] std::invalid_argument const& e)
-		{
-			LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, std::string("ProtocolInterfacePCap: Packet dropped: ") + e.what());
-		}
-		catch (...)
-		{
-			AVDECC_ASSERT(false, "Unknown exception");
-			LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfacePCap: Packet dropped due to unknown exception");
-		}
+		// Frames are sent by the transmit queue thread
+		return _transmitQueue.enqueue(buffer.data(), length, command);
 	}
 
+	// Private types
+	struct Frame
+	{
+		std::array<std::uint8_t, EthernetMaxFrameSize> data{};
+		size_t length{ 0u };
+		std::chrono::nanoseconds kernelTimestamp{ 0 };
+	};
+
+	// Private constants
+	static constexpr auto MaxBatchSize = size_t{ 64u }; // Maximum number of packets read by a single pcap_dispatch call
+	static constexpr auto ReceiveStatisticsSamplingPeriod = std::chrono::milliseconds{ 100u }; // Minimum delay between two pcap_stats calls
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	static constexpr auto MaxBatchesPerWakeUp = size_t{ 8u }; // Maximum number of batches processed before giving the I/O reactor back to the other descriptors
+#endif // ENABLE_AVDECC_IO_REACTOR
+
 	// Private variables
+	FrameDecoder _frameDecoder{ *this, *this, _stateMachineManager }; // Declared first so it's destroyed last (owns the received PDUs pools)
 	watchDog::WatchDog::SharedPointer _watchDogSharedPointer{ watchDog::WatchDog::getInstance() };
 	watchDog::WatchDog& _watchDog{ *_watchDogSharedPointer };
+	watchDog::WatchDog::HeartbeatHandle _dispatchHeartbeat{ _watchDog.registerHeartbeat("avdecc::PCapInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(this)), std::chrono::milliseconds{ 1000u }) };
 	PcapInterface _pcapLibrary;
 	std::unique_ptr<pcap_t, std::function<void(pcap_t*)>> _pcap{ nullptr, nullptr };
+	mutable TransmitQueue _transmitQueue{ *this }; // Declared after _pcap so it's stopped before _pcap is released
 	int _fd{ -1 };
 	bool _shouldTerminate{ false };
 	mutable stateMachine::Manager _stateMachineManager{ this, this, this, this, this };
 	std::thread _captureThread{};
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	IoReactor::SharedPointer _ioReactor{ IoReactor::getInstance() };
+	std::atomic<IoReactor::Handle> _captureReader{ IoReactor::InvalidHandle }; // Used instead of _captureThread
+#endif // ENABLE_AVDECC_IO_REACTOR
+	std::array<Frame, MaxBatchSize> _batch{}; // Only accessed from the capture thread
+	size_t _batchCount{ 0u };
+	std::atomic_bool _isSniffingMode{ false };
+	std::mutex _filterProgramLock{}; // Protects _pendingFilterProgram
+	entityFilter::Program _pendingFilterProgram{};
+	std::atomic_bool _hasPendingFilterProgram{ false };
+	std::chrono::steady_clock::time_point _nextReceiveStatisticsSample{}; // Only accessed from the capture thread
+	std::atomic<std::uint64_t> _receivedFrames{ 0u }; // Written by the capture thread
+	std::atomic<std::uint64_t> _droppedFrames{ 0u }; // Written by the capture thread
+	std::atomic<std::uint64_t> _interfaceDroppedFrames{ 0u }; // Written by the capture thread
 };
 
 ProtocolInterfacePcap::ProtocolInterfacePcap(std::string const& networkInterfaceName)
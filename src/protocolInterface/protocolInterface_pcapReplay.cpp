@@ -0,0 +1,1045 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_pcapReplay.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/serialization.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolAaAecpdu.hpp"
+#include "la/avdecc/watchDog.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "stateMachine/stateMachineManager.hpp"
+#include "protocolInterface_pcapReplay.hpp"
+#include "pcapInterface.hpp"
+#include "frameDecoder.hpp"
+#include "logHelper.hpp"
+
+#include <stdexcept>
+#include <array>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <thread>
+#include <string>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
+#include <cstring>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace
+{
+// Offsets of the AECPDU fields in an ethernet frame, used to match sent commands with recorded responses without fully decoding them
+constexpr auto SubTypeOffset = EtherLayer2::HeaderLength;
+constexpr auto MessageTypeOffset = SubTypeOffset + 1u;
+constexpr auto ControlDataLengthOffset = SubTypeOffset + 2u;
+constexpr auto TargetEntityIDOffset = SubTypeOffset + 4u;
+constexpr auto ControllerEntityIDOffset = EtherLayer2::HeaderLength + AvtpduControl::HeaderLength;
+constexpr auto AecpPayloadOffset = ControllerEntityIDOffset + Aecpdu::HeaderLength;
+
+/** Returns true if the frame is an AVDECC one (same checks than the live capture) */
+bool isAvdeccFrame(std::uint8_t const* const frame, std::size_t const length) noexcept
+{
+	// Not enough bytes for an AVTP control frame, or too many for an AVDECC one
+	if (length <= EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+	{
+		return false;
+	}
+
+	// Check ether type (captures are usually not filtered)
+	auto const etherType = static_cast<std::uint16_t>((frame[12] << 8) | frame[13]);
+	if (etherType != AvtpEtherType)
+	{
+		return false;
+	}
+
+	// Check AVTP control bit (meaning AVDECC packet)
+	return (frame[SubTypeOffset] & 0x80) != 0;
+}
+
+/** Returns the AECP message type of the frame, or std::nullopt if it's not a valid AECPDU */
+std::optional<std::uint8_t> getAecpMessageType(std::uint8_t const* const frame, std::size_t const length) noexcept
+{
+	if (length < AecpPayloadOffset || (frame[SubTypeOffset] & 0x7f) != AvtpSubType_Aecp)
+	{
+		return std::nullopt;
+	}
+	return static_cast<std::uint8_t>(frame[MessageTypeOffset] & 0x0f);
+}
+
+/**
+* @brief Builds the key identifying an AECP command regardless of the controller sending it.
+* @details Made of the TargetEntityID, the MessageType and the command specific payload (ControllerEntityID and SequenceID excluded).
+*          Returns an empty string if the frame is truncated.
+*/
+std::string makeCommandKey(std::uint8_t const* const frame, std::size_t const length, std::uint8_t const messageType) noexcept
+{
+	auto const controlDataLength = static_cast<std::size_t>(((frame[ControlDataLengthOffset] & 0x07) << 8) | frame[ControlDataLengthOffset + 1]);
+	auto const payloadEnd = ControllerEntityIDOffset + controlDataLength;
+	if (controlDataLength < Aecpdu::HeaderLength || payloadEnd > length)
+	{
+		return {};
+	}
+
+	auto key = std::string(reinterpret_cast<char const*>(frame + TargetEntityIDOffset), 8u);
+	key.push_back(static_cast<char>(messageType));
+	key.append(reinterpret_cast<char const*>(frame + AecpPayloadOffset), payloadEnd - AecpPayloadOffset);
+	return key;
+}
+
+/** Builds the key pairing a recorded command with its response: TargetEntityID, ControllerEntityID and SequenceID */
+std::string makeTransactionKey(std::uint8_t const* const frame) noexcept
+{
+	return std::string(reinterpret_cast<char const*>(frame + TargetEntityIDOffset), AecpPayloadOffset - TargetEntityIDOffset);
+}
+} // namespace
+
+class ProtocolInterfacePcapReplayImpl final : public ProtocolInterfacePcapReplay, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private FrameDecoder::Delegate
+{
+public:
+	/* ************************************************************ */
+	/* Public APIs                                                  */
+	/* ************************************************************ */
+	/** Constructor */
+	ProtocolInterfacePcapReplayImpl(std::string const& filePath, networkInterface::MacAddress const& macAddress, ReplayMode const replayMode)
+		: ProtocolInterfacePcapReplay(filePath, macAddress)
+		, _replayMode{ replayMode }
+	{
+		// Should always be supported. Cannot create a PcapReplay ProtocolInterface if it's not supported.
+		AVDECC_ASSERT(isSupported(), "Should always be supported. Cannot create a PcapReplay ProtocolInterface if it's not supported");
+
+		// Load the whole capture before starting, so the replay doesn't depend on the disk speed
+		loadCaptureFile(filePath);
+		indexRecordedResponses();
+
+		// Start the replay thread
+		_replayThread = std::thread(
+			[this]
+			{
+				utils::setCurrentThreadName("avdecc::PcapReplayInterface::Replay");
+				replay();
+			});
+
+		// Start the state machines
+		_stateMachineManager.startStateMachines();
+	}
+
+	/** Destructor */
+	virtual ~ProtocolInterfacePcapReplayImpl() noexcept
+	{
+		shutdown();
+	}
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfacePcapReplayImpl(ProtocolInterfacePcapReplayImpl&&) = delete;
+	ProtocolInterfacePcapReplayImpl(ProtocolInterfacePcapReplayImpl const&) = delete;
+	ProtocolInterfacePcapReplayImpl& operator=(ProtocolInterfacePcapReplayImpl const&) = delete;
+	ProtocolInterfacePcapReplayImpl& operator=(ProtocolInterfacePcapReplayImpl&&) = delete;
+
+private:
+	// Private types
+	struct RecordedFrame
+	{
+		std::size_t offset{ 0u }; /**< Offset of the frame in _framesData */
+		std::size_t length{ 0u };
+		std::chrono::microseconds timestamp{}; /**< Relative to the first frame */
+	};
+
+	struct RecordedResponse
+	{
+		std::size_t frameIndex{ 0u };
+		std::chrono::microseconds latency{}; /**< Time the entity took to respond in the capture */
+	};
+
+	struct BatchFrame
+	{
+		std::uint8_t const* data{ nullptr };
+		std::size_t length{ 0u };
+	};
+
+	/* ************************************************************ */
+	/* ProtocolInterfacePcapReplay overrides                        */
+	/* ************************************************************ */
+	virtual bool waitForCompletion(std::chrono::milliseconds const timeout) const noexcept override
+	{
+		auto lock = std::unique_lock{ _lock };
+		return _condition.wait_for(lock, timeout,
+			[this]
+			{
+				return _isCompleted;
+			});
+	}
+
+	virtual ReplayStatistics getReplayStatistics() const noexcept override
+	{
+		auto statistics = ReplayStatistics{};
+		statistics.replayedFrames = _replayedFrames;
+		statistics.answeredCommands = _answeredCommands;
+		statistics.unansweredCommands = _unansweredCommands;
+		return statistics;
+	}
+
+	/* ************************************************************ */
+	/* ProtocolInterface overrides                                  */
+	/* ************************************************************ */
+	virtual void shutdown() noexcept override
+	{
+		// Stop the state machines
+		_stateMachineManager.stopStateMachines();
+
+		// Notify the thread we are shutting down
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_shouldTerminate = true;
+		}
+		_condition.notify_all();
+
+		// Wait for the thread to complete its pending tasks
+		if (_replayThread.joinable())
+		{
+			_replayThread.join();
+		}
+
+		// Release the heartbeat watch
+		if (_dispatchHeartbeat != watchDog::WatchDog::InvalidHeartbeatHandle)
+		{
+			_watchDog.unregisterHeartbeat(_dispatchHeartbeat);
+			_dispatchHeartbeat = watchDog::WatchDog::InvalidHeartbeatHandle;
+		}
+	}
+
+	virtual UniqueIdentifier getDynamicEID() const noexcept override
+	{
+		UniqueIdentifier::value_type eid{ 0u };
+		auto const& macAddress = getMacAddress();
+
+		eid += macAddress[0];
+		eid <<= 8;
+		eid += macAddress[1];
+		eid <<= 8;
+		eid += macAddress[2];
+		eid <<= 16;
+		std::srand(static_cast<unsigned int>(std::time(0)));
+		eid += static_cast<std::uint16_t>((std::rand() % 0xFFFD) + 1);
+		eid <<= 8;
+		eid += macAddress[3];
+		eid <<= 8;
+		eid += macAddress[4];
+		eid <<= 8;
+		eid += macAddress[5];
+
+		return UniqueIdentifier{ eid };
+	}
+
+	virtual void releaseDynamicEID(UniqueIdentifier const /*entityID*/) const noexcept override
+	{
+		// Nothing to do
+	}
+
+	virtual Error registerLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		// Checks if entity has declared an InterfaceInformation matching this ProtocolInterface
+		auto const index = _stateMachineManager.getMatchingInterfaceIndex(entity);
+
+		if (index)
+		{
+			return _stateMachineManager.registerLocalEntity(entity);
+		}
+
+		return Error::InvalidParameters;
+	}
+
+	virtual Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		return _stateMachineManager.unregisterLocalEntity(entity);
+	}
+
+	virtual Error setEntityNeedsAdvertise(entity::LocalEntity const& entity, entity::LocalEntity::AdvertiseFlags const /*flags*/) noexcept override
+	{
+		return _stateMachineManager.setEntityNeedsAdvertise(entity);
+	}
+
+	virtual Error enableEntityAdvertising(entity::LocalEntity& entity) noexcept override
+	{
+		return _stateMachineManager.enableEntityAdvertising(entity);
+	}
+
+	virtual Error disableEntityAdvertising(entity::LocalEntity const& entity) noexcept override
+	{
+		return _stateMachineManager.disableEntityAdvertising(entity);
+	}
+
+	virtual Error discoverRemoteEntities() const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntities();
+	}
+
+	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntity(entityID);
+	}
+
+	virtual Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
+	}
+
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setRemoteEntitiesUpdateCoalescingDelay(delay);
+	}
+
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryPacing(enabled);
+	}
+
+	virtual bool isDirectMessageSupported() const noexcept override
+	{
+		return true;
+	}
+
+	virtual Error sendAdpMessage(Adpdu const& adpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(adpdu);
+	}
+
+	virtual Error sendAecpMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(aecpdu);
+	}
+
+	virtual Error sendAcmpMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(acmpdu);
+	}
+
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(!isAecpResponseMessageType(messageType), "Calling sendAecpCommand with a Response MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueCommand)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult, priority);
+	}
+
+	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(isAecpResponseMessageType(messageType), "Calling sendAecpResponse with a Command MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueResponse)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Response can be directly sent
+		return sendMessage(static_cast<Aecpdu const&>(*aecpdu));
+	}
+
+	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override
+	{
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAcmpCommand(std::move(acmpdu), onResult);
+	}
+
+	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept override
+	{
+		// Response can be directly sent
+		return sendMessage(static_cast<Acmpdu const&>(*acmpdu));
+	}
+
+	virtual void lock() const noexcept override
+	{
+		_stateMachineManager.lock();
+	}
+
+	virtual void unlock() const noexcept override
+	{
+		_stateMachineManager.unlock();
+	}
+
+	virtual bool isSelfLocked() const noexcept override
+	{
+		return _stateMachineManager.isSelfLocked();
+	}
+
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override
+	{
+		return _frameDecoder.getPduPoolStatistics();
+	}
+
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override
+	{
+		// Frames are never put on the wire
+		auto statistics = TransmitQueueStatistics{};
+		statistics.sentFrames = _sentFrames;
+		statistics.sendBatches = _sentFrames;
+		return statistics;
+	}
+
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override
+	{
+		return _stateMachineManager.getCommandTimeoutStatistics();
+	}
+
+	virtual LockStatistics getLockStatistics() const noexcept override
+	{
+		return _stateMachineManager.getLockStatistics();
+	}
+
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override
+	{
+		// Frames are read from a file, nothing can be dropped
+		return {};
+	}
+
+	virtual Error setSniffingMode(bool const /*enabled*/) noexcept override
+	{
+		// All the frames of the capture file are always replayed
+		return Error::NoError;
+	}
+
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept override
+	{
+		if (length < EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+		{
+			return Error::InvalidParameters;
+		}
+
+		// Short frames are padded the same way serialized messages are
+		auto buffer = SerializationBuffer{};
+		buffer.packBuffer(frame, length);
+		return sendPacket(buffer);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::ProtocolInterfaceDelegate overrides            */
+	/* ************************************************************ */
+	/* **** AECP notifications **** */
+	virtual void onAecpCommand(Aecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpCommand, this, aecpdu);
+	}
+
+	/* **** ACMP notifications **** */
+	virtual void onAcmpCommand(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpCommand, this, acmpdu);
+	}
+
+	virtual void onAcmpResponse(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpResponse, this, acmpdu);
+	}
+
+	/* **** Sending methods **** */
+	virtual Error sendMessage(Adpdu const& adpdu) const noexcept override
+	{
+		try
+		{
+			// Build the full frame, exactly like a real transport would, so commands can be matched with the capture
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(adpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(adpdu, buffer);
+			// Then with Adp
+			serialize<Adpdu>(adpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(adpdu.getSrcAddress(), adpdu.getDestAddress(), std::string("Failed to serialize ADPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		try
+		{
+			// Build the full frame, exactly like a real transport would, so commands can be matched with the capture
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(aecpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(aecpdu, buffer);
+			// Then with Aecp
+			serialize<Aecpdu>(aecpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(aecpdu.getSrcAddress(), aecpdu.getDestAddress(), std::string("Failed to serialize AECPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		try
+		{
+			// Build the full frame, exactly like a real transport would, so commands can be matched with the capture
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(acmpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(acmpdu, buffer);
+			// Then with Acmp
+			serialize<Acmpdu>(acmpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(acmpdu.getSrcAddress(), Acmpdu::Multicast_Mac_Address, "Failed to serialize ACMPDU: {}", e.what());
+			return Error::InternalError;
+		}
+	}
+
+	/* *** Other methods **** */
+	virtual std::uint32_t getVuAecpCommandTimeoutMsec(VuAecpdu::ProtocolIdentifier const& protocolIdentifier, VuAecpdu const& aecpdu) const noexcept override
+	{
+		return getVuAecpCommandTimeout(protocolIdentifier, aecpdu);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::AdvertiseStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+
+	/* ************************************************************ */
+	/* stateMachine::DiscoveryStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+	virtual void onLocalEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOnline, this, entity);
+	}
+
+	virtual void onLocalEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOffline, this, entityID);
+	}
+
+	virtual void onLocalEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOnline, this, entity);
+	}
+
+	virtual void onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOffline, this, entityID);
+	}
+
+	virtual void onRemoteEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntitiesUpdated, this, entities);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::CommandStateMachine::Delegate overrides        */
+	/* ************************************************************ */
+	virtual void onAecpAemUnsolicitedResponse(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemUnsolicitedResponse, this, aecpdu);
+	}
+
+	virtual void onAecpAemIdentifyNotification(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemIdentifyNotification, this, aecpdu);
+	}
+	virtual void onAecpRetry(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpRetry, this, entityID);
+	}
+	virtual void onAecpTimeout(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpTimeout, this, entityID);
+	}
+	virtual void onAecpUnexpectedResponse(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpUnexpectedResponse, this, entityID);
+	}
+	virtual void onAecpResponseTime(UniqueIdentifier const& entityID, std::chrono::milliseconds const& responseTime) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpResponseTime, this, entityID, responseTime);
+	}
+
+	/* ************************************************************ */
+	/* FrameDecoder::Delegate overrides                             */
+	/* ************************************************************ */
+	virtual VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept override
+	{
+		return getVendorUniqueDelegate(protocolIdentifier);
+	}
+
+	virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adpdu);
+	}
+
+	virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecpdu);
+	}
+
+	virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmpdu);
+	}
+
+	/* ************************************************************ */
+	/* la::avdecc::utils::Subject overrides                         */
+	/* ************************************************************ */
+	virtual void onObserverRegistered(observer_type* const observer) noexcept override
+	{
+		if (observer)
+		{
+			class DiscoveryDelegate final : public stateMachine::DiscoveryStateMachine::Delegate
+			{
+			public:
+				DiscoveryDelegate(ProtocolInterface& pi, ProtocolInterface::Observer& obs)
+					: _pi{ pi }
+					, _obs{ obs }
+				{
+				}
+
+			private:
+				virtual void onLocalEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onLocalEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onLocalEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onLocalEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onRemoteEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntitiesUpdated(EntityReferences const& /*entities*/) noexcept override {}
+
+				ProtocolInterface& _pi;
+				ProtocolInterface::Observer& _obs;
+			};
+			auto discoveryDelegate = DiscoveryDelegate{ *this, static_cast<ProtocolInterface::Observer&>(*observer) };
+
+			_stateMachineManager.notifyDiscoveredEntities(discoveryDelegate);
+		}
+	}
+
+	/* ************************************************************ */
+	/* Private methods                                              */
+	/* ************************************************************ */
+	void loadCaptureFile(std::string const& filePath)
+	{
+		auto errbuf = std::array<char, PCAP_ERRBUF_SIZE>{};
+		auto* const pcap = _pcapLibrary.open_offline(filePath.c_str(), errbuf.data());
+		if (pcap == nullptr)
+		{
+			throw Exception(Error::InterfaceNotFound, errbuf.data());
+		}
+		// Close the file when leaving this method, whatever happens
+		auto const pcapGuard = std::unique_ptr<pcap_t, std::function<void(pcap_t*)>>{ pcap, [this](pcap_t* pcap)
+			{
+				_pcapLibrary.close(pcap);
+			} };
+
+		if (_pcapLibrary.datalink(pcap) != DLT_EN10MB)
+		{
+			throw Exception(Error::InvalidParameters, "Capture file is not an ethernet capture");
+		}
+
+		auto firstTimestamp = std::optional<std::chrono::microseconds>{};
+		while (true)
+		{
+			auto* header = static_cast<struct pcap_pkthdr*>(nullptr);
+			auto const* data = static_cast<u_char const*>(nullptr);
+			auto const result = _pcapLibrary.next_ex(pcap, &header, &data);
+			// End of file
+			if (result == -2)
+			{
+				break;
+			}
+			if (result != 1)
+			{
+				throw Exception(Error::TransportError, "Failed to read capture file");
+			}
+
+			if (!isAvdeccFrame(data, header->caplen))
+			{
+				continue;
+			}
+
+			auto const timestamp = std::chrono::seconds{ header->ts.tv_sec } + std::chrono::microseconds{ header->ts.tv_usec };
+			if (!firstTimestamp)
+			{
+				firstTimestamp = timestamp;
+			}
+
+			// All the frames are stored in a single buffer, it's way smaller than one fixed size buffer per frame
+			_frames.push_back(RecordedFrame{ _framesData.size(), header->caplen, timestamp - *firstTimestamp });
+			_framesData.insert(_framesData.end(), data, data + header->caplen);
+		}
+	}
+
+	/** Pairs the recorded AECP commands with their responses, so the commands sent during the replay can be answered */
+	void indexRecordedResponses() noexcept
+	{
+		struct PendingCommand
+		{
+			std::string commandKey{};
+			std::chrono::microseconds timestamp{};
+		};
+		auto pendingCommands = std::unordered_map<std::string, PendingCommand>{};
+
+		for (auto frameIndex = std::size_t{ 0u }; frameIndex < _frames.size(); ++frameIndex)
+		{
+			auto const& recordedFrame = _frames[frameIndex];
+			auto const* const frame = getFrameData(recordedFrame);
+			auto const messageType = getAecpMessageType(frame, recordedFrame.length);
+			if (!messageType)
+			{
+				continue;
+			}
+
+			// Commands have an even MessageType, their response being the next one
+			if ((*messageType & 0x01) == 0)
+			{
+				if (auto commandKey = makeCommandKey(frame, recordedFrame.length, *messageType); !commandKey.empty())
+				{
+					pendingCommands[makeTransactionKey(frame)] = PendingCommand{ std::move(commandKey), recordedFrame.timestamp };
+				}
+			}
+			else if (auto const pendingIt = pendingCommands.find(makeTransactionKey(frame)); pendingIt != pendingCommands.end())
+			{
+				// Only keep the first response to a given command
+				_recordedResponses.emplace(std::move(pendingIt->second.commandKey), RecordedResponse{ frameIndex, recordedFrame.timestamp - pendingIt->second.timestamp });
+				pendingCommands.erase(pendingIt);
+			}
+		}
+	}
+
+	std::uint8_t const* getFrameData(RecordedFrame const& recordedFrame) const noexcept
+	{
+		return _framesData.data() + recordedFrame.offset;
+	}
+
+	void replay() noexcept
+	{
+		auto const startTime = std::chrono::steady_clock::now();
+		auto nextFrameIndex = std::size_t{ 0u };
+		auto batch = std::vector<BatchFrame>{};
+		auto batchInjectedFrames = std::vector<std::vector<std::uint8_t>>{};
+		batch.reserve(MaxBatchSize);
+		batchInjectedFrames.reserve(MaxBatchSize);
+
+		auto lock = std::unique_lock{ _lock };
+		while (!_shouldTerminate)
+		{
+			auto const now = std::chrono::steady_clock::now();
+			auto nextDueTime = std::optional<std::chrono::steady_clock::time_point>{};
+			auto capturedFramesCount = std::size_t{ 0u };
+
+			// Gather all the frames that are due (up to MaxBatchSize), from both the capture and the injected responses, in order
+			while (batch.size() < MaxBatchSize)
+			{
+				auto captureDueTime = std::optional<std::chrono::steady_clock::time_point>{};
+				if (nextFrameIndex < _frames.size())
+				{
+					captureDueTime = _replayMode == ReplayMode::OriginalTiming ? startTime + _frames[nextFrameIndex].timestamp : now;
+				}
+
+				// Injected responses go first when they are due at the same time, a controller is waiting for them
+				if (!_injectedFrames.empty() && (!captureDueTime || _injectedFrames.begin()->first <= *captureDueTime))
+				{
+					auto const injectedIt = _injectedFrames.begin();
+					if (injectedIt->first > now)
+					{
+						nextDueTime = injectedIt->first;
+						break;
+					}
+					auto& injectedFrame = batchInjectedFrames.emplace_back(std::move(injectedIt->second));
+					batch.push_back(BatchFrame{ injectedFrame.data(), injectedFrame.size() });
+					_injectedFrames.erase(injectedIt);
+				}
+				else if (captureDueTime)
+				{
+					if (*captureDueTime > now)
+					{
+						nextDueTime = captureDueTime;
+						break;
+					}
+					auto const& recordedFrame = _frames[nextFrameIndex];
+					batch.push_back(BatchFrame{ getFrameData(recordedFrame), recordedFrame.length });
+					++nextFrameIndex;
+					++capturedFramesCount;
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if (!batch.empty())
+			{
+				// The state machines might send messages while processing the batch, don't hold our lock
+				lock.unlock();
+				processBatch(batch);
+				_replayedFrames += capturedFramesCount;
+				batch.clear();
+				batchInjectedFrames.clear();
+				lock.lock();
+				continue;
+			}
+
+			// The whole capture has been processed
+			if (nextFrameIndex == _frames.size() && !_isCompleted)
+			{
+				_isCompleted = true;
+				_condition.notify_all();
+			}
+
+			// Wait for the next frame to be due, or for a new injected response
+			if (nextDueTime)
+			{
+				_condition.wait_until(lock, *nextDueTime);
+			}
+			else
+			{
+				_condition.wait(lock);
+			}
+		}
+	}
+
+	void processBatch(std::vector<BatchFrame> const& batch) noexcept
+	{
+		// Try to detect possible deadlock
+		_watchDog.armHeartbeat(_dispatchHeartbeat);
+
+		{
+			// Lock the state machines once for the whole batch, instead of once per packet
+			auto const lg = std::lock_guard{ _stateMachineManager };
+
+			// Replayed frames are received when injected, not at the time they were captured
+			auto const receiveTime = std::chrono::steady_clock::now();
+
+			for (auto const& frame : batch)
+			{
+				_frameDecoder.processFrame(frame.data, frame.length, receiveTime);
+			}
+			_frameDecoder.completeBatch();
+		}
+
+		_watchDog.disarmHeartbeat(_dispatchHeartbeat);
+	}
+
+	Error sendPacket(SerializationBuffer const& buffer) const noexcept
+	{
+		// Nothing is put on the wire, but AECP commands are answered from the capture
+		++_sentFrames;
+		recordSentFrame(buffer.data(), buffer.size());
+		answerAecpCommand(buffer.data(), buffer.size());
+
+		return Error::NoError;
+	}
+
+	void answerAecpCommand(std::uint8_t const* const command, std::size_t const length) const noexcept
+	{
+		auto const messageType = getAecpMessageType(command, length);
+		if (!messageType || (*messageType & 0x01) != 0)
+		{
+			return;
+		}
+
+		auto const responseIt = _recordedResponses.find(makeCommandKey(command, length, *messageType));
+		if (responseIt == _recordedResponses.end())
+		{
+			++_unansweredCommands;
+			return;
+		}
+		++_answeredCommands;
+
+		auto const& recordedResponse = responseIt->second;
+		auto const& recordedFrame = _frames[recordedResponse.frameIndex];
+		auto const* const frame = getFrameData(recordedFrame);
+		auto response = std::vector<std::uint8_t>(frame, frame + recordedFrame.length);
+
+		// Address the response to the sender of the command
+		std::memcpy(response.data(), command + 6u, 6u); // DestMacAddress = command's SrcMacAddress
+		std::memcpy(response.data() + ControllerEntityIDOffset, command + ControllerEntityIDOffset, AecpPayloadOffset - ControllerEntityIDOffset); // ControllerEntityID + SequenceID
+
+		// Respond as fast as the recorded entity did, when replaying with the original timing
+		auto dueTime = std::chrono::steady_clock::now();
+		if (_replayMode == ReplayMode::OriginalTiming)
+		{
+			dueTime += recordedResponse.latency;
+		}
+
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_injectedFrames.emplace(dueTime, std::move(response));
+		}
+		_condition.notify_all();
+	}
+
+	// Private constants
+	static constexpr auto MaxBatchSize = std::size_t{ 64u }; // Maximum number of frames processed with a single lock of the state machines
+
+	// Private variables
+	FrameDecoder _frameDecoder{ *this, *this, _stateMachineManager }; // Declared first so it's destroyed last (owns the received PDUs pools)
+	watchDog::WatchDog::SharedPointer _watchDogSharedPointer{ watchDog::WatchDog::getInstance() };
+	watchDog::WatchDog& _watchDog{ *_watchDogSharedPointer };
+	watchDog::WatchDog::HeartbeatHandle _dispatchHeartbeat{ _watchDog.registerHeartbeat("avdecc::PcapReplayInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(this)), std::chrono::milliseconds{ 1000u }) };
+	PcapInterface _pcapLibrary;
+	ReplayMode const _replayMode{ ReplayMode::OriginalTiming };
+	std::vector<std::uint8_t> _framesData{}; // Immutable once the capture is loaded
+	std::vector<RecordedFrame> _frames{}; // Immutable once the capture is loaded
+	std::unordered_map<std::string, RecordedResponse> _recordedResponses{}; // Immutable once the capture is loaded
+	mutable std::mutex _lock{}; // Protects _injectedFrames, _isCompleted and _shouldTerminate
+	mutable std::condition_variable _condition{};
+	mutable std::multimap<std::chrono::steady_clock::time_point, std::vector<std::uint8_t>> _injectedFrames{};
+	bool _isCompleted{ false };
+	bool _shouldTerminate{ false };
+	mutable std::atomic<std::uint64_t> _sentFrames{ 0u };
+	mutable std::atomic<std::uint64_t> _answeredCommands{ 0u };
+	mutable std::atomic<std::uint64_t> _unansweredCommands{ 0u };
+	std::atomic<std::uint64_t> _replayedFrames{ 0u };
+	mutable stateMachine::Manager _stateMachineManager{ this, this, this, this, this };
+	std::thread _replayThread{};
+};
+
+ProtocolInterfacePcapReplay::ProtocolInterfacePcapReplay(std::string const& filePath, networkInterface::MacAddress const& macAddress)
+	: ProtocolInterface(filePath, macAddress)
+{
+}
+
+bool ProtocolInterfacePcapReplay::isSupported() noexcept
+{
+	try
+	{
+		PcapInterface pcapLibrary{};
+
+		return pcapLibrary.is_available();
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+ProtocolInterfacePcapReplay* ProtocolInterfacePcapReplay::createRawProtocolInterfacePcapReplay(std::string const& filePath, networkInterface::MacAddress const& macAddress, ReplayMode const replayMode)
+{
+	return new ProtocolInterfacePcapReplayImpl(filePath, macAddress, replayMode);
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
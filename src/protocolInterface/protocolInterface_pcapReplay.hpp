@@ -0,0 +1,94 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_pcapReplay.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+class ProtocolInterfacePcapReplay : public ProtocolInterface
+{
+public:
+	enum class ReplayMode
+	{
+		OriginalTiming = 0, /**< Frames are replayed with the same inter-frame delays than in the capture file */
+		AsFastAsPossible = 1, /**< Frames are replayed back to back, without any delay */
+	};
+
+	struct ReplayStatistics
+	{
+		std::uint64_t replayedFrames{ 0u }; /**< Number of frames of the capture file processed so far */
+		std::uint64_t answeredCommands{ 0u }; /**< Number of sent AECP commands a recorded response was found for */
+		std::uint64_t unansweredCommands{ 0u }; /**< Number of sent AECP commands no recorded response was found for */
+	};
+
+	static constexpr auto DefaultMacAddress = networkInterface::MacAddress{ { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 } }; /**< Locally administered MAC address used by createRawProtocolInterface */
+
+	/**
+	* @brief Factory method to create a new ProtocolInterfacePcapReplay.
+	* @details Creates a new ProtocolInterfacePcapReplay as a raw pointer. The AVDECC frames of the capture file (any format supported by libpcap, including pcapng)
+	*          are loaded in memory then fed to the state machines, exactly like frames received from a real network interface would.
+	*          Sent frames are never put on the wire, but each AECP command is answered with the matching response found in the capture file
+	*          (same target, command type and payload), so a controller can enumerate the recorded entities.
+	* @param[in] filePath The path to the capture file, also used as the network interface name.
+	* @param[in] macAddress The MAC address associated with the interface. Cannot be all 0.
+	* @param[in] replayMode How the frames of the capture file are scheduled.
+	* @return A new ProtocolInterfacePcapReplay as a raw pointer.
+	* @note Throws Exception if #filePath cannot be read, or is not an ethernet capture.
+	*/
+	static ProtocolInterfacePcapReplay* createRawProtocolInterfacePcapReplay(std::string const& filePath, networkInterface::MacAddress const& macAddress, ReplayMode const replayMode);
+
+	/** Returns true if this ProtocolInterface is supported (runtime check) */
+	static bool isSupported() noexcept;
+
+	/** Destructor */
+	virtual ~ProtocolInterfacePcapReplay() noexcept = default;
+
+	/** Waits for all the frames of the capture file to have been processed. Returns false if the timeout expired first. */
+	virtual bool waitForCompletion(std::chrono::milliseconds const timeout) const noexcept = 0;
+
+	/** Returns the statistics of the replay */
+	virtual ReplayStatistics getReplayStatistics() const noexcept = 0;
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfacePcapReplay(ProtocolInterfacePcapReplay&&) = delete;
+	ProtocolInterfacePcapReplay(ProtocolInterfacePcapReplay const&) = delete;
+	ProtocolInterfacePcapReplay& operator=(ProtocolInterfacePcapReplay const&) = delete;
+	ProtocolInterfacePcapReplay& operator=(ProtocolInterfacePcapReplay&&) = delete;
+
+protected:
+	ProtocolInterfacePcapReplay(std::string const& filePath, networkInterface::MacAddress const& macAddress);
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,861 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_proxy.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/serialization.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolAaAecpdu.hpp"
+#include "la/avdecc/internals/proxyServer.hpp"
+#include "la/avdecc/watchDog.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "stateMachine/stateMachineManager.hpp"
+#include "protocolInterface_proxy.hpp"
+#include "frameDecoder.hpp"
+#include "proxyProtocol.hpp"
+#include "logHelper.hpp"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <array>
+#include <thread>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <cstring>
+#include <cerrno>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace
+{
+constexpr auto WelcomeTimeout = std::chrono::seconds{ 2u }; /**< Maximum time to wait for the welcome message of the ProxyServer */
+
+/** An established connection to a ProxyServer */
+struct Connection
+{
+	int fd{ -1 };
+	proxy::MessageReader reader{}; // Might already contain the first messages following the welcome one
+	networkInterface::MacAddress macAddress{};
+};
+
+void setReceiveTimeout(int const fd, std::chrono::microseconds const timeout) noexcept
+{
+	auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+	auto value = timeval{};
+	value.tv_sec = static_cast<decltype(value.tv_sec)>(seconds.count());
+	value.tv_usec = static_cast<decltype(value.tv_usec)>((timeout - seconds).count());
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+}
+
+/** Connects to the ProxyServer and waits for its welcome message. Throws an Exception on error. */
+Connection connectToServer(std::string const& address)
+{
+	auto connection = Connection{};
+	connection.fd = proxy::connectTo(address);
+
+	try
+	{
+		setReceiveTimeout(connection.fd, WelcomeTimeout);
+		while (true)
+		{
+			if (auto const message = connection.reader.next())
+			{
+				auto const macAddress = proxy::parseWelcomeMessage(*message);
+				if (!macAddress)
+				{
+					throw ProtocolInterface::Exception(ProtocolInterface::Error::TransportError, "Incompatible proxy server " + address);
+				}
+				connection.macAddress = *macAddress;
+				break;
+			}
+
+			auto const status = connection.reader.read(connection.fd);
+			if (status == proxy::MessageReader::Status::WouldBlock)
+			{
+				throw ProtocolInterface::Exception(ProtocolInterface::Error::TransportError, "Proxy server " + address + " did not answer");
+			}
+			if (status != proxy::MessageReader::Status::Success)
+			{
+				throw ProtocolInterface::Exception(ProtocolInterface::Error::TransportError, "Connection to proxy server " + address + " lost");
+			}
+		}
+		setReceiveTimeout(connection.fd, std::chrono::microseconds{ 0 });
+	}
+	catch (...)
+	{
+		::close(connection.fd);
+		throw;
+	}
+
+	return connection;
+}
+} // namespace
+
+class ProtocolInterfaceProxyImpl final : public ProtocolInterfaceProxy, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private FrameDecoder::Delegate
+{
+public:
+	/* ************************************************************ */
+	/* Public APIs                                                  */
+	/* ************************************************************ */
+	/** Constructor */
+	ProtocolInterfaceProxyImpl(std::string const& proxyAddress, Connection&& connection)
+		: ProtocolInterfaceProxy(proxyAddress, connection.macAddress)
+		, _fd{ connection.fd }
+		, _reader{ std::move(connection.reader) }
+	{
+		// Should always be supported. Cannot create a Proxy ProtocolInterface if it's not supported.
+		AVDECC_ASSERT(isSupported(), "Should always be supported. Cannot create a Proxy ProtocolInterface if it's not supported");
+
+		// Start the capture thread
+		_captureThread = std::thread(
+			[this]
+			{
+				utils::setCurrentThreadName("avdecc::ProxyInterface::Capture");
+				receiveMessages();
+			});
+
+		// Start the state machines
+		_stateMachineManager.startStateMachines();
+	}
+
+	/** Destructor */
+	virtual ~ProtocolInterfaceProxyImpl() noexcept
+	{
+		shutdown();
+	}
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfaceProxyImpl(ProtocolInterfaceProxyImpl&&) = delete;
+	ProtocolInterfaceProxyImpl(ProtocolInterfaceProxyImpl const&) = delete;
+	ProtocolInterfaceProxyImpl& operator=(ProtocolInterfaceProxyImpl const&) = delete;
+	ProtocolInterfaceProxyImpl& operator=(ProtocolInterfaceProxyImpl&&) = delete;
+
+private:
+	/* ************************************************************ */
+	/* ProtocolInterface overrides                                  */
+	/* ************************************************************ */
+	virtual void shutdown() noexcept override
+	{
+		// Stop the state machines
+		_stateMachineManager.stopStateMachines();
+
+		// Notify the thread we are shutting down
+		_shouldTerminate = true;
+
+		// Wait for the thread to complete its pending tasks
+		if (_captureThread.joinable())
+		{
+			// Wake up the capture thread if it's waiting for a message
+			::shutdown(_fd, SHUT_RDWR);
+			_captureThread.join();
+		}
+
+		// Close the connection
+		if (_fd != -1)
+		{
+			::close(_fd);
+			_fd = -1;
+		}
+
+		// Release the heartbeat watch
+		if (_dispatchHeartbeat != watchDog::WatchDog::InvalidHeartbeatHandle)
+		{
+			_watchDog.unregisterHeartbeat(_dispatchHeartbeat);
+			_dispatchHeartbeat = watchDog::WatchDog::InvalidHeartbeatHandle;
+		}
+	}
+
+	virtual UniqueIdentifier getDynamicEID() const noexcept override
+	{
+		UniqueIdentifier::value_type eid{ 0u };
+		auto const& macAddress = getMacAddress();
+
+		eid += macAddress[0];
+		eid <<= 8;
+		eid += macAddress[1];
+		eid <<= 8;
+		eid += macAddress[2];
+		eid <<= 16;
+		std::srand(static_cast<unsigned int>(std::time(0)));
+		eid += static_cast<std::uint16_t>((std::rand() % 0xFFFD) + 1);
+		eid <<= 8;
+		eid += macAddress[3];
+		eid <<= 8;
+		eid += macAddress[4];
+		eid <<= 8;
+		eid += macAddress[5];
+
+		return UniqueIdentifier{ eid };
+	}
+
+	virtual void releaseDynamicEID(UniqueIdentifier const /*entityID*/) const noexcept override
+	{
+		// Nothing to do
+	}
+	virtual Error registerLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		// Checks if entity has declared an InterfaceInformation matching this ProtocolInterface
+		auto const index = _stateMachineManager.getMatchingInterfaceIndex(entity);
+
+		if (index)
+		{
+			auto const error = _stateMachineManager.registerLocalEntity(entity);
+			if (!error)
+			{
+				sendFilter();
+			}
+			return error;
+		}
+
+		return Error::InvalidParameters;
+	}
+
+	virtual Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		auto const error = _stateMachineManager.unregisterLocalEntity(entity);
+		if (!error)
+		{
+			sendFilter();
+		}
+		return error;
+	}
+
+	virtual Error setEntityNeedsAdvertise(entity::LocalEntity const& entity, entity::LocalEntity::AdvertiseFlags const /*flags*/) noexcept override
+	{
+		return _stateMachineManager.setEntityNeedsAdvertise(entity);
+	}
+
+	virtual Error enableEntityAdvertising(entity::LocalEntity& entity) noexcept override
+	{
+		return _stateMachineManager.enableEntityAdvertising(entity);
+	}
+
+	virtual Error disableEntityAdvertising(entity::LocalEntity const& entity) noexcept override
+	{
+		return _stateMachineManager.disableEntityAdvertising(entity);
+	}
+
+	virtual Error discoverRemoteEntities() const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntities();
+	}
+
+	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntity(entityID);
+	}
+
+	virtual Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
+	}
+
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setRemoteEntitiesUpdateCoalescingDelay(delay);
+	}
+
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryPacing(enabled);
+	}
+
+	virtual bool isDirectMessageSupported() const noexcept override
+	{
+		return true;
+	}
+
+	virtual Error sendAdpMessage(Adpdu const& adpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(adpdu);
+	}
+
+	virtual Error sendAecpMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(aecpdu);
+	}
+
+	virtual Error sendAcmpMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(acmpdu);
+	}
+
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(!isAecpResponseMessageType(messageType), "Calling sendAecpCommand with a Response MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueCommand)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult, priority);
+	}
+
+	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(isAecpResponseMessageType(messageType), "Calling sendAecpResponse with a Command MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueResponse)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Response can be directly sent
+		return sendMessage(static_cast<Aecpdu const&>(*aecpdu));
+	}
+
+	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override
+	{
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAcmpCommand(std::move(acmpdu), onResult);
+	}
+
+	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept override
+	{
+		// Response can be directly sent
+		return sendMessage(static_cast<Acmpdu const&>(*acmpdu));
+	}
+
+	virtual void lock() const noexcept override
+	{
+		_stateMachineManager.lock();
+	}
+
+	virtual void unlock() const noexcept override
+	{
+		_stateMachineManager.unlock();
+	}
+
+	virtual bool isSelfLocked() const noexcept override
+	{
+		return _stateMachineManager.isSelfLocked();
+	}
+
+
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override
+	{
+		return _frameDecoder.getPduPoolStatistics();
+	}
+
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override
+	{
+		// Frames are directly written to the socket, there is no transmit queue
+		auto statistics = TransmitQueueStatistics{};
+		statistics.sentFrames = _sentFrames.load(std::memory_order_relaxed);
+		statistics.failedFrames = _failedFrames.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override
+	{
+		return _stateMachineManager.getCommandTimeoutStatistics();
+	}
+
+	virtual LockStatistics getLockStatistics() const noexcept override
+	{
+		return _stateMachineManager.getLockStatistics();
+	}
+
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override
+	{
+		// Frames are captured by the ProxyServer, which does not forward its capture statistics
+		return {};
+	}
+
+	virtual Error setSniffingMode(bool const enabled) noexcept override
+	{
+		// Frames are filtered by the ProxyServer
+		_isSniffingMode = enabled;
+		return sendFilter();
+	}
+
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept override
+	{
+		if (length < EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+		{
+			return Error::InvalidParameters;
+		}
+
+		// Short frames are padded the same way serialized messages are
+		auto buffer = SerializationBuffer{};
+		buffer.packBuffer(frame, length);
+		return sendPacket(buffer);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::ProtocolInterfaceDelegate overrides            */
+	/* ************************************************************ */
+	/* **** AECP notifications **** */
+	virtual void onAecpCommand(Aecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpCommand, this, aecpdu);
+	}
+
+	/* **** ACMP notifications **** */
+	virtual void onAcmpCommand(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpCommand, this, acmpdu);
+	}
+
+	virtual void onAcmpResponse(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpResponse, this, acmpdu);
+	}
+
+	/* **** Sending methods **** */
+	virtual Error sendMessage(Adpdu const& adpdu) const noexcept override
+	{
+		try
+		{
+			// Proxy transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(adpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(adpdu, buffer);
+			// Then with Adp
+			serialize<Adpdu>(adpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(adpdu.getSrcAddress(), adpdu.getDestAddress(), std::string("Failed to serialize ADPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		try
+		{
+			// Proxy transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(aecpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(aecpdu, buffer);
+			// Then with Aecp
+			serialize<Aecpdu>(aecpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(aecpdu.getSrcAddress(), aecpdu.getDestAddress(), std::string("Failed to serialize AECPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		try
+		{
+			// Proxy transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(acmpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(acmpdu, buffer);
+			// Then with Acmp
+			serialize<Acmpdu>(acmpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(acmpdu.getSrcAddress(), Acmpdu::Multicast_Mac_Address, "Failed to serialize ACMPDU: {}", e.what());
+			return Error::InternalError;
+		}
+	}
+
+	/* *** Other methods **** */
+	virtual std::uint32_t getVuAecpCommandTimeoutMsec(VuAecpdu::ProtocolIdentifier const& protocolIdentifier, VuAecpdu const& aecpdu) const noexcept override
+	{
+		return getVuAecpCommandTimeout(protocolIdentifier, aecpdu);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::AdvertiseStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+
+	/* ************************************************************ */
+	/* stateMachine::DiscoveryStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+	virtual void onLocalEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOnline, this, entity);
+	}
+
+	virtual void onLocalEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOffline, this, entityID);
+	}
+
+	virtual void onLocalEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOnline, this, entity);
+	}
+
+	virtual void onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOffline, this, entityID);
+	}
+
+	virtual void onRemoteEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntitiesUpdated, this, entities);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::CommandStateMachine::Delegate overrides        */
+	/* ************************************************************ */
+	virtual void onAecpAemUnsolicitedResponse(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemUnsolicitedResponse, this, aecpdu);
+	}
+
+	virtual void onAecpAemIdentifyNotification(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemIdentifyNotification, this, aecpdu);
+	}
+	virtual void onAecpRetry(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpRetry, this, entityID);
+	}
+	virtual void onAecpTimeout(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpTimeout, this, entityID);
+	}
+	virtual void onAecpUnexpectedResponse(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpUnexpectedResponse, this, entityID);
+	}
+	virtual void onAecpResponseTime(UniqueIdentifier const& entityID, std::chrono::milliseconds const& responseTime) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpResponseTime, this, entityID, responseTime);
+	}
+
+	/* ************************************************************ */
+	/* FrameDecoder::Delegate overrides                             */
+	/* ************************************************************ */
+	virtual VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept override
+	{
+		return getVendorUniqueDelegate(protocolIdentifier);
+	}
+
+	virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adpdu);
+	}
+
+	virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecpdu);
+	}
+
+	virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmpdu);
+	}
+
+
+	/* ************************************************************ */
+	/* la::avdecc::utils::Subject overrides                         */
+	/* ************************************************************ */
+	virtual void onObserverRegistered(observer_type* const observer) noexcept override
+	{
+		if (observer)
+		{
+			class DiscoveryDelegate final : public stateMachine::DiscoveryStateMachine::Delegate
+			{
+			public:
+				DiscoveryDelegate(ProtocolInterface& pi, ProtocolInterface::Observer& obs)
+					: _pi{ pi }
+					, _obs{ obs }
+				{
+				}
+
+			private:
+				virtual void onLocalEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onLocalEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onLocalEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onLocalEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onRemoteEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntitiesUpdated(EntityReferences const& /*entities*/) noexcept override {}
+
+				ProtocolInterface& _pi;
+				ProtocolInterface::Observer& _obs;
+			};
+			auto discoveryDelegate = DiscoveryDelegate{ *this, static_cast<ProtocolInterface::Observer&>(*observer) };
+
+			_stateMachineManager.notifyDiscoveredEntities(discoveryDelegate);
+		}
+	}
+
+
+	/* ************************************************************ */
+	/* Private methods                                              */
+	/* ************************************************************ */
+	void receiveMessages() noexcept
+	{
+		while (!_shouldTerminate)
+		{
+			// Process the complete messages (the welcome message might have been followed by other messages)
+			while (auto const message = _reader.next())
+			{
+				processMessage(*message);
+			}
+
+			auto const status = _reader.hasError() ? proxy::MessageReader::Status::Error : _reader.read(_fd);
+			if (status == proxy::MessageReader::Status::Success || status == proxy::MessageReader::Status::WouldBlock)
+			{
+				continue;
+			}
+
+			// Connection closed by the server (or by shutdown)
+			if (!_shouldTerminate)
+			{
+				LOG_PROTOCOL_INTERFACE_ERROR(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceProxy: Connection to the proxy server lost");
+				notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onTransportError, this);
+			}
+			break;
+		}
+	}
+
+	void processMessage(proxy::Message const& message) noexcept
+	{
+		if (message.type != proxy::MessageType::Frames)
+		{
+			LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceProxy: Unexpected message type {} from the proxy server", static_cast<std::uint16_t>(message.type));
+			return;
+		}
+
+		// Try to detect possible deadlock
+		_watchDog.armHeartbeat(_dispatchHeartbeat);
+
+		{
+			// Lock the state machines once for the whole message, instead of once per frame
+			auto const lg = std::lock_guard{ _stateMachineManager };
+
+			// Frames are received when read from the socket
+			auto const receiveTime = std::chrono::steady_clock::now();
+
+			// Frames are decoded directly from the read buffer
+			auto const isValid = proxy::forEachFrame(message,
+				[this, receiveTime](std::uint8_t const* const /*record*/, std::uint8_t const* const frame, std::size_t const frameLength)
+				{
+					_frameDecoder.processFrame(frame, frameLength, receiveTime);
+				});
+			_frameDecoder.completeBatch();
+
+			if (!isValid)
+			{
+				LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceProxy: Malformed frames message from the proxy server");
+			}
+		}
+
+		_watchDog.disarmHeartbeat(_dispatchHeartbeat);
+	}
+
+	/** Sends the EntityIDs of the registered LocalEntities to the server, so it only forwards the relevant AECP messages */
+	Error sendFilter() noexcept
+	{
+		try
+		{
+			auto message = proxy::makeSetFilterMessage(_isSniffingMode, _stateMachineManager.getLocalEntityIDs());
+			auto vector = iovec{ message.data(), message.size() };
+
+			auto const lg = std::lock_guard{ _sendLock };
+			if (_fd == -1 || !proxy::sendAllVectors(_fd, &vector, 1u))
+			{
+				return Error::TransportError;
+			}
+			return Error::NoError;
+		}
+		catch (...)
+		{
+			return Error::InternalError;
+		}
+	}
+
+	Error sendPacket(SerializationBuffer const& buffer) const noexcept
+	{
+		auto length = buffer.size();
+		constexpr auto minimumSize = EthernetPayloadMinimumSize + EtherLayer2::HeaderLength;
+
+		/* Check the buffer has enough bytes in it */
+		if (length < minimumSize)
+			length = minimumSize; // No need to resize nor pad the buffer, it has enough capacity and we don't care about the unused bytes. Simply increase the length of the data to send.
+
+		recordSentFrame(buffer.data(), length);
+
+		// Send the frame as a single record message, without copying it
+		auto header = proxy::makeHeader(proxy::MessageType::Frames, 1u, proxy::RecordHeaderLength + length);
+		auto recordHeader = proxy::makeRecordHeader(length);
+		auto vectors = std::array<iovec, 3>{ iovec{ header.data(), header.size() }, iovec{ recordHeader.data(), recordHeader.size() }, iovec{ const_cast<std::uint8_t*>(buffer.data()), length } };
+
+		auto const lg = std::lock_guard{ _sendLock };
+		if (_fd == -1 || !proxy::sendAllVectors(_fd, vectors.data(), vectors.size()))
+		{
+			_failedFrames.fetch_add(1u, std::memory_order_relaxed);
+			return Error::TransportError;
+		}
+
+		_sentFrames.fetch_add(1u, std::memory_order_relaxed);
+		return Error::NoError;
+	}
+
+	// Private variables
+	FrameDecoder _frameDecoder{ *this, *this, _stateMachineManager }; // Declared first so it's destroyed last (owns the received PDUs pools)
+	watchDog::WatchDog::SharedPointer _watchDogSharedPointer{ watchDog::WatchDog::getInstance() };
+	watchDog::WatchDog& _watchDog{ *_watchDogSharedPointer };
+	watchDog::WatchDog::HeartbeatHandle _dispatchHeartbeat{ _watchDog.registerHeartbeat("avdecc::ProxyInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(this)), std::chrono::milliseconds{ 1000u }) };
+	int _fd{ -1 };
+	proxy::MessageReader _reader{}; // Only accessed from the capture thread (once constructed)
+	mutable std::mutex _sendLock{}; // Serializes the messages sent to the server
+	mutable std::atomic<std::uint64_t> _sentFrames{ 0u };
+	mutable std::atomic<std::uint64_t> _failedFrames{ 0u };
+	std::atomic_bool _isSniffingMode{ false };
+	std::atomic_bool _shouldTerminate{ false };
+	mutable stateMachine::Manager _stateMachineManager{ this, this, this, this, this };
+	std::thread _captureThread{};
+};
+
+ProtocolInterfaceProxy::ProtocolInterfaceProxy(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
+	: ProtocolInterface(networkInterfaceName, macAddress)
+{
+}
+
+bool ProtocolInterfaceProxy::isSupported() noexcept
+{
+	// Unix domain and TCP sockets are always available
+	return true;
+}
+
+ProtocolInterfaceProxy* ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(std::string const& proxyAddress)
+{
+	// Not an address, connect to the default address of the ProxyServer serving this network interface
+	auto address = proxyAddress;
+	if (!address.empty() && address[0] != '/' && address.find(':') == std::string::npos)
+	{
+		address = ProxyServer::getDefaultAddress(proxyAddress);
+	}
+
+	return new ProtocolInterfaceProxyImpl(proxyAddress, connectToServer(address));
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
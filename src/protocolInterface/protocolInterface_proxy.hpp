@@ -0,0 +1,66 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_proxy.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+class ProtocolInterfaceProxy : public ProtocolInterface
+{
+public:
+	/**
+	* @brief Factory method to create a new ProtocolInterfaceProxy.
+	* @details Creates a new ProtocolInterfaceProxy as a raw pointer, connected to a la::avdecc::protocol::ProxyServer.
+	* @param[in] proxyAddress The address of the ProxyServer ('unix:<path>', a path starting with '/', or '<host>:<port>'), or the name of a network interface
+	*            to connect to the ProxyServer listening on its default address (see ProxyServer::getDefaultAddress).
+	* @return A new ProtocolInterfaceProxy as a raw pointer.
+	* @note Throws Exception if the ProxyServer cannot be reached.
+	*/
+	static ProtocolInterfaceProxy* createRawProtocolInterfaceProxy(std::string const& proxyAddress);
+
+	/** Returns true if this ProtocolInterface is supported (runtime check) */
+	static bool isSupported() noexcept;
+
+	/** Destructor */
+	virtual ~ProtocolInterfaceProxy() noexcept = default;
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfaceProxy(ProtocolInterfaceProxy&&) = delete;
+	ProtocolInterfaceProxy(ProtocolInterfaceProxy const&) = delete;
+	ProtocolInterfaceProxy& operator=(ProtocolInterfaceProxy const&) = delete;
+	ProtocolInterfaceProxy& operator=(ProtocolInterfaceProxy&&) = delete;
+
+protected:
+	ProtocolInterfaceProxy(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress);
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
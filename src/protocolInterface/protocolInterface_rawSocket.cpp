@@ -0,0 +1,1158 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_rawSocket.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/serialization.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolAaAecpdu.hpp"
+#include "la/avdecc/watchDog.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "stateMachine/stateMachineManager.hpp"
+#include "protocolInterface_rawSocket.hpp"
+#include "frameDecoder.hpp"
+#include "entityFilter.hpp"
+#include "transmitQueue.hpp"
+#include "logHelper.hpp"
+#ifdef ENABLE_AVDECC_IO_REACTOR
+#	include "ioReactor.hpp"
+#endif // ENABLE_AVDECC_IO_REACTOR
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <array>
+#include <thread>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+class ProtocolInterfaceRawSocketImpl final : public ProtocolInterfaceRawSocket, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private FrameDecoder::Delegate, private TransmitQueue::Delegate
+{
+public:
+	/* ************************************************************ */
+	/* Public APIs                                                  */
+	/* ************************************************************ */
+	/** Constructor */
+	ProtocolInterfaceRawSocketImpl(std::string const& networkInterfaceName)
+		: ProtocolInterfaceRawSocket(networkInterfaceName)
+	{
+		// Should always be supported. Cannot create a RawSocket ProtocolInterface if it's not supported.
+		AVDECC_ASSERT(isSupported(), "Should always be supported. Cannot create a RawSocket ProtocolInterface if it's not supported");
+
+		// Get the index of the network interface
+		auto const interfaceIndex = ::if_nametoindex(networkInterfaceName.c_str());
+		if (interfaceIndex == 0)
+		{
+			throw Exception(Error::InterfaceNotFound, "No interface found with specified name");
+		}
+
+		// Open the socket and map the rings, releasing everything if anything fails
+		try
+		{
+			openSocket(static_cast<int>(interfaceIndex));
+		}
+		catch (...)
+		{
+			closeSocket();
+			throw;
+		}
+
+#ifdef ENABLE_AVDECC_IO_REACTOR
+		// Capture from the shared I/O reactor thread
+		_captureReader = _ioReactor->addReader(_fd,
+			[this](bool const hasError)
+			{
+				onCaptureReadable(hasError);
+			});
+		if (_captureReader == IoReactor::InvalidHandle)
+		{
+			closeSocket();
+			throw Exception(Error::TransportError, "Failed to register to the I/O reactor");
+		}
+#else // !ENABLE_AVDECC_IO_REACTOR
+		// Start the capture thread
+		_captureThread = std::thread(
+			[this]
+			{
+				utils::setCurrentThreadName("avdecc::RawSocketInterface::Capture");
+
+				auto fds = std::array<pollfd, 2>{ { { _fd, POLLIN | POLLERR, 0 }, { _wakeUpFd, POLLIN, 0 } } };
+
+				while (!_shouldTerminate)
+				{
+					// No block retired by the kernel, wait for one (or for shutdown() to wake us up)
+					if (processRetiredBlocks() == 0u)
+					{
+						if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0)
+						{
+							if (errno == EINTR)
+							{
+								continue;
+							}
+							break;
+						}
+						if ((fds[0].revents & POLLERR) != 0 && getSocketError() != 0)
+						{
+							break;
+						}
+					}
+				}
+
+				// Notify observers if we exited the loop because of an error
+				if (!_shouldTerminate)
+				{
+					// Socket error but we never asked for termination
+					notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onTransportError, this);
+				}
+			});
+#endif // ENABLE_AVDECC_IO_REACTOR
+
+		// Start the transmit queue
+		_transmitQueue.start("avdecc::RawSocketInterface::Send");
+
+		// Start the state machines
+		_stateMachineManager.startStateMachines();
+	}
+
+	/** Destructor */
+	virtual ~ProtocolInterfaceRawSocketImpl() noexcept
+	{
+		shutdown();
+	}
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfaceRawSocketImpl(ProtocolInterfaceRawSocketImpl&&) = delete;
+	ProtocolInterfaceRawSocketImpl(ProtocolInterfaceRawSocketImpl const&) = delete;
+	ProtocolInterfaceRawSocketImpl& operator=(ProtocolInterfaceRawSocketImpl const&) = delete;
+	ProtocolInterfaceRawSocketImpl& operator=(ProtocolInterfaceRawSocketImpl&&) = delete;
+
+private:
+	/* ************************************************************ */
+	/* ProtocolInterface overrides                                  */
+	/* ************************************************************ */
+	virtual void shutdown() noexcept override
+	{
+		// Stop the state machines
+		_stateMachineManager.stopStateMachines();
+
+		// Stop the transmit queue, after the last queued frames have been sent
+		_transmitQueue.stop();
+
+		// Notify the thread we are shutting down
+		_shouldTerminate = true;
+
+#ifdef ENABLE_AVDECC_IO_REACTOR
+		// Waits for the capture handler to complete if it's currently running
+		_ioReactor->remove(_captureReader.exchange(IoReactor::InvalidHandle));
+#endif // ENABLE_AVDECC_IO_REACTOR
+
+		// Wait for the thread to complete its pending tasks
+		if (_captureThread.joinable())
+		{
+			// Wake up the capture thread if it's waiting for a block
+			auto const value = std::uint64_t{ 1u };
+			[[maybe_unused]] auto const ret = ::write(_wakeUpFd, &value, sizeof(value));
+			_captureThread.join();
+		}
+
+		// Release the socket and the rings
+		closeSocket();
+
+		// Release the heartbeat watch
+		if (_dispatchHeartbeat != watchDog::WatchDog::InvalidHeartbeatHandle)
+		{
+			_watchDog.unregisterHeartbeat(_dispatchHeartbeat);
+			_dispatchHeartbeat = watchDog::WatchDog::InvalidHeartbeatHandle;
+		}
+	}
+
+	virtual UniqueIdentifier getDynamicEID() const noexcept override
+	{
+		UniqueIdentifier::value_type eid{ 0u };
+		auto const& macAddress = getMacAddress();
+
+		eid += macAddress[0];
+		eid <<= 8;
+		eid += macAddress[1];
+		eid <<= 8;
+		eid += macAddress[2];
+		eid <<= 16;
+		std::srand(static_cast<unsigned int>(std::time(0)));
+		eid += static_cast<std::uint16_t>((std::rand() % 0xFFFD) + 1);
+		eid <<= 8;
+		eid += macAddress[3];
+		eid <<= 8;
+		eid += macAddress[4];
+		eid <<= 8;
+		eid += macAddress[5];
+
+		return UniqueIdentifier{ eid };
+	}
+
+	virtual void releaseDynamicEID(UniqueIdentifier const /*entityID*/) const noexcept override
+	{
+		// Nothing to do
+	}
+
+	virtual Error registerLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		// Checks if entity has declared an InterfaceInformation matching this ProtocolInterface
+		auto const index = _stateMachineManager.getMatchingInterfaceIndex(entity);
+
+		if (index)
+		{
+			auto const error = _stateMachineManager.registerLocalEntity(entity);
+			if (!error)
+			{
+				updateFilterProgram();
+			}
+			return error;
+		}
+
+		return Error::InvalidParameters;
+	}
+
+	virtual Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		auto const error = _stateMachineManager.unregisterLocalEntity(entity);
+		if (!error)
+		{
+			updateFilterProgram();
+		}
+		return error;
+	}
+
+	virtual Error setEntityNeedsAdvertise(entity::LocalEntity const& entity, entity::LocalEntity::AdvertiseFlags const /*flags*/) noexcept override
+	{
+		return _stateMachineManager.setEntityNeedsAdvertise(entity);
+	}
+
+	virtual Error enableEntityAdvertising(entity::LocalEntity& entity) noexcept override
+	{
+		return _stateMachineManager.enableEntityAdvertising(entity);
+	}
+
+	virtual Error disableEntityAdvertising(entity::LocalEntity const& entity) noexcept override
+	{
+		return _stateMachineManager.disableEntityAdvertising(entity);
+	}
+
+	virtual Error discoverRemoteEntities() const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntities();
+	}
+
+	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntity(entityID);
+	}
+
+	virtual Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
+	}
+
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setRemoteEntitiesUpdateCoalescingDelay(delay);
+	}
+
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryPacing(enabled);
+	}
+
+	virtual bool isDirectMessageSupported() const noexcept override
+	{
+		return true;
+	}
+
+	virtual Error sendAdpMessage(Adpdu const& adpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(adpdu);
+	}
+
+	virtual Error sendAecpMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(aecpdu);
+	}
+
+	virtual Error sendAcmpMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(acmpdu);
+	}
+
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(!isAecpResponseMessageType(messageType), "Calling sendAecpCommand with a Response MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueCommand)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult, priority);
+	}
+
+	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(isAecpResponseMessageType(messageType), "Calling sendAecpResponse with a Command MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueResponse)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Response can be directly sent
+		return sendMessage(static_cast<Aecpdu const&>(*aecpdu));
+	}
+
+	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override
+	{
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAcmpCommand(std::move(acmpdu), onResult);
+	}
+
+	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept override
+	{
+		// Response can be directly sent
+		return sendMessage(static_cast<Acmpdu const&>(*acmpdu));
+	}
+
+	virtual void lock() const noexcept override
+	{
+		_stateMachineManager.lock();
+	}
+
+	virtual void unlock() const noexcept override
+	{
+		_stateMachineManager.unlock();
+	}
+
+	virtual bool isSelfLocked() const noexcept override
+	{
+		return _stateMachineManager.isSelfLocked();
+	}
+
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override
+	{
+		return _frameDecoder.getPduPoolStatistics();
+	}
+
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override
+	{
+		return _transmitQueue.getStatistics();
+	}
+
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override
+	{
+		return _stateMachineManager.getCommandTimeoutStatistics();
+	}
+
+	virtual LockStatistics getLockStatistics() const noexcept override
+	{
+		return _stateMachineManager.getLockStatistics();
+	}
+
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override
+	{
+		auto const lg = std::lock_guard{ _receiveStatisticsLock };
+
+		// Kernel counters are reset each time they are read, accumulate them
+		auto stats = tpacket_stats_v3{};
+		auto length = socklen_t{ sizeof(stats) };
+		if (_fd != -1 && ::getsockopt(_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &length) == 0)
+		{
+			_receiveStatistics.receivedFrames += stats.tp_packets; // Already includes the dropped frames
+			_receiveStatistics.droppedFrames += stats.tp_drops;
+		}
+		return _receiveStatistics;
+	}
+
+	virtual Error setSniffingMode(bool const enabled) noexcept override
+	{
+		_isSniffingMode = enabled;
+		updateFilterProgram();
+		return Error::NoError;
+	}
+
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept override
+	{
+		if (length < EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+		{
+			return Error::InvalidParameters;
+		}
+
+		// Short frames are padded the same way serialized messages are
+		auto buffer = SerializationBuffer{};
+		buffer.packBuffer(frame, length);
+		return sendPacket(buffer);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::ProtocolInterfaceDelegate overrides            */
+	/* ************************************************************ */
+	/* **** AECP notifications **** */
+	virtual void onAecpCommand(Aecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpCommand, this, aecpdu);
+	}
+
+	/* **** ACMP notifications **** */
+	virtual void onAcmpCommand(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpCommand, this, acmpdu);
+	}
+
+	virtual void onAcmpResponse(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpResponse, this, acmpdu);
+	}
+
+	/* **** Sending methods **** */
+	virtual Error sendMessage(Adpdu const& adpdu) const noexcept override
+	{
+		try
+		{
+			// Raw socket transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(adpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(adpdu, buffer);
+			// Then with Adp
+			serialize<Adpdu>(adpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(adpdu.getSrcAddress(), adpdu.getDestAddress(), std::string("Failed to serialize ADPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		try
+		{
+			// Raw socket transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(aecpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(aecpdu, buffer);
+			// Then with Aecp
+			serialize<Aecpdu>(aecpdu, buffer);
+
+			// Send the message (a command that cannot be sent after this call returned is reported to the state machines)
+			return sendPacket(buffer, stateMachine::SentCommand::fromMessage(aecpdu));
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(aecpdu.getSrcAddress(), aecpdu.getDestAddress(), std::string("Failed to serialize AECPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		try
+		{
+			// Raw socket transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(acmpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(acmpdu, buffer);
+			// Then with Acmp
+			serialize<Acmpdu>(acmpdu, buffer);
+
+			// Send the message (a command that cannot be sent after this call returned is reported to the state machines)
+			return sendPacket(buffer, stateMachine::SentCommand::fromMessage(acmpdu));
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(acmpdu.getSrcAddress(), Acmpdu::Multicast_Mac_Address, "Failed to serialize ACMPDU: {}", e.what());
+			return Error::InternalError;
+		}
+	}
+
+	/* *** Other methods **** */
+	virtual std::uint32_t getVuAecpCommandTimeoutMsec(VuAecpdu::ProtocolIdentifier const& protocolIdentifier, VuAecpdu const& aecpdu) const noexcept override
+	{
+		return getVuAecpCommandTimeout(protocolIdentifier, aecpdu);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::AdvertiseStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+
+	/* ************************************************************ */
+	/* stateMachine::DiscoveryStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+	virtual void onLocalEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOnline, this, entity);
+	}
+
+	virtual void onLocalEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOffline, this, entityID);
+	}
+
+	virtual void onLocalEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOnline, this, entity);
+	}
+
+	virtual void onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOffline, this, entityID);
+	}
+
+	virtual void onRemoteEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntitiesUpdated, this, entities);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::CommandStateMachine::Delegate overrides        */
+	/* ************************************************************ */
+	virtual void onAecpAemUnsolicitedResponse(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemUnsolicitedResponse, this, aecpdu);
+	}
+
+	virtual void onAecpAemIdentifyNotification(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemIdentifyNotification, this, aecpdu);
+	}
+	virtual void onAecpRetry(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpRetry, this, entityID);
+	}
+	virtual void onAecpTimeout(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpTimeout, this, entityID);
+	}
+	virtual void onAecpUnexpectedResponse(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpUnexpectedResponse, this, entityID);
+	}
+	virtual void onAecpResponseTime(UniqueIdentifier const& entityID, std::chrono::milliseconds const& responseTime) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpResponseTime, this, entityID, responseTime);
+	}
+	virtual bool isReadyToSendCommands() const noexcept override
+	{
+		return _transmitQueue.isReadyForCommands();
+	}
+
+	/* ************************************************************ */
+	/* FrameDecoder::Delegate overrides                             */
+	/* ************************************************************ */
+	virtual VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept override
+	{
+		return getVendorUniqueDelegate(protocolIdentifier);
+	}
+
+	virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adpdu);
+	}
+
+	virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecpdu);
+	}
+
+	virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmpdu);
+	}
+
+	/* ************************************************************ */
+	/* TransmitQueue::Delegate overrides                            */
+	/* ************************************************************ */
+	virtual std::size_t sendFrames(TransmitQueue::Frame const* const* const frames, std::size_t const count) noexcept override
+	{
+		AVDECC_ASSERT(_fd >= 0, "Trying to send a message but socket has been closed");
+		if (_fd < 0)
+		{
+			return 0u;
+		}
+
+		// No TX ring, send all the frames with a single system call
+		if (_txRing == nullptr)
+		{
+			return sendFramesWithSendmmsg(frames, count);
+		}
+
+		return sendFramesWithTxRing(frames, count);
+	}
+
+	virtual void onCommandNotSent(stateMachine::SentCommand const& command) noexcept override
+	{
+		_stateMachineManager.notifyCommandNotSent(command);
+	}
+
+	virtual void onReadyForCommands() noexcept override
+	{
+		_stateMachineManager.notifyReadyToSendCommands();
+	}
+
+	/* ************************************************************ */
+	/* la::avdecc::utils::Subject overrides                         */
+	/* ************************************************************ */
+	virtual void onObserverRegistered(observer_type* const observer) noexcept override
+	{
+		if (observer)
+		{
+			class DiscoveryDelegate final : public stateMachine::DiscoveryStateMachine::Delegate
+			{
+			public:
+				DiscoveryDelegate(ProtocolInterface& pi, ProtocolInterface::Observer& obs)
+					: _pi{ pi }
+					, _obs{ obs }
+				{
+				}
+
+			private:
+				virtual void onLocalEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onLocalEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onLocalEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onLocalEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onRemoteEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntitiesUpdated(EntityReferences const& /*entities*/) noexcept override {}
+
+				ProtocolInterface& _pi;
+				ProtocolInterface::Observer& _obs;
+			};
+			auto discoveryDelegate = DiscoveryDelegate{ *this, static_cast<ProtocolInterface::Observer&>(*observer) };
+
+			_stateMachineManager.notifyDiscoveredEntities(discoveryDelegate);
+		}
+	}
+
+	/* ************************************************************ */
+	/* Private methods                                              */
+	/* ************************************************************ */
+	bool setFilterProgram(entityFilter::Program const& filterProgram) const noexcept
+	{
+		static_assert(sizeof(sock_filter) == sizeof(entityFilter::Instruction), "entityFilter::Instruction must have the same layout than sock_filter");
+		auto filter = sock_fprog{};
+		filter.len = static_cast<unsigned short>(filterProgram.size());
+		filter.filter = reinterpret_cast<sock_filter*>(const_cast<entityFilter::Instruction*>(filterProgram.data()));
+		// The kernel atomically replaces the previous filter
+		return ::setsockopt(_fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) == 0;
+	}
+
+	/** Installs the filter program matching the currently registered local entities */
+	void updateFilterProgram() noexcept
+	{
+		try
+		{
+			// Lock the state machines so programs are installed in the same order the local entities changed
+			auto const lg = std::lock_guard{ _stateMachineManager };
+			auto const filterProgram = _isSniffingMode ? entityFilter::makeAvdeccProgram() : entityFilter::makeLocalEntitiesProgram(_stateMachineManager.getLocalEntityIDs());
+			if (!setFilterProgram(filterProgram))
+			{
+				LOG_PROTOCOL_INTERFACE_ERROR(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceRawSocket: Failed to set the kernel filter: {}", std::strerror(errno));
+			}
+		}
+		catch (...)
+		{
+			LOG_PROTOCOL_INTERFACE_ERROR(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceRawSocket: Failed to generate the kernel filter");
+		}
+	}
+
+	void openSocket(int const interfaceIndex)
+	{
+		auto const throwError = [](std::string const& message)
+		{
+			throw Exception(Error::TransportError, message + ": " + std::strerror(errno));
+		};
+
+		// Create a raw socket receiving all frames (including the ones sent by other local sockets, so we can see local entities), the kernel filter below will drop anything that is not AVDECC
+		_fd = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+		if (_fd < 0)
+		{
+			throwError("Failed to create AF_PACKET socket");
+		}
+
+		// Attach a kernel filter only accepting AVTP control frames (AVDECC), without the AECP messages not addressed to us (no local entity registered yet)
+		if (!setFilterProgram(entityFilter::makeLocalEntitiesProgram({})))
+		{
+			throwError("Failed to set ether filter");
+		}
+
+		// Use TPACKET_V3 so the kernel hands us whole blocks of frames
+		auto const version = int{ TPACKET_V3 };
+		if (::setsockopt(_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+		{
+			throwError("Failed to set TPACKET_V3");
+		}
+
+		// Have the kernel timestamp frames as soon as they are received by the network stack (reported in the RX ring headers), instead of when they are copied to the ring
+		auto const enableTimestamps = int{ 1 };
+		if (::setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enableTimestamps, sizeof(enableTimestamps)) < 0)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceRawSocket: SO_TIMESTAMPNS not supported: {}", std::strerror(errno));
+		}
+
+		// Configure the RX ring
+		auto rxRequest = tpacket_req3{};
+		rxRequest.tp_block_size = RxBlockSize;
+		rxRequest.tp_block_nr = RxBlockCount;
+		rxRequest.tp_frame_size = FrameSize;
+		rxRequest.tp_frame_nr = (RxBlockSize / FrameSize) * RxBlockCount;
+		rxRequest.tp_retire_blk_tov = RxBlockRetireTimeoutMsec;
+		if (::setsockopt(_fd, SOL_PACKET, PACKET_RX_RING, &rxRequest, sizeof(rxRequest)) < 0)
+		{
+			throwError("Failed to create RX ring");
+		}
+		_ringSize = static_cast<std::size_t>(RxBlockSize) * RxBlockCount;
+
+		// Configure the TX ring (only supported with TPACKET_V3 since linux 4.11, fallback to regular send if not available)
+		auto txRequest = tpacket_req3{};
+		txRequest.tp_block_size = TxBlockSize;
+		txRequest.tp_block_nr = TxBlockCount;
+		txRequest.tp_frame_size = FrameSize;
+		txRequest.tp_frame_nr = TxFrameCount;
+		auto const hasTxRing = ::setsockopt(_fd, SOL_PACKET, PACKET_TX_RING, &txRequest, sizeof(txRequest)) == 0;
+		if (hasTxRing)
+		{
+			_ringSize += static_cast<std::size_t>(TxBlockSize) * TxBlockCount;
+		}
+		else
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceRawSocket: TX ring not supported, using regular send: {}", std::strerror(errno));
+		}
+
+		// Map the rings (RX ring is always first)
+		auto* const ring = ::mmap(nullptr, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		if (ring == MAP_FAILED)
+		{
+			_ringSize = 0u;
+			throwError("Failed to map rings");
+		}
+		_rxRing = static_cast<std::uint8_t*>(ring);
+		if (hasTxRing)
+		{
+			_txRing = _rxRing + static_cast<std::size_t>(RxBlockSize) * RxBlockCount;
+		}
+
+		// Bind to the network interface
+		auto address = sockaddr_ll{};
+		address.sll_family = AF_PACKET;
+		address.sll_protocol = htons(ETH_P_ALL);
+		address.sll_ifindex = interfaceIndex;
+		if (::bind(_fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) < 0)
+		{
+			throwError("Failed to bind to network interface");
+		}
+
+		// Set promiscuous mode (same behavior than the PCap ProtocolInterface)
+		auto membership = packet_mreq{};
+		membership.mr_ifindex = interfaceIndex;
+		membership.mr_type = PACKET_MR_PROMISC;
+		if (::setsockopt(_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0)
+		{
+			throwError("Failed to set promiscuous mode");
+		}
+
+		// Create the event used to wake up the capture thread
+		_wakeUpFd = ::eventfd(0, EFD_CLOEXEC);
+		if (_wakeUpFd < 0)
+		{
+			throwError("Failed to create wake up event");
+		}
+	}
+
+	void closeSocket() noexcept
+	{
+		if (_rxRing != nullptr)
+		{
+			::munmap(_rxRing, _ringSize);
+			_rxRing = nullptr;
+			_txRing = nullptr;
+			_ringSize = 0u;
+		}
+		if (_fd >= 0)
+		{
+			::close(_fd);
+			_fd = -1;
+		}
+		if (_wakeUpFd >= 0)
+		{
+			::close(_wakeUpFd);
+			_wakeUpFd = -1;
+		}
+	}
+
+	int getSocketError() const noexcept
+	{
+		auto error = int{ 0 };
+		auto length = socklen_t{ sizeof(error) };
+		if (::getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0)
+		{
+			return errno;
+		}
+		return error;
+	}
+
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	/** Called from the I/O reactor thread when blocks have been retired by the kernel */
+	void onCaptureReadable(bool const hasError) noexcept
+	{
+		if (hasError && getSocketError() != 0)
+		{
+			// Socket error, stop reading from the descriptor
+			_ioReactor->remove(_captureReader.exchange(IoReactor::InvalidHandle));
+			notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onTransportError, this);
+			return;
+		}
+
+		processRetiredBlocks();
+	}
+#endif // ENABLE_AVDECC_IO_REACTOR
+
+	/** Processes the blocks retired by the kernel (at most a full ring), in order. Returns the number of processed blocks. */
+	std::uint32_t processRetiredBlocks() noexcept
+	{
+		auto processedCount = std::uint32_t{ 0u };
+
+		while (processedCount < RxBlockCount && !_shouldTerminate)
+		{
+			auto* const block = reinterpret_cast<tpacket_block_desc*>(_rxRing + _rxBlockIndex * RxBlockSize);
+
+			// Block still owned by the kernel
+			if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0)
+			{
+				break;
+			}
+
+			// Make sure we read the block content after its status
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			// Process all the frames of the block at once
+			processBlock(*block);
+
+			// Give the block back to the kernel
+			std::atomic_thread_fence(std::memory_order_release);
+			block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+			_rxBlockIndex = (_rxBlockIndex + 1u) % RxBlockCount;
+			++processedCount;
+		}
+
+		return processedCount;
+	}
+
+	void processBlock(tpacket_block_desc const& block) noexcept
+	{
+		auto const* const blockData = reinterpret_cast<std::uint8_t const*>(&block);
+		auto const packetsCount = block.hdr.bh1.num_pkts;
+		auto offset = block.hdr.bh1.offset_to_first_pkt;
+
+		// Try to detect possible deadlock
+		_watchDog.armHeartbeat(_dispatchHeartbeat);
+
+		{
+			// Lock the state machines once for the whole block, instead of once per packet
+			auto const lg = std::lock_guard{ _stateMachineManager };
+
+			for (auto packet = decltype(packetsCount){ 0u }; packet < packetsCount; ++packet)
+			{
+				auto const& packetHeader = *reinterpret_cast<tpacket3_hdr const*>(blockData + offset);
+
+				// Frames are decoded directly from the ring, without copy (using the receive time set by the kernel in the ring)
+				auto const receiveTime = FrameDecoder::fromKernelTimestamp(std::chrono::seconds{ packetHeader.tp_sec } + std::chrono::nanoseconds{ packetHeader.tp_nsec });
+				_frameDecoder.processFrame(blockData + offset + packetHeader.tp_mac, packetHeader.tp_snaplen, receiveTime);
+
+				offset += packetHeader.tp_next_offset;
+			}
+			_frameDecoder.completeBatch();
+		}
+
+		_watchDog.disarmHeartbeat(_dispatchHeartbeat);
+	}
+
+	Error sendPacket(SerializationBuffer const& buffer, stateMachine::SentCommand const& command = {}) const noexcept
+	{
+		auto length = buffer.size();
+		constexpr auto minimumSize = EthernetPayloadMinimumSize + EtherLayer2::HeaderLength;
+
+		/* Check the buffer has enough bytes in it */
+		if (length < minimumSize)
+			length = minimumSize; // No need to resize nor pad the buffer, it has enough capacity and we don't care about the unused bytes. Simply increase the length of the data to send.
+
+		recordSentFrame(buffer.data(), length);
+
+		// Frames are sent by the transmit queue thread
+		return _transmitQueue.enqueue(buffer.data(), length, command);
+	}
+
+	std::size_t sendFramesWithTxRing(TransmitQueue::Frame const* const* const frames, std::size_t const count) noexcept
+	{
+		auto sentCount = std::size_t{ 0u };
+		auto pendingCount = std::size_t{ 0u };
+
+		// Hand all the pending slots to the kernel with a single system call (blocking until the frames have been sent)
+		auto const flush = [this, &sentCount, &pendingCount]()
+		{
+			auto const success = pendingCount == 0u || ::send(_fd, nullptr, 0, 0) >= 0;
+			if (success)
+			{
+				sentCount += pendingCount;
+			}
+			pendingCount = 0u;
+			return success;
+		};
+
+		for (auto frameIndex = std::size_t{ 0u }; frameIndex < count; ++frameIndex)
+		{
+			auto const& frame = *frames[frameIndex];
+
+			// Frames are sent in order, stop at the first one that cannot be sent
+			if (frame.length > (FrameSize - TxFrameDataOffset))
+			{
+				break;
+			}
+
+			// Get next TX slot, flushing the ring if it's full
+			auto* frameHeader = reinterpret_cast<tpacket3_hdr*>(_txRing + _txFrameIndex * FrameSize);
+			if (frameHeader->tp_status != TP_STATUS_AVAILABLE && frameHeader->tp_status != TP_STATUS_WRONG_FORMAT)
+			{
+				if (!flush() || (frameHeader->tp_status != TP_STATUS_AVAILABLE && frameHeader->tp_status != TP_STATUS_WRONG_FORMAT))
+				{
+					return sentCount;
+				}
+			}
+
+			// Copy the frame to the slot
+			std::memcpy(reinterpret_cast<std::uint8_t*>(frameHeader) + TxFrameDataOffset, frame.data.data(), frame.length);
+			frameHeader->tp_len = static_cast<std::uint32_t>(frame.length);
+			frameHeader->tp_snaplen = static_cast<std::uint32_t>(frame.length);
+			frameHeader->tp_next_offset = 0u;
+
+			// Give the slot to the kernel
+			std::atomic_thread_fence(std::memory_order_release);
+			frameHeader->tp_status = TP_STATUS_SEND_REQUEST;
+			_txFrameIndex = (_txFrameIndex + 1u) % TxFrameCount;
+			++pendingCount;
+		}
+
+		flush();
+
+		return sentCount;
+	}
+
+	std::size_t sendFramesWithSendmmsg(TransmitQueue::Frame const* const* const frames, std::size_t const count) noexcept
+	{
+		auto messages = std::array<mmsghdr, TransmitQueue::MaximumBatchSize>{};
+		auto vectors = std::array<iovec, TransmitQueue::MaximumBatchSize>{};
+		auto const messagesCount = std::min(count, messages.size());
+
+		for (auto frameIndex = std::size_t{ 0u }; frameIndex < messagesCount; ++frameIndex)
+		{
+			auto const& frame = *frames[frameIndex];
+			vectors[frameIndex].iov_base = const_cast<std::uint8_t*>(frame.data.data());
+			vectors[frameIndex].iov_len = frame.length;
+			messages[frameIndex].msg_hdr.msg_iov = &vectors[frameIndex];
+			messages[frameIndex].msg_hdr.msg_iovlen = 1u;
+		}
+
+		// sendmmsg might send less messages than requested, retry with the remaining ones
+		auto sentCount = std::size_t{ 0u };
+		while (sentCount < messagesCount)
+		{
+			auto const ret = ::sendmmsg(_fd, messages.data() + sentCount, static_cast<unsigned int>(messagesCount - sentCount), 0);
+			if (ret <= 0)
+			{
+				if (ret < 0 && errno == EINTR)
+				{
+					continue;
+				}
+				break;
+			}
+			sentCount += static_cast<std::size_t>(ret);
+		}
+
+		return sentCount;
+	}
+
+	// Private constants
+	static constexpr auto FrameSize = std::uint32_t{ 2048u }; // Enough for a full ethernet frame plus TPACKET header
+	static constexpr auto RxBlockSize = std::uint32_t{ 1u << 16 }; // Must be a multiple of the page size
+	static constexpr auto RxBlockCount = std::uint32_t{ 32u };
+	static constexpr auto RxBlockRetireTimeoutMsec = std::uint32_t{ 5u }; // Same latency than the PCap read timeout
+	static constexpr auto TxBlockSize = std::uint32_t{ 1u << 16 }; // Must be a multiple of the page size
+	static constexpr auto TxBlockCount = std::uint32_t{ 1u };
+	static constexpr auto TxFrameCount = (TxBlockSize / FrameSize) * TxBlockCount;
+	static constexpr auto TxFrameDataOffset = std::uint32_t{ TPACKET3_HDRLEN - sizeof(sockaddr_ll) };
+
+	// Private variables
+	FrameDecoder _frameDecoder{ *this, *this, _stateMachineManager }; // Declared first so it's destroyed last (owns the received PDUs pools)
+	mutable TransmitQueue _transmitQueue{ *this };
+	watchDog::WatchDog::SharedPointer _watchDogSharedPointer{ watchDog::WatchDog::getInstance() };
+	watchDog::WatchDog& _watchDog{ *_watchDogSharedPointer };
+	watchDog::WatchDog::HeartbeatHandle _dispatchHeartbeat{ _watchDog.registerHeartbeat("avdecc::RawSocketInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(this)), std::chrono::milliseconds{ 1000u }) };
+	int _fd{ -1 };
+	int _wakeUpFd{ -1 };
+	std::uint8_t* _rxRing{ nullptr };
+	std::uint8_t* _txRing{ nullptr };
+	std::size_t _ringSize{ 0u };
+	std::uint32_t _txFrameIndex{ 0u };
+	std::uint32_t _rxBlockIndex{ 0u }; // Only accessed from the capture thread
+	std::atomic_bool _isSniffingMode{ false };
+	mutable std::mutex _receiveStatisticsLock{}; // Protects _receiveStatistics
+	mutable ReceiveStatistics _receiveStatistics{}; // Accumulated kernel counters
+	bool _shouldTerminate{ false };
+	mutable stateMachine::Manager _stateMachineManager{ this, this, this, this, this };
+	std::thread _captureThread{};
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	IoReactor::SharedPointer _ioReactor{ IoReactor::getInstance() };
+	std::atomic<IoReactor::Handle> _captureReader{ IoReactor::InvalidHandle }; // Used instead of _captureThread
+#endif // ENABLE_AVDECC_IO_REACTOR
+};
+
+ProtocolInterfaceRawSocket::ProtocolInterfaceRawSocket(std::string const& networkInterfaceName)
+	: ProtocolInterface(networkInterfaceName)
+{
+}
+
+bool ProtocolInterfaceRawSocket::isSupported() noexcept
+{
+	// AF_PACKET sockets are always available on linux (but require CAP_NET_RAW to be opened)
+	return true;
+}
+
+ProtocolInterfaceRawSocket* ProtocolInterfaceRawSocket::createRawProtocolInterfaceRawSocket(std::string const& networkInterfaceName)
+{
+	return new ProtocolInterfaceRawSocketImpl(networkInterfaceName);
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
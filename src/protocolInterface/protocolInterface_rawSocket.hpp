@@ -0,0 +1,65 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_rawSocket.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+class ProtocolInterfaceRawSocket : public ProtocolInterface
+{
+public:
+	/**
+	* @brief Factory method to create a new ProtocolInterfaceRawSocket.
+	* @details Creates a new ProtocolInterfaceRawSocket as a raw pointer. Uses a linux AF_PACKET socket with TPACKET_V3 memory mapped rings.
+	* @param[in] networkInterfaceName The name of the network interface to use.
+	* @return A new ProtocolInterfaceRawSocket as a raw pointer.
+	* @note Throws Exception if #interfaceName is invalid or inaccessible.
+	*/
+	static ProtocolInterfaceRawSocket* createRawProtocolInterfaceRawSocket(std::string const& networkInterfaceName);
+
+	/** Returns true if this ProtocolInterface is supported (runtime check) */
+	static bool isSupported() noexcept;
+
+	/** Destructor */
+	virtual ~ProtocolInterfaceRawSocket() noexcept = default;
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfaceRawSocket(ProtocolInterfaceRawSocket&&) = delete;
+	ProtocolInterfaceRawSocket(ProtocolInterfaceRawSocket const&) = delete;
+	ProtocolInterfaceRawSocket& operator=(ProtocolInterfaceRawSocket const&) = delete;
+	ProtocolInterfaceRawSocket& operator=(ProtocolInterfaceRawSocket&&) = delete;
+
+protected:
+	ProtocolInterfaceRawSocket(std::string const& networkInterfaceName);
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
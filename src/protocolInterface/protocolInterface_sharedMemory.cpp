@@ -0,0 +1,1069 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_sharedMemory.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/serialization.hpp"
+#include "la/avdecc/internals/protocolAemAecpdu.hpp"
+#include "la/avdecc/internals/protocolAaAecpdu.hpp"
+#include "la/avdecc/watchDog.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "stateMachine/stateMachineManager.hpp"
+#include "protocolInterface_sharedMemory.hpp"
+#include "frameDecoder.hpp"
+#include "logHelper.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <array>
+#include <thread>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <new>
+#include <cstdlib>
+#include <ctime>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace
+{
+/**
+* @brief Layout of the shared memory segment: a SegmentHeader followed by SlotsCount Slot.
+* @details The ring is a broadcast one: producers never wait for consumers, each consumer (one per ProtocolInterface) has its own read position
+*          and detects when it has been overrun. Each slot is protected by a sequence number (seqlock): odd while a producer writes the slot,
+*          2 * (position + 1) once the frame at position is committed.
+*/
+constexpr auto SegmentMagic = std::uint32_t{ 0x41564443 }; // 'AVDC'
+constexpr auto SegmentVersion = std::uint32_t{ 1u };
+constexpr auto SlotsCount = std::uint32_t{ 4096u };
+constexpr auto CacheLineSize = std::size_t{ 64u };
+
+struct alignas(CacheLineSize) Slot
+{
+	std::atomic<std::uint64_t> sequence{ 0u };
+	std::uint32_t length{ 0u };
+	std::uint8_t data[EthernetMaxFrameSize]{};
+};
+
+struct SegmentHeader
+{
+	std::atomic<std::uint32_t> magic{ 0u }; // Set last by the creator of the segment, once everything else has been initialized
+	std::uint32_t version{ SegmentVersion };
+	std::uint32_t slotsCount{ SlotsCount };
+	std::uint32_t slotSize{ sizeof(Slot) };
+	std::atomic<std::uint32_t> attachedCount{ 0u };
+	alignas(CacheLineSize) std::atomic<std::uint64_t> writePosition{ 0u };
+	alignas(CacheLineSize) std::atomic<std::uint32_t> generation{ 0u }; // Futex word, incremented each time a frame is committed
+	std::atomic<std::uint32_t> waitersCount{ 0u };
+};
+
+constexpr auto HeaderSize = ((sizeof(SegmentHeader) + CacheLineSize - 1u) / CacheLineSize) * CacheLineSize;
+constexpr auto SegmentSize = HeaderSize + sizeof(Slot) * SlotsCount;
+
+// Atomics are shared between processes, they have to be address-free
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free, "Shared memory atomics must be lock-free");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "Futex word must be 32 bits");
+
+constexpr std::uint64_t committedSequence(std::uint64_t const position) noexcept
+{
+	return (position + 1u) * 2u;
+}
+
+int futex(std::atomic<std::uint32_t>* const address, int const operation, std::uint32_t const value, timespec const* const timeout) noexcept
+{
+	// Not using FUTEX_PRIVATE_FLAG, the futex word is shared with other processes
+	return static_cast<int>(::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(address), operation, value, timeout, nullptr, 0));
+}
+} // namespace
+
+class ProtocolInterfaceSharedMemoryImpl final : public ProtocolInterfaceSharedMemory, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private FrameDecoder::Delegate
+{
+public:
+	static constexpr auto MaximumProcessBatchSize = std::size_t{ 64u }; /**< Maximum number of frames processed while holding the state machines lock */
+	static constexpr auto WaitTimeout = std::chrono::milliseconds{ 100u }; /**< Maximum time the capture thread waits for a frame, before checking for stalled slots */
+	static constexpr auto StalledSlotTimeout = std::chrono::milliseconds{ 500u }; /**< Time after which a claimed but never committed slot is skipped (producer crashed) */
+	static constexpr auto AttachTimeout = std::chrono::seconds{ 2u }; /**< Maximum time to wait for the creator of the segment to initialize it */
+
+	/* ************************************************************ */
+	/* Public APIs                                                  */
+	/* ************************************************************ */
+	/** Constructor */
+	ProtocolInterfaceSharedMemoryImpl(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
+		: ProtocolInterfaceSharedMemory(networkInterfaceName, macAddress)
+	{
+		// Should always be supported. Cannot create a SharedMemory ProtocolInterface if it's not supported.
+		AVDECC_ASSERT(isSupported(), "Should always be supported. Cannot create a SharedMemory ProtocolInterface if it's not supported");
+
+		// Check the name can be used as a shared memory object name
+		if (networkInterfaceName.find('/') != std::string::npos || networkInterfaceName.size() > (NAME_MAX - 8u))
+		{
+			throw Exception(Error::InvalidParameters, "Invalid shared memory network name");
+		}
+		_segmentName = "/avdecc." + networkInterfaceName;
+
+		// Open (or create) the segment, releasing everything if anything fails
+		try
+		{
+			openSegment();
+		}
+		catch (...)
+		{
+			closeSegment();
+			throw;
+		}
+
+		// Start the capture thread
+		_captureThread = std::thread(
+			[this]
+			{
+				utils::setCurrentThreadName("avdecc::SharedMemoryInterface::Capture");
+				captureFrames();
+			});
+
+		// Start the state machines
+		_stateMachineManager.startStateMachines();
+	}
+
+	/** Destructor */
+	virtual ~ProtocolInterfaceSharedMemoryImpl() noexcept
+	{
+		shutdown();
+	}
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfaceSharedMemoryImpl(ProtocolInterfaceSharedMemoryImpl&&) = delete;
+	ProtocolInterfaceSharedMemoryImpl(ProtocolInterfaceSharedMemoryImpl const&) = delete;
+	ProtocolInterfaceSharedMemoryImpl& operator=(ProtocolInterfaceSharedMemoryImpl const&) = delete;
+	ProtocolInterfaceSharedMemoryImpl& operator=(ProtocolInterfaceSharedMemoryImpl&&) = delete;
+
+private:
+	/* ************************************************************ */
+	/* ProtocolInterface overrides                                  */
+	/* ************************************************************ */
+	virtual void shutdown() noexcept override
+	{
+		// Stop the state machines
+		_stateMachineManager.stopStateMachines();
+
+		// Notify the thread we are shutting down
+		_shouldTerminate = true;
+
+		// Wait for the thread to complete its pending tasks
+		if (_captureThread.joinable())
+		{
+			// Wake up the capture thread if it's waiting for a frame (also wakes up other consumers, which will simply wait again)
+			futex(&_header->generation, FUTEX_WAKE, INT_MAX, nullptr);
+			_captureThread.join();
+		}
+
+		// Detach from the segment
+		closeSegment();
+
+		// Release the heartbeat watch
+		if (_dispatchHeartbeat != watchDog::WatchDog::InvalidHeartbeatHandle)
+		{
+			_watchDog.unregisterHeartbeat(_dispatchHeartbeat);
+			_dispatchHeartbeat = watchDog::WatchDog::InvalidHeartbeatHandle;
+		}
+	}
+
+	virtual UniqueIdentifier getDynamicEID() const noexcept override
+	{
+		UniqueIdentifier::value_type eid{ 0u };
+		auto const& macAddress = getMacAddress();
+
+		eid += macAddress[0];
+		eid <<= 8;
+		eid += macAddress[1];
+		eid <<= 8;
+		eid += macAddress[2];
+		eid <<= 16;
+		std::srand(static_cast<unsigned int>(std::time(0)));
+		eid += static_cast<std::uint16_t>((std::rand() % 0xFFFD) + 1);
+		eid <<= 8;
+		eid += macAddress[3];
+		eid <<= 8;
+		eid += macAddress[4];
+		eid <<= 8;
+		eid += macAddress[5];
+
+		return UniqueIdentifier{ eid };
+	}
+
+	virtual void releaseDynamicEID(UniqueIdentifier const /*entityID*/) const noexcept override
+	{
+		// Nothing to do
+	}
+
+	virtual Error registerLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		// Checks if entity has declared an InterfaceInformation matching this ProtocolInterface
+		auto const index = _stateMachineManager.getMatchingInterfaceIndex(entity);
+
+		if (index)
+		{
+			return _stateMachineManager.registerLocalEntity(entity);
+		}
+
+		return Error::InvalidParameters;
+	}
+
+	virtual Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept override
+	{
+		return _stateMachineManager.unregisterLocalEntity(entity);
+	}
+
+	virtual Error setEntityNeedsAdvertise(entity::LocalEntity const& entity, entity::LocalEntity::AdvertiseFlags const /*flags*/) noexcept override
+	{
+		return _stateMachineManager.setEntityNeedsAdvertise(entity);
+	}
+
+	virtual Error enableEntityAdvertising(entity::LocalEntity& entity) noexcept override
+	{
+		return _stateMachineManager.enableEntityAdvertising(entity);
+	}
+
+	virtual Error disableEntityAdvertising(entity::LocalEntity const& entity) noexcept override
+	{
+		return _stateMachineManager.disableEntityAdvertising(entity);
+	}
+
+	virtual Error discoverRemoteEntities() const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntities();
+	}
+
+	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept override
+	{
+		return _stateMachineManager.discoverRemoteEntity(entityID);
+	}
+
+	virtual Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
+	}
+
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept override
+	{
+		return _stateMachineManager.setRemoteEntitiesUpdateCoalescingDelay(delay);
+	}
+
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept override
+	{
+		return _stateMachineManager.setAutomaticDiscoveryPacing(enabled);
+	}
+
+	virtual bool isDirectMessageSupported() const noexcept override
+	{
+		return true;
+	}
+
+	virtual Error sendAdpMessage(Adpdu const& adpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(adpdu);
+	}
+
+	virtual Error sendAecpMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(aecpdu);
+	}
+
+	virtual Error sendAcmpMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		// Directly send the message on the network
+		return sendMessage(acmpdu);
+	}
+
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(!isAecpResponseMessageType(messageType), "Calling sendAecpCommand with a Response MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueCommand)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult, priority);
+	}
+
+	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept override
+	{
+		auto const messageType = aecpdu->getMessageType();
+
+		if (!AVDECC_ASSERT_WITH_RET(isAecpResponseMessageType(messageType), "Calling sendAecpResponse with a Command MessageType"))
+		{
+			return Error::MessageNotSupported;
+		}
+
+		// Special check for VendorUnique messages
+		if (messageType == AecpMessageType::VendorUniqueResponse)
+		{
+			auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
+
+			auto const vuProtocolID = vuAecp.getProtocolIdentifier();
+			auto* vuDelegate = getVendorUniqueDelegate(vuProtocolID);
+
+			// No delegate, or the messages are not handled by the ControllerStateMachine
+			if (!vuDelegate || !vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
+			{
+				return Error::MessageNotSupported;
+			}
+		}
+
+		// Response can be directly sent
+		return sendMessage(static_cast<Aecpdu const&>(*aecpdu));
+	}
+
+	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override
+	{
+		// Command goes through the state machine to handle timeout, retry and response
+		return _stateMachineManager.sendAcmpCommand(std::move(acmpdu), onResult);
+	}
+
+	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept override
+	{
+		// Response can be directly sent
+		return sendMessage(static_cast<Acmpdu const&>(*acmpdu));
+	}
+
+	virtual void lock() const noexcept override
+	{
+		_stateMachineManager.lock();
+	}
+
+	virtual void unlock() const noexcept override
+	{
+		_stateMachineManager.unlock();
+	}
+
+	virtual bool isSelfLocked() const noexcept override
+	{
+		return _stateMachineManager.isSelfLocked();
+	}
+
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override
+	{
+		return _frameDecoder.getPduPoolStatistics();
+	}
+
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override
+	{
+		// Frames are directly written to the shared ring, there is no transmit queue. Writing never waits nor fails, but a frame can be overwritten
+		// before a slow consumer read it, in which case it's counted in the droppedFrames of that consumer's ReceiveStatistics
+		auto statistics = TransmitQueueStatistics{};
+		statistics.sentFrames = _sentFrames.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override
+	{
+		return _stateMachineManager.getCommandTimeoutStatistics();
+	}
+
+	virtual LockStatistics getLockStatistics() const noexcept override
+	{
+		return _stateMachineManager.getLockStatistics();
+	}
+
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override
+	{
+		// Frames are read from the shared ring, where they are lost if the producers overrun us (overwriting the frames we didn't read yet)
+		auto statistics = ReceiveStatistics{};
+		statistics.receivedFrames = _receivedFrames.load(std::memory_order_relaxed);
+		statistics.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	virtual Error setSniffingMode(bool const /*enabled*/) noexcept override
+	{
+		// Frames of the shared memory network are not filtered
+		return Error::NoError;
+	}
+
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept override
+	{
+		if (length < EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+		{
+			return Error::InvalidParameters;
+		}
+
+		// Short frames are padded the same way serialized messages are
+		auto buffer = SerializationBuffer{};
+		buffer.packBuffer(frame, length);
+		return sendPacket(buffer);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::ProtocolInterfaceDelegate overrides            */
+	/* ************************************************************ */
+	/* **** AECP notifications **** */
+	virtual void onAecpCommand(Aecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpCommand, this, aecpdu);
+	}
+
+	/* **** ACMP notifications **** */
+	virtual void onAcmpCommand(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpCommand, this, acmpdu);
+	}
+
+	virtual void onAcmpResponse(Acmpdu const& acmpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpResponse, this, acmpdu);
+	}
+
+	/* **** Sending methods **** */
+	virtual Error sendMessage(Adpdu const& adpdu) const noexcept override
+	{
+		try
+		{
+			// Shared memory transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(adpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(adpdu, buffer);
+			// Then with Adp
+			serialize<Adpdu>(adpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(adpdu.getSrcAddress(), adpdu.getDestAddress(), std::string("Failed to serialize ADPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Aecpdu const& aecpdu) const noexcept override
+	{
+		try
+		{
+			// Shared memory transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(aecpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(aecpdu, buffer);
+			// Then with Aecp
+			serialize<Aecpdu>(aecpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(aecpdu.getSrcAddress(), aecpdu.getDestAddress(), std::string("Failed to serialize AECPDU: ") + e.what());
+			return Error::InternalError;
+		}
+	}
+
+	virtual Error sendMessage(Acmpdu const& acmpdu) const noexcept override
+	{
+		try
+		{
+			// Shared memory transport requires the full frame to be built
+			SerializationBuffer buffer;
+
+			// Start with EtherLayer2
+			serialize<EtherLayer2>(acmpdu, buffer);
+			// Then Avtp control
+			serialize<AvtpduControl>(acmpdu, buffer);
+			// Then with Acmp
+			serialize<Acmpdu>(acmpdu, buffer);
+
+			// Send the message
+			return sendPacket(buffer);
+		}
+		catch ([[maybe_unused]] std::exception const& e)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(acmpdu.getSrcAddress(), Acmpdu::Multicast_Mac_Address, "Failed to serialize ACMPDU: {}", e.what());
+			return Error::InternalError;
+		}
+	}
+
+	/* *** Other methods **** */
+	virtual std::uint32_t getVuAecpCommandTimeoutMsec(VuAecpdu::ProtocolIdentifier const& protocolIdentifier, VuAecpdu const& aecpdu) const noexcept override
+	{
+		return getVuAecpCommandTimeout(protocolIdentifier, aecpdu);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::AdvertiseStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+
+	/* ************************************************************ */
+	/* stateMachine::DiscoveryStateMachine::Delegate overrides      */
+	/* ************************************************************ */
+	virtual void onLocalEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOnline, this, entity);
+	}
+
+	virtual void onLocalEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityOffline, this, entityID);
+	}
+
+	virtual void onLocalEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onLocalEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntityOnline(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOnline, this, entity);
+	}
+
+	virtual void onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityOffline, this, entityID);
+	}
+
+	virtual void onRemoteEntityUpdated(entity::Entity const& entity) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
+	}
+
+	virtual void onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntitiesUpdated, this, entities);
+	}
+
+	/* ************************************************************ */
+	/* stateMachine::CommandStateMachine::Delegate overrides        */
+	/* ************************************************************ */
+	virtual void onAecpAemUnsolicitedResponse(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemUnsolicitedResponse, this, aecpdu);
+	}
+
+	virtual void onAecpAemIdentifyNotification(AemAecpdu const& aecpdu) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpAemIdentifyNotification, this, aecpdu);
+	}
+	virtual void onAecpRetry(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpRetry, this, entityID);
+	}
+	virtual void onAecpTimeout(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpTimeout, this, entityID);
+	}
+	virtual void onAecpUnexpectedResponse(UniqueIdentifier const& entityID) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpUnexpectedResponse, this, entityID);
+	}
+	virtual void onAecpResponseTime(UniqueIdentifier const& entityID, std::chrono::milliseconds const& responseTime) noexcept override
+	{
+		// Notify observers
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpResponseTime, this, entityID, responseTime);
+	}
+
+	/* ************************************************************ */
+	/* FrameDecoder::Delegate overrides                             */
+	/* ************************************************************ */
+	virtual VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept override
+	{
+		return getVendorUniqueDelegate(protocolIdentifier);
+	}
+
+	virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adpdu);
+	}
+
+	virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecpdu);
+	}
+
+	virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept override
+	{
+		notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmpdu);
+	}
+
+
+	/* ************************************************************ */
+	/* la::avdecc::utils::Subject overrides                         */
+	/* ************************************************************ */
+	virtual void onObserverRegistered(observer_type* const observer) noexcept override
+	{
+		if (observer)
+		{
+			class DiscoveryDelegate final : public stateMachine::DiscoveryStateMachine::Delegate
+			{
+			public:
+				DiscoveryDelegate(ProtocolInterface& pi, ProtocolInterface::Observer& obs)
+					: _pi{ pi }
+					, _obs{ obs }
+				{
+				}
+
+			private:
+				virtual void onLocalEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onLocalEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onLocalEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onLocalEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntityOnline(la::avdecc::entity::Entity const& entity) noexcept override
+				{
+					utils::invokeProtectedMethod(&ProtocolInterface::Observer::onRemoteEntityOnline, &_obs, &_pi, entity);
+				}
+				virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
+				virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+				virtual void onRemoteEntitiesUpdated(EntityReferences const& /*entities*/) noexcept override {}
+
+				ProtocolInterface& _pi;
+				ProtocolInterface::Observer& _obs;
+			};
+			auto discoveryDelegate = DiscoveryDelegate{ *this, static_cast<ProtocolInterface::Observer&>(*observer) };
+
+			_stateMachineManager.notifyDiscoveredEntities(discoveryDelegate);
+		}
+	}
+
+
+	/* ************************************************************ */
+	/* Private methods                                              */
+	/* ************************************************************ */
+	void openSegment()
+	{
+		auto const throwError = [](std::string const& message)
+		{
+			throw Exception(Error::TransportError, message + ": " + std::strerror(errno));
+		};
+
+		// Try to create the segment, join it if it already exists
+		_fd = ::shm_open(_segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+		_isCreator = _fd >= 0;
+		if (_fd < 0 && errno == EEXIST)
+		{
+			_fd = ::shm_open(_segmentName.c_str(), O_RDWR | O_CLOEXEC, 0);
+		}
+		if (_fd < 0)
+		{
+			throwError("Failed to open shared memory segment");
+		}
+
+		auto const deadline = std::chrono::steady_clock::now() + AttachTimeout;
+		auto const throwIfExpired = [&deadline](std::string const& message)
+		{
+			if (std::chrono::steady_clock::now() >= deadline)
+			{
+				throw Exception(Error::TransportError, message);
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 1u });
+		};
+
+		if (_isCreator)
+		{
+			if (::ftruncate(_fd, static_cast<off_t>(SegmentSize)) < 0)
+			{
+				throwError("Failed to size shared memory segment");
+			}
+		}
+		else
+		{
+			// Wait for the creator to size the segment
+			while (true)
+			{
+				struct stat status
+				{
+				};
+				if (::fstat(_fd, &status) < 0)
+				{
+					throwError("Failed to get shared memory segment size");
+				}
+				if (static_cast<std::size_t>(status.st_size) == SegmentSize)
+				{
+					break;
+				}
+				if (status.st_size != 0)
+				{
+					throw Exception(Error::TransportError, "Incompatible shared memory segment (size mismatch)");
+				}
+				throwIfExpired("Shared memory segment never sized by its creator");
+			}
+		}
+
+		auto* const segment = ::mmap(nullptr, SegmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		if (segment == MAP_FAILED)
+		{
+			throwError("Failed to map shared memory segment");
+		}
+		_header = static_cast<SegmentHeader*>(segment);
+		_slots = reinterpret_cast<Slot*>(static_cast<std::uint8_t*>(segment) + HeaderSize);
+
+		if (_isCreator)
+		{
+			// Construct the objects in place (the segment is already zero-filled), then publish the segment
+			new (_header) SegmentHeader{};
+			for (auto slot = std::uint32_t{ 0u }; slot < SlotsCount; ++slot)
+			{
+				new (&_slots[slot]) Slot{};
+			}
+			_header->magic.store(SegmentMagic, std::memory_order_release);
+		}
+		else
+		{
+			// Wait for the creator to initialize the segment
+			while (_header->magic.load(std::memory_order_acquire) != SegmentMagic)
+			{
+				throwIfExpired("Shared memory segment never initialized by its creator");
+			}
+			if (_header->version != SegmentVersion || _header->slotsCount != SlotsCount || _header->slotSize != sizeof(Slot))
+			{
+				throw Exception(Error::TransportError, "Incompatible shared memory segment (version mismatch)");
+			}
+		}
+
+		_header->attachedCount.fetch_add(1u);
+		_isAttached = true;
+
+		// Only receive the frames sent from now on
+		_readPosition = _header->writePosition.load(std::memory_order_acquire);
+	}
+
+	void closeSegment() noexcept
+	{
+		if (_header != nullptr)
+		{
+			// Last one detaching from the segment removes it (also remove a segment we created but never managed to initialize)
+			if ((_isAttached && _header->attachedCount.fetch_sub(1u) == 1u) || (!_isAttached && _isCreator))
+			{
+				::shm_unlink(_segmentName.c_str());
+			}
+			::munmap(_header, SegmentSize);
+			_header = nullptr;
+			_slots = nullptr;
+			_isAttached = false;
+		}
+		else if (_isCreator)
+		{
+			::shm_unlink(_segmentName.c_str());
+		}
+		_isCreator = false;
+		if (_fd >= 0)
+		{
+			::close(_fd);
+			_fd = -1;
+		}
+	}
+
+	void captureFrames() noexcept
+	{
+		auto stalledSince = std::chrono::steady_clock::time_point{};
+
+		while (!_shouldTerminate)
+		{
+			if (processFrames() != 0u)
+			{
+				stalledSince = {};
+				continue;
+			}
+
+			// Next slot has been claimed by a producer but not committed yet
+			if (_readPosition < _header->writePosition.load(std::memory_order_acquire))
+			{
+				auto const now = std::chrono::steady_clock::now();
+				if (stalledSince == std::chrono::steady_clock::time_point{})
+				{
+					stalledSince = now;
+				}
+				// Producer probably died while writing the slot, skip it
+				else if ((now - stalledSince) > StalledSlotTimeout)
+				{
+					LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceSharedMemory: Skipping a slot never committed by its producer");
+					++_readPosition;
+					stalledSince = {};
+				}
+				std::this_thread::yield();
+				continue;
+			}
+
+			waitForFrame();
+		}
+	}
+
+	void waitForFrame() noexcept
+	{
+		// Register as a waiter before checking for new frames, so a producer committing a frame after the check will wake us up
+		_header->waitersCount.fetch_add(1u);
+		auto const generation = _header->generation.load();
+		if (_header->writePosition.load() == _readPosition && !_shouldTerminate)
+		{
+			auto const timeout = timespec{ 0, static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(WaitTimeout).count()) };
+			futex(&_header->generation, FUTEX_WAIT, generation, &timeout);
+		}
+		_header->waitersCount.fetch_sub(1u);
+	}
+
+	std::size_t processFrames() noexcept
+	{
+		// Don't lock the state machines if there is nothing to process
+		if (_slots[_readPosition % SlotsCount].sequence.load(std::memory_order_acquire) < committedSequence(_readPosition))
+		{
+			return 0u;
+		}
+
+		auto processedCount = std::size_t{ 0u };
+
+		// Try to detect possible deadlock
+		_watchDog.armHeartbeat(_dispatchHeartbeat);
+
+		{
+			// Lock the state machines once for the whole batch, instead of once per frame
+			auto const lg = std::lock_guard{ _stateMachineManager };
+
+			while (processedCount < MaximumProcessBatchSize && !_shouldTerminate)
+			{
+				auto const& slot = _slots[_readPosition % SlotsCount];
+				auto const expectedSequence = committedSequence(_readPosition);
+				auto const sequence = slot.sequence.load(std::memory_order_acquire);
+
+				// Not committed yet
+				if (sequence < expectedSequence)
+				{
+					break;
+				}
+
+				// Slot has already been reused by a newer frame, we have been overrun by the producers
+				if (sequence > expectedSequence)
+				{
+					auto const writePosition = _header->writePosition.load(std::memory_order_acquire);
+					// Resume in the middle of the ring, to leave some room before being overrun again
+					auto const resumePosition = std::max(_readPosition + 1u, writePosition - std::min<std::uint64_t>(writePosition, SlotsCount / 2u));
+					LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProtocolInterfaceSharedMemory: Overrun by the producers, {} frames lost", resumePosition - _readPosition);
+					_droppedFrames.fetch_add(resumePosition - _readPosition, std::memory_order_relaxed);
+					_readPosition = resumePosition;
+					++processedCount;
+					continue;
+				}
+
+				// Only decode frames for my MacAddress or the broadcast addresses, directly from the shared memory
+				auto decodedFrame = FrameDecoder::DecodedFrame{};
+				auto const length = std::min<std::size_t>(slot.length, EthernetMaxFrameSize);
+				if (length >= EtherLayer2::HeaderLength)
+				{
+					auto destAddress = networkInterface::MacAddress{};
+					std::memcpy(destAddress.data(), slot.data, destAddress.size());
+					if (destAddress == getMacAddress() || destAddress == Adpdu::Multicast_Mac_Address || destAddress == AemAecpdu::Identify_Mac_Address)
+					{
+						decodedFrame = _frameDecoder.decode(slot.data, length, std::chrono::steady_clock::now());
+					}
+				}
+
+				// Make sure the slot has not been overwritten while we were reading it (if so, the next iteration will handle the overrun)
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (slot.sequence.load(std::memory_order_relaxed) != expectedSequence)
+				{
+					continue;
+				}
+
+				++_readPosition;
+				++processedCount;
+				_receivedFrames.fetch_add(1u, std::memory_order_relaxed);
+
+				if (decodedFrame.route != FrameDecoder::Route::Drop)
+				{
+					_frameDecoder.route(std::move(decodedFrame));
+				}
+			}
+			_frameDecoder.completeBatch();
+		}
+
+		_watchDog.disarmHeartbeat(_dispatchHeartbeat);
+
+		return processedCount;
+	}
+
+	Error sendPacket(SerializationBuffer const& buffer) const noexcept
+	{
+		auto length = buffer.size();
+		constexpr auto minimumSize = EthernetPayloadMinimumSize + EtherLayer2::HeaderLength;
+
+		/* Check the buffer has enough bytes in it */
+		if (length < minimumSize)
+			length = minimumSize; // No need to resize nor pad the buffer, it has enough capacity and we don't care about the unused bytes. Simply increase the length of the data to send.
+
+		recordSentFrame(buffer.data(), length);
+
+		AVDECC_ASSERT(_header != nullptr, "Trying to send a message but segment has been closed");
+		if (_header == nullptr)
+		{
+			return Error::TransportError;
+		}
+
+		// Claim a position, producers never wait for the consumers
+		auto const position = _header->writePosition.fetch_add(1u, std::memory_order_relaxed);
+		auto& slot = _slots[position % SlotsCount];
+
+		// Mark the slot as being written, so consumers still reading its previous frame detect the overwrite
+		slot.sequence.store(committedSequence(position) - 1u, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		slot.length = static_cast<std::uint32_t>(length);
+		std::memcpy(slot.data, buffer.data(), length);
+
+		// Commit the frame
+		slot.sequence.store(committedSequence(position), std::memory_order_release);
+
+		// Wake up consumers waiting for a frame
+		_header->generation.fetch_add(1u);
+		if (_header->waitersCount.load() != 0u)
+		{
+			futex(&_header->generation, FUTEX_WAKE, INT_MAX, nullptr);
+		}
+
+		_sentFrames.fetch_add(1u, std::memory_order_relaxed);
+		return Error::NoError;
+	}
+
+	// Private variables
+	FrameDecoder _frameDecoder{ *this, *this, _stateMachineManager }; // Declared first so it's destroyed last (owns the received PDUs pools)
+	watchDog::WatchDog::SharedPointer _watchDogSharedPointer{ watchDog::WatchDog::getInstance() };
+	watchDog::WatchDog& _watchDog{ *_watchDogSharedPointer };
+	watchDog::WatchDog::HeartbeatHandle _dispatchHeartbeat{ _watchDog.registerHeartbeat("avdecc::SharedMemoryInterface::dispatchAvdeccMessage::" + utils::toHexString(reinterpret_cast<size_t>(this)), std::chrono::milliseconds{ 1000u }) };
+	std::string _segmentName{};
+	int _fd{ -1 };
+	SegmentHeader* _header{ nullptr };
+	Slot* _slots{ nullptr };
+	bool _isCreator{ false };
+	bool _isAttached{ false };
+	std::uint64_t _readPosition{ 0u };
+	mutable std::atomic<std::uint64_t> _sentFrames{ 0u };
+	std::atomic<std::uint64_t> _receivedFrames{ 0u };
+	std::atomic<std::uint64_t> _droppedFrames{ 0u }; // Frames overwritten by the producers before we read them
+	std::atomic_bool _shouldTerminate{ false };
+	mutable stateMachine::Manager _stateMachineManager{ this, this, this, this, this };
+	std::thread _captureThread{};
+};
+
+ProtocolInterfaceSharedMemory::ProtocolInterfaceSharedMemory(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
+	: ProtocolInterface(networkInterfaceName, macAddress)
+{
+}
+
+networkInterface::MacAddress ProtocolInterfaceSharedMemory::generateMacAddress() noexcept
+{
+	auto seed = static_cast<std::uint64_t>(::getpid()) ^ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	try
+	{
+		seed ^= static_cast<std::uint64_t>(std::random_device{}()) << 32;
+	}
+	catch (...)
+	{
+		// No random device, pid and time are good enough to be unique on the machine
+	}
+
+	auto generator = std::mt19937_64{ seed };
+	auto const value = generator();
+
+	auto macAddress = networkInterface::MacAddress{};
+	for (auto index = std::size_t{ 0u }; index < macAddress.size(); ++index)
+	{
+		macAddress[index] = static_cast<networkInterface::MacAddress::value_type>(value >> (index * 8u));
+	}
+
+	// Locally administered unicast address
+	macAddress[0] = static_cast<networkInterface::MacAddress::value_type>((macAddress[0] & 0xFC) | 0x02);
+
+	return macAddress;
+}
+
+bool ProtocolInterfaceSharedMemory::isSupported() noexcept
+{
+	// POSIX shared memory and futexes are always available on linux
+	return true;
+}
+
+ProtocolInterfaceSharedMemory* ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
+{
+	return new ProtocolInterfaceSharedMemoryImpl(networkInterfaceName, macAddress);
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
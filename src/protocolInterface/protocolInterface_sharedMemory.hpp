@@ -0,0 +1,70 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_sharedMemory.hpp
+* @author Christophe Calmejane
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+class ProtocolInterfaceSharedMemory : public ProtocolInterface
+{
+public:
+	/**
+	* @brief Factory method to create a new ProtocolInterfaceSharedMemory.
+	* @details Creates a new ProtocolInterfaceSharedMemory as a raw pointer. All the ProtocolInterfaceSharedMemory using the same networkInterfaceName,
+	*          in any process of the machine, are connected through a broadcast ring located in a POSIX shared memory segment (/dev/shm/avdecc.<networkInterfaceName>).
+	* @param[in] networkInterfaceName The name of the shared memory network to join (created if needed). Cannot contain a '/'.
+	* @param[in] macAddress The MAC address associated with the network interface. Cannot be all 0 and must be unique on the shared memory network.
+	* @return A new ProtocolInterfaceSharedMemory as a raw pointer.
+	* @note Throws Exception if #networkInterfaceName is invalid or the shared memory segment cannot be accessed.
+	*/
+	static ProtocolInterfaceSharedMemory* createRawProtocolInterfaceSharedMemory(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress);
+
+	/** Returns a locally administered MAC address, randomly generated so it's unique on a shared memory network. */
+	static networkInterface::MacAddress generateMacAddress() noexcept;
+
+	/** Returns true if this ProtocolInterface is supported (runtime check) */
+	static bool isSupported() noexcept;
+
+	/** Destructor */
+	virtual ~ProtocolInterfaceSharedMemory() noexcept = default;
+
+	// Deleted compiler auto-generated methods
+	ProtocolInterfaceSharedMemory(ProtocolInterfaceSharedMemory&&) = delete;
+	ProtocolInterfaceSharedMemory(ProtocolInterfaceSharedMemory const&) = delete;
+	ProtocolInterfaceSharedMemory& operator=(ProtocolInterfaceSharedMemory const&) = delete;
+	ProtocolInterfaceSharedMemory& operator=(ProtocolInterfaceSharedMemory&&) = delete;
+
+protected:
+	ProtocolInterfaceSharedMemory(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress);
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
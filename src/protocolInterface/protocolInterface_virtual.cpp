@@ -32,43 +32,28 @@
 
 #include "stateMachine/stateMachineManager.hpp"
 #include "protocolInterface_virtual.hpp"
+#include "frameDecoder.hpp"
+#include "frameRing.hpp"
 #include "logHelper.hpp"
 
 #include <stdexcept>
 #include <thread>
 #include <condition_variable>
-#include <list>
+#include <deque>
+#include <unordered_map>
 #include <mutex>
 #include <memory>
+#include <cstring>
 #include <functional>
 #include <atomic>
+#include <array>
+#include <chrono>
 
 // Only enable instrumentation in static library and in debug (for unit testing mainly)
 #if defined(DEBUG) && defined(la_avdecc_cxx_STATICS)
-#	include <chrono>
 #	define SEND_INSTRUMENTATION_NOTIFICATION(eventName) la::avdecc::InstrumentationNotifier::getInstance().triggerEvent(eventName)
-#	define UNIQUE_LOCK(mutex, sleepDelay, retryCount) \
-		la::avdecc::InstrumentationNotifier::getInstance().triggerEvent("ProtocolInterfaceVirtual::PushMessage::PreLock"); \
-		std::unique_lock<decltype(mutex)> lock(mutex, std::defer_lock); \
-		{ \
-			std::uint8_t count{ retryCount }; \
-			while (count > 0) \
-			{ \
-				if (lock.try_lock()) \
-					break; \
-				std::this_thread::sleep_for(sleepDelay); \
-				--count; \
-			} \
-			if (!lock.owns_lock()) \
-			{ \
-				la::avdecc::InstrumentationNotifier::getInstance().triggerEvent("ProtocolInterfaceVirtual::PushMessage::LockTimeOut"); \
-				lock.lock(); \
-			} \
-		} \
-		la::avdecc::InstrumentationNotifier::getInstance().triggerEvent(std::string("ProtocolInterfaceVirtual::PushMessage::PostLock"))
 #else // !DEBUG || !la_avdecc_cxx_STATICS
 #	define SEND_INSTRUMENTATION_NOTIFICATION(eventName)
-#	define UNIQUE_LOCK(mutex, sleepDelay, retryCount) std::unique_lock<decltype(mutex)> lock(mutex)
 #endif // DEBUG && la_avdecc_cxx_STATICS
 
 namespace la
@@ -80,34 +65,199 @@ namespace protocol
 class MessageDispatcher final
 {
 	using Subject = utils::TypedSubject<struct SubjectTag, std::mutex>;
-	using MessagesList = std::list<SerializationBuffer>;
-	struct Interface
+
+public:
+	class Observer : public utils::Observer<Subject>
+	{
+	public:
+		/** A message has been received. The data is only valid during the call. */
+		virtual void onMessage(std::uint8_t const* const data, std::size_t const length) noexcept = 0;
+		virtual void onTransportError() noexcept = 0;
+	};
+
+	/**
+	* A virtual network: frames pushed by any thread are dispatched to all its observers, in order, by a dedicated thread.
+	* Frames go through a bounded lock-free ring. When it's full, they spill to an unbounded overflow list (and keep going there until the
+	* dispatch thread drained it), so a sender never blocks nor loses a frame, even when it's the dispatch thread itself.
+	*/
+	class Interface final
 	{
-		std::atomic_bool shouldTerminate{ false };
-		std::mutex mutex;
-		std::thread dispatchThread{};
-		Subject observers{};
-		MessagesList messages{};
-		std::condition_variable cond{};
-
-		~Interface()
+	public:
+		static constexpr auto MaximumDispatchBatchSize = std::size_t{ 32u }; /**< Maximum number of frames read from the ring before releasing them */
+
+		Interface(std::string const& networkInterfaceName) noexcept
+		{
+			_dispatchThread = std::thread(
+				[this, networkInterfaceName]
+				{
+					utils::setCurrentThreadName("avdecc::VirtualInterface." + networkInterfaceName + "::Capture");
+					dispatchMessages();
+				});
+		}
+
+		~Interface() noexcept
 		{
 			// Notify the thread we shall terminate
-			shouldTerminate = true;
-			cond.notify_all();
+			_shouldTerminate = true;
+			wakeUpDispatchThread(true);
 
 			// Wait for the thread to complete its pending tasks
-			if (dispatchThread.joinable())
-				dispatchThread.join();
+			if (_dispatchThread.joinable())
+			{
+				_dispatchThread.join();
+			}
 		}
-	};
 
-public:
-	class Observer : public utils::Observer<Subject>
-	{
-	public:
-		virtual void onMessage(SerializationBuffer const& message) noexcept = 0;
-		virtual void onTransportError() noexcept = 0;
+		/** Pushes a message (an empty message is a transport error). Returns false if the message had to be dropped (interface being destroyed, frame too big or out of memory). Never blocks. */
+		bool push(std::uint8_t const* const data, std::size_t const length) noexcept
+		{
+			// Dispatch thread is not running anymore, nobody will read the message
+			if (_shouldTerminate || length > EthernetMaxFrameSize)
+			{
+				return false;
+			}
+
+			// Once frames have overflowed, the next ones must follow them (to be dispatched in order)
+			if (_hasOverflow.load(std::memory_order_acquire) || !_ring.tryPush(data, length))
+			{
+				try
+				{
+					auto const lg = std::lock_guard{ _overflowLock };
+					auto& frame = _overflow.emplace_back();
+					if (length != 0u)
+					{
+						std::memcpy(frame.data.data(), data, length);
+					}
+					frame.length = length;
+					_hasOverflow.store(true, std::memory_order_release);
+				}
+				catch (...)
+				{
+					return false;
+				}
+			}
+
+			SEND_INSTRUMENTATION_NOTIFICATION("ProtocolInterfaceVirtual::PushMessage::PostLock");
+
+			wakeUpDispatchThread(false);
+			return true;
+		}
+
+		Subject& getObservers() noexcept
+		{
+			return _observers;
+		}
+
+		// Deleted compiler auto-generated methods
+		Interface(Interface&&) = delete;
+		Interface(Interface const&) = delete;
+		Interface& operator=(Interface const&) = delete;
+		Interface& operator=(Interface&&) = delete;
+
+	private:
+		void wakeUpDispatchThread(bool const force) noexcept
+		{
+			// Pairs with the fence in dispatchMessages: either the dispatch thread sees the published slot, or we see it's waiting
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (force || _dispatchThreadWaiting.load(std::memory_order_relaxed))
+			{
+				// Taking the lock guarantees the dispatch thread is either before its predicate check, or already waiting
+				auto const lg = std::lock_guard{ _mutex };
+				_cond.notify_one();
+			}
+		}
+
+		void dispatchMessages() noexcept
+		{
+			auto frames = std::array<FrameRing::Frame const*, MaximumDispatchBatchSize>{};
+			auto overflow = Overflow{};
+
+			while (!_shouldTerminate)
+			{
+				auto const count = _ring.peek(frames.data(), frames.size());
+
+				// Ring drained, dispatch the frames that overflowed (they are more recent than the ones in the ring)
+				if (count == 0u && _hasOverflow.load(std::memory_order_acquire))
+				{
+					{
+						auto const lg = std::lock_guard{ _overflowLock };
+						overflow.swap(_overflow);
+						_hasOverflow.store(false, std::memory_order_release);
+					}
+					for (auto const& frame : overflow)
+					{
+						if (_shouldTerminate)
+						{
+							break;
+						}
+						dispatchFrame(frame);
+					}
+					overflow.clear();
+					continue;
+				}
+
+				// Wait for one (or more) message to be available, or for shouldTerminate to be set
+				if (count == 0u)
+				{
+					auto lock = std::unique_lock{ _mutex };
+					_dispatchThreadWaiting = true;
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					_cond.wait(lock,
+						[this]
+						{
+							return !_ring.empty() || _hasOverflow.load(std::memory_order_acquire) || _shouldTerminate;
+						});
+					_dispatchThreadWaiting = false;
+					continue;
+				}
+
+				// Messages are read directly from the ring, their slots are released once all observers have been notified
+				for (auto index = std::size_t{ 0u }; index < count && !_shouldTerminate; ++index)
+				{
+					dispatchFrame(*frames[index]);
+				}
+				_ring.release(count);
+			}
+		}
+
+		void dispatchFrame(FrameRing::Frame const& frame) noexcept
+		{
+			SEND_INSTRUMENTATION_NOTIFICATION("ProtocolInterfaceVirtual::onMessage::PostLock");
+
+			// Transport error
+			if (frame.length == 0u)
+			{
+				_observers.notifyObservers<Observer>(
+					[](auto* obs)
+					{
+						obs->onTransportError();
+					});
+				_shouldTerminate = true;
+				return;
+			}
+
+			// Notify registered observers
+			_observers.notifyObservers<Observer>(
+				[&frame](auto* obs)
+				{
+					obs->onMessage(frame.data.data(), frame.length);
+				});
+		}
+
+		// Private types
+		using Overflow = std::deque<FrameRing::Frame>;
+
+		// Private variables
+		FrameRing _ring{};
+		std::mutex _overflowLock{}; // Protects _overflow
+		Overflow _overflow{};
+		std::atomic_bool _hasOverflow{ false };
+		std::atomic_bool _shouldTerminate{ false };
+		std::atomic_bool _dispatchThreadWaiting{ false };
+		std::mutex _mutex{};
+		std::condition_variable _cond{};
+		Subject _observers{};
+		std::thread _dispatchThread{};
 	};
 
 	static MessageDispatcher& getInstance() noexcept
@@ -116,7 +266,8 @@ public:
 		return s_dispatcher;
 	}
 
-	void registerObserver(std::string const& networkInterfaceName, Observer* const observer) noexcept
+	/** Registers an observer to the specified virtual network, creating it if needed. The returned Interface is used to push messages without going through the dispatcher. */
+	std::shared_ptr<Interface> registerObserver(std::string const& networkInterfaceName, Observer* const observer) noexcept
 	{
 		std::lock_guard<decltype(_mutex)> const lg(_mutex);
 
@@ -125,80 +276,31 @@ public:
 		// Virtual interface not created yet
 		if (interfaceIt == _interfaces.end())
 		{
-			auto intfc = std::make_unique<Interface>();
-			intfc->dispatchThread = std::thread(
-				[networkInterfaceName, intfc = intfc.get()]()
-				{
-					utils::setCurrentThreadName("avdecc::VirtualInterface." + networkInterfaceName + "::Capture");
-					while (!intfc->shouldTerminate)
-					{
-						MessagesList messagesToSend{};
-
-						// Wait for one (or more) message to be available (while under the lock), or for shouldTerminate to be set
-						{
-							std::unique_lock<decltype(intfc->mutex)> lock(intfc->mutex);
-
-							// Wait for message in the queue
-							intfc->cond.wait(lock,
-								[intfc]
-								{
-									return intfc->messages.size() > 0 || intfc->shouldTerminate;
-								});
-
-							// Empty the queue
-							while (!intfc->shouldTerminate && intfc->messages.size() > 0)
-							{
-								// Pop a message from the queue
-								messagesToSend.push_back(std::move(intfc->messages.front()));
-								intfc->messages.pop_front();
-
-								SEND_INSTRUMENTATION_NOTIFICATION("ProtocolInterfaceVirtual::onMessage::PostLock");
-							}
-						}
-
-						// Now we can send messages without locking
-						while (!intfc->shouldTerminate && messagesToSend.size() > 0)
-						{
-							auto const& message = messagesToSend.front();
-
-							// Transport error
-							if (message.size() == 0)
-							{
-								intfc->observers.notifyObservers<Observer>(
-									[](auto* obs)
-									{
-										obs->onTransportError();
-									});
-								intfc->shouldTerminate = true;
-								break;
-							}
-
-							// Notify registered observers
-							intfc->observers.notifyObservers<Observer>(
-								[&message](auto* obs)
-								{
-									obs->onMessage(message);
-								});
-							messagesToSend.pop_front();
-						}
-					}
-				});
-			auto result = _interfaces.emplace(std::make_pair(networkInterfaceName, std::move(intfc)));
-			// Insertion failed
-			if (!result.second)
-				return;
-			interfaceIt = result.first;
+			try
+			{
+				auto result = _interfaces.emplace(std::make_pair(networkInterfaceName, std::make_shared<Interface>(networkInterfaceName)));
+				// Insertion failed
+				if (!result.second)
+					return {};
+				interfaceIt = result.first;
+			}
+			catch (...)
+			{
+				return {};
+			}
 		}
 
 		// Register observer
-		auto& intfc = *interfaceIt->second;
+		auto& intfc = interfaceIt->second;
 		try
 		{
-			intfc.observers.registerObserver(observer);
+			intfc->getObservers().registerObserver(observer);
 		}
 		catch (std::invalid_argument const&)
 		{
 		}
+
+		return intfc;
 	}
 
 	void unregisterObserver(std::string const& networkInterfaceName, Observer* const observer) noexcept
@@ -215,40 +317,19 @@ public:
 		auto& intfc = *interfaceIt->second;
 		try
 		{
-			intfc.observers.unregisterObserver(observer);
+			intfc.getObservers().unregisterObserver(observer);
 		}
 		catch (std::invalid_argument const&)
 		{
 		}
 
-		// If last observer for this interface, remove the interface (effectively waiting for the dispatch thread to shutdown)
-		if (intfc.observers.countObservers() == 0)
+		// If last observer for this interface, remove the interface (the dispatch thread is shutdown when the last reference to the interface is released)
+		if (intfc.getObservers().countObservers() == 0)
 		{
 			_interfaces.erase(interfaceIt);
 		}
 	}
 
-	void push(std::string const& networkInterfaceName, SerializationBuffer message)
-	{
-		std::lock_guard<decltype(_mutex)> const lg(_mutex);
-
-		auto interfaceIt = _interfaces.find(networkInterfaceName);
-
-		// Interface does not exist, ignore the message
-		if (interfaceIt == _interfaces.end())
-			return;
-
-		// Add message to the queue
-		auto& intfc = *interfaceIt->second;
-
-		UNIQUE_LOCK(intfc.mutex, std::chrono::milliseconds(10), 100);
-
-		intfc.messages.push_back(std::move(message));
-
-		// Notify the dispatch thread
-		intfc.cond.notify_all();
-	}
-
 	// Deleted compiler auto-generated methods
 	MessageDispatcher(MessageDispatcher&&) = delete;
 	MessageDispatcher(MessageDispatcher const&) = delete;
@@ -262,14 +343,14 @@ private:
 
 	// Private variables
 	std::mutex _mutex;
-	std::unordered_map<std::string, std::unique_ptr<Interface>> _interfaces{};
+	std::unordered_map<std::string, std::shared_ptr<Interface>> _interfaces{};
 };
 
 
 static networkInterface::MacAddress Multicast_Mac_Address{ { 0x91, 0xe0, 0xf0, 0x01, 0x00, 0x00 } };
 static networkInterface::MacAddress Identify_Mac_Address{ { 0x91, 0xe0, 0xf0, 0x01, 0x00, 0x01 } };
 
-class ProtocolInterfaceVirtualImpl final : public ProtocolInterfaceVirtual, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private MessageDispatcher::Observer
+class ProtocolInterfaceVirtualImpl final : public ProtocolInterfaceVirtual, private stateMachine::ProtocolInterfaceDelegate, private stateMachine::AdvertiseStateMachine::Delegate, private stateMachine::DiscoveryStateMachine::Delegate, private stateMachine::CommandStateMachine::Delegate, private FrameDecoder::Delegate, private MessageDispatcher::Observer
 {
 public:
 	/* ************************************************************ */
@@ -305,17 +386,26 @@ private:
 	virtual Error discoverRemoteEntities() const noexcept override;
 	virtual Error discoverRemoteEntity(UniqueIdentifier const entityID) const noexcept override;
 	virtual Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) const noexcept override;
+	virtual Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept override;
+	virtual Error setAutomaticDiscoveryPacing(bool const enabled) const noexcept override;
 	virtual bool isDirectMessageSupported() const noexcept override;
 	virtual Error sendAdpMessage(Adpdu const& adpdu) const noexcept override;
 	virtual Error sendAecpMessage(Aecpdu const& aecpdu) const noexcept override;
 	virtual Error sendAcmpMessage(Acmpdu const& acmpdu) const noexcept override;
-	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult) const noexcept override;
+	virtual Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept override;
 	virtual Error sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept override;
 	virtual Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, AcmpCommandResultHandler const& onResult) const noexcept override;
 	virtual Error sendAcmpResponse(Acmpdu::UniquePointer&& acmpdu) const noexcept override;
 	virtual void lock() const noexcept override;
 	virtual void unlock() const noexcept override;
 	virtual bool isSelfLocked() const noexcept override;
+	virtual PduPoolStatistics getPduPoolStatistics() const noexcept override;
+	virtual TransmitQueueStatistics getTransmitQueueStatistics() const noexcept override;
+	virtual CommandTimeoutStatistics getCommandTimeoutStatistics() const noexcept override;
+	virtual LockStatistics getLockStatistics() const noexcept override;
+	virtual ReceiveStatistics getReceiveStatistics() const noexcept override;
+	virtual Error setSniffingMode(bool const enabled) noexcept override;
+	virtual Error sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept override;
 
 	/* ************************************************************ */
 	/* ProtocolInterfaceVirtual overrides                           */
@@ -346,6 +436,7 @@ private:
 	virtual void onRemoteEntityOnline(entity::Entity const& entity) noexcept override;
 	virtual void onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept override;
 	virtual void onRemoteEntityUpdated(entity::Entity const& entity) noexcept override;
+	virtual void onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept override;
 
 	/* ************************************************************ */
 	/* stateMachine::CommandStateMachine::Delegate overrides        */
@@ -357,10 +448,18 @@ private:
 	virtual void onAecpUnexpectedResponse(UniqueIdentifier const& entityID) noexcept override;
 	virtual void onAecpResponseTime(UniqueIdentifier const& entityID, std::chrono::milliseconds const& responseTime) noexcept override;
 
+	/* ************************************************************ */
+	/* FrameDecoder::Delegate overrides                             */
+	/* ************************************************************ */
+	virtual VendorUniqueDelegate* findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept override;
+	virtual void onAdpduDecoded(Adpdu const& adpdu) noexcept override;
+	virtual void onAecpduDecoded(Aecpdu const& aecpdu) noexcept override;
+	virtual void onAcmpduDecoded(Acmpdu const& acmpdu) noexcept override;
+
 	/* ************************************************************ */
 	/* MessageDispatcher::Observer overrides                        */
 	/* ************************************************************ */
-	virtual void onMessage(SerializationBuffer const& message) noexcept override;
+	virtual void onMessage(std::uint8_t const* const buffer, std::size_t const length) noexcept override;
 	virtual void onTransportError() noexcept override;
 
 	/* ************************************************************ */
@@ -372,10 +471,12 @@ private:
 	/* Private methods                                              */
 	/* ************************************************************ */
 	Error sendPacket(SerializationBuffer const& buffer) const noexcept;
-	void deserializeAecpMessage(EtherLayer2 const& etherLayer2, Deserializer& des, Aecpdu& aecp) const;
-	void dispatchAvdeccMessage(std::uint8_t const* const pkt_data, size_t const pkt_len, EtherLayer2 const& etherLayer2) noexcept;
 
 	// Private variables
+	FrameDecoder _frameDecoder{ *this, *this, _stateMachineManager }; // Declared first so it's destroyed last (owns the received PDUs pools)
+	std::shared_ptr<MessageDispatcher::Interface> _dispatcherInterface{};
+	mutable std::atomic<std::uint64_t> _sentFrames{ 0u };
+	mutable std::atomic<std::uint64_t> _droppedFrames{ 0u };
 	mutable stateMachine::Manager _stateMachineManager{ this, this, this, this, this };
 };
 
@@ -391,7 +492,8 @@ ProtocolInterfaceVirtualImpl::ProtocolInterfaceVirtualImpl(std::string const& ne
 
 	// Register to the message dispatcher
 	auto& dispatcher = MessageDispatcher::getInstance();
-	dispatcher.registerObserver(networkInterfaceName, this);
+	_dispatcherInterface = dispatcher.registerObserver(networkInterfaceName, this);
+	AVDECC_ASSERT(_dispatcherInterface, "Failed to register to the MessageDispatcher");
 
 	// Start the state machines
 	_stateMachineManager.startStateMachines();
@@ -497,6 +599,16 @@ ProtocolInterface::Error ProtocolInterfaceVirtualImpl::setAutomaticDiscoveryDela
 	return _stateMachineManager.setAutomaticDiscoveryDelay(delay);
 }
 
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) const noexcept
+{
+	return _stateMachineManager.setRemoteEntitiesUpdateCoalescingDelay(delay);
+}
+
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::setAutomaticDiscoveryPacing(bool const enabled) const noexcept
+{
+	return _stateMachineManager.setAutomaticDiscoveryPacing(enabled);
+}
+
 bool ProtocolInterfaceVirtualImpl::isDirectMessageSupported() const noexcept
 {
 	return true;
@@ -520,7 +632,7 @@ ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAcmpMessage(Acmpdu co
 	return sendMessage(acmpdu);
 }
 
-ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult) const noexcept
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, AecpCommandResultHandler const& onResult, AecpCommandPriority const priority) const noexcept
 {
 	auto const messageType = aecpdu->getMessageType();
 
@@ -545,7 +657,7 @@ ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpCommand(Aecpdu::U
 	}
 
 	// Command goes through the state machine to handle timeout, retry and response
-	return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult);
+	return _stateMachineManager.sendAecpCommand(std::move(aecpdu), onResult, priority);
 }
 
 ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendAecpResponse(Aecpdu::UniquePointer&& aecpdu) const noexcept
@@ -603,12 +715,65 @@ bool ProtocolInterfaceVirtualImpl::isSelfLocked() const noexcept
 	return _stateMachineManager.isSelfLocked();
 }
 
+ProtocolInterface::PduPoolStatistics ProtocolInterfaceVirtualImpl::getPduPoolStatistics() const noexcept
+{
+	return _frameDecoder.getPduPoolStatistics();
+}
+
+ProtocolInterface::TransmitQueueStatistics ProtocolInterfaceVirtualImpl::getTransmitQueueStatistics() const noexcept
+{
+	// Messages are directly pushed to the MessageDispatcher ring, which is drained by its own thread
+	auto statistics = TransmitQueueStatistics{};
+	statistics.sentFrames = _sentFrames.load(std::memory_order_relaxed);
+	statistics.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+ProtocolInterface::CommandTimeoutStatistics ProtocolInterfaceVirtualImpl::getCommandTimeoutStatistics() const noexcept
+{
+	return _stateMachineManager.getCommandTimeoutStatistics();
+}
+
+ProtocolInterface::LockStatistics ProtocolInterfaceVirtualImpl::getLockStatistics() const noexcept
+{
+	return _stateMachineManager.getLockStatistics();
+}
+
+ProtocolInterface::ReceiveStatistics ProtocolInterfaceVirtualImpl::getReceiveStatistics() const noexcept
+{
+	// There is no capture, dropped messages are counted on the sending side (see getTransmitQueueStatistics)
+	return {};
+}
+
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::setSniffingMode(bool const /*enabled*/) noexcept
+{
+	// Virtual network messages are not filtered
+	return Error::NoError;
+}
+
+ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendRawFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept
+{
+	if (length < EtherLayer2::HeaderLength || length > EthernetMaxFrameSize)
+	{
+		return Error::InvalidParameters;
+	}
+
+	// Short frames are padded the same way serialized messages are
+	auto buffer = SerializationBuffer{};
+	buffer.packBuffer(frame, length);
+	return sendPacket(buffer);
+}
+
 /* ************************************************************ */
 /* ProtocolInterfaceVirtual overrides                           */
 /* ************************************************************ */
 void ProtocolInterfaceVirtualImpl::forceTransportError() const noexcept
 {
-	sendPacket({});
+	// An empty message is a transport error for the MessageDispatcher
+	if (_dispatcherInterface)
+	{
+		_dispatcherInterface->push(nullptr, 0u);
+	}
 }
 
 /* ************************************************************ */
@@ -755,6 +920,12 @@ void ProtocolInterfaceVirtualImpl::onRemoteEntityUpdated(entity::Entity const& e
 	notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntityUpdated, this, entity);
 }
 
+void ProtocolInterfaceVirtualImpl::onRemoteEntitiesUpdated(EntityReferences const& entities) noexcept
+{
+	// Notify observers
+	notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onRemoteEntitiesUpdated, this, entities);
+}
+
 /* ************************************************************ */
 /* stateMachine::CommandStateMachine::Delegate overrides        */
 /* ************************************************************ */
@@ -795,35 +966,47 @@ void ProtocolInterfaceVirtualImpl::onAecpResponseTime(UniqueIdentifier const& en
 }
 
 /* ************************************************************ */
-/* MessageDispatcher::Observer overrides                        */
+/* FrameDecoder::Delegate overrides                             */
 /* ************************************************************ */
-void ProtocolInterfaceVirtualImpl::onMessage(SerializationBuffer const& message) noexcept
+ProtocolInterface::VendorUniqueDelegate* ProtocolInterfaceVirtualImpl::findVendorUniqueDelegate(VuAecpdu::ProtocolIdentifier const& protocolIdentifier) const noexcept
 {
-	auto const* const buffer = message.data();
-	auto const length = message.size();
+	return getVendorUniqueDelegate(protocolIdentifier);
+}
 
-	// Packet received, process it
-	auto des = DeserializationBuffer(buffer, length);
-	EtherLayer2 etherLayer2;
-	deserialize<EtherLayer2>(&etherLayer2, des);
+void ProtocolInterfaceVirtualImpl::onAdpduDecoded(Adpdu const& adpdu) noexcept
+{
+	notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adpdu);
+}
+
+void ProtocolInterfaceVirtualImpl::onAecpduDecoded(Aecpdu const& aecpdu) noexcept
+{
+	notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecpdu);
+}
+
+void ProtocolInterfaceVirtualImpl::onAcmpduDecoded(Acmpdu const& acmpdu) noexcept
+{
+	notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmpdu);
+}
+
+/* ************************************************************ */
+/* MessageDispatcher::Observer overrides                        */
+/* ************************************************************ */
+void ProtocolInterfaceVirtualImpl::onMessage(std::uint8_t const* const buffer, std::size_t const length) noexcept
+{
+	// Not enough bytes for an ethernet header
+	if (length < EtherLayer2::HeaderLength)
+	{
+		return;
+	}
 
 	// Only accept message for my MacAddress or the broadcast address
-	auto const& destAddress = etherLayer2.getDestAddress();
+	auto destAddress = networkInterface::MacAddress{};
+	std::memcpy(destAddress.data(), buffer, destAddress.size());
 	if (destAddress == getMacAddress() || destAddress == Multicast_Mac_Address || destAddress == Identify_Mac_Address)
 	{
-		// Check ether type (shouldn't be needed, pcap filter is active)
-		std::uint16_t etherType = AVDECC_UNPACK_TYPE(*((std::uint16_t*)(buffer + 12)), std::uint16_t);
-		if (etherType == AvtpEtherType)
-		{
-			std::uint8_t const* avtpdu = &buffer[14]; // Start of AVB Transport Protocol
-			auto avtpdu_size = length - 14;
-			// Check AVTP control bit (meaning AVDECC packet)
-			std::uint8_t avtp_sub_type_control = avtpdu[0];
-			if ((avtp_sub_type_control & 0xF0) != 0)
-			{
-				dispatchAvdeccMessage(avtpdu, avtpdu_size, etherLayer2);
-			}
-		}
+		// Packet received, process it (no transport timestamp for in-process frames)
+		_frameDecoder.processFrame(buffer, length, std::chrono::steady_clock::now());
+		_frameDecoder.completeBatch();
 	}
 }
 void ProtocolInterfaceVirtualImpl::onTransportError() noexcept
@@ -860,6 +1043,7 @@ void ProtocolInterfaceVirtualImpl::onObserverRegistered(observer_type* const obs
 			}
 			virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const /*entityID*/) noexcept override {}
 			virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& /*entity*/) noexcept override {}
+			virtual void onRemoteEntitiesUpdated(EntityReferences const& /*entities*/) noexcept override {}
 
 			ProtocolInterface& _pi;
 			ProtocolInterface::Observer& _obs;
@@ -883,245 +1067,18 @@ ProtocolInterface::Error ProtocolInterfaceVirtualImpl::sendPacket(SerializationB
 	if (length < minimumSize)
 		length = minimumSize; // No need to resize nor pad the buffer, it has enough capacity and we don't care about the unused bytes. Simply increase the length of the data to send.
 
-	try
-	{
-		// Push the buffer to the message dispatcher
-		auto& dispatcher = MessageDispatcher::getInstance();
-		dispatcher.push(_networkInterfaceName, buffer);
-		return Error::NoError;
-	}
-	catch (...)
-	{
-	}
-	return Error::TransportError;
-}
-
-void ProtocolInterfaceVirtualImpl::deserializeAecpMessage(EtherLayer2 const& etherLayer2, Deserializer& des, Aecpdu& aecp) const
-{
-	// Fill EtherLayer2
-	aecp.setSrcAddress(etherLayer2.getSrcAddress());
-	aecp.setDestAddress(etherLayer2.getDestAddress());
-	// Then deserialize Avtp control
-	deserialize<AvtpduControl>(&aecp, des);
-	// Then deserialize Aecp
-	deserialize<Aecpdu>(&aecp, des);
-}
-
-void ProtocolInterfaceVirtualImpl::dispatchAvdeccMessage(std::uint8_t const* const pkt_data, size_t const pkt_len, EtherLayer2 const& etherLayer2) noexcept
-{
-	try
-	{
-		// Read Avtpdu SubType and ControlData (which is remapped to MessageType for all 1722.1 messages)
-		std::uint8_t const subType = pkt_data[0] & 0x7f;
-		std::uint8_t const controlData = pkt_data[1] & 0x7f;
-
-		// Create a deserialization buffer
-		auto des = DeserializationBuffer(pkt_data, pkt_len);
-
-		switch (subType)
-		{
-			/* ADP Message */
-			case AvtpSubType_Adp:
-			{
-				auto adpdu = Adpdu::create();
-				auto& adp = static_cast<Adpdu&>(*adpdu);
-
-				// Fill EtherLayer2
-				adp.setSrcAddress(etherLayer2.getSrcAddress());
-				adp.setDestAddress(etherLayer2.getDestAddress());
-				// Then deserialize Avtp control
-				deserialize<AvtpduControl>(&adp, des);
-				// Then deserialize Adp
-				deserialize<Adpdu>(&adp, des);
-
-				// Low level notification
-				notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAdpduReceived, this, adp);
-
-				// Forward to our state machine
-				_stateMachineManager.processAdpdu(adp);
-				break;
-			}
-
-			/* AECP Message */
-			case AvtpSubType_Aecp:
-			{
-				auto const messageType = static_cast<AecpMessageType>(controlData);
-
-				static std::unordered_map<AecpMessageType, std::function<Aecpdu::UniquePointer(ProtocolInterfaceVirtualImpl* const pi, EtherLayer2 const& etherLayer2, Deserializer& des, std::uint8_t const* const pkt_data, size_t const pkt_len)>, AecpMessageType::Hash> s_Dispatch{
-					{ AecpMessageType::AemCommand,
-						[](ProtocolInterfaceVirtualImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-						{
-							return AemAecpdu::create(false);
-						} },
-					{ AecpMessageType::AemResponse,
-						[](ProtocolInterfaceVirtualImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-						{
-							return AemAecpdu::create(true);
-						} },
-					{ AecpMessageType::AddressAccessCommand,
-						[](ProtocolInterfaceVirtualImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-						{
-							return AaAecpdu::create(false);
-						} },
-					{ AecpMessageType::AddressAccessResponse,
-						[](ProtocolInterfaceVirtualImpl* const /*pi*/, EtherLayer2 const& /*etherLayer2*/, Deserializer& /*des*/, std::uint8_t const* const /*pkt_data*/, size_t const /*pkt_len*/)
-						{
-							return AaAecpdu::create(true);
-						} },
-					{ AecpMessageType::VendorUniqueCommand,
-						[](ProtocolInterfaceVirtualImpl* const pi, EtherLayer2 const& etherLayer2, Deserializer& des, std::uint8_t const* const pkt_data, size_t const pkt_len)
-						{
-							// We have to retrieve the ProtocolID to dispatch
-							auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
-							if (pkt_len >= (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifier::Size))
-							{
-								auto protocolIdentifier = VuAecpdu::ProtocolIdentifier::ArrayType{};
-								std::memcpy(protocolIdentifier.data(), pkt_data + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifier::Size);
-
-								auto const vuProtocolID = VuAecpdu::ProtocolIdentifier{ protocolIdentifier };
-								auto* vuDelegate = pi->getVendorUniqueDelegate(vuProtocolID);
-								if (vuDelegate)
-								{
-									// VendorUnique Commands are always handled by the VendorUniqueDelegate
-									auto aecpdu = vuDelegate->createAecpdu(vuProtocolID, false);
-									auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
-
-									// Deserialize the aecp message
-									pi->deserializeAecpMessage(etherLayer2, des, vuAecp);
-
-									// Low level notification
-									pi->notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, pi, vuAecp);
-
-									// Forward to the delegate
-									vuDelegate->onVuAecpCommand(pi, vuProtocolID, vuAecp);
-
-									// Return empty Aecpdu so that it's not processed by the StateMachineManager
-								}
-								else
-								{
-									LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Unhandled VendorUnique Command for ProtocolIdentifier {}", utils::toHexString(static_cast<VuAecpdu::ProtocolIdentifier::IntegralType>(vuProtocolID), true));
-								}
-							}
-							else
-							{
-								LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Invalid VendorUnique Command received. Not enough bytes in the message to hold ProtocolIdentifier");
-							}
-
-							return Aecpdu::UniquePointer{ nullptr, nullptr };
-						} },
-					{ AecpMessageType::VendorUniqueResponse,
-						[](ProtocolInterfaceVirtualImpl* const pi, EtherLayer2 const& etherLayer2, Deserializer& des, std::uint8_t const* const pkt_data, size_t const pkt_len)
-						{
-							// We have to retrieve the ProtocolID to dispatch
-							auto const protocolIdentifierOffset = AvtpduControl::HeaderLength + Aecpdu::HeaderLength;
-							if (pkt_len >= (protocolIdentifierOffset + VuAecpdu::ProtocolIdentifier::Size))
-							{
-								auto protocolIdentifier = VuAecpdu::ProtocolIdentifier::ArrayType{};
-								std::memcpy(protocolIdentifier.data(), pkt_data + protocolIdentifierOffset, VuAecpdu::ProtocolIdentifier::Size);
-
-								auto const vuProtocolID = VuAecpdu::ProtocolIdentifier{ protocolIdentifier };
-								auto* vuDelegate = pi->getVendorUniqueDelegate(vuProtocolID);
-								if (vuDelegate)
-								{
-									auto aecpdu = vuDelegate->createAecpdu(vuProtocolID, true);
-
-									// Are the messages handled by the VendorUniqueDelegate itself
-									if (!vuDelegate->areHandledByControllerStateMachine(vuProtocolID))
-									{
-										auto& vuAecp = static_cast<VuAecpdu&>(*aecpdu);
-
-										// Deserialize the aecp message
-										pi->deserializeAecpMessage(etherLayer2, des, vuAecp);
-
-										// Low level notification
-										pi->notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, pi, vuAecp);
-
-										// Forward to the delegate
-										vuDelegate->onVuAecpResponse(pi, vuProtocolID, vuAecp);
-
-										// Return empty Aecpdu so that it's not processed by the StateMachineManager
-										aecpdu.reset(nullptr);
-									}
-
-									return aecpdu;
-								}
-								else
-								{
-									LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Unhandled VendorUnique Response for ProtocolIdentifier {}", utils::toHexString(static_cast<VuAecpdu::ProtocolIdentifier::IntegralType>(vuProtocolID), true));
-								}
-							}
-							else
-							{
-								LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "Invalid VendorUnique Command received. Not enough bytes in the message to hold ProtocolIdentifier");
-							}
-
-							return Aecpdu::UniquePointer{ nullptr, nullptr };
-						} },
-				};
-
-				auto const& it = s_Dispatch.find(messageType);
-				if (it == s_Dispatch.end())
-					return; // Unsupported AECP message type
-
-				// Create aecpdu frame based on message type
-				auto aecpdu = it->second(this, etherLayer2, des, pkt_data, pkt_len);
-
-				if (aecpdu != nullptr)
-				{
-					auto& aecp = static_cast<Aecpdu&>(*aecpdu);
-
-					// Deserialize the aecp message
-					deserializeAecpMessage(etherLayer2, des, aecp);
-
-					// Low level notification
-					notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAecpduReceived, this, aecp);
+	recordSentFrame(buffer.data(), length);
 
-					// Forward to our state machine
-					_stateMachineManager.processAecpdu(aecp);
-				}
-				break;
-			}
-
-			/* ACMP Message */
-			case AvtpSubType_Acmp:
-			{
-				auto acmpdu = Acmpdu::create();
-				auto& acmp = static_cast<Acmpdu&>(*acmpdu);
-
-				// Fill EtherLayer2
-				acmp.setSrcAddress(etherLayer2.getSrcAddress());
-				static_cast<EtherLayer2&>(*acmpdu).setDestAddress(etherLayer2.getDestAddress()); // Fill dest address, even if we know it's always the MultiCast address
-				// Then deserialize Avtp control
-				deserialize<AvtpduControl>(&acmp, des);
-				// Then deserialize Acmp
-				deserialize<Acmpdu>(&acmp, des);
-
-				// Low level notification
-				notifyObserversMethod<ProtocolInterface::Observer>(&ProtocolInterface::Observer::onAcmpduReceived, this, acmp);
-
-				// Forward to our state machine
-				_stateMachineManager.processAcmpdu(acmp);
-				break;
-			}
-
-			/* MAAP Message */
-			case AvtpSubType_Maap:
-			{
-				break;
-			}
-			default:
-				return;
-		}
-	}
-	catch ([[maybe_unused]] std::invalid_argument const& e)
+	// Push the buffer to the message dispatcher
+	if (!_dispatcherInterface || !_dispatcherInterface->push(buffer.data(), length))
 	{
-		LOG_GENERIC_WARN(std::string("ProtocolInterfaceVirtual: Packet dropped: ") + e.what());
-	}
-	catch (...)
-	{
-		AVDECC_ASSERT(false, "Unknown exception");
-		LOG_GENERIC_WARN("ProtocolInterfaceVirtual: Packet dropped due to unknown exception");
+		_droppedFrames.fetch_add(1u, std::memory_order_relaxed);
+		LOG_PROTOCOL_INTERFACE_WARN(getMacAddress(), networkInterface::MacAddress{}, "ProtocolInterfaceVirtual: Frame dropped by the virtual network");
+		return Error::TransportError;
 	}
+
+	_sentFrames.fetch_add(1u, std::memory_order_relaxed);
+	return Error::NoError;
 }
 
 ProtocolInterfaceVirtual::ProtocolInterfaceVirtual(std::string const& networkInterfaceName, networkInterface::MacAddress const& macAddress)
@@ -0,0 +1,546 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file proxyProtocol.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+#include "proxyProtocol.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#ifndef MSG_NOSIGNAL
+#	define MSG_NOSIGNAL 0 // SO_NOSIGPIPE is set on the socket instead
+#endif // !MSG_NOSIGNAL
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace proxy
+{
+namespace
+{
+constexpr auto UnixPrefix = "unix:";
+constexpr auto ListenBacklog = 16;
+constexpr auto ReadChunkSize = std::size_t{ 64u * 1024u };
+
+struct Address
+{
+	bool isUnix{ false };
+	std::string path{}; // Unix domain socket path
+	std::string host{}; // TCP host (empty for any/localhost)
+	std::string port{}; // TCP port
+};
+
+Address parseAddress(std::string const& address)
+{
+	auto result = Address{};
+
+	if (address.compare(0, std::strlen(UnixPrefix), UnixPrefix) == 0)
+	{
+		result.isUnix = true;
+		result.path = address.substr(std::strlen(UnixPrefix));
+	}
+	else if (!address.empty() && address[0] == '/')
+	{
+		result.isUnix = true;
+		result.path = address;
+	}
+	else
+	{
+		auto const pos = address.rfind(':');
+		if (pos == std::string::npos || pos + 1u == address.size())
+		{
+			throw ProtocolInterface::Exception(ProtocolInterface::Error::InvalidParameters, "Invalid proxy address (expected 'unix:<path>' or '<host>:<port>'): " + address);
+		}
+		result.host = address.substr(0u, pos);
+		result.port = address.substr(pos + 1u);
+	}
+
+	if (result.isUnix && (result.path.empty() || result.path.size() >= sizeof(sockaddr_un::sun_path)))
+	{
+		throw ProtocolInterface::Exception(ProtocolInterface::Error::InvalidParameters, "Invalid proxy Unix domain socket path: " + address);
+	}
+
+	return result;
+}
+
+[[noreturn]] void throwSocketError(std::string const& message)
+{
+	throw ProtocolInterface::Exception(ProtocolInterface::Error::TransportError, message + ": " + std::strerror(errno));
+}
+
+sockaddr_un makeUnixAddress(std::string const& path) noexcept
+{
+	auto unixAddress = sockaddr_un{};
+	unixAddress.sun_family = AF_UNIX;
+	std::memcpy(unixAddress.sun_path, path.c_str(), path.size());
+	return unixAddress;
+}
+
+/** Socket closed when going out of scope, unless released */
+class ScopedSocket final
+{
+public:
+	explicit ScopedSocket(int const fd) noexcept
+		: _fd{ fd }
+	{
+	}
+
+	~ScopedSocket() noexcept
+	{
+		if (_fd != -1)
+		{
+			::close(_fd);
+		}
+	}
+
+	int get() const noexcept
+	{
+		return _fd;
+	}
+
+	int release() noexcept
+	{
+		return std::exchange(_fd, -1);
+	}
+
+	// Deleted compiler auto-generated methods
+	ScopedSocket(ScopedSocket&&) = delete;
+	ScopedSocket(ScopedSocket const&) = delete;
+	ScopedSocket& operator=(ScopedSocket const&) = delete;
+	ScopedSocket& operator=(ScopedSocket&&) = delete;
+
+private:
+	int _fd{ -1 };
+};
+
+int createSocket(int const family) noexcept
+{
+	auto const fd = ::socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+	{
+		return -1;
+	}
+
+#ifdef SO_NOSIGPIPE
+	auto const enable = int{ 1 };
+	::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif // SO_NOSIGPIPE
+	if (family != AF_UNIX)
+	{
+		// AECP commands are small and latency sensitive
+		auto const noDelay = int{ 1 };
+		::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	}
+
+	return fd;
+}
+
+std::unique_ptr<addrinfo, decltype(&::freeaddrinfo)> resolve(Address const& address, bool const isPassive)
+{
+	auto hints = addrinfo{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = isPassive ? AI_PASSIVE : 0;
+
+	auto* result = static_cast<addrinfo*>(nullptr);
+	auto const* const host = address.host.empty() ? nullptr : address.host.c_str();
+	if (auto const error = ::getaddrinfo(host, address.port.c_str(), &hints, &result); error != 0)
+	{
+		throw ProtocolInterface::Exception(ProtocolInterface::Error::InvalidParameters, std::string("Cannot resolve proxy address: ") + ::gai_strerror(error));
+	}
+	return { result, &::freeaddrinfo };
+}
+} // namespace
+
+Header makeHeader(MessageType const type, std::uint16_t const count, std::size_t const payloadLength) noexcept
+{
+	auto const length = static_cast<std::uint32_t>(payloadLength);
+	auto const messageType = static_cast<std::uint16_t>(type);
+	return Header{ static_cast<std::uint8_t>(length >> 24), static_cast<std::uint8_t>(length >> 16), static_cast<std::uint8_t>(length >> 8), static_cast<std::uint8_t>(length), static_cast<std::uint8_t>(messageType >> 8), static_cast<std::uint8_t>(messageType), static_cast<std::uint8_t>(count >> 8), static_cast<std::uint8_t>(count) };
+}
+
+RecordHeader makeRecordHeader(std::size_t const frameLength) noexcept
+{
+	return RecordHeader{ static_cast<std::uint8_t>(frameLength >> 8), static_cast<std::uint8_t>(frameLength) };
+}
+
+std::vector<std::uint8_t> makeWelcomeMessage(networkInterface::MacAddress const& macAddress)
+{
+	auto const header = makeHeader(MessageType::Welcome, 0u, WelcomePayloadLength);
+	auto message = std::vector<std::uint8_t>{ header.begin(), header.end() };
+
+	message.push_back(static_cast<std::uint8_t>(ProtocolMagic >> 24));
+	message.push_back(static_cast<std::uint8_t>(ProtocolMagic >> 16));
+	message.push_back(static_cast<std::uint8_t>(ProtocolMagic >> 8));
+	message.push_back(static_cast<std::uint8_t>(ProtocolMagic));
+	message.push_back(static_cast<std::uint8_t>(ProtocolVersion >> 8));
+	message.push_back(static_cast<std::uint8_t>(ProtocolVersion));
+	message.insert(message.end(), macAddress.begin(), macAddress.end());
+
+	return message;
+}
+
+std::vector<std::uint8_t> makeSetFilterMessage(bool const isSniffing, std::vector<UniqueIdentifier> const& entityIDs)
+{
+	auto const count = std::min<std::size_t>(entityIDs.size(), std::numeric_limits<std::uint16_t>::max());
+	auto const header = makeHeader(MessageType::SetFilter, static_cast<std::uint16_t>(count), sizeof(std::uint16_t) + count * sizeof(UniqueIdentifier::value_type));
+	auto message = std::vector<std::uint8_t>{ header.begin(), header.end() };
+
+	auto const flags = isSniffing ? FilterFlag_Sniffing : std::uint16_t{ 0u };
+	message.push_back(static_cast<std::uint8_t>(flags >> 8));
+	message.push_back(static_cast<std::uint8_t>(flags));
+	for (auto index = std::size_t{ 0u }; index < count; ++index)
+	{
+		auto const value = entityIDs[index].getValue();
+		for (auto shift = 56; shift >= 0; shift -= 8)
+		{
+			message.push_back(static_cast<std::uint8_t>(value >> shift));
+		}
+	}
+
+	return message;
+}
+
+std::optional<networkInterface::MacAddress> parseWelcomeMessage(Message const& message) noexcept
+{
+	if (message.type != MessageType::Welcome || message.length != WelcomePayloadLength)
+	{
+		return std::nullopt;
+	}
+
+	auto const* const payload = message.payload;
+	auto const magic = (static_cast<std::uint32_t>(payload[0]) << 24) | (static_cast<std::uint32_t>(payload[1]) << 16) | (static_cast<std::uint32_t>(payload[2]) << 8) | payload[3];
+	auto const version = static_cast<std::uint16_t>((payload[4] << 8) | payload[5]);
+	if (magic != ProtocolMagic || version != ProtocolVersion)
+	{
+		return std::nullopt;
+	}
+
+	auto macAddress = networkInterface::MacAddress{};
+	std::memcpy(macAddress.data(), payload + 6, macAddress.size());
+	return macAddress;
+}
+
+bool parseSetFilterMessage(Message const& message, bool& isSniffing, std::vector<UniqueIdentifier>& entityIDs)
+{
+	if (message.type != MessageType::SetFilter || message.length != sizeof(std::uint16_t) + message.count * sizeof(UniqueIdentifier::value_type))
+	{
+		return false;
+	}
+
+	auto const* payload = message.payload;
+	auto const flags = static_cast<std::uint16_t>((payload[0] << 8) | payload[1]);
+	payload += sizeof(flags);
+
+	isSniffing = (flags & FilterFlag_Sniffing) != 0u;
+	entityIDs.clear();
+	entityIDs.reserve(message.count);
+	for (auto index = std::uint16_t{ 0u }; index < message.count; ++index)
+	{
+		auto value = UniqueIdentifier::value_type{ 0u };
+		for (auto byte = 0u; byte < sizeof(value); ++byte)
+		{
+			value = (value << 8) | *payload++;
+		}
+		entityIDs.push_back(UniqueIdentifier{ value });
+	}
+
+	return true;
+}
+
+MessageReader::MessageReader()
+	: _buffer(ReadChunkSize)
+{
+}
+
+MessageReader::Status MessageReader::read(int const fd) noexcept
+{
+	// Move the incomplete message at the beginning of the buffer
+	if (_readOffset != 0u)
+	{
+		std::memmove(_buffer.data(), _buffer.data() + _readOffset, _writeOffset - _readOffset);
+		_writeOffset -= _readOffset;
+		_readOffset = 0u;
+	}
+
+	// Make sure there is room for a complete chunk (the buffer grows up to the maximum message size)
+	if (_hasError)
+	{
+		return Status::Error;
+	}
+	if (_buffer.size() - _writeOffset < ReadChunkSize)
+	{
+		try
+		{
+			_buffer.resize(_writeOffset + ReadChunkSize);
+		}
+		catch (...)
+		{
+			return Status::Error;
+		}
+	}
+
+	auto const result = ::recv(fd, _buffer.data() + _writeOffset, _buffer.size() - _writeOffset, 0);
+	if (result > 0)
+	{
+		_writeOffset += static_cast<std::size_t>(result);
+		return Status::Success;
+	}
+	if (result == 0)
+	{
+		return Status::Closed;
+	}
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	{
+		return Status::WouldBlock;
+	}
+	return Status::Error;
+}
+
+std::optional<Message> MessageReader::next() noexcept
+{
+	auto const available = _writeOffset - _readOffset;
+	if (available < HeaderLength)
+	{
+		return std::nullopt;
+	}
+
+	auto const* const header = _buffer.data() + _readOffset;
+	auto const length = (static_cast<std::size_t>(header[0]) << 24) | (static_cast<std::size_t>(header[1]) << 16) | (static_cast<std::size_t>(header[2]) << 8) | header[3];
+	if (length > MaximumPayloadLength)
+	{
+		// Invalid stream, the connection has to be closed
+		_readOffset = _writeOffset = 0u;
+		_hasError = true;
+		return std::nullopt;
+	}
+	if (available < HeaderLength + length)
+	{
+		return std::nullopt;
+	}
+
+	auto message = Message{};
+	message.type = static_cast<MessageType>((header[4] << 8) | header[5]);
+	message.count = static_cast<std::uint16_t>((header[6] << 8) | header[7]);
+	message.payload = header + HeaderLength;
+	message.length = length;
+
+	_readOffset += HeaderLength + length;
+
+	return message;
+}
+
+bool MessageReader::hasError() const noexcept
+{
+	return _hasError;
+}
+
+int listenOn(std::string const& address)
+{
+	auto const parsedAddress = parseAddress(address);
+
+	if (parsedAddress.isUnix)
+	{
+		auto const unixAddress = makeUnixAddress(parsedAddress.path);
+
+		// Remove a stale socket file, unless a server is still listening on it
+		{
+			auto probe = ScopedSocket{ createSocket(AF_UNIX) };
+			if (probe.get() != -1 && ::connect(probe.get(), reinterpret_cast<sockaddr const*>(&unixAddress), sizeof(unixAddress)) == 0)
+			{
+				throw ProtocolInterface::Exception(ProtocolInterface::Error::TransportError, "A proxy server is already listening on " + address);
+			}
+			::unlink(parsedAddress.path.c_str());
+		}
+
+		auto fd = ScopedSocket{ createSocket(AF_UNIX) };
+		if (fd.get() == -1)
+		{
+			throwSocketError("Failed to create proxy socket");
+		}
+		if (::bind(fd.get(), reinterpret_cast<sockaddr const*>(&unixAddress), sizeof(unixAddress)) == -1)
+		{
+			throwSocketError("Failed to bind proxy socket to " + address);
+		}
+		if (::listen(fd.get(), ListenBacklog) == -1)
+		{
+			throwSocketError("Failed to listen on " + address);
+		}
+		return fd.release();
+	}
+
+	auto const addresses = resolve(parsedAddress, true);
+	for (auto const* info = addresses.get(); info != nullptr; info = info->ai_next)
+	{
+		auto fd = ScopedSocket{ createSocket(info->ai_family) };
+		if (fd.get() == -1)
+		{
+			continue;
+		}
+		auto const reuse = int{ 1 };
+		::setsockopt(fd.get(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		if (::bind(fd.get(), info->ai_addr, info->ai_addrlen) == 0 && ::listen(fd.get(), ListenBacklog) == 0)
+		{
+			return fd.release();
+		}
+	}
+
+	throwSocketError("Failed to listen on " + address);
+}
+
+int connectTo(std::string const& address)
+{
+	auto const parsedAddress = parseAddress(address);
+
+	if (parsedAddress.isUnix)
+	{
+		auto const unixAddress = makeUnixAddress(parsedAddress.path);
+		auto fd = ScopedSocket{ createSocket(AF_UNIX) };
+		if (fd.get() == -1)
+		{
+			throwSocketError("Failed to create proxy socket");
+		}
+		if (::connect(fd.get(), reinterpret_cast<sockaddr const*>(&unixAddress), sizeof(unixAddress)) == -1)
+		{
+			throwSocketError("Failed to connect to proxy server " + address);
+		}
+		return fd.release();
+	}
+
+	auto const addresses = resolve(parsedAddress, false);
+	for (auto const* info = addresses.get(); info != nullptr; info = info->ai_next)
+	{
+		auto fd = ScopedSocket{ createSocket(info->ai_family) };
+		if (fd.get() != -1 && ::connect(fd.get(), info->ai_addr, info->ai_addrlen) == 0)
+		{
+			return fd.release();
+		}
+	}
+
+	throwSocketError("Failed to connect to proxy server " + address);
+}
+
+int acceptFrom(int const listenFd) noexcept
+{
+	auto address = sockaddr_storage{};
+	auto addressLength = socklen_t{ sizeof(address) };
+	auto fd = ScopedSocket{ ::accept(listenFd, reinterpret_cast<sockaddr*>(&address), &addressLength) };
+	if (fd.get() == -1)
+	{
+		return -1;
+	}
+
+	if (::fcntl(fd.get(), F_SETFD, FD_CLOEXEC) == -1 || ::fcntl(fd.get(), F_SETFL, ::fcntl(fd.get(), F_GETFL) | O_NONBLOCK) == -1)
+	{
+		return -1;
+	}
+#ifdef SO_NOSIGPIPE
+	auto const enable = int{ 1 };
+	::setsockopt(fd.get(), SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif // SO_NOSIGPIPE
+	if (address.ss_family != AF_UNIX)
+	{
+		auto const noDelay = int{ 1 };
+		::setsockopt(fd.get(), IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	}
+
+	return fd.release();
+}
+
+void unlinkAddress(std::string const& address) noexcept
+{
+	try
+	{
+		auto const parsedAddress = parseAddress(address);
+		if (parsedAddress.isUnix)
+		{
+			::unlink(parsedAddress.path.c_str());
+		}
+	}
+	catch (...)
+	{
+	}
+}
+
+ssize_t sendVectors(int const fd, iovec* const vectors, std::size_t const count) noexcept
+{
+	auto header = msghdr{};
+	header.msg_iov = vectors;
+	header.msg_iovlen = static_cast<decltype(header.msg_iovlen)>(count);
+
+	while (true)
+	{
+		auto const result = ::sendmsg(fd, &header, MSG_NOSIGNAL);
+		if (result == -1 && errno == EINTR)
+		{
+			continue;
+		}
+		return result;
+	}
+}
+
+bool sendAllVectors(int const fd, iovec* vectors, std::size_t count) noexcept
+{
+	while (count != 0u)
+	{
+		auto sent = sendVectors(fd, vectors, count);
+		if (sent == -1)
+		{
+			return false;
+		}
+
+		// Skip the vectors that have been completely sent, and adjust the first partially sent one
+		while (count != 0u && static_cast<std::size_t>(sent) >= vectors->iov_len)
+		{
+			sent -= static_cast<ssize_t>(vectors->iov_len);
+			++vectors;
+			--count;
+		}
+		if (count != 0u)
+		{
+			vectors->iov_base = static_cast<std::uint8_t*>(vectors->iov_base) + sent;
+			vectors->iov_len -= static_cast<std::size_t>(sent);
+		}
+	}
+	return true;
+}
+
+} // namespace proxy
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,168 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file proxyProtocol.hpp
+* @author Christophe Calmejane
+* @brief Messages and sockets shared by the proxy server and the proxy ProtocolInterface.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/uniqueIdentifier.hpp"
+#include "la/avdecc/networkInterfaceHelper.hpp"
+
+#include <sys/uio.h>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace proxy
+{
+/**
+* Messages are made of a Header followed by a payload, all fields in network byte order:
+*  - Header: 32 bits payload length, 16 bits MessageType, 16 bits count
+*  - Welcome (server to client, once connected): 32 bits ProtocolMagic, 16 bits ProtocolVersion, 48 bits MAC address of the served network interface
+*  - Frames (both ways): count records of 16 bits frame length followed by the ethernet frame
+*  - SetFilter (client to server): 16 bits FilterFlags, followed by count 64 bits EntityIDs of the client's LocalEntities
+*/
+enum class MessageType : std::uint16_t
+{
+	Welcome = 1,
+	Frames = 2,
+	SetFilter = 3,
+};
+
+constexpr auto ProtocolMagic = std::uint32_t{ 0x41564450 }; // 'AVDP'
+constexpr auto ProtocolVersion = std::uint16_t{ 1u };
+constexpr auto HeaderLength = std::size_t{ 8u };
+constexpr auto RecordHeaderLength = std::size_t{ 2u };
+constexpr auto WelcomePayloadLength = std::size_t{ 12u };
+constexpr auto MaximumPayloadLength = std::size_t{ 256u * 1024u };
+constexpr auto FilterFlag_Sniffing = std::uint16_t{ 0x0001 };
+
+using Header = std::array<std::uint8_t, HeaderLength>;
+using RecordHeader = std::array<std::uint8_t, RecordHeaderLength>;
+
+/** A complete message, pointing to the buffer of the MessageReader it was extracted from */
+struct Message
+{
+	MessageType type{ MessageType::Frames };
+	std::uint16_t count{ 0u };
+	std::uint8_t const* payload{ nullptr };
+	std::size_t length{ 0u };
+};
+
+Header makeHeader(MessageType const type, std::uint16_t const count, std::size_t const payloadLength) noexcept;
+RecordHeader makeRecordHeader(std::size_t const frameLength) noexcept;
+std::vector<std::uint8_t> makeWelcomeMessage(networkInterface::MacAddress const& macAddress);
+std::vector<std::uint8_t> makeSetFilterMessage(bool const isSniffing, std::vector<UniqueIdentifier> const& entityIDs);
+
+/** Returns the MAC address of a Welcome message, or nothing if the message is not a valid Welcome one. */
+std::optional<networkInterface::MacAddress> parseWelcomeMessage(Message const& message) noexcept;
+/** Decodes a SetFilter message. Returns false if the message is not a valid SetFilter one. */
+bool parseSetFilterMessage(Message const& message, bool& isSniffing, std::vector<UniqueIdentifier>& entityIDs);
+
+/** Calls handler(record, frame, frameLength) for each record of a Frames message, record pointing to the RecordHeader of the frame. Returns false if the message is malformed (stopping at the first invalid record). */
+template<typename Handler>
+bool forEachFrame(Message const& message, Handler&& handler)
+{
+	auto offset = std::size_t{ 0u };
+	for (auto index = std::uint16_t{ 0u }; index < message.count; ++index)
+	{
+		if (offset + RecordHeaderLength > message.length)
+		{
+			return false;
+		}
+		auto const* const record = message.payload + offset;
+		auto const frameLength = static_cast<std::size_t>((record[0] << 8) | record[1]);
+		if (offset + RecordHeaderLength + frameLength > message.length)
+		{
+			return false;
+		}
+		handler(record, record + RecordHeaderLength, frameLength);
+		offset += RecordHeaderLength + frameLength;
+	}
+	return offset == message.length;
+}
+
+/**
+* @brief Accumulates the bytes read from a stream socket and splits them into messages.
+* @details Messages are returned in place (no copy), they are valid until the next call to read.
+*/
+class MessageReader final
+{
+public:
+	enum class Status
+	{
+		Success = 0, /**< Some bytes have been read */
+		WouldBlock = 1, /**< Non-blocking socket has nothing to read */
+		Closed = 2, /**< Peer closed the connection */
+		Error = 3, /**< Socket error, or the peer sent a message exceeding MaximumPayloadLength */
+	};
+
+	MessageReader();
+
+	/** Reads as many bytes as possible from fd with a single recv call. */
+	Status read(int const fd) noexcept;
+
+	/** Returns the next complete message, or nothing if more bytes have to be read (or if the peer sent an invalid message, in which case the next read returns Status::Error). */
+	std::optional<Message> next() noexcept;
+
+	/** Returns true if the peer sent an invalid message (the connection has to be closed). */
+	bool hasError() const noexcept;
+
+private:
+	bool _hasError{ false };
+	std::vector<std::uint8_t> _buffer{};
+	std::size_t _readOffset{ 0u };
+	std::size_t _writeOffset{ 0u };
+};
+
+/** Opens a listening socket on the specified address ('unix:<path>', '<path>' starting with '/', or '<host>:<port>'). Throws ProtocolInterface::Exception on error. */
+int listenOn(std::string const& address);
+
+/** Connects a socket to the specified address (same syntax than listenOn). Throws ProtocolInterface::Exception on error. */
+int connectTo(std::string const& address);
+
+/** Accepts a connection on a listening socket, returning a non-blocking socket (or -1 on error, errno being set). */
+int acceptFrom(int const listenFd) noexcept;
+
+/** Removes the Unix domain socket file, if address is a Unix domain one. */
+void unlinkAddress(std::string const& address) noexcept;
+
+/** Sends the iovecs with a single sendmsg call (without raising SIGPIPE). Returns the number of bytes sent, or -1 on error (errno being set). */
+ssize_t sendVectors(int const fd, iovec* const vectors, std::size_t const count) noexcept;
+
+/** Sends the iovecs, blocking until everything is sent (the iovecs are modified). Returns false on error. */
+bool sendAllVectors(int const fd, iovec* vectors, std::size_t count) noexcept;
+
+} // namespace proxy
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,619 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file proxyServer.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/internals/proxyServer.hpp"
+#include "la/avdecc/internals/protocolAvtpdu.hpp"
+#include "la/avdecc/utils.hpp"
+
+#include "entityFilter.hpp"
+#include "frameTap.hpp"
+#include "proxyProtocol.hpp"
+#include "logHelper.hpp"
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+class ProxyServerImpl final : public ProxyServer, private FrameTap
+{
+public:
+	static constexpr auto MaximumBatchSize = std::size_t{ 64u }; /**< Maximum number of received frames sent to the clients in a single message */
+	static constexpr auto MaximumBacklogSize = std::size_t{ 4u * 1024u * 1024u }; /**< Maximum number of bytes buffered for a client not reading its socket fast enough, before frames are dropped */
+	static constexpr auto PollTimeout = std::chrono::milliseconds{ 100u };
+
+	/** Constructor */
+	ProxyServerImpl(ProtocolInterface::Type const protocolInterfaceType, std::string const& networkInterfaceName, std::string const& listenAddress)
+		: _protocolInterface{ ProtocolInterface::create(protocolInterfaceType, networkInterfaceName) }
+		, _listenAddress{ listenAddress.empty() ? getDefaultAddress(networkInterfaceName) : listenAddress }
+	{
+		// Clients are filtered by the server, the served ProtocolInterface has to receive all AVDECC messages
+		_protocolInterface->setSniffingMode(true);
+
+		_listenFd = proxy::listenOn(_listenAddress);
+
+		if (::pipe(_wakeUpPipe) == -1)
+		{
+			auto const error = std::string("Failed to create proxy server wake up pipe: ") + std::strerror(errno);
+			::close(_listenFd);
+			proxy::unlinkAddress(_listenAddress);
+			throw ProtocolInterface::Exception(ProtocolInterface::Error::TransportError, error);
+		}
+		for (auto const fd : _wakeUpPipe)
+		{
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+			::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+		}
+
+		_batch.reserve(MaximumBatchSize * (proxy::RecordHeaderLength + EthernetMaxFrameSize));
+		_batchRecords.reserve(MaximumBatchSize);
+
+		// Received frames are now forwarded to the clients instead of being decoded
+		_protocolInterface->_frameTap.store(this, std::memory_order_release);
+
+		_thread = std::thread(
+			[this]
+			{
+				utils::setCurrentThreadName("avdecc::ProxyServer");
+				run();
+			});
+	}
+
+	/** Destructor */
+	virtual ~ProxyServerImpl() noexcept
+	{
+		// Stop receiving frames first, so the frame tap is no longer called
+		_protocolInterface->shutdown();
+		_protocolInterface->_frameTap.store(nullptr, std::memory_order_release);
+
+		// Stop the server thread
+		_shouldTerminate = true;
+		wakeUp();
+		if (_thread.joinable())
+		{
+			_thread.join();
+		}
+
+		{
+			auto const lg = std::lock_guard{ _clientsLock };
+			_clients.clear();
+		}
+
+		::close(_listenFd);
+		proxy::unlinkAddress(_listenAddress);
+		for (auto const fd : _wakeUpPipe)
+		{
+			::close(fd);
+		}
+	}
+
+	/** Destroy method for COM-like interface */
+	virtual void destroy() noexcept override
+	{
+		delete this;
+	}
+
+	// Deleted compiler auto-generated methods
+	ProxyServerImpl(ProxyServerImpl&&) = delete;
+	ProxyServerImpl(ProxyServerImpl const&) = delete;
+	ProxyServerImpl& operator=(ProxyServerImpl const&) = delete;
+	ProxyServerImpl& operator=(ProxyServerImpl&&) = delete;
+
+private:
+	/** A record (RecordHeader followed by the frame) of a Frames message, pointing either to the received frames batch or to the message of a client */
+	struct Record
+	{
+		std::uint8_t const* data{ nullptr };
+		std::size_t length{ 0u };
+	};
+
+	struct Client
+	{
+		explicit Client(int const socket) noexcept
+			: fd{ socket }
+		{
+		}
+
+		~Client() noexcept
+		{
+			::close(fd);
+		}
+
+		int const fd{ -1 };
+		proxy::MessageReader reader{}; // Only accessed from the server thread
+		entityFilter::Program filter{ entityFilter::makeLocalEntitiesProgram({}) }; // Protected by _clientsLock
+		std::vector<std::uint8_t> backlog{}; // Bytes not accepted by the socket yet, protected by _clientsLock
+		bool hasError{ false }; // Protected by _clientsLock
+	};
+
+	using SharedClient = std::shared_ptr<Client>;
+
+	/* ************************************************************ */
+	/* ProxyServer overrides                                        */
+	/* ************************************************************ */
+	virtual ProtocolInterface& getProtocolInterface() noexcept override
+	{
+		return *_protocolInterface;
+	}
+
+	virtual Statistics getStatistics() const noexcept override
+	{
+		auto statistics = Statistics{};
+		{
+			auto const lg = std::lock_guard{ _clientsLock };
+			statistics.connectedClients = _clients.size();
+		}
+		statistics.receivedFrames = _receivedFrames.load(std::memory_order_relaxed);
+		statistics.clientFrames = _clientFrames.load(std::memory_order_relaxed);
+		statistics.forwardedFrames = _forwardedFrames.load(std::memory_order_relaxed);
+		statistics.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+		statistics.rejectedFrames = _rejectedFrames.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	/* ************************************************************ */
+	/* FrameTap overrides                                           */
+	/* ************************************************************ */
+	virtual bool onFrameReceived(std::uint8_t const* const frame, std::size_t const length) noexcept override
+	{
+		if (length > EthernetMaxFrameSize)
+		{
+			return true;
+		}
+
+		// Copy the frame to the batch once, the messages sent to the clients point to it (the batch is never reallocated, its capacity being reserved for MaximumBatchSize frames)
+		auto const recordHeader = proxy::makeRecordHeader(length);
+		auto const offset = _batch.size();
+		_batch.insert(_batch.end(), recordHeader.begin(), recordHeader.end());
+		_batch.insert(_batch.end(), frame, frame + length);
+		_batchRecords.push_back(Record{ _batch.data() + offset, proxy::RecordHeaderLength + length });
+
+		_receivedFrames.fetch_add(1u, std::memory_order_relaxed);
+
+		if (_batchRecords.size() == MaximumBatchSize)
+		{
+			flushBatch();
+		}
+
+		return true;
+	}
+
+	virtual void onBatchComplete() noexcept override
+	{
+		flushBatch();
+	}
+
+	/* ************************************************************ */
+	/* Private methods                                              */
+	/* ************************************************************ */
+	void flushBatch() noexcept
+	{
+		if (_batchRecords.empty())
+		{
+			return;
+		}
+
+		fanOut(_batchRecords);
+
+		_batch.clear();
+		_batchRecords.clear();
+	}
+
+	/** Sends the records to all the clients, each client only receiving the frames accepted by its filter */
+	void fanOut(std::vector<Record> const& records) noexcept
+	{
+		auto const lg = std::lock_guard{ _clientsLock };
+
+		for (auto const& client : _clients)
+		{
+			if (client->hasError)
+			{
+				continue;
+			}
+
+			// Scatter/gather the accepted records, without copying them (consecutive records are sent as a single vector)
+			_vectors.clear();
+			_vectors.push_back(iovec{});
+			auto count = std::uint16_t{ 0u };
+			auto payloadLength = std::size_t{ 0u };
+			for (auto const& record : records)
+			{
+				if (!entityFilter::accepts(client->filter, record.data + proxy::RecordHeaderLength, record.length - proxy::RecordHeaderLength))
+				{
+					continue;
+				}
+				auto& lastVector = _vectors.back();
+				if (count != 0u && static_cast<std::uint8_t const*>(lastVector.iov_base) + lastVector.iov_len == record.data)
+				{
+					lastVector.iov_len += record.length;
+				}
+				else
+				{
+					_vectors.push_back(iovec{ const_cast<std::uint8_t*>(record.data), record.length });
+				}
+				++count;
+				payloadLength += record.length;
+			}
+
+			if (count == 0u)
+			{
+				continue;
+			}
+
+			auto header = proxy::makeHeader(proxy::MessageType::Frames, count, payloadLength);
+			_vectors.front() = iovec{ header.data(), header.size() };
+
+			sendToClient(*client, _vectors, proxy::HeaderLength + payloadLength, count);
+		}
+	}
+
+	/** Sends a message to a client, buffering what cannot be sent right away. Must be called with _clientsLock held. */
+	void sendToClient(Client& client, std::vector<iovec>& vectors, std::size_t const length, std::size_t const framesCount) noexcept
+	{
+		auto sent = std::size_t{ 0u };
+
+		// Keep the messages ordered: if some bytes are already waiting, the whole message has to wait
+		if (client.backlog.empty())
+		{
+			auto const result = proxy::sendVectors(client.fd, vectors.data(), vectors.size());
+			if (result == -1)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+				{
+					client.hasError = true;
+					wakeUp();
+					return;
+				}
+			}
+			else
+			{
+				sent = static_cast<std::size_t>(result);
+			}
+		}
+
+		if (sent < length)
+		{
+			if (client.backlog.size() + (length - sent) > MaximumBacklogSize)
+			{
+				// A partially sent message has to be completed, to keep the stream valid
+				if (sent == 0u)
+				{
+					_droppedFrames.fetch_add(framesCount, std::memory_order_relaxed);
+					return;
+				}
+			}
+
+			try
+			{
+				// Buffer the bytes not sent yet, the server thread will send them once the socket is writable
+				auto skipped = sent;
+				for (auto const& vector : vectors)
+				{
+					auto const* const data = static_cast<std::uint8_t const*>(vector.iov_base);
+					if (skipped >= vector.iov_len)
+					{
+						skipped -= vector.iov_len;
+						continue;
+					}
+					client.backlog.insert(client.backlog.end(), data + skipped, data + vector.iov_len);
+					skipped = 0u;
+				}
+			}
+			catch (...)
+			{
+				client.hasError = true;
+			}
+			wakeUp();
+		}
+
+		_forwardedFrames.fetch_add(framesCount, std::memory_order_relaxed);
+	}
+
+	void wakeUp() noexcept
+	{
+		auto const value = std::uint8_t{ 1u };
+		[[maybe_unused]] auto const ret = ::write(_wakeUpPipe[1], &value, sizeof(value));
+	}
+
+	void run() noexcept
+	{
+		auto pollDescriptors = std::vector<pollfd>{};
+		auto polledClients = std::vector<SharedClient>{};
+
+		while (!_shouldTerminate)
+		{
+			pollDescriptors.clear();
+			polledClients.clear();
+			pollDescriptors.push_back(pollfd{ _wakeUpPipe[0], POLLIN, 0 });
+			pollDescriptors.push_back(pollfd{ _listenFd, POLLIN, 0 });
+			{
+				auto const lg = std::lock_guard{ _clientsLock };
+				for (auto const& client : _clients)
+				{
+					auto const events = static_cast<short>(client->backlog.empty() ? POLLIN : (POLLIN | POLLOUT));
+					pollDescriptors.push_back(pollfd{ client->fd, events, 0 });
+					polledClients.push_back(client);
+				}
+			}
+
+			if (::poll(pollDescriptors.data(), static_cast<nfds_t>(pollDescriptors.size()), static_cast<int>(PollTimeout.count())) == -1)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				LOG_PROTOCOL_INTERFACE_ERROR(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProxyServer: poll failed: {}", std::strerror(errno));
+				return;
+			}
+
+			// Drain the wake up pipe
+			if (pollDescriptors[0].revents != 0)
+			{
+				auto buffer = std::array<std::uint8_t, 64>{};
+				while (::read(_wakeUpPipe[0], buffer.data(), buffer.size()) > 0)
+				{
+				}
+			}
+
+			if ((pollDescriptors[1].revents & POLLIN) != 0)
+			{
+				acceptClient();
+			}
+
+			for (auto index = std::size_t{ 0u }; index < polledClients.size(); ++index)
+			{
+				auto const events = pollDescriptors[index + 2u].revents;
+				auto& client = *polledClients[index];
+
+				if ((events & POLLOUT) != 0)
+				{
+					flushBacklog(client);
+				}
+				if ((events & (POLLIN | POLLERR | POLLHUP)) != 0)
+				{
+					readFromClient(client);
+				}
+			}
+
+			removeFailedClients();
+		}
+	}
+
+	void acceptClient() noexcept
+	{
+		auto const fd = proxy::acceptFrom(_listenFd);
+		if (fd == -1)
+		{
+			return;
+		}
+
+		try
+		{
+			auto client = std::make_shared<Client>(fd);
+
+			// Socket buffer is empty, the welcome message can always be sent right away
+			auto welcome = proxy::makeWelcomeMessage(_protocolInterface->getMacAddress());
+			auto vector = iovec{ welcome.data(), welcome.size() };
+			if (!proxy::sendAllVectors(client->fd, &vector, 1u))
+			{
+				return;
+			}
+
+			auto const lg = std::lock_guard{ _clientsLock };
+			_clients.push_back(std::move(client));
+		}
+		catch (...)
+		{
+			// Client is released
+		}
+	}
+
+	void flushBacklog(Client& client) noexcept
+	{
+		auto const lg = std::lock_guard{ _clientsLock };
+
+		if (client.backlog.empty())
+		{
+			return;
+		}
+
+		auto vector = iovec{ client.backlog.data(), client.backlog.size() };
+		auto const result = proxy::sendVectors(client.fd, &vector, 1u);
+		if (result == -1)
+		{
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				client.hasError = true;
+			}
+			return;
+		}
+		client.backlog.erase(client.backlog.begin(), client.backlog.begin() + result);
+	}
+
+	void readFromClient(Client& client) noexcept
+	{
+		auto const status = client.reader.read(client.fd);
+		if (status == proxy::MessageReader::Status::Closed || status == proxy::MessageReader::Status::Error)
+		{
+			auto const lg = std::lock_guard{ _clientsLock };
+			client.hasError = true;
+			return;
+		}
+
+		while (auto const message = client.reader.next())
+		{
+			if (!processClientMessage(client, *message))
+			{
+				auto const lg = std::lock_guard{ _clientsLock };
+				client.hasError = true;
+				return;
+			}
+		}
+
+		if (client.reader.hasError())
+		{
+			auto const lg = std::lock_guard{ _clientsLock };
+			client.hasError = true;
+		}
+	}
+
+	/** Clients are only allowed to send AVTP frames, from the MAC address of the served network interface (which they all share). Rejections are only logged at debug level, a client could flood the log otherwise */
+	bool isValidClientFrame(std::uint8_t const* const frame, std::size_t const length) const noexcept
+	{
+		static constexpr auto SrcAddressOffset = std::size_t{ 6u };
+		static constexpr auto EtherTypeOffset = std::size_t{ 12u };
+
+		if (length < EtherLayer2::HeaderLength)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProxyServer: Rejecting a {} bytes frame from a client (too short)", length);
+			return false;
+		}
+
+		auto const etherType = static_cast<std::uint16_t>((frame[EtherTypeOffset] << 8) | frame[EtherTypeOffset + 1u]);
+		if (etherType != AvtpEtherType)
+		{
+			LOG_PROTOCOL_INTERFACE_DEBUG(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProxyServer: Rejecting a frame from a client (EtherType {} is not AVTP)", utils::toHexString(etherType, true));
+			return false;
+		}
+
+		auto const& macAddress = _protocolInterface->getMacAddress();
+		if (std::memcmp(frame + SrcAddressOffset, macAddress.data(), macAddress.size()) != 0)
+		{
+			auto srcAddress = networkInterface::MacAddress{};
+			std::memcpy(srcAddress.data(), frame + SrcAddressOffset, srcAddress.size());
+			LOG_PROTOCOL_INTERFACE_DEBUG(srcAddress, networkInterface::MacAddress{}, "ProxyServer: Rejecting a frame from a client (source MAC address is not the one of the interface)");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool processClientMessage(Client& client, proxy::Message const& message) noexcept
+	{
+		switch (message.type)
+		{
+			case proxy::MessageType::Frames:
+			{
+				// Send on the network, directly from the received message. The served ProtocolInterface captures its own frames, so all the clients will receive them the same way a standalone ProtocolInterface would
+				return proxy::forEachFrame(message,
+					[this](std::uint8_t const* const /*record*/, std::uint8_t const* const frame, std::size_t const frameLength)
+					{
+						_clientFrames.fetch_add(1u, std::memory_order_relaxed);
+						if (!isValidClientFrame(frame, frameLength))
+						{
+							_rejectedFrames.fetch_add(1u, std::memory_order_relaxed);
+							return;
+						}
+						_protocolInterface->sendRawFrame(frame, frameLength);
+					});
+			}
+			case proxy::MessageType::SetFilter:
+			{
+				auto isSniffing = false;
+				auto entityIDs = std::vector<UniqueIdentifier>{};
+				try
+				{
+					if (!proxy::parseSetFilterMessage(message, isSniffing, entityIDs))
+					{
+						return false;
+					}
+					auto filter = isSniffing ? entityFilter::makeAvdeccProgram() : entityFilter::makeLocalEntitiesProgram(entityIDs);
+
+					auto const lg = std::lock_guard{ _clientsLock };
+					client.filter = std::move(filter);
+				}
+				catch (...)
+				{
+					return false;
+				}
+				return true;
+			}
+			default:
+				LOG_PROTOCOL_INTERFACE_WARN(networkInterface::MacAddress{}, networkInterface::MacAddress{}, "ProxyServer: Unexpected message type {} from a client", static_cast<std::uint16_t>(message.type));
+				return false;
+		}
+	}
+
+	void removeFailedClients() noexcept
+	{
+		auto const lg = std::lock_guard{ _clientsLock };
+
+		// Sockets are closed when the last reference to the client is released
+		_clients.erase(std::remove_if(_clients.begin(), _clients.end(),
+										 [](auto const& client)
+										 {
+											 return client->hasError;
+										 }),
+			_clients.end());
+	}
+
+	// Private variables
+	ProtocolInterface::UniquePointer _protocolInterface{ nullptr, nullptr };
+	std::string _listenAddress{};
+	int _listenFd{ -1 };
+	int _wakeUpPipe[2]{ -1, -1 };
+	std::atomic_bool _shouldTerminate{ false };
+	mutable std::mutex _clientsLock{};
+	std::vector<SharedClient> _clients{}; // Protected by _clientsLock
+	std::vector<iovec> _vectors{}; // Protected by _clientsLock
+	std::vector<std::uint8_t> _batch{}; // Only accessed from the served ProtocolInterface receive thread
+	std::vector<Record> _batchRecords{}; // Only accessed from the served ProtocolInterface receive thread
+	std::atomic<std::uint64_t> _receivedFrames{ 0u };
+	std::atomic<std::uint64_t> _clientFrames{ 0u };
+	std::atomic<std::uint64_t> _forwardedFrames{ 0u };
+	std::atomic<std::uint64_t> _droppedFrames{ 0u };
+	std::atomic<std::uint64_t> _rejectedFrames{ 0u };
+	std::thread _thread{};
+};
+
+std::string LA_AVDECC_CALL_CONVENTION ProxyServer::getDefaultAddress(std::string const& networkInterfaceName) noexcept
+{
+	return "unix:/tmp/avdecc-proxy-" + networkInterfaceName + ".sock";
+}
+
+ProxyServer* LA_AVDECC_CALL_CONVENTION ProxyServer::createRawProxyServer(ProtocolInterface::Type const protocolInterfaceType, std::string const& networkInterfaceName, std::string const& listenAddress)
+{
+	return new ProxyServerImpl(protocolInterfaceType, networkInterfaceName, listenAddress);
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -0,0 +1,218 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file transmitQueue.cpp
+* @author Christophe Calmejane
+*/
+
+#include "la/avdecc/utils.hpp"
+
+#include "transmitQueue.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+TransmitQueue::TransmitQueue(Delegate& delegate) noexcept
+	: _delegate{ delegate }
+{
+}
+
+TransmitQueue::~TransmitQueue() noexcept
+{
+	stop();
+}
+
+void TransmitQueue::start(std::string const& threadName) noexcept
+{
+	AVDECC_ASSERT(!_thread.joinable(), "TransmitQueue already started");
+	if (_thread.joinable())
+	{
+		return;
+	}
+
+	_thread = std::thread(
+		[this, threadName]
+		{
+			utils::setCurrentThreadName(threadName);
+			senderThread();
+		});
+}
+
+void TransmitQueue::stop() noexcept
+{
+	if (!_thread.joinable())
+	{
+		return;
+	}
+
+	{
+		auto const lg = std::lock_guard{ _lock };
+		_shouldTerminate = true;
+	}
+	_notEmpty.notify_one();
+
+	_thread.join();
+}
+
+ProtocolInterface::Error TransmitQueue::enqueue(std::uint8_t const* const data, std::size_t const length, stateMachine::SentCommand const& command) noexcept
+{
+	if (length > EthernetMaxFrameSize)
+	{
+		return ProtocolInterface::Error::TransportError;
+	}
+
+	auto lock = std::unique_lock{ _lock };
+
+	// Never wait for room in the queue (the caller usually holds the state machines lock), the sender gets the error right away
+	// Also drop the frame if the sender thread is not running anymore, nobody would send it
+	if (_count == Capacity || _shouldTerminate)
+	{
+		_droppedFrames.fetch_add(1u, std::memory_order_relaxed);
+		return ProtocolInterface::Error::TransportError;
+	}
+
+	auto& frame = _frames[(_readIndex + _count) % Capacity];
+	std::memcpy(frame.data.data(), data, length);
+	frame.length = length;
+	frame.command = command;
+	++_count;
+
+	if (_count > _maximumDepth.load(std::memory_order_relaxed))
+	{
+		_maximumDepth.store(_count, std::memory_order_relaxed);
+	}
+
+	// Only wake up the sender thread if it might be waiting
+	auto const wasEmpty = _count == 1u;
+	lock.unlock();
+	if (wasEmpty)
+	{
+		_notEmpty.notify_one();
+	}
+
+	return ProtocolInterface::Error::NoError;
+}
+
+bool TransmitQueue::isReadyForCommands() noexcept
+{
+	auto const lg = std::lock_guard{ _lock };
+
+	if (_count < Capacity - ReservedCapacity)
+	{
+		return true;
+	}
+
+	// Back-pressure: the caller keeps its command until we tell it there is room again
+	if (!_isCommandWaiting)
+	{
+		_isCommandWaiting = true;
+		_commandWaits.fetch_add(1u, std::memory_order_relaxed);
+	}
+	return false;
+}
+
+ProtocolInterface::TransmitQueueStatistics TransmitQueue::getStatistics() const noexcept
+{
+	auto statistics = ProtocolInterface::TransmitQueueStatistics{};
+	statistics.sentFrames = _sentFrames.load(std::memory_order_relaxed);
+	statistics.sendBatches = _sendBatches.load(std::memory_order_relaxed);
+	statistics.failedFrames = _failedFrames.load(std::memory_order_relaxed);
+	statistics.droppedFrames = _droppedFrames.load(std::memory_order_relaxed);
+	statistics.failedCommands = _failedCommands.load(std::memory_order_relaxed);
+	statistics.commandWaits = _commandWaits.load(std::memory_order_relaxed);
+	statistics.maximumDepth = _maximumDepth.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+void TransmitQueue::senderThread() noexcept
+{
+	auto batch = std::array<Frame const*, MaximumBatchSize>{};
+
+	while (true)
+	{
+		auto batchSize = std::size_t{ 0u };
+		{
+			auto lock = std::unique_lock{ _lock };
+			_notEmpty.wait(lock,
+				[this]
+				{
+					return _count != 0u || _shouldTerminate;
+				});
+
+			// Terminate only once all queued frames have been sent
+			if (_count == 0u)
+			{
+				break;
+			}
+
+			// Slots of the batch are not released before the frames have been sent, so they can be read without holding the lock
+			batchSize = std::min(_count, MaximumBatchSize);
+			for (auto index = std::size_t{ 0u }; index < batchSize; ++index)
+			{
+				batch[index] = &_frames[(_readIndex + index) % Capacity];
+			}
+		}
+
+		auto const sentCount = std::min(_delegate.sendFrames(batch.data(), batchSize), batchSize);
+
+		_sendBatches.fetch_add(1u, std::memory_order_relaxed);
+		_sentFrames.fetch_add(sentCount, std::memory_order_relaxed);
+		_failedFrames.fetch_add(batchSize - sentCount, std::memory_order_relaxed);
+
+		// Report the commands that were not sent, so they fail right away instead of timing out
+		for (auto index = sentCount; index < batchSize; ++index)
+		{
+			if (batch[index]->command.type != stateMachine::SentCommand::Type::None)
+			{
+				_failedCommands.fetch_add(1u, std::memory_order_relaxed);
+				_delegate.onCommandNotSent(batch[index]->command);
+			}
+		}
+
+		// Release the slots
+		auto notifyReadyForCommands = false;
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_readIndex = (_readIndex + batchSize) % Capacity;
+			_count -= batchSize;
+			if (_isCommandWaiting && _count < Capacity - ReservedCapacity)
+			{
+				_isCommandWaiting = false;
+				notifyReadyForCommands = true;
+			}
+		}
+
+		// Commands were kept by the command state machine, they can be sent now
+		if (notifyReadyForCommands)
+		{
+			_delegate.onReadyForCommands();
+		}
+	}
+}
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
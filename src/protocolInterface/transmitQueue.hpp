@@ -0,0 +1,139 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file transmitQueue.hpp
+* @author Christophe Calmejane
+* @brief Transmit queue of a ProtocolInterface, drained by batches from a dedicated thread.
+*/
+
+#pragma once
+
+#include "la/avdecc/internals/protocolInterface.hpp"
+#include "la/avdecc/internals/protocolAvtpdu.hpp"
+
+#include "stateMachine/protocolInterfaceDelegate.hpp"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+/**
+* @brief Bounded FIFO of outgoing frames with its sender thread.
+* @details Senders copy their frame to a preallocated slot and return immediately, the sender thread then hands all pending frames
+*          to the transport at once so it can send them with a single system call when supported (sendmmsg, TPACKET TX ring).
+*          Senders never wait: when the queue is full, the frame is dropped right away and TransportError is returned to the sender.
+*          Senders usually hold the state machines lock, so waiting for a congested interface would stall all the other threads.
+*          Commands are subject to back-pressure instead: they are only accepted while the queue has more than ReservedCapacity free slots
+*          (see isReadyForCommands), the remaining slots being kept for the other frames. The command state machine keeps its commands
+*          queued when the queue is not ready, and is told through Delegate::onReadyForCommands when the sender thread freed enough slots.
+*          A frame carrying a command that the transport fails to send is reported through Delegate::onCommandNotSent.
+*/
+class TransmitQueue final
+{
+public:
+	static constexpr auto Capacity = std::size_t{ 256u }; /**< Maximum number of frames waiting to be sent */
+	static constexpr auto MaximumBatchSize = std::size_t{ 64u }; /**< Maximum number of frames handed to the transport at once */
+	static constexpr auto ReservedCapacity = std::size_t{ 64u }; /**< Number of slots not used by commands, kept for responses and advertising (and for the frames enqueued between isReadyForCommands and enqueue) */
+	static_assert(ReservedCapacity < Capacity, "ReservedCapacity must leave room for the commands");
+
+	struct Frame
+	{
+		std::array<std::uint8_t, EthernetMaxFrameSize> data{};
+		std::size_t length{ 0u };
+		stateMachine::SentCommand command{}; // Command carried by the frame, if any
+	};
+
+	class Delegate
+	{
+	public:
+		virtual ~Delegate() noexcept = default;
+
+		/** Sends the specified frames, in order, stopping at the first frame that cannot be sent. Called from the sender thread only. Returns the number of frames successfully sent. */
+		virtual std::size_t sendFrames(Frame const* const* const frames, std::size_t const count) noexcept = 0;
+		/** Notification that a frame carrying a command could not be sent. Called from the sender thread only, without any lock taken. */
+		virtual void onCommandNotSent(stateMachine::SentCommand const& command) noexcept = 0;
+		/** Notification that commands can be enqueued again, after isReadyForCommands returned false. Called from the sender thread only, without any lock taken. */
+		virtual void onReadyForCommands() noexcept = 0;
+	};
+
+	/** Constructor. The sender thread is not started until start() is called. */
+	TransmitQueue(Delegate& delegate) noexcept;
+
+	/** Destructor. Stops the sender thread if still running. */
+	~TransmitQueue() noexcept;
+
+	/** Starts the sender thread. */
+	void start(std::string const& threadName) noexcept;
+
+	/** Stops the sender thread, after all queued frames have been handed to the transport. */
+	void stop() noexcept;
+
+	/** Copies the specified frame to the queue, never waiting. Returns ProtocolInterface::Error::TransportError if the frame had to be dropped (queue full or stopped). */
+	ProtocolInterface::Error enqueue(std::uint8_t const* const data, std::size_t const length, stateMachine::SentCommand const& command = {}) noexcept;
+
+	/** Returns true if a command can be enqueued. Otherwise, Delegate::onReadyForCommands will be called once the sender thread freed enough slots. */
+	bool isReadyForCommands() noexcept;
+
+	/** Returns the statistics of the queue. */
+	ProtocolInterface::TransmitQueueStatistics getStatistics() const noexcept;
+
+	// Deleted compiler auto-generated methods
+	TransmitQueue(TransmitQueue&&) = delete;
+	TransmitQueue(TransmitQueue const&) = delete;
+	TransmitQueue& operator=(TransmitQueue const&) = delete;
+	TransmitQueue& operator=(TransmitQueue&&) = delete;
+
+private:
+	void senderThread() noexcept;
+
+	// Private variables
+	Delegate& _delegate;
+	std::array<Frame, Capacity> _frames{};
+	std::size_t _readIndex{ 0u };
+	std::size_t _count{ 0u };
+	bool _shouldTerminate{ false };
+	bool _isCommandWaiting{ false }; // isReadyForCommands returned false, Delegate::onReadyForCommands must be called once there is room
+	mutable std::mutex _lock{};
+	std::condition_variable _notEmpty{};
+	std::thread _thread{};
+	// Statistics
+	std::atomic<std::uint64_t> _sentFrames{ 0u };
+	std::atomic<std::uint64_t> _sendBatches{ 0u };
+	std::atomic<std::uint64_t> _failedFrames{ 0u };
+	std::atomic<std::uint64_t> _droppedFrames{ 0u };
+	std::atomic<std::uint64_t> _failedCommands{ 0u };
+	std::atomic<std::uint64_t> _commandWaits{ 0u };
+	std::atomic<std::uint64_t> _maximumDepth{ 0u };
+};
+
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -58,7 +58,7 @@ void AdvertiseStateMachine::checkLocalEntitiesAnnouncement() noexcept
 	auto* const protocolInterface = _manager->getProtocolInterfaceDelegate();
 
 	// Get current time
-	auto const now = std::chrono::system_clock::now();
+	auto const now = std::chrono::steady_clock::now();
 
 	// Process all Advertised Entities on the attached Protocol Interface
 	for (auto& entityKV : _advertisedEntities)
@@ -107,6 +107,7 @@ void AdvertiseStateMachine::setEntityNeedsAdvertise(entity::LocalEntity const& e
 	{
 		// Schedule EntityAvailable message
 		infoIt->second.nextAdvertiseTime = computeDelayedAdvertiseTime(entity, *interfaceIndex);
+		_manager->scheduleStateMachines(infoIt->second.nextAdvertiseTime);
 	}
 }
 
@@ -128,6 +129,9 @@ void AdvertiseStateMachine::enableEntityAdvertising(entity::LocalEntity& entity)
 	{
 		// Register LocalEntity for Advertising
 		_advertisedEntities.emplace(std::make_pair(entityID, AdvertiseEntityInfo{ entity, *interfaceIndex }));
+
+		// First EntityAvailable message is sent right away
+		_manager->scheduleStateMachines(std::chrono::steady_clock::now());
 	}
 }
 
@@ -183,10 +187,24 @@ void AdvertiseStateMachine::handleAdpEntityDiscover(Adpdu const& adpdu) noexcept
 		{
 			// Schedule EntityAvailable message
 			entityInfo.nextAdvertiseTime = computeDelayedAdvertiseTime(entity, entityInfo.interfaceIndex);
+			_manager->scheduleStateMachines(entityInfo.nextAdvertiseTime);
 		}
 	}
 }
 
+std::chrono::steady_clock::time_point AdvertiseStateMachine::getNextCheckTime() noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	auto nextCheckTime = std::chrono::steady_clock::time_point::max();
+	for (auto const& [entityID, entityInfo] : _advertisedEntities)
+	{
+		nextCheckTime = std::min(nextCheckTime, entityInfo.nextAdvertiseTime);
+	}
+	return nextCheckTime;
+}
+
 /* ************************************************************ */
 /* Private methods                                              */
 /* ************************************************************ */
@@ -198,15 +216,15 @@ std::chrono::milliseconds AdvertiseStateMachine::computeRandomDelay(entity::Enti
 	return std::chrono::milliseconds(randomValue);
 }
 
-std::chrono::time_point<std::chrono::system_clock> AdvertiseStateMachine::computeNextAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const
+std::chrono::time_point<std::chrono::steady_clock> AdvertiseStateMachine::computeNextAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const
 {
 	auto const& interfaceInfo = entity.getInterfaceInformation(interfaceIndex);
-	return std::chrono::system_clock::now() + std::chrono::milliseconds(std::max(1000u, interfaceInfo.validTime * 1000u / 2u)) + computeRandomDelay(entity, interfaceIndex);
+	return std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(1000u, interfaceInfo.validTime * 1000u / 2u)) + computeRandomDelay(entity, interfaceIndex);
 }
 
-std::chrono::time_point<std::chrono::system_clock> AdvertiseStateMachine::computeDelayedAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const
+std::chrono::time_point<std::chrono::steady_clock> AdvertiseStateMachine::computeDelayedAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const
 {
-	return std::chrono::system_clock::now() + computeRandomDelay(entity, interfaceIndex);
+	return std::chrono::steady_clock::now() + computeRandomDelay(entity, interfaceIndex);
 }
 
 
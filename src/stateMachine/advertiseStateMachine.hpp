@@ -58,6 +58,7 @@ public:
 	void enableEntityAdvertising(entity::LocalEntity& entity) noexcept;
 	void disableEntityAdvertising(entity::LocalEntity const& entity) noexcept;
 	void handleAdpEntityDiscover(Adpdu const& adpdu) noexcept;
+	std::chrono::steady_clock::time_point getNextCheckTime() noexcept; // Returns the time of the next advertise
 
 private:
 	// Private types
@@ -65,7 +66,7 @@ private:
 	{
 		entity::LocalEntity& entity;
 		entity::model::AvbInterfaceIndex interfaceIndex{ 0u };
-		std::chrono::time_point<std::chrono::system_clock> nextAdvertiseTime{};
+		std::chrono::time_point<std::chrono::steady_clock> nextAdvertiseTime{};
 
 		/** Constructor */
 		AdvertiseEntityInfo(entity::LocalEntity& entity, entity::model::AvbInterfaceIndex const interfaceIndex) noexcept
@@ -78,8 +79,8 @@ private:
 
 	// Private methods
 	std::chrono::milliseconds computeRandomDelay(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const noexcept;
-	std::chrono::time_point<std::chrono::system_clock> computeNextAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const;
-	std::chrono::time_point<std::chrono::system_clock> computeDelayedAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const;
+	std::chrono::time_point<std::chrono::steady_clock> computeNextAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const;
+	std::chrono::time_point<std::chrono::steady_clock> computeDelayedAdvertiseTime(entity::Entity const& entity, entity::model::AvbInterfaceIndex const interfaceIndex) const;
 
 	// Private members
 	Manager* _manager{ nullptr };
@@ -0,0 +1,438 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file commandContainers.hpp
+* @author Christophe Calmejane
+* @brief Allocation-free containers for the queued and inflight commands of the CommandStateMachine.
+*/
+
+#pragma once
+
+#include "la/avdecc/utils.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace stateMachine
+{
+/**
+* @brief Command stored in a CommandNodePool, with the hooks of the intrusive containers.
+* @details A node is either in a queue or in an inflight list (never both), and in the SequenceIDRing and the CommandTimerHeap when inflight.
+*          InfoType must have a sequenceID and a timeoutTime field.
+*/
+template<class InfoType>
+struct CommandNode
+{
+	static constexpr auto NotInHeap = ~std::size_t{ 0u };
+
+	InfoType info{};
+	CommandNode* previous{ nullptr }; // CommandNodeList hook
+	CommandNode* next{ nullptr }; // CommandNodeList hook (or CommandNodePool free-list)
+	CommandNode* nextInSlot{ nullptr }; // SequenceIDRing hook
+	std::size_t heapIndex{ NotInHeap }; // CommandTimerHeap hook
+};
+
+/**
+* @brief Recycling pool of CommandNode.
+* @details Released nodes are kept in a free-list and reused by the next acquire, so sending commands does not allocate once the pool has grown to the maximum number of pending commands.
+*          Nodes are owned by the pool, those still in use when the pool is destroyed are destroyed with it.
+* @warning Not thread-safe, to be used with the Manager locked.
+*/
+template<class InfoType>
+class CommandNodePool final
+{
+public:
+	using Node = CommandNode<InfoType>;
+
+	CommandNodePool() noexcept = default;
+
+	/** Returns a recycled (or newly allocated) node, with a default constructed info. Returns nullptr if allocation failed. */
+	Node* acquire() noexcept
+	{
+		auto* node = _freeList;
+		if (node != nullptr)
+		{
+			_freeList = node->next;
+			node->next = nullptr;
+			return node;
+		}
+
+		try
+		{
+			return _nodes.emplace_back(std::make_unique<Node>()).get();
+		}
+		catch (...)
+		{
+			return nullptr;
+		}
+	}
+
+	/** Releases a node acquired from this pool, destroying the content of its info right away. The node must have been removed from all containers. */
+	void release(Node* const node) noexcept
+	{
+		AVDECC_ASSERT(node->previous == nullptr && node->next == nullptr && node->nextInSlot == nullptr && node->heapIndex == Node::NotInHeap, "Releasing a node still in a container");
+		node->info = InfoType{};
+		node->next = _freeList;
+		_freeList = node;
+	}
+
+	/** Returns the number of nodes allocated by the pool (in use and free). */
+	std::size_t getAllocatedCount() const noexcept
+	{
+		return _nodes.size();
+	}
+
+	// Deleted compiler auto-generated methods
+	CommandNodePool(CommandNodePool&&) = delete;
+	CommandNodePool(CommandNodePool const&) = delete;
+	CommandNodePool& operator=(CommandNodePool const&) = delete;
+	CommandNodePool& operator=(CommandNodePool&&) = delete;
+
+private:
+	std::vector<std::unique_ptr<Node>> _nodes{};
+	Node* _freeList{ nullptr };
+};
+
+/**
+* @brief Intrusive doubly linked list of CommandNode (FIFO order).
+* @details All operations are constant-time. The list does not own its nodes.
+*/
+template<class Node>
+class CommandNodeList final
+{
+public:
+	class iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Node;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Node*;
+		using reference = Node&;
+
+		explicit iterator(Node* const node) noexcept
+			: _node(node)
+		{
+		}
+		reference operator*() const noexcept
+		{
+			return *_node;
+		}
+		pointer operator->() const noexcept
+		{
+			return _node;
+		}
+		iterator& operator++() noexcept
+		{
+			_node = _node->next;
+			return *this;
+		}
+		bool operator==(iterator const& other) const noexcept
+		{
+			return _node == other._node;
+		}
+		bool operator!=(iterator const& other) const noexcept
+		{
+			return _node != other._node;
+		}
+
+	private:
+		Node* _node{ nullptr };
+	};
+
+	iterator begin() const noexcept
+	{
+		return iterator{ _head };
+	}
+	iterator end() const noexcept
+	{
+		return iterator{ nullptr };
+	}
+	bool empty() const noexcept
+	{
+		return _head == nullptr;
+	}
+	std::size_t size() const noexcept
+	{
+		return _size;
+	}
+	Node* front() const noexcept
+	{
+		return _head;
+	}
+
+	void push_back(Node* const node) noexcept
+	{
+		node->previous = _tail;
+		node->next = nullptr;
+		if (_tail != nullptr)
+		{
+			_tail->next = node;
+		}
+		else
+		{
+			_head = node;
+		}
+		_tail = node;
+		++_size;
+	}
+
+	Node* pop_front() noexcept
+	{
+		auto* const node = _head;
+		if (node != nullptr)
+		{
+			erase(node);
+		}
+		return node;
+	}
+
+	/** Removes the node from the list, and returns the node that followed it */
+	Node* erase(Node* const node) noexcept
+	{
+		auto* const next = node->next;
+		if (node->previous != nullptr)
+		{
+			node->previous->next = next;
+		}
+		else
+		{
+			_head = next;
+		}
+		if (next != nullptr)
+		{
+			next->previous = node->previous;
+		}
+		else
+		{
+			_tail = node->previous;
+		}
+		node->previous = nullptr;
+		node->next = nullptr;
+		--_size;
+		return next;
+	}
+
+private:
+	Node* _head{ nullptr };
+	Node* _tail{ nullptr };
+	std::size_t _size{ 0u };
+};
+
+/**
+* @brief Inflight commands indexed by their 16-bit sequence ID.
+* @details Sequence IDs being allocated sequentially, masking them spreads the inflight commands evenly over the slots.
+*          Commands sharing a slot (more than SlotsCount inflight commands, or sequence ID wrap-around) are chained, so lookup is constant-time as long as there are less than SlotsCount inflight commands.
+*          The ring does not own its nodes.
+*/
+template<class Node, std::size_t SlotsCount>
+class SequenceIDRing final
+{
+	static_assert(SlotsCount != 0u && (SlotsCount & (SlotsCount - 1u)) == 0u, "SlotsCount must be a power of 2");
+
+public:
+	void insert(Node* const node) noexcept
+	{
+		auto& slot = _slots[getSlotIndex(node->info.sequenceID)];
+		node->nextInSlot = slot;
+		slot = node;
+	}
+
+	void remove(Node* const node) noexcept
+	{
+		auto* slot = &_slots[getSlotIndex(node->info.sequenceID)];
+		while (*slot != nullptr)
+		{
+			if (*slot == node)
+			{
+				*slot = node->nextInSlot;
+				node->nextInSlot = nullptr;
+				return;
+			}
+			slot = &(*slot)->nextInSlot;
+		}
+		AVDECC_ASSERT(false, "Node not found in SequenceIDRing");
+	}
+
+	/** Returns the first inflight node with the specified sequenceID matching the predicate, or nullptr */
+	template<typename SequenceIDType, typename Predicate>
+	Node* find(SequenceIDType const sequenceID, Predicate const& predicate) const noexcept
+	{
+		for (auto* node = _slots[getSlotIndex(sequenceID)]; node != nullptr; node = node->nextInSlot)
+		{
+			if (node->info.sequenceID == sequenceID && predicate(*node))
+			{
+				return node;
+			}
+		}
+		return nullptr;
+	}
+
+private:
+	template<typename SequenceIDType>
+	static constexpr std::size_t getSlotIndex(SequenceIDType const sequenceID) noexcept
+	{
+		return static_cast<std::size_t>(sequenceID) & (SlotsCount - 1u);
+	}
+
+	std::array<Node*, SlotsCount> _slots{};
+};
+
+/**
+* @brief Inflight commands ordered by timeout time (binary min-heap).
+* @details Each node stores its position in the heap, so the timeout of any node can be changed (or the node removed) in logarithmic time,
+*          and the next command to expire is always at the top: checking for expired commands only touches the expired ones.
+*          The heap does not own its nodes, and only allocates in reserve: scheduling a node never throws.
+*/
+template<class Node>
+class CommandTimerHeap final
+{
+public:
+	bool empty() const noexcept
+	{
+		return _nodes.empty();
+	}
+	std::size_t size() const noexcept
+	{
+		return _nodes.size();
+	}
+	/** Returns the node with the earliest timeout, or nullptr if the heap is empty */
+	Node* top() const noexcept
+	{
+		return _nodes.empty() ? nullptr : _nodes.front();
+	}
+
+	/** Makes room for the specified number of nodes, to be called before inserting a new node (for example with the allocated count of the pool the nodes come from). Returns false if allocation failed. */
+	bool reserve(std::size_t const count) noexcept
+	{
+		try
+		{
+			_nodes.reserve(count);
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	/** Inserts the node if it's not in the heap yet (room must have been made with reserve), otherwise moves it according to its new timeout time */
+	void schedule(Node* const node) noexcept
+	{
+		if (node->heapIndex == Node::NotInHeap)
+		{
+			AVDECC_ASSERT(_nodes.size() < _nodes.capacity(), "CommandTimerHeap::reserve not called before inserting a new node");
+			node->heapIndex = _nodes.size();
+			_nodes.push_back(node);
+			siftUp(node->heapIndex);
+		}
+		else
+		{
+			siftDown(siftUp(node->heapIndex));
+		}
+	}
+
+	void remove(Node* const node) noexcept
+	{
+		auto const index = node->heapIndex;
+		AVDECC_ASSERT(index < _nodes.size() && _nodes[index] == node, "Node not found in CommandTimerHeap");
+		auto* const last = _nodes.back();
+		_nodes.pop_back();
+		node->heapIndex = Node::NotInHeap;
+		if (last != node)
+		{
+			// Move the last node to the freed position, then restore the heap property
+			place(index, last);
+			siftDown(siftUp(index));
+		}
+	}
+
+private:
+	static bool isEarlier(Node const* const lhs, Node const* const rhs) noexcept
+	{
+		return lhs->info.timeoutTime < rhs->info.timeoutTime;
+	}
+
+	void place(std::size_t const index, Node* const node) noexcept
+	{
+		_nodes[index] = node;
+		node->heapIndex = index;
+	}
+
+	/** Returns the new index of the node */
+	std::size_t siftUp(std::size_t index) noexcept
+	{
+		auto* const node = _nodes[index];
+		while (index > 0u)
+		{
+			auto const parentIndex = (index - 1u) / 2u;
+			if (!isEarlier(node, _nodes[parentIndex]))
+			{
+				break;
+			}
+			place(index, _nodes[parentIndex]);
+			index = parentIndex;
+		}
+		place(index, node);
+		return index;
+	}
+
+	void siftDown(std::size_t index) noexcept
+	{
+		auto* const node = _nodes[index];
+		auto const count = _nodes.size();
+		while (true)
+		{
+			auto childIndex = 2u * index + 1u;
+			if (childIndex >= count)
+			{
+				break;
+			}
+			if (childIndex + 1u < count && isEarlier(_nodes[childIndex + 1u], _nodes[childIndex]))
+			{
+				++childIndex;
+			}
+			if (!isEarlier(_nodes[childIndex], node))
+			{
+				break;
+			}
+			place(index, _nodes[childIndex]);
+			index = childIndex;
+		}
+		place(index, node);
+	}
+
+	std::vector<Node*> _nodes{};
+};
+
+} // namespace stateMachine
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
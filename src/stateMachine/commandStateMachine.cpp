@@ -29,6 +29,7 @@
 #include "stateMachineManager.hpp"
 #include "logHelper.hpp"
 
+#include <algorithm>
 #include <utility>
 #include <optional>
 
@@ -54,7 +55,13 @@ static constexpr auto AcmpGetTxConnectionCommandTimeoutMsec = 200u;
 
 /* Default state machine parameters */
 static constexpr size_t DefaultMaxAecpInflightCommands = 10;
+/* Aecp congestion control parameters */
+static constexpr size_t MinAecpInflightCommands = 1;
+static constexpr size_t MaxAecpInflightCommands = 32;
+static constexpr std::chrono::milliseconds MaxAecpRetransmissionTimeout{ 2000u };
+static constexpr std::chrono::microseconds AecpRttClockGranularity{ 1000u }; // 'G' in RFC 6298
 static constexpr std::chrono::milliseconds DefaultAecpSendInterval{ 1u };
+static constexpr std::chrono::milliseconds CongestedRetryDelay{ 10u }; // Delay before trying again to retry a command the transport was not ready to send
 static constexpr size_t DefaultMaxAcmpMulticastInflightCommands = 10;
 static constexpr size_t DefaultMaxAcmpUnicastInflightCommands = 10;
 static constexpr std::chrono::milliseconds DefaultAcmpMulticastSendInterval{ 1u };
@@ -82,7 +89,7 @@ void CommandStateMachine::registerLocalEntity(entity::LocalEntity& entity) noexc
 	if (infoIt == _commandEntities.end())
 	{
 		// Register LocalEntity for Advertising
-		_commandEntities.emplace(std::make_pair(entityID, CommandEntityInfo{ entity }));
+		_commandEntities.try_emplace(entityID, entity);
 	}
 }
 
@@ -96,8 +103,15 @@ void CommandStateMachine::unregisterLocalEntity(entity::LocalEntity& entity) noe
 	auto const infoIt = _commandEntities.find(entityID);
 	if (infoIt != _commandEntities.end())
 	{
-		// Unregister LocalEntity
+		// Unregister LocalEntity (pending commands are discarded)
+		releaseCommands(infoIt->second);
 		_commandEntities.erase(infoIt);
+
+		// No more entity sending commands, the congestion control state of the targets is no longer needed
+		if (_commandEntities.empty())
+		{
+			_aecpTargets.clear();
+		}
 	}
 }
 
@@ -111,110 +125,155 @@ void CommandStateMachine::checkInflightCommandsTimeoutExpiracy() noexcept
 
 	auto* const protocolInterface = _manager->getProtocolInterfaceDelegate();
 
+	++_timeoutStatistics.checks;
+
+	// Fail the commands the transport reported as not sent, before they time out
+	if (_hasNotSentCommands.load(std::memory_order_acquire))
+	{
+		failNotSentCommands();
+	}
+
+	// The transport has room again, check the queues that were waiting for it
+	if (_isTransportReady.exchange(false, std::memory_order_acq_rel))
+	{
+		_isWaitingForTransport = false;
+	}
+
 	// Iterate over all locally registered command entities
 	for (auto& localEntityInfoKV : _commandEntities)
 	{
 		auto& localEntityInfo = localEntityInfoKV.second;
 
-		// Check AECP commands
-		for (auto& [targetEntityID, inflight] : localEntityInfo.inflightAecpCommands)
+		// Check AECP commands, only examining the expired ones (in timeout order)
+		while (auto* const node = localEntityInfo.inflightAecpTimeouts.top())
 		{
-			// Check all inflight timeouts
-			for (auto it = inflight.inflightCommands.begin(); it != inflight.inflightCommands.end(); /* Iterate inside the loop */)
+			++_timeoutStatistics.examinedCommands;
+			auto& command = node->info;
+			if (now <= command.timeoutTime)
 			{
-				auto& command = *it;
-				if (now > command.timeoutTime)
+				break;
+			}
+			++_timeoutStatistics.expiredCommands;
+
+			auto const targetEntityID = static_cast<Aecpdu const&>(*command.command).getTargetEntityID();
+			auto& inflight = localEntityInfo.inflightAecpCommands[targetEntityID];
+			auto error = ProtocolInterface::Error::NoError;
+			// Timeout expired, check if we retried yet
+			if (!command.retried)
+			{
+				// Back-pressure from the transport, try again a bit later (without failing the command)
+				if (!protocolInterface->isReadyToSendCommands())
 				{
-					auto error = ProtocolInterface::Error::NoError;
-					// Timeout expired, check if we retried yet
-					if (!command.retried)
-					{
-						// Let's retry
-						command.retried = true;
+					command.timeoutTime = now + CongestedRetryDelay;
+					localEntityInfo.inflightAecpTimeouts.schedule(node);
+					scheduleCheck(command.timeoutTime);
+					continue;
+				}
 
-						// Update last send time
-						inflight.lastSendTime = now;
+				// Back off the retransmission timeout and shrink the inflight window of this target
+				updateAecpTargetOnTimeout(targetEntityID, now);
 
-						// Ask the transport layer to send the packet
-						error = protocolInterface->sendMessage(static_cast<Aecpdu const&>(*command.command));
+				// Let's retry
+				command.retried = true;
 
-						// Reset command timeout
-						resetAecpCommandTimeoutValue(command);
+				// Update last send time
+				inflight.lastSendTime = now;
 
-						// Statistics
-						utils::invokeProtectedMethod(&Delegate::onAecpRetry, _delegate, targetEntityID);
-						LOG_CONTROLLER_STATE_MACHINE_DEBUG(targetEntityID, std::string("AECP command with sequenceID ") + std::to_string(command.sequenceID) + " timed out, trying again");
-					}
-					else
-					{
-						error = ProtocolInterface::Error::Timeout;
-						// Statistics
-						utils::invokeProtectedMethod(&Delegate::onAecpTimeout, _delegate, targetEntityID);
-						LOG_CONTROLLER_STATE_MACHINE_DEBUG(targetEntityID, std::string("AECP command with sequenceID ") + std::to_string(command.sequenceID) + " timed out 2 times");
-					}
+				// Ask the transport layer to send the packet
+				error = protocolInterface->sendMessage(static_cast<Aecpdu const&>(*command.command));
 
-					if (!!error)
-					{
-						// Already retried, the command has been lost
-						utils::invokeProtectedHandler(command.resultHandler, nullptr, error);
-						it = removeInflight(protocolInterface, localEntityInfo, targetEntityID, inflight, it);
-					}
-				}
-				else
-				{
-					++it;
-				}
+				// Reset command timeout
+				resetAecpCommandTimeoutValue(localEntityInfo, node);
+
+				// Statistics
+				utils::invokeProtectedMethod(&Delegate::onAecpRetry, _delegate, targetEntityID);
+				LOG_CONTROLLER_STATE_MACHINE_DEBUG(targetEntityID, std::string("AECP command with sequenceID ") + std::to_string(command.sequenceID) + " timed out, trying again");
+			}
+			else
+			{
+				error = ProtocolInterface::Error::Timeout;
+				// Statistics
+				utils::invokeProtectedMethod(&Delegate::onAecpTimeout, _delegate, targetEntityID);
+				LOG_CONTROLLER_STATE_MACHINE_DEBUG(targetEntityID, std::string("AECP command with sequenceID ") + std::to_string(command.sequenceID) + " timed out 2 times");
 			}
 
-			// Check if we need to empty the queue
-			checkQueue(protocolInterface, localEntityInfo, targetEntityID, inflight, inflight.inflightCommands.end());
+			if (!!error)
+			{
+				// Already retried, the command has been lost
+				utils::invokeProtectedHandler(command.resultHandler, nullptr, error);
+				removeInflight(protocolInterface, localEntityInfo, targetEntityID, inflight, node);
+			}
 		}
 
-		// Check ACMP commands
-		for (auto& [targetMacAddress, inflight] : localEntityInfo.inflightAcmpCommands)
+		// Check ACMP commands, only examining the expired ones (in timeout order)
+		while (auto* const node = localEntityInfo.inflightAcmpTimeouts.top())
 		{
-			// Check all inflight timeouts
-			for (auto it = inflight.inflightCommands.begin(); it != inflight.inflightCommands.end(); /* Iterate inside the loop */)
+			++_timeoutStatistics.examinedCommands;
+			auto& command = node->info;
+			if (now <= command.timeoutTime)
+			{
+				break;
+			}
+			++_timeoutStatistics.expiredCommands;
+
+			auto const targetMacAddress = command.command->getDestAddress();
+			auto& inflight = localEntityInfo.inflightAcmpCommands[targetMacAddress];
+			auto error = ProtocolInterface::Error::NoError;
+			// Timeout expired, check if we retried yet
+			if (!command.retried)
 			{
-				auto& command = *it;
-				if (now > command.timeoutTime)
+				// Back-pressure from the transport, try again a bit later (without failing the command)
+				if (!protocolInterface->isReadyToSendCommands())
 				{
-					auto error = ProtocolInterface::Error::NoError;
-					// Timeout expired, check if we retried yet
-					if (!command.retried)
-					{
-						// Let's retry
-						command.retried = true;
+					command.timeoutTime = now + CongestedRetryDelay;
+					localEntityInfo.inflightAcmpTimeouts.schedule(node);
+					scheduleCheck(command.timeoutTime);
+					continue;
+				}
 
-						// Update last send time
-						inflight.lastSendTime = now;
+				// Let's retry
+				command.retried = true;
 
-						// Ask the transport layer to send the packet
-						error = protocolInterface->sendMessage(static_cast<Acmpdu const&>(*command.command));
+				// Update last send time
+				inflight.lastSendTime = now;
 
-						// Reset command timeout
-						resetAcmpCommandTimeoutValue(command);
-					}
-					else
-					{
-						error = ProtocolInterface::Error::Timeout;
-					}
+				// Ask the transport layer to send the packet
+				error = protocolInterface->sendMessage(static_cast<Acmpdu const&>(*command.command));
 
-					if (!!error)
-					{
-						// Already retried, the command has been lost
-						utils::invokeProtectedHandler(command.resultHandler, nullptr, error);
-						it = removeInflight(protocolInterface, localEntityInfo, targetMacAddress, inflight, it);
-					}
-				}
-				else
-				{
-					++it;
-				}
+				// Reset command timeout
+				resetAcmpCommandTimeoutValue(localEntityInfo, node);
+			}
+			else
+			{
+				error = ProtocolInterface::Error::Timeout;
 			}
 
-			// Check if we need to empty the queue
-			checkQueue(protocolInterface, localEntityInfo, targetMacAddress, inflight, inflight.inflightCommands.end());
+			if (!!error)
+			{
+				// Already retried, the command has been lost
+				utils::invokeProtectedHandler(command.resultHandler, nullptr, error);
+				removeInflight(protocolInterface, localEntityInfo, targetMacAddress, inflight, node);
+			}
+		}
+
+		// Send the queued commands that were waiting for the send interval to elapse (checkQueue marks them pending again if they still have to wait)
+		if (!localEntityInfo.pendingAecpQueues.empty())
+		{
+			auto pendingQueues = PendingAecpQueues{};
+			pendingQueues.swap(localEntityInfo.pendingAecpQueues);
+			for (auto const& targetEntityID : pendingQueues)
+			{
+				checkQueue(protocolInterface, localEntityInfo, targetEntityID, localEntityInfo.inflightAecpCommands[targetEntityID]);
+			}
+		}
+		if (!localEntityInfo.pendingAcmpQueues.empty())
+		{
+			auto pendingQueues = PendingAcmpQueues{};
+			pendingQueues.swap(localEntityInfo.pendingAcmpQueues);
+			for (auto const& targetMacAddress : pendingQueues)
+			{
+				checkQueue(protocolInterface, localEntityInfo, targetMacAddress, localEntityInfo.inflightAcmpCommands[targetMacAddress]);
+			}
 		}
 
 		// Notify scheduled errors
@@ -232,14 +291,11 @@ void CommandStateMachine::checkInflightCommandsTimeoutExpiracy() noexcept
 	}
 }
 
-void CommandStateMachine::handleAecpResponse(Aecpdu const& aecpdu) noexcept
+void CommandStateMachine::handleAecpResponse(Aecpdu const& aecpdu, std::chrono::steady_clock::time_point const receiveTime) noexcept
 {
 	// Lock
 	auto const lg = std::lock_guard{ *_manager };
 
-	// Get current time
-	auto const now = std::chrono::steady_clock::now();
-
 	auto* const protocolInterface = _manager->getProtocolInterfaceDelegate();
 	auto const controllerID = aecpdu.getControllerEntityID();
 
@@ -273,17 +329,16 @@ void CommandStateMachine::handleAecpResponse(Aecpdu const& aecpdu) noexcept
 			if (auto inflightIt = commandEntityInfo.inflightAecpCommands.find(targetID); inflightIt != commandEntityInfo.inflightAecpCommands.end())
 			{
 				auto& inflight = inflightIt->second;
-				auto& inflightCommands = inflight.inflightCommands;
 				auto const sequenceID = aecpdu.getSequenceID();
-				auto commandIt = std::find_if(inflightCommands.begin(), inflightCommands.end(),
-					[sequenceID](AecpCommandInfo const& command)
+				auto* const node = commandEntityInfo.inflightAecpSequenceIDs.find(sequenceID,
+					[targetID](AecpCommandNode const& node)
 					{
-						return command.sequenceID == sequenceID;
+						return static_cast<Aecpdu const&>(*node.info.command).getTargetEntityID() == targetID;
 					});
 				// If the sequenceID is not found, it means the response already timed out (arriving too late)
-				if (commandIt != inflightCommands.end())
+				if (node != nullptr)
 				{
-					auto& info = *commandIt;
+					auto& info = node->info;
 
 					// Validate the sender
 					if (info.command->getDestAddress() != aecpdu.getSrcAddress())
@@ -295,21 +350,26 @@ void CommandStateMachine::handleAecpResponse(Aecpdu const& aecpdu) noexcept
 					// Check for special cases where we should re-arm the timer
 					if (shouldRearmTimer(aecpdu))
 					{
-						resetAecpCommandTimeoutValue(info);
+						info.rearmed = true;
+						resetAecpCommandTimeoutValue(commandEntityInfo, node);
 						return;
 					}
 
-					// Move the query (it will be deleted)
-					AecpCommandInfo aecpQuery = std::move(info);
+					// Update congestion control of this target before sending queued commands (only sampling the RTT of commands sent once and not re-armed, see Karn's algorithm)
+					auto const responseTime = std::max(receiveTime - info.sendTime, std::chrono::steady_clock::duration::zero());
+					updateAecpTargetOnResponse(targetID, (info.retried || info.rearmed) ? std::nullopt : std::make_optional(responseTime), isAEMBusyResponse(aecpdu));
+
+					// Move the result handler (the command will be released)
+					auto const resultHandler = std::move(info.resultHandler);
 
 					// Remove the command from inflight list
-					removeInflight(protocolInterface, commandEntityInfo, targetID, inflight, commandIt);
+					removeInflight(protocolInterface, commandEntityInfo, targetID, inflight, node);
 
 					// Call completion handler
-					utils::invokeProtectedHandler(aecpQuery.resultHandler, &aecpdu, ProtocolInterface::Error::NoError);
+					utils::invokeProtectedHandler(resultHandler, &aecpdu, ProtocolInterface::Error::NoError);
 
-					// Statistics
-					utils::invokeProtectedMethod(&Delegate::onAecpResponseTime, _delegate, targetID, std::chrono::duration_cast<std::chrono::milliseconds>(now - aecpQuery.sendTime));
+					// Statistics (using the time the response was received by the transport, not the time we got the lock to process it)
+					utils::invokeProtectedMethod(&Delegate::onAecpResponseTime, _delegate, targetID, std::chrono::duration_cast<std::chrono::milliseconds>(responseTime));
 				}
 				else
 				{
@@ -340,38 +400,37 @@ void CommandStateMachine::handleAcmpResponse(Acmpdu const& acmpdu) noexcept
 		if (auto inflightIt = commandEntityInfo.inflightAcmpCommands.find(targetMacAddress); inflightIt != commandEntityInfo.inflightAcmpCommands.end())
 		{
 			auto& inflight = inflightIt->second;
-			auto& inflightCommands = inflight.inflightCommands;
 			auto const sequenceID = acmpdu.getSequenceID();
-			auto commandIt = std::find_if(inflightCommands.begin(), inflightCommands.end(),
-				[sequenceID](AcmpCommandInfo const& command)
+			auto* const node = commandEntityInfo.inflightAcmpSequenceIDs.find(sequenceID,
+				[&targetMacAddress](AcmpCommandNode const& node)
 				{
-					return command.sequenceID == sequenceID;
+					return node.info.command->getDestAddress() == targetMacAddress;
 				});
 			// If the sequenceID is not found, it either means the response already timed out (arriving too late), or it's a communication btw talker and listener (requested by us) and they did not use our sequenceID
-			if (commandIt != inflightCommands.end())
+			if (node != nullptr)
 			{
-				auto& info = *commandIt;
+				auto& info = node->info;
 
 				// Check if it's an expected response (since the communication btw listener and talkers uses our controllerID and might use our sequenceID, we don't want to detect talker's response as ours)
 				auto const messageType = acmpdu.getMessageType().getValue();
 				auto const expectedResponseType = info.command->getMessageType().getValue() + 1; // Based on Clause 8.2.1.5, responses are always Command + 1
 				if (messageType == expectedResponseType)
 				{
-					// Move the query (it will be deleted)
-					AcmpCommandInfo acmpQuery = std::move(info);
+					// Move the result handler (the command will be released)
+					auto const resultHandler = std::move(info.resultHandler);
 
 					// Remove the command from inflight list
-					removeInflight(protocolInterface, commandEntityInfo, targetMacAddress, inflight, commandIt);
+					removeInflight(protocolInterface, commandEntityInfo, targetMacAddress, inflight, node);
 
 					// Call completion handler
-					utils::invokeProtectedHandler(acmpQuery.resultHandler, &acmpdu, ProtocolInterface::Error::NoError);
+					utils::invokeProtectedHandler(resultHandler, &acmpdu, ProtocolInterface::Error::NoError);
 				}
 			}
 		}
 	}
 }
 
-ProtocolInterface::Error CommandStateMachine::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult) noexcept
+ProtocolInterface::Error CommandStateMachine::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult, ProtocolInterface::AecpCommandPriority const priority) noexcept
 {
 	auto* aecp = static_cast<Aecpdu*>(aecpdu.get());
 	auto const targetEntityID = aecp->getTargetEntityID();
@@ -393,17 +452,28 @@ ProtocolInterface::Error CommandStateMachine::sendAecpCommand(Aecpdu::UniquePoin
 
 	try
 	{
+		auto& inflight = commandEntityInfo.inflightAecpCommands[targetEntityID];
+		auto& queue = commandEntityInfo.aecpCommandsQueue[targetEntityID];
+
 		// Record the query for when we get a response (so we can send it again if it timed out)
-		AecpCommandInfo command{ sequenceID, std::move(aecpdu), onResult };
+		auto* const node = _aecpCommandsPool.acquire();
+		if (node == nullptr)
+		{
+			return ProtocolInterface::Error::InternalError;
+		}
+		// Make room in the timer heap for all the nodes of the pool, so scheduling the command timeout never allocates
+		if (!commandEntityInfo.inflightAecpTimeouts.reserve(_aecpCommandsPool.getAllocatedCount()))
 		{
-			auto& inflight = commandEntityInfo.inflightAecpCommands[targetEntityID];
+			_aecpCommandsPool.release(node);
+			return ProtocolInterface::Error::InternalError;
+		}
+		node->info = AecpCommandInfo{ sequenceID, std::move(aecpdu), onResult };
 
-			// Add the command to the queue (to send directly, in case there is something waiting in the queue)
-			commandEntityInfo.aecpCommandsQueue[targetEntityID].queuedCommands.push_back(std::move(command));
+		// Add the command to the queue of its priority (to send directly, in case there is something waiting in the queue)
+		queue.queuedCommands[static_cast<std::size_t>(priority)].push_back(node);
 
-			// Check the queue
-			checkQueue(protocolInterface, commandEntityInfo, targetEntityID, inflight, inflight.inflightCommands.end());
-		}
+		// Check the queue
+		checkQueue(protocolInterface, commandEntityInfo, targetEntityID, inflight);
 	}
 	catch (...)
 	{
@@ -434,17 +504,28 @@ ProtocolInterface::Error CommandStateMachine::sendAcmpCommand(Acmpdu::UniquePoin
 
 	try
 	{
+		auto& inflight = commandEntityInfo.inflightAcmpCommands[targetMacAddress];
+		auto& queue = commandEntityInfo.acmpCommandsQueue[targetMacAddress].queuedCommands;
+
 		// Record the query for when we get a response (so we can send it again if it timed out)
-		AcmpCommandInfo command{ sequenceID, std::move(acmpdu), onResult };
+		auto* const node = _acmpCommandsPool.acquire();
+		if (node == nullptr)
 		{
-			auto& inflight = commandEntityInfo.inflightAcmpCommands[targetMacAddress];
+			return ProtocolInterface::Error::InternalError;
+		}
+		// Make room in the timer heap for all the nodes of the pool, so scheduling the command timeout never allocates
+		if (!commandEntityInfo.inflightAcmpTimeouts.reserve(_acmpCommandsPool.getAllocatedCount()))
+		{
+			_acmpCommandsPool.release(node);
+			return ProtocolInterface::Error::InternalError;
+		}
+		node->info = AcmpCommandInfo{ sequenceID, std::move(acmpdu), onResult };
 
-			// Add the command to the queue (to send directly, in case there is something waiting in the queue)
-			commandEntityInfo.acmpCommandsQueue[targetMacAddress].queuedCommands.push_back(std::move(command));
+		// Add the command to the queue (to send directly, in case there is something waiting in the queue)
+		queue.push_back(node);
 
-			// Check the queue
-			checkQueue(protocolInterface, commandEntityInfo, targetMacAddress, inflight, inflight.inflightCommands.end());
-		}
+		// Check the queue
+		checkQueue(protocolInterface, commandEntityInfo, targetMacAddress, inflight);
 	}
 	catch (...)
 	{
@@ -453,9 +534,356 @@ ProtocolInterface::Error CommandStateMachine::sendAcmpCommand(Acmpdu::UniquePoin
 	return ProtocolInterface::Error::NoError;
 }
 
+void CommandStateMachine::forgetAecpTarget(UniqueIdentifier const& entityID) noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	_aecpTargets.erase(entityID);
+}
+
+void CommandStateMachine::notifyReadyToSendCommands() noexcept
+{
+	_isTransportReady.store(true, std::memory_order_release);
+	scheduleCheck(std::chrono::steady_clock::now());
+}
+
+void CommandStateMachine::notifyCommandNotSent(SentCommand const& command) noexcept
+{
+	try
+	{
+		auto const lg = std::lock_guard{ _notSentCommandsLock };
+		_notSentCommands.push_back(command);
+		_hasNotSentCommands.store(true, std::memory_order_release);
+	}
+	catch (...)
+	{
+		// The command will time out
+		return;
+	}
+	scheduleCheck(std::chrono::steady_clock::now());
+}
+
+std::chrono::steady_clock::time_point CommandStateMachine::getNextCheckTime() noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	// Commands reported as not sent are failed during the next check, and the queues waiting for the transport are checked again
+	if (_hasNotSentCommands.load(std::memory_order_acquire) || _isTransportReady.load(std::memory_order_acquire))
+	{
+		return std::chrono::steady_clock::now();
+	}
+
+	auto nextCheckTime = std::chrono::steady_clock::time_point::max();
+
+	// Iterate over all locally registered command entities
+	for (auto const& [entityID, localEntityInfo] : _commandEntities)
+	{
+		// Scheduled errors are notified during the next check
+		if (!localEntityInfo.scheduledAecpErrors.empty() || !localEntityInfo.scheduledAcmpErrors.empty())
+		{
+			return std::chrono::steady_clock::now();
+		}
+
+		// Check inflight commands
+		if (auto const* const node = localEntityInfo.inflightAecpTimeouts.top())
+		{
+			nextCheckTime = std::min(nextCheckTime, node->info.timeoutTime);
+		}
+		if (auto const* const node = localEntityInfo.inflightAcmpTimeouts.top())
+		{
+			nextCheckTime = std::min(nextCheckTime, node->info.timeoutTime);
+		}
+
+		// Check queued commands waiting for the send interval to elapse (unless they are waiting for the transport, which will notify us)
+		if (_isWaitingForTransport)
+		{
+			continue;
+		}
+		for (auto const& targetEntityID : localEntityInfo.pendingAecpQueues)
+		{
+			if (auto const inflightIt = localEntityInfo.inflightAecpCommands.find(targetEntityID); inflightIt != localEntityInfo.inflightAecpCommands.end())
+			{
+				nextCheckTime = std::min(nextCheckTime, inflightIt->second.lastSendTime + getAecpSendInterval(targetEntityID));
+			}
+		}
+		for (auto const& targetMacAddress : localEntityInfo.pendingAcmpQueues)
+		{
+			if (auto const inflightIt = localEntityInfo.inflightAcmpCommands.find(targetMacAddress); inflightIt != localEntityInfo.inflightAcmpCommands.end())
+			{
+				nextCheckTime = std::min(nextCheckTime, inflightIt->second.lastSendTime + getAcmpSendInterval(targetMacAddress));
+			}
+		}
+	}
+
+	return nextCheckTime;
+}
+
+ProtocolInterface::CommandTimeoutStatistics CommandStateMachine::getTimeoutStatistics() noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	return _timeoutStatistics;
+}
+
 /* ************************************************************ */
 /* Private methods                                              */
 /* ************************************************************ */
+void CommandStateMachine::setCommandInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, InflightAecpInfo& inflight, AecpCommandNode* const node) noexcept
+{
+	// Update last send time
+	inflight.lastSendTime = std::chrono::steady_clock::now();
+
+	// Ask the transport layer to send the packet
+	auto const error = protocolInterface->sendMessage(static_cast<Aecpdu const&>(*node->info.command));
+	if (!!error)
+	{
+		// Schedule the result handler to be called with the returned error from the delegate
+		info.scheduledAecpErrors.push_back(std::make_pair(error, node->info.resultHandler));
+		scheduleCheck(std::chrono::steady_clock::now());
+		_aecpCommandsPool.release(node);
+	}
+	else
+	{
+		// Move the command to inflight queue
+		resetAecpCommandTimeoutValue(info, node);
+		inflight.inflightCommands.push_back(node);
+		info.inflightAecpSequenceIDs.insert(node);
+	}
+}
+
+void CommandStateMachine::checkQueue(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, UniqueIdentifier const& entityID, InflightAecpInfo& inflight) noexcept
+{
+	// Get current time
+	auto const now = std::chrono::steady_clock::now();
+
+	// Check if queue is not empty for this entity
+	auto& queue = info.aecpCommandsQueue[entityID];
+	if (queue.empty())
+	{
+		return;
+	}
+
+	// Check if we don't have too many inflight commands for this destination (the queue will be checked again when an inflight command completes)
+	if (inflight.inflightCommands.size() >= getMaxInflightAecpMessages(entityID))
+	{
+		return;
+	}
+
+	// Check if we are not sending too fast for this destination, otherwise wake up the state machines when it's time to send
+	auto const sendInterval = getAecpSendInterval(entityID);
+	if (!hasExpired(now, inflight.lastSendTime, sendInterval))
+	{
+		info.pendingAecpQueues.insert(entityID);
+		scheduleCheck(inflight.lastSendTime + sendInterval);
+		return;
+	}
+
+	// Back-pressure from the transport, keep the command at the head of the queue until it notifies it's ready
+	if (!protocolInterface->isReadyToSendCommands())
+	{
+		info.pendingAecpQueues.insert(entityID);
+		_isWaitingForTransport = true;
+		return;
+	}
+
+	// Remove command from queue (highest priority first)
+	setCommandInflight(protocolInterface, info, inflight, queue.pop_front());
+
+	// More commands can be sent once the send interval has elapsed
+	if (!queue.empty() && inflight.inflightCommands.size() < getMaxInflightAecpMessages(entityID))
+	{
+		info.pendingAecpQueues.insert(entityID);
+		scheduleCheck(inflight.lastSendTime + sendInterval);
+	}
+}
+
+CommandStateMachine::AecpCommandNode* CommandStateMachine::removeInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, UniqueIdentifier const& entityID, InflightAecpInfo& inflight, AecpCommandNode* const node) noexcept
+{
+	auto* const next = inflight.inflightCommands.erase(node);
+	info.inflightAecpSequenceIDs.remove(node);
+	info.inflightAecpTimeouts.remove(node);
+	_aecpCommandsPool.release(node);
+	checkQueue(protocolInterface, info, entityID, inflight);
+	return next;
+}
+
+void CommandStateMachine::setCommandInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, InflightAcmpInfo& inflight, AcmpCommandNode* const node) noexcept
+{
+	// Update last send time
+	inflight.lastSendTime = std::chrono::steady_clock::now();
+
+	// Ask the transport layer to send the packet
+	auto const error = protocolInterface->sendMessage(static_cast<Acmpdu const&>(*node->info.command));
+	if (!!error)
+	{
+		// Schedule the result handler to be called with the returned error from the delegate
+		info.scheduledAcmpErrors.push_back(std::make_pair(error, node->info.resultHandler));
+		scheduleCheck(std::chrono::steady_clock::now());
+		_acmpCommandsPool.release(node);
+	}
+	else
+	{
+		// Move the command to inflight queue
+		resetAcmpCommandTimeoutValue(info, node);
+		inflight.inflightCommands.push_back(node);
+		info.inflightAcmpSequenceIDs.insert(node);
+	}
+}
+
+void CommandStateMachine::checkQueue(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, networkInterface::MacAddress const& targetMacAddress, InflightAcmpInfo& inflight) noexcept
+{
+	// Get current time
+	auto const now = std::chrono::steady_clock::now();
+
+	// Check if queue is not empty for this entity
+	auto& queue = info.acmpCommandsQueue[targetMacAddress].queuedCommands;
+	if (queue.empty())
+	{
+		return;
+	}
+
+	// Check if we don't have too many inflight commands for this destination (the queue will be checked again when an inflight command completes)
+	if (inflight.inflightCommands.size() >= getMaxInflightAcmpMessages(targetMacAddress))
+	{
+		return;
+	}
+
+	// Check if we are not sending too fast for this destination, otherwise wake up the state machines when it's time to send
+	auto const sendInterval = getAcmpSendInterval(targetMacAddress);
+	if (!hasExpired(now, inflight.lastSendTime, sendInterval))
+	{
+		info.pendingAcmpQueues.insert(targetMacAddress);
+		scheduleCheck(inflight.lastSendTime + sendInterval);
+		return;
+	}
+
+	// Back-pressure from the transport, keep the command at the head of the queue until it notifies it's ready
+	if (!protocolInterface->isReadyToSendCommands())
+	{
+		info.pendingAcmpQueues.insert(targetMacAddress);
+		_isWaitingForTransport = true;
+		return;
+	}
+
+	// Remove command from queue
+	setCommandInflight(protocolInterface, info, inflight, queue.pop_front());
+
+	// More commands can be sent once the send interval has elapsed
+	if (!queue.empty() && inflight.inflightCommands.size() < getMaxInflightAcmpMessages(targetMacAddress))
+	{
+		info.pendingAcmpQueues.insert(targetMacAddress);
+		scheduleCheck(inflight.lastSendTime + sendInterval);
+	}
+}
+
+CommandStateMachine::AcmpCommandNode* CommandStateMachine::removeInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, networkInterface::MacAddress const& macAddress, InflightAcmpInfo& inflight, AcmpCommandNode* const node) noexcept
+{
+	auto* const next = inflight.inflightCommands.erase(node);
+	info.inflightAcmpSequenceIDs.remove(node);
+	info.inflightAcmpTimeouts.remove(node);
+	_acmpCommandsPool.release(node);
+	checkQueue(protocolInterface, info, macAddress, inflight);
+	return next;
+}
+
+void CommandStateMachine::releaseCommands(CommandEntityInfo& info) noexcept
+{
+	for (auto& [targetEntityID, inflight] : info.inflightAecpCommands)
+	{
+		while (auto* const node = inflight.inflightCommands.pop_front())
+		{
+			info.inflightAecpSequenceIDs.remove(node);
+			info.inflightAecpTimeouts.remove(node);
+			_aecpCommandsPool.release(node);
+		}
+	}
+	for (auto& [targetEntityID, queue] : info.aecpCommandsQueue)
+	{
+		while (auto* const node = queue.pop_front())
+		{
+			_aecpCommandsPool.release(node);
+		}
+	}
+	for (auto& [targetMacAddress, inflight] : info.inflightAcmpCommands)
+	{
+		while (auto* const node = inflight.inflightCommands.pop_front())
+		{
+			info.inflightAcmpSequenceIDs.remove(node);
+			info.inflightAcmpTimeouts.remove(node);
+			_acmpCommandsPool.release(node);
+		}
+	}
+	for (auto& [targetMacAddress, queue] : info.acmpCommandsQueue)
+	{
+		while (auto* const node = queue.queuedCommands.pop_front())
+		{
+			_acmpCommandsPool.release(node);
+		}
+	}
+}
+
+void CommandStateMachine::failNotSentCommands() noexcept
+{
+	auto notSentCommands = std::vector<SentCommand>{};
+	{
+		auto const lg = std::lock_guard{ _notSentCommandsLock };
+		notSentCommands.swap(_notSentCommands);
+		_hasNotSentCommands.store(false, std::memory_order_release);
+	}
+
+	auto* const protocolInterface = _manager->getProtocolInterfaceDelegate();
+
+	for (auto const& command : notSentCommands)
+	{
+		auto const commandEntityIt = _commandEntities.find(command.controllerEntityID);
+		if (commandEntityIt == _commandEntities.end())
+		{
+			continue;
+		}
+		auto& commandEntityInfo = commandEntityIt->second;
+
+		// The command might have completed (or failed) in the meantime, in which case it's no longer inflight
+		if (command.type == SentCommand::Type::Aecp)
+		{
+			auto const targetID = command.targetEntityID;
+			auto* const node = commandEntityInfo.inflightAecpSequenceIDs.find(static_cast<AecpSequenceID>(command.sequenceID),
+				[targetID](AecpCommandNode const& node)
+				{
+					return static_cast<Aecpdu const&>(*node.info.command).getTargetEntityID() == targetID;
+				});
+			if (node != nullptr)
+			{
+				auto const resultHandler = std::move(node->info.resultHandler);
+				removeInflight(protocolInterface, commandEntityInfo, targetID, commandEntityInfo.inflightAecpCommands[targetID], node);
+				utils::invokeProtectedHandler(resultHandler, nullptr, ProtocolInterface::Error::TransportError);
+			}
+		}
+		else if (command.type == SentCommand::Type::Acmp)
+		{
+			auto* const node = commandEntityInfo.inflightAcmpSequenceIDs.find(static_cast<AcmpSequenceID>(command.sequenceID),
+				[](AcmpCommandNode const& /*node*/)
+				{
+					return true;
+				});
+			if (node != nullptr)
+			{
+				auto const targetMacAddress = node->info.command->getDestAddress();
+				auto const resultHandler = std::move(node->info.resultHandler);
+				removeInflight(protocolInterface, commandEntityInfo, targetMacAddress, commandEntityInfo.inflightAcmpCommands[targetMacAddress], node);
+				utils::invokeProtectedHandler(resultHandler, nullptr, ProtocolInterface::Error::TransportError);
+			}
+		}
+	}
+}
+
+void CommandStateMachine::scheduleCheck(std::chrono::steady_clock::time_point const checkTime) const noexcept
+{
+	_manager->scheduleStateMachines(checkTime);
+}
+
 bool CommandStateMachine::isAEMUnsolicitedResponse(Aecpdu const& aecpdu) const noexcept
 {
 	auto const messageType = aecpdu.getMessageType();
@@ -470,6 +898,91 @@ bool CommandStateMachine::isAEMUnsolicitedResponse(Aecpdu const& aecpdu) const n
 	return false;
 }
 
+bool CommandStateMachine::isAEMBusyResponse(Aecpdu const& aecpdu) const noexcept
+{
+	// The entity is temporarily out of resources to process our commands
+	return aecpdu.getMessageType() == AecpMessageType::AemResponse && aecpdu.getStatus() == AemAecpStatus::NoResources;
+}
+
+CommandStateMachine::AecpTargetInfo& CommandStateMachine::getAecpTargetInfo(UniqueIdentifier const& entityID) noexcept
+{
+	auto const [targetIt, inserted] = _aecpTargets.try_emplace(entityID);
+	auto& targetInfo = targetIt->second;
+	if (inserted)
+	{
+		targetInfo.inflightWindow = DefaultMaxAecpInflightCommands;
+	}
+	return targetInfo;
+}
+
+void CommandStateMachine::updateAecpTargetOnResponse(UniqueIdentifier const& entityID, std::optional<std::chrono::steady_clock::duration> const& rtt, bool const isBusy) noexcept
+{
+	auto& targetInfo = getAecpTargetInfo(entityID);
+
+	// Update the retransmission timeout (RFC 6298 - Clause 2)
+	if (rtt)
+	{
+		auto const sample = std::chrono::duration_cast<std::chrono::microseconds>(*rtt);
+		if (targetInfo.smoothedRtt.count() == 0)
+		{
+			targetInfo.smoothedRtt = sample;
+			targetInfo.rttVariation = sample / 2;
+		}
+		else
+		{
+			auto const delta = targetInfo.smoothedRtt > sample ? targetInfo.smoothedRtt - sample : sample - targetInfo.smoothedRtt;
+			targetInfo.rttVariation = (3 * targetInfo.rttVariation + delta) / 4;
+			targetInfo.smoothedRtt = (7 * targetInfo.smoothedRtt + sample) / 8;
+		}
+		targetInfo.retransmissionTimeout = std::min(targetInfo.smoothedRtt + std::max(AecpRttClockGranularity, 4 * targetInfo.rttVariation), std::chrono::duration_cast<std::chrono::microseconds>(MaxAecpRetransmissionTimeout));
+	}
+
+	// Multiplicative decrease if the entity is busy
+	if (isBusy)
+	{
+		decreaseAecpInflightWindow(targetInfo, std::chrono::steady_clock::now());
+		return;
+	}
+
+	// Additive increase: one more inflight command each time a full window has been answered
+	if (targetInfo.inflightWindow < MaxAecpInflightCommands)
+	{
+		++targetInfo.windowCredits;
+		if (targetInfo.windowCredits >= targetInfo.inflightWindow)
+		{
+			++targetInfo.inflightWindow;
+			targetInfo.windowCredits = 0u;
+		}
+	}
+}
+
+void CommandStateMachine::updateAecpTargetOnTimeout(UniqueIdentifier const& entityID, std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept
+{
+	auto& targetInfo = getAecpTargetInfo(entityID);
+
+	if (decreaseAecpInflightWindow(targetInfo, now))
+	{
+		// Back off the retransmission timeout (RFC 6298 - Clause 5.5), until the next RTT sample
+		auto const retransmissionTimeout = std::max(targetInfo.retransmissionTimeout, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::milliseconds{ AecpAemCommandTimeoutMsec }));
+		targetInfo.retransmissionTimeout = std::min(2 * retransmissionTimeout, std::chrono::duration_cast<std::chrono::microseconds>(MaxAecpRetransmissionTimeout));
+	}
+}
+
+bool CommandStateMachine::decreaseAecpInflightWindow(AecpTargetInfo& targetInfo, std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept
+{
+	// Only decrease once per retransmission timeout period, all the commands inflight at the time of the congestion are likely to time out (or be rejected) together
+	auto const period = std::max(targetInfo.retransmissionTimeout, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::milliseconds{ AecpAemCommandTimeoutMsec }));
+	if (now < targetInfo.lastWindowDecreaseTime + period)
+	{
+		return false;
+	}
+
+	targetInfo.inflightWindow = std::max(MinAecpInflightCommands, targetInfo.inflightWindow / 2);
+	targetInfo.windowCredits = 0u;
+	targetInfo.lastWindowDecreaseTime = now;
+	return true;
+}
+
 bool CommandStateMachine::shouldRearmTimer(Aecpdu const& aecpdu) const noexcept
 {
 	auto const messageType = aecpdu.getMessageType();
@@ -487,8 +1000,9 @@ bool CommandStateMachine::shouldRearmTimer(Aecpdu const& aecpdu) const noexcept
 	return false;
 }
 
-void CommandStateMachine::resetAecpCommandTimeoutValue(AecpCommandInfo& command) const noexcept
+void CommandStateMachine::resetAecpCommandTimeoutValue(CommandEntityInfo& info, AecpCommandNode* const node) noexcept
 {
+	auto& command = node->info;
 	auto const messageType = command.command->getMessageType();
 	auto timeout = std::uint32_t{ 250u };
 
@@ -513,14 +1027,24 @@ void CommandStateMachine::resetAecpCommandTimeoutValue(AecpCommandInfo& command)
 		{
 			timeout = it->second;
 		}
+
+		// Use the retransmission timeout of the target if it's greater than the standard timeout (never retrying before the entity is allowed to respond)
+		if (auto const targetIt = _aecpTargets.find(command.command->getTargetEntityID()); targetIt != _aecpTargets.end())
+		{
+			auto const retransmissionTimeout = std::chrono::ceil<std::chrono::milliseconds>(targetIt->second.retransmissionTimeout);
+			timeout = std::max(timeout, static_cast<std::uint32_t>(retransmissionTimeout.count()));
+		}
 	}
 
 	command.sendTime = std::chrono::steady_clock::now();
 	command.timeoutTime = command.sendTime + std::chrono::milliseconds(timeout);
+	info.inflightAecpTimeouts.schedule(node);
+	scheduleCheck(command.timeoutTime);
 }
 
-void CommandStateMachine::resetAcmpCommandTimeoutValue(AcmpCommandInfo& command) const noexcept
+void CommandStateMachine::resetAcmpCommandTimeoutValue(CommandEntityInfo& info, AcmpCommandNode* const node) noexcept
 {
+	auto& command = node->info;
 	static std::unordered_map<AcmpMessageType, std::uint32_t, AcmpMessageType::Hash> s_AcmpCommandTimeoutMap{
 		{ AcmpMessageType::ConnectTxCommand, AcmpConnectTxCommandTimeoutMsec },
 		{ AcmpMessageType::DisconnectTxCommand, AcmpDisconnectTxCommandTimeoutMsec },
@@ -540,6 +1064,8 @@ void CommandStateMachine::resetAcmpCommandTimeoutValue(AcmpCommandInfo& command)
 
 	command.sendTime = std::chrono::steady_clock::now();
 	command.timeoutTime = command.sendTime + std::chrono::milliseconds(timeout);
+	info.inflightAcmpTimeouts.schedule(node);
+	scheduleCheck(command.timeoutTime);
 }
 
 AecpSequenceID CommandStateMachine::getNextAecpSequenceID(CommandEntityInfo& info) noexcept
@@ -556,8 +1082,12 @@ AcmpSequenceID CommandStateMachine::getNextAcmpSequenceID(CommandEntityInfo& inf
 	return nextID;
 }
 
-size_t CommandStateMachine::getMaxInflightAecpMessages(UniqueIdentifier const& /*entityID*/) const noexcept
+size_t CommandStateMachine::getMaxInflightAecpMessages(UniqueIdentifier const& entityID) const noexcept
 {
+	if (auto const targetIt = _aecpTargets.find(entityID); targetIt != _aecpTargets.end())
+	{
+		return targetIt->second.inflightWindow;
+	}
 	return DefaultMaxAecpInflightCommands;
 }
 
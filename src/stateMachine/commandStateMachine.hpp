@@ -27,9 +27,16 @@
 #include "la/avdecc/internals/entity.hpp"
 
 #include "protocolInterfaceDelegate.hpp"
+#include "commandContainers.hpp"
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace la
 {
@@ -65,10 +72,15 @@ public:
 	void registerLocalEntity(entity::LocalEntity& entity) noexcept;
 	void unregisterLocalEntity(entity::LocalEntity& entity) noexcept;
 	void checkInflightCommandsTimeoutExpiracy() noexcept;
-	void handleAecpResponse(Aecpdu const& aecpdu) noexcept;
+	void handleAecpResponse(Aecpdu const& aecpdu, std::chrono::steady_clock::time_point const receiveTime) noexcept;
 	void handleAcmpResponse(Acmpdu const& acmpdu) noexcept;
-	ProtocolInterface::Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult) noexcept;
+	ProtocolInterface::Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult, ProtocolInterface::AecpCommandPriority const priority) noexcept;
 	ProtocolInterface::Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, ProtocolInterface::AcmpCommandResultHandler const& onResult) noexcept;
+	void forgetAecpTarget(UniqueIdentifier const& entityID) noexcept; // Drops the congestion control state of a target entity that went offline (it is measured again if the entity comes back)
+	void notifyCommandNotSent(SentCommand const& command) noexcept; // Can be called from any thread, without the lock (the command fails with TransportError during the next check)
+	void notifyReadyToSendCommands() noexcept; // Can be called from any thread, without the lock (the commands kept queued because of the transport back-pressure are sent during the next check)
+	std::chrono::steady_clock::time_point getNextCheckTime() noexcept; // Returns the time of the next inflight command timeout, or of the next queued command that can be sent, whichever comes first
+	ProtocolInterface::CommandTimeoutStatistics getTimeoutStatistics() noexcept;
 
 private:
 	// Private types
@@ -78,6 +90,7 @@ private:
 		std::chrono::time_point<std::chrono::steady_clock> sendTime{};
 		std::chrono::time_point<std::chrono::steady_clock> timeoutTime{};
 		bool retried{ false };
+		bool rearmed{ false };
 		Aecpdu::UniquePointer command{ nullptr, nullptr };
 		ProtocolInterface::AecpCommandResultHandler resultHandler{};
 
@@ -89,17 +102,56 @@ private:
 		{
 		}
 	};
+	using AecpCommandNode = CommandNode<AecpCommandInfo>;
+	using AecpCommandList = CommandNodeList<AecpCommandNode>;
 	struct InflightAecpInfo
 	{
 		std::chrono::time_point<std::chrono::steady_clock> lastSendTime{};
-		std::list<AecpCommandInfo> inflightCommands{};
+		AecpCommandList inflightCommands{};
 	};
 	struct QueuedAecpInfo
 	{
-		std::list<AecpCommandInfo> queuedCommands{};
+		std::array<AecpCommandList, 2> queuedCommands{}; // Indexed by AecpCommandPriority, Interactive commands being sent first
+
+		bool empty() const noexcept
+		{
+			for (auto const& list : queuedCommands)
+			{
+				if (!list.empty())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		/** Removes and returns the oldest command of the highest priority, or nullptr if the queue is empty */
+		AecpCommandNode* pop_front() noexcept
+		{
+			for (auto& list : queuedCommands)
+			{
+				if (auto* const node = list.pop_front())
+				{
+					return node;
+				}
+			}
+			return nullptr;
+		}
 	};
 	using InflightAecpCommands = std::unordered_map<UniqueIdentifier, InflightAecpInfo, UniqueIdentifier::hash>;
 	using AecpCommandsQueue = std::unordered_map<UniqueIdentifier, QueuedAecpInfo, UniqueIdentifier::hash>;
+	using PendingAecpQueues = std::unordered_set<UniqueIdentifier, UniqueIdentifier::hash>;
+
+	/** Congestion control of the AECP commands sent to a target entity: retransmission timeout computed from the measured RTT (RFC 6298) and AIMD inflight window */
+	struct AecpTargetInfo
+	{
+		std::chrono::microseconds smoothedRtt{ 0 }; // SRTT, null until the first RTT sample
+		std::chrono::microseconds rttVariation{ 0 }; // RTTVAR
+		std::chrono::microseconds retransmissionTimeout{ 0 }; // RTO, null until the first RTT sample or timeout (the standard timeout is then used)
+		std::size_t inflightWindow{ 0u }; // Maximum number of inflight commands
+		std::size_t windowCredits{ 0u }; // Responses received since the window was last increased
+		std::chrono::time_point<std::chrono::steady_clock> lastWindowDecreaseTime{};
+	};
+	using AecpTargets = std::unordered_map<UniqueIdentifier, AecpTargetInfo, UniqueIdentifier::hash>;
 
 	struct AcmpCommandInfo
 	{
@@ -118,17 +170,20 @@ private:
 		{
 		}
 	};
+	using AcmpCommandNode = CommandNode<AcmpCommandInfo>;
+	using AcmpCommandList = CommandNodeList<AcmpCommandNode>;
 	struct InflightAcmpInfo
 	{
 		std::chrono::time_point<std::chrono::steady_clock> lastSendTime{};
-		std::list<AcmpCommandInfo> inflightCommands{};
+		AcmpCommandList inflightCommands{};
 	};
 	struct QueuedAcmpInfo
 	{
-		std::list<AcmpCommandInfo> queuedCommands{};
+		AcmpCommandList queuedCommands{};
 	};
 	using InflightAcmpCommands = std::unordered_map<networkInterface::MacAddress, InflightAcmpInfo, networkInterface::MacAddressHash>;
 	using AcmpCommandsQueue = std::unordered_map<networkInterface::MacAddress, QueuedAcmpInfo, networkInterface::MacAddressHash>;
+	using PendingAcmpQueues = std::unordered_set<networkInterface::MacAddress, networkInterface::MacAddressHash>;
 
 	using ScheduledAecpErrors = std::list<std::pair<ProtocolInterface::Error, ProtocolInterface::AecpCommandResultHandler>>;
 	using ScheduledAcmpErrors = std::list<std::pair<ProtocolInterface::Error, ProtocolInterface::AcmpCommandResultHandler>>;
@@ -141,11 +196,17 @@ private:
 		AecpSequenceID currentAecpSequenceID{ 0 };
 		InflightAecpCommands inflightAecpCommands{};
 		AecpCommandsQueue aecpCommandsQueue{};
+		SequenceIDRing<AecpCommandNode, 4096> inflightAecpSequenceIDs{}; // All inflight AECP commands, for constant-time response matching
+		CommandTimerHeap<AecpCommandNode> inflightAecpTimeouts{}; // All inflight AECP commands, ordered by timeout time
+		PendingAecpQueues pendingAecpQueues{}; // Targets with queued AECP commands waiting for the send interval to elapse
 
 		// ACMP variables
 		AcmpSequenceID currentAcmpSequenceID{ 0 };
 		InflightAcmpCommands inflightAcmpCommands{};
 		AcmpCommandsQueue acmpCommandsQueue{};
+		SequenceIDRing<AcmpCommandNode, 256> inflightAcmpSequenceIDs{}; // All inflight ACMP commands, for constant-time response matching
+		CommandTimerHeap<AcmpCommandNode> inflightAcmpTimeouts{}; // All inflight ACMP commands, ordered by timeout time
+		PendingAcmpQueues pendingAcmpQueues{}; // Targets with queued ACMP commands waiting for the send interval to elapse
 
 		// Other variables
 		ScheduledAecpErrors scheduledAecpErrors{};
@@ -165,116 +226,25 @@ private:
 	{
 		return (lastInterval + delay) < currentTime;
 	}
-	template<typename T>
-	T setCommandInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, InflightAecpInfo& inflight, T const it, AecpCommandInfo&& command)
-	{
-		// Update last send time
-		inflight.lastSendTime = std::chrono::steady_clock::now();
-
-		// Ask the transport layer to send the packet
-		auto const error = protocolInterface->sendMessage(static_cast<Aecpdu const&>(*command.command));
-		if (!!error)
-		{
-			// Schedule the result handler to be called with the returned error from the delegate
-			info.scheduledAecpErrors.push_back(std::make_pair(error, command.resultHandler));
-			return it;
-		}
-		else
-		{
-			// Move the command to inflight queue
-			resetAecpCommandTimeoutValue(command);
-			return inflight.inflightCommands.insert(it, std::move(command));
-		}
-	}
-	template<typename T>
-	T checkQueue(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, UniqueIdentifier const& entityID, InflightAecpInfo& inflight, T const it)
-	{
-		// Get current time
-		auto const now = std::chrono::steady_clock::now();
-
-		// Check if we don't have too many inflight commands or sending too fast for this destination macAddress
-		if (inflight.inflightCommands.size() >= getMaxInflightAecpMessages(entityID) || !hasExpired(now, inflight.lastSendTime, getAecpSendInterval(entityID)))
-		{
-			return it;
-		}
-
-		// Check if queue is not empty for this entity
-		auto& queue = info.aecpCommandsQueue[entityID].queuedCommands;
-		if (queue.empty())
-		{
-			return it;
-		}
-
-		// Remove command from queue
-		auto command = std::move(queue.front());
-		queue.pop_front();
-
-		return setCommandInflight(protocolInterface, info, inflight, it, std::move(command));
-	}
-	template<typename T>
-	T removeInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, UniqueIdentifier const& entityID, InflightAecpInfo& inflight, T const it)
-	{
-		auto retIt = inflight.inflightCommands.erase(it);
-		return checkQueue(protocolInterface, info, entityID, inflight, retIt);
-	}
-
-	template<typename T>
-	T setCommandInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, InflightAcmpInfo& inflight, T const it, AcmpCommandInfo&& command)
-	{
-		// Update last send time
-		inflight.lastSendTime = std::chrono::steady_clock::now();
-
-		// Ask the transport layer to send the packet
-		auto const error = protocolInterface->sendMessage(static_cast<Acmpdu const&>(*command.command));
-		if (!!error)
-		{
-			// Schedule the result handler to be called with the returned error from the delegate
-			info.scheduledAcmpErrors.push_back(std::make_pair(error, command.resultHandler));
-			return it;
-		}
-		else
-		{
-			// Move the command to inflight queue
-			resetAcmpCommandTimeoutValue(command);
-			return inflight.inflightCommands.insert(it, std::move(command));
-		}
-	}
-	template<typename T>
-	T checkQueue(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, networkInterface::MacAddress const& targetMacAddress, InflightAcmpInfo& inflight, T const it)
-	{
-		// Get current time
-		auto const now = std::chrono::steady_clock::now();
-
-		// Check if we don't have too many inflight commands or sending too fast for this destination macAddress
-		if (inflight.inflightCommands.size() >= getMaxInflightAcmpMessages(targetMacAddress) || !hasExpired(now, inflight.lastSendTime, getAcmpSendInterval(targetMacAddress)))
-		{
-			return it;
-		}
-
-		// Check if queue is not empty for this entity
-		auto& queue = info.acmpCommandsQueue[targetMacAddress].queuedCommands;
-		if (queue.empty())
-		{
-			return it;
-		}
-
-		// Remove command from queue
-		auto command = std::move(queue.front());
-		queue.pop_front();
-
-		return setCommandInflight(protocolInterface, info, inflight, it, std::move(command));
-	}
-	template<typename T>
-	T removeInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, networkInterface::MacAddress const& macAddress, InflightAcmpInfo& inflight, T const it)
-	{
-		auto retIt = inflight.inflightCommands.erase(it);
-		return checkQueue(protocolInterface, info, macAddress, inflight, retIt);
-	}
-
+	void setCommandInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, InflightAecpInfo& inflight, AecpCommandNode* const node) noexcept;
+	void checkQueue(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, UniqueIdentifier const& entityID, InflightAecpInfo& inflight) noexcept;
+	AecpCommandNode* removeInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, UniqueIdentifier const& entityID, InflightAecpInfo& inflight, AecpCommandNode* const node) noexcept;
+	void setCommandInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, InflightAcmpInfo& inflight, AcmpCommandNode* const node) noexcept;
+	void checkQueue(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, networkInterface::MacAddress const& targetMacAddress, InflightAcmpInfo& inflight) noexcept;
+	AcmpCommandNode* removeInflight(ProtocolInterfaceDelegate* const protocolInterface, CommandEntityInfo& info, networkInterface::MacAddress const& macAddress, InflightAcmpInfo& inflight, AcmpCommandNode* const node) noexcept;
+	void releaseCommands(CommandEntityInfo& info) noexcept;
+	void failNotSentCommands() noexcept;
+
+	void scheduleCheck(std::chrono::steady_clock::time_point const checkTime) const noexcept;
 	bool isAEMUnsolicitedResponse(Aecpdu const& aecpdu) const noexcept;
+	bool isAEMBusyResponse(Aecpdu const& aecpdu) const noexcept;
+	AecpTargetInfo& getAecpTargetInfo(UniqueIdentifier const& entityID) noexcept;
+	void updateAecpTargetOnResponse(UniqueIdentifier const& entityID, std::optional<std::chrono::steady_clock::duration> const& rtt, bool const isBusy) noexcept;
+	void updateAecpTargetOnTimeout(UniqueIdentifier const& entityID, std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept;
+	bool decreaseAecpInflightWindow(AecpTargetInfo& targetInfo, std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept;
 	bool shouldRearmTimer(Aecpdu const& aecpdu) const noexcept;
-	void resetAecpCommandTimeoutValue(AecpCommandInfo& command) const noexcept;
-	void resetAcmpCommandTimeoutValue(AcmpCommandInfo& command) const noexcept;
+	void resetAecpCommandTimeoutValue(CommandEntityInfo& info, AecpCommandNode* const node) noexcept;
+	void resetAcmpCommandTimeoutValue(CommandEntityInfo& info, AcmpCommandNode* const node) noexcept;
 	AecpSequenceID getNextAecpSequenceID(CommandEntityInfo& info) noexcept;
 	AcmpSequenceID getNextAcmpSequenceID(CommandEntityInfo& info) noexcept;
 	size_t getMaxInflightAecpMessages(UniqueIdentifier const& entityID) const noexcept;
@@ -285,7 +255,16 @@ private:
 	// Private members
 	Manager* _manager{ nullptr };
 	Delegate* _delegate{ nullptr };
+	CommandNodePool<AecpCommandInfo> _aecpCommandsPool{}; // Declared before _commandEntities, which references its nodes
+	CommandNodePool<AcmpCommandInfo> _acmpCommandsPool{}; // Declared before _commandEntities, which references its nodes
 	CommandEntities _commandEntities{};
+	AecpTargets _aecpTargets{};
+	ProtocolInterface::CommandTimeoutStatistics _timeoutStatistics{};
+	std::mutex _notSentCommandsLock{}; // Protects _notSentCommands, never held while taking the Manager lock
+	std::vector<SentCommand> _notSentCommands{};
+	std::atomic_bool _hasNotSentCommands{ false };
+	bool _isWaitingForTransport{ false }; // The transport was not ready to send commands, the pending queues are only checked again once it notified it's ready
+	std::atomic_bool _isTransportReady{ false }; // Set by notifyReadyToSendCommands
 };
 
 } // namespace stateMachine
@@ -28,6 +28,7 @@
 #include "stateMachineManager.hpp"
 #include "logHelper.hpp"
 
+#include <algorithm>
 #include <utility>
 #include <optional>
 
@@ -39,25 +40,102 @@ namespace protocol
 {
 namespace stateMachine
 {
+/* Resolution of the remote entities timeout (the timing wheel covering 4096 ticks, more than the maximum ADP valid time of 62 seconds) */
+static constexpr auto RemoteEntityTimeoutTick = std::chrono::milliseconds{ 20u };
+/* Maximum jitter added to the paced discovery delay, as a fraction of the delay */
+static constexpr auto PacedDiscoveryJitterDivisor = 10;
+
 /* ************************************************************ */
 /* Public methods                                               */
 /* ************************************************************ */
 DiscoveryStateMachine::DiscoveryStateMachine(Manager* manager, Delegate* const delegate) noexcept
 	: _manager(manager)
 	, _delegate(delegate)
+	, _timeoutsWheel(RemoteEntityTimeoutTick)
 {
 }
 
-DiscoveryStateMachine::~DiscoveryStateMachine() noexcept {}
+DiscoveryStateMachine::~DiscoveryStateMachine() noexcept
+{
+	// Disarm all timeouts before destroying them
+	while (!_discoveredEntities.empty())
+	{
+		removeEntity(_discoveredEntities.begin());
+	}
+}
 
 void DiscoveryStateMachine::setDiscoveryDelay(std::chrono::milliseconds const delay) noexcept
 {
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
 	_discoveryDelay = delay;
 	_lastDiscovery = std::chrono::steady_clock::now();
+
+	// Restart the paced discovery with the new delay
+	if (_isDiscoveryPaced)
+	{
+		_discoveryJitter = computeDiscoveryJitter();
+		_pacedDiscoveryTargets.clear();
+		_pacedDiscoveryNextTarget = 0u;
+	}
+
+	if (_discoveryDelay.count() != 0)
+	{
+		_manager->scheduleStateMachines(_lastDiscovery + _discoveryDelay + _discoveryJitter);
+	}
+}
+
+void DiscoveryStateMachine::setUpdatesCoalescingDelay(std::chrono::milliseconds const delay) noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	_updatesCoalescingDelay = delay;
+
+	// Don't keep the pending updates waiting for the previous delay
+	if (!_pendingUpdates.empty())
+	{
+		_pendingUpdatesNotifyTime = std::min(_pendingUpdatesNotifyTime, std::chrono::steady_clock::now() + delay);
+		_manager->scheduleStateMachines(_pendingUpdatesNotifyTime);
+	}
 }
 
-void DiscoveryStateMachine::discoverMessageSent() noexcept
+void DiscoveryStateMachine::setDiscoveryPacing(bool const enabled) noexcept
 {
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	_isDiscoveryPaced = enabled;
+	_discoveryJitter = enabled ? computeDiscoveryJitter() : std::chrono::milliseconds{ 0 };
+	_pacedDiscoveryTargets.clear();
+	_pacedDiscoveryNextTarget = 0u;
+
+	if (_discoveryDelay.count() != 0)
+	{
+		_manager->scheduleStateMachines(_lastDiscovery + _discoveryDelay + _discoveryJitter);
+	}
+}
+
+void DiscoveryStateMachine::discoverMessageSent(UniqueIdentifier const targetEntityID) noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	if (_isDiscoveryPaced)
+	{
+		// Targeted DISCOVER messages do not change the paced discovery period
+		if (targetEntityID)
+		{
+			return;
+		}
+
+		// All entities are about to answer, start a new period
+		_isGlobalDiscoveryNeeded = false;
+		_pacedDiscoveryTargets.clear();
+		_pacedDiscoveryNextTarget = 0u;
+	}
+
 	_lastDiscovery = std::chrono::steady_clock::now();
 }
 
@@ -69,20 +147,24 @@ void DiscoveryStateMachine::checkRemoteEntitiesTimeoutExpiracy() noexcept
 	// Get current time
 	auto const now = std::chrono::steady_clock::now();
 
-	// Process all Discovered Entities on the attached Protocol Interface
-	for (auto discoveredEntityKV = _discoveredEntities.begin(); discoveredEntityKV != _discoveredEntities.end(); /* Iterate inside the loop */)
+	// Only process the interfaces that timed out, the other entities are not touched
+	while (auto* const expiredTimeout = _timeoutsWheel.popExpired(now))
 	{
-		auto& entity = discoveredEntityKV->second;
-		auto hasInterfaceTimeout{ false };
-		auto shouldRemoveEntity{ false };
+		auto const entityIt = _discoveredEntities.find(expiredTimeout->entityID);
+		if (!AVDECC_ASSERT_WITH_RET(entityIt != _discoveredEntities.end(), "Timeout of an unknown entity"))
+		{
+			continue;
+		}
+		auto const entityID = entityIt->first;
+		auto& entity = entityIt->second;
 
-		// Check timeout value for all interfaces
+		// Remove all the interfaces of the entity that timed out, so a single notification is sent
 		for (auto timeoutKV = entity.timeouts.begin(); timeoutKV != entity.timeouts.end(); /* Iterate inside the loop */)
 		{
-			auto const timeout = timeoutKV->second;
-			if (now > timeout)
+			auto& timeout = timeoutKV->second;
+			if (&timeout == expiredTimeout || now > timeout.timeout)
 			{
-				hasInterfaceTimeout = true;
+				_timeoutsWheel.disarm(&timeout);
 				entity.entity.removeInterfaceInformation(timeoutKV->first);
 				timeoutKV = entity.timeouts.erase(timeoutKV);
 			}
@@ -92,36 +174,56 @@ void DiscoveryStateMachine::checkRemoteEntitiesTimeoutExpiracy() noexcept
 			}
 		}
 
-		// We had at least one interface timeout
-		if (hasInterfaceTimeout)
+		// No more interfaces, set the entity offline
+		if (entity.entity.getInterfacesInformation().empty())
 		{
-			// No more interfaces, set the entity offline
-			if (entity.entity.getInterfacesInformation().empty())
-			{
-				// Notify this entity is offline
-				utils::invokeProtectedMethod(&Delegate::onRemoteEntityOffline, _delegate, discoveredEntityKV->first);
-				shouldRemoveEntity = true;
-			}
-			// Otherwise just notify an update
-			else
-			{
-				// Notify this entity has been updated
-				utils::invokeProtectedMethod(&Delegate::onRemoteEntityUpdated, _delegate, entity.entity);
-			}
-		}
+			// Remove the entity from the list of known entities
+			removeEntity(entityIt);
 
-		// Should we remove the entity from the list of known entities
-		if (shouldRemoveEntity)
-		{
-			discoveredEntityKV = _discoveredEntities.erase(discoveredEntityKV);
+			// It might be back with its ADPDUs having been lost, a targeted DISCOVER can no longer reach it
+			_isGlobalDiscoveryNeeded = true;
+
+			// Notify this entity is offline
+			notifyOffline(entityID);
 		}
+		// Otherwise just notify an update
 		else
 		{
-			++discoveredEntityKV;
+			notifyUpdate(entity, now);
 		}
 	}
 }
 
+void DiscoveryStateMachine::checkPendingUpdates() noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	if (_pendingUpdates.empty() || std::chrono::steady_clock::now() < _pendingUpdatesNotifyTime)
+	{
+		return;
+	}
+
+	// Notify all the entities still online at once, with their latest state
+	_notifiedEntities.clear();
+	for (auto const& entityID : _pendingUpdates)
+	{
+		auto const entityIt = _discoveredEntities.find(entityID);
+		if (entityIt != _discoveredEntities.end() && entityIt->second.isUpdatePending)
+		{
+			entityIt->second.isUpdatePending = false;
+			_notifiedEntities.push_back(entityIt->second.entity);
+		}
+	}
+	_pendingUpdates.clear();
+
+	if (!_notifiedEntities.empty())
+	{
+		utils::invokeProtectedMethod(&Delegate::onRemoteEntitiesUpdated, _delegate, _notifiedEntities);
+		_notifiedEntities.clear();
+	}
+}
+
 void DiscoveryStateMachine::checkDiscovery() noexcept
 {
 	if (_discoveryDelay.count() == 0)
@@ -131,6 +233,12 @@ void DiscoveryStateMachine::checkDiscovery() noexcept
 
 	auto const now = std::chrono::steady_clock::now();
 
+	if (_isDiscoveryPaced)
+	{
+		checkPacedDiscovery(now);
+		return;
+	}
+
 	if (now >= (_lastDiscovery + _discoveryDelay))
 	{
 		// Update time now so we don't enter the loop again, in case the message is delayed a bit by the manager (which will trigger a discoverMessageSent when the message is actually sent)
@@ -186,8 +294,14 @@ void DiscoveryStateMachine::handleAdpEntityAvailable(Adpdu const& adpdu) noexcep
 		discoveredInfo = &_discoveredEntities.emplace(std::make_pair(entityID, DiscoveredEntityInfo{ std::move(entity) })).first->second;
 	}
 
-	// Compute timeout value and always update
-	discoveredInfo->timeouts[avbInterfaceIndex] = std::chrono::steady_clock::now() + std::chrono::seconds(2 * adpdu.getValidTime());
+	// Compute timeout value and always update (re-arming the timeout in constant time)
+	auto const now = std::chrono::steady_clock::now();
+	discoveredInfo->lastAvailableTime = now;
+	auto& timeout = discoveredInfo->timeouts[avbInterfaceIndex];
+	timeout.entityID = entityID;
+	timeout.avbInterfaceIndex = avbInterfaceIndex;
+	timeout.timeout = now + std::chrono::seconds(2 * adpdu.getValidTime());
+	_manager->scheduleStateMachines(_timeoutsWheel.arm(&timeout, timeout.timeout));
 
 	// Notify delegate
 	if (notify && _delegate != nullptr)
@@ -200,12 +314,15 @@ void DiscoveryStateMachine::handleAdpEntityAvailable(Adpdu const& adpdu) noexcep
 		if (simulateOffline)
 		{
 			AVDECC_ASSERT(!update, "When simulateOffline is set, update should not be");
-			utils::invokeProtectedMethod(&Delegate::onRemoteEntityOffline, _delegate, entityID);
+			notifyOffline(entityID);
+
+			// The online notification already contains the pending update
+			discoveredInfo->isUpdatePending = false;
 		}
 
 		if (update)
 		{
-			utils::invokeProtectedMethod(&Delegate::onRemoteEntityUpdated, _delegate, discoveredInfo->entity);
+			notifyUpdate(*discoveredInfo, now);
 		}
 		else
 		{
@@ -233,10 +350,10 @@ void DiscoveryStateMachine::handleAdpEntityDeparting(Adpdu const& adpdu) noexcep
 		return;
 
 	// Remove from the list
-	_discoveredEntities.erase(entityIt);
+	removeEntity(entityIt);
 
 	// Notify delegate
-	utils::invokeProtectedMethod(&Delegate::onRemoteEntityOffline, _delegate, entityID);
+	notifyOffline(entityID);
 }
 
 void DiscoveryStateMachine::notifyDiscoveredRemoteEntities(Delegate& delegate) const noexcept
@@ -250,10 +367,143 @@ void DiscoveryStateMachine::notifyDiscoveredRemoteEntities(Delegate& delegate) c
 	}
 }
 
+std::chrono::steady_clock::time_point DiscoveryStateMachine::getNextCheckTime() noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	auto nextCheckTime = std::chrono::steady_clock::time_point::max();
+	if (_discoveryDelay.count() != 0)
+	{
+		nextCheckTime = _lastDiscovery + _discoveryDelay + _discoveryJitter;
+		if (_pacedDiscoveryNextTarget < _pacedDiscoveryTargets.size())
+		{
+			nextCheckTime = std::min(nextCheckTime, getPacedDiscoveryTargetTime(_pacedDiscoveryNextTarget));
+		}
+	}
+	if (!_pendingUpdates.empty())
+	{
+		nextCheckTime = std::min(nextCheckTime, _pendingUpdatesNotifyTime);
+	}
+	return std::min(nextCheckTime, _timeoutsWheel.getNextExpiryTime());
+}
+
 
 /* ************************************************************ */
 /* Private methods                                              */
 /* ************************************************************ */
+void DiscoveryStateMachine::removeEntity(DiscoveredEntities::iterator const entityIt) noexcept
+{
+	for (auto& [avbInterfaceIndex, timeout] : entityIt->second.timeouts)
+	{
+		_timeoutsWheel.disarm(&timeout);
+	}
+	_discoveredEntities.erase(entityIt);
+}
+
+void DiscoveryStateMachine::notifyOffline(UniqueIdentifier const entityID) noexcept
+{
+	_manager->onRemoteEntityOffline(entityID);
+	utils::invokeProtectedMethod(&Delegate::onRemoteEntityOffline, _delegate, entityID);
+}
+
+void DiscoveryStateMachine::notifyUpdate(DiscoveredEntityInfo& entityInfo, std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept
+{
+	// No coalescing, notify right away
+	if (_updatesCoalescingDelay.count() == 0 && _pendingUpdates.empty())
+	{
+		utils::invokeProtectedMethod(&Delegate::onRemoteEntityUpdated, _delegate, entityInfo.entity);
+		return;
+	}
+
+	// Already pending, the notification will contain this update as well
+	if (entityInfo.isUpdatePending)
+	{
+		return;
+	}
+
+	try
+	{
+		// First pending update, notify all the updates when the delay elapses
+		if (_pendingUpdates.empty())
+		{
+			_pendingUpdatesNotifyTime = now + _updatesCoalescingDelay;
+			_manager->scheduleStateMachines(_pendingUpdatesNotifyTime);
+		}
+		_pendingUpdates.push_back(entityInfo.entity.getEntityID());
+		entityInfo.isUpdatePending = true;
+	}
+	catch (...)
+	{
+		utils::invokeProtectedMethod(&Delegate::onRemoteEntityUpdated, _delegate, entityInfo.entity);
+	}
+}
+
+void DiscoveryStateMachine::checkPacedDiscovery(std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *_manager };
+
+	if (now >= (_lastDiscovery + _discoveryDelay + _discoveryJitter))
+	{
+		startPacedDiscoveryPeriod(now);
+	}
+
+	// Send the targeted DISCOVER messages that are due, only to the entities not heard of during the last delay
+	while (_pacedDiscoveryNextTarget < _pacedDiscoveryTargets.size() && now >= getPacedDiscoveryTargetTime(_pacedDiscoveryNextTarget))
+	{
+		auto const entityID = _pacedDiscoveryTargets[_pacedDiscoveryNextTarget];
+		++_pacedDiscoveryNextTarget;
+
+		auto const entityIt = _discoveredEntities.find(entityID);
+		if (entityIt != _discoveredEntities.end() && (now - entityIt->second.lastAvailableTime) >= _discoveryDelay)
+		{
+			_manager->discoverRemoteEntity(entityID);
+		}
+	}
+}
+
+void DiscoveryStateMachine::startPacedDiscoveryPeriod(std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept
+{
+	_lastDiscovery = now;
+	_discoveryJitter = computeDiscoveryJitter();
+	_pacedDiscoveryTargets.clear();
+	_pacedDiscoveryNextTarget = 0u;
+
+	if (!_isGlobalDiscoveryNeeded && !_discoveredEntities.empty())
+	{
+		try
+		{
+			_pacedDiscoveryTargets.reserve(_discoveredEntities.size());
+			for (auto const& [entityID, entityInfo] : _discoveredEntities)
+			{
+				_pacedDiscoveryTargets.push_back(entityID);
+			}
+			return;
+		}
+		catch (...)
+		{
+			_pacedDiscoveryTargets.clear();
+		}
+	}
+
+	// No entity to target (or some might have been missed), discover the whole network
+	_manager->discoverRemoteEntities();
+}
+
+std::chrono::time_point<std::chrono::steady_clock> DiscoveryStateMachine::getPacedDiscoveryTargetTime(std::size_t const targetIndex) const noexcept
+{
+	// Targets are evenly spread over the period
+	auto const period = _discoveryDelay + _discoveryJitter;
+	return _lastDiscovery + (period * static_cast<std::chrono::milliseconds::rep>(targetIndex)) / static_cast<std::chrono::milliseconds::rep>(_pacedDiscoveryTargets.size());
+}
+
+std::chrono::milliseconds DiscoveryStateMachine::computeDiscoveryJitter() noexcept
+{
+	auto distribution = std::uniform_int_distribution<std::chrono::milliseconds::rep>{ 0, _discoveryDelay.count() / PacedDiscoveryJitterDivisor };
+	return std::chrono::milliseconds{ distribution(_jitterGenerator) };
+}
+
 entity::Entity DiscoveryStateMachine::makeEntity(Adpdu const& adpdu) const noexcept
 {
 	auto const entityCaps = adpdu.getEntityCapabilities();
@@ -27,9 +27,13 @@
 #include "la/avdecc/internals/entity.hpp"
 
 #include "protocolInterfaceDelegate.hpp"
+#include "timingWheel.hpp"
 
 #include <chrono>
+#include <cstddef>
+#include <random>
 #include <unordered_map>
+#include <vector>
 
 namespace la
 {
@@ -56,18 +60,23 @@ public:
 		virtual void onRemoteEntityOnline(la::avdecc::entity::Entity const& entity) noexcept = 0;
 		virtual void onRemoteEntityOffline(la::avdecc::UniqueIdentifier const entityID) noexcept = 0;
 		virtual void onRemoteEntityUpdated(la::avdecc::entity::Entity const& entity) noexcept = 0;
+		virtual void onRemoteEntitiesUpdated(ProtocolInterface::EntityReferences const& entities) noexcept = 0;
 	};
 
 	DiscoveryStateMachine(Manager* manager, Delegate* const delegate) noexcept;
 	~DiscoveryStateMachine() noexcept;
 
 	void setDiscoveryDelay(std::chrono::milliseconds const delay = DefaultDiscoverySendDelay) noexcept; // 0 as delay means never send automatic DISCOVER messages
-	void discoverMessageSent() noexcept;
+	void setUpdatesCoalescingDelay(std::chrono::milliseconds const delay) noexcept; // 0 as delay means notify each remote entity update right away
+	void setDiscoveryPacing(bool const enabled) noexcept;
+	void discoverMessageSent(UniqueIdentifier const targetEntityID) noexcept;
 	void checkRemoteEntitiesTimeoutExpiracy() noexcept;
+	void checkPendingUpdates() noexcept;
 	void checkDiscovery() noexcept;
 	void handleAdpEntityAvailable(Adpdu const& adpdu) noexcept;
 	void handleAdpEntityDeparting(Adpdu const& adpdu) noexcept;
 	void notifyDiscoveredRemoteEntities(Delegate& delegate) const noexcept;
+	std::chrono::steady_clock::time_point getNextCheckTime() noexcept; // Returns the time of the next automatic (or paced) DISCOVER message, remote entity timeout or coalesced updates notification, whichever comes first
 
 private:
 	// Private types
@@ -77,23 +86,50 @@ private:
 		NotifyUpdate = 1, /**< Upper layers shall be notified of change(s) in the entity */
 		NotifyOfflineOnline = 2, /**< An invalid change in consecutive ADPDUs has been detecter, upper layers will be notified through Offline/Online simulation calls */
 	};
+	struct InterfaceTimeout : public TimingWheelTimer
+	{
+		UniqueIdentifier entityID{};
+		entity::model::AvbInterfaceIndex avbInterfaceIndex{ entity::Entity::GlobalAvbInterfaceIndex };
+		std::chrono::time_point<std::chrono::steady_clock> timeout{};
+	};
 	struct DiscoveredEntityInfo
 	{
 		entity::Entity entity{ {}, {} };
-		std::unordered_map<entity::model::AvbInterfaceIndex, std::chrono::time_point<std::chrono::steady_clock>> timeouts{};
+		std::unordered_map<entity::model::AvbInterfaceIndex, InterfaceTimeout> timeouts{}; // Armed in _timeoutsWheel
+		bool isUpdatePending{ false }; // Listed in _pendingUpdates
+		std::chrono::time_point<std::chrono::steady_clock> lastAvailableTime{}; // Time the last ENTITY_AVAILABLE was received
 	};
 	using DiscoveredEntities = std::unordered_map<UniqueIdentifier, DiscoveredEntityInfo, UniqueIdentifier::hash>;
+	using TimeoutsWheel = TimingWheel<InterfaceTimeout, 4096>;
 
 	// Private methods
 	entity::Entity makeEntity(Adpdu const& adpdu) const noexcept;
 	EntityUpdateAction updateEntity(entity::Entity& entity, entity::Entity&& newEntity) const noexcept;
+	void removeEntity(DiscoveredEntities::iterator const entityIt) noexcept;
+	void notifyOffline(UniqueIdentifier const entityID) noexcept;
+	void notifyUpdate(DiscoveredEntityInfo& entityInfo, std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept;
+	void checkPacedDiscovery(std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept;
+	void startPacedDiscoveryPeriod(std::chrono::time_point<std::chrono::steady_clock> const& now) noexcept;
+	std::chrono::time_point<std::chrono::steady_clock> getPacedDiscoveryTargetTime(std::size_t const targetIndex) const noexcept;
+	std::chrono::milliseconds computeDiscoveryJitter() noexcept;
 
 	// Private members
 	Manager* _manager{ nullptr };
 	Delegate* _delegate{ nullptr };
+	TimeoutsWheel _timeoutsWheel; // Declared before _discoveredEntities, which references it
 	DiscoveredEntities _discoveredEntities{};
 	std::chrono::milliseconds _discoveryDelay{};
 	std::chrono::time_point<std::chrono::steady_clock> _lastDiscovery{ std::chrono::steady_clock::now() };
+	std::chrono::milliseconds _updatesCoalescingDelay{};
+	std::vector<UniqueIdentifier> _pendingUpdates{}; // Entities updated since the last notification, in the order of their first update (might contain entities that went offline since then)
+	std::chrono::time_point<std::chrono::steady_clock> _pendingUpdatesNotifyTime{};
+	ProtocolInterface::EntityReferences _notifiedEntities{}; // Kept to reuse its capacity
+	bool _isDiscoveryPaced{ false };
+	bool _isGlobalDiscoveryNeeded{ true }; // Paced discovery: sending a global DISCOVER on the next period, a remote entity having timed out since the last one
+	std::chrono::milliseconds _discoveryJitter{}; // Paced discovery: added to _discoveryDelay for the current period
+	std::vector<UniqueIdentifier> _pacedDiscoveryTargets{}; // Paced discovery: entities known at the start of the current period, sent a targeted DISCOVER at regular intervals during the period
+	std::size_t _pacedDiscoveryNextTarget{ 0u };
+	std::minstd_rand _jitterGenerator{ static_cast<std::minstd_rand::result_type>(std::chrono::steady_clock::now().time_since_epoch().count()) };
 };
 
 } // namespace stateMachine
@@ -26,6 +26,8 @@
 
 #include "la/avdecc/internals/protocolInterface.hpp"
 
+#include <cstdint>
+
 namespace la
 {
 namespace avdecc
@@ -34,6 +36,42 @@ namespace protocol
 {
 namespace stateMachine
 {
+/** Identifies a command sent through ProtocolInterfaceDelegate::sendMessage, so a transport sending frames asynchronously can report a failure that occurred after sendMessage returned (see Manager::notifyCommandNotSent) */
+struct SentCommand
+{
+	enum class Type : std::uint8_t
+	{
+		None = 0, /**< Not a command (ADPDU or response), no failure has to be reported */
+		Aecp = 1,
+		Acmp = 2,
+	};
+
+	Type type{ Type::None };
+	UniqueIdentifier controllerEntityID{};
+	UniqueIdentifier targetEntityID{}; // AECP only
+	std::uint16_t sequenceID{ 0u };
+
+	static SentCommand fromMessage(Aecpdu const& aecpdu) noexcept
+	{
+		// Odd numbers are responses (see Clause 9.2.1.1.5)
+		if ((aecpdu.getMessageType().getValue() % 2) == 1)
+		{
+			return {};
+		}
+		return SentCommand{ Type::Aecp, aecpdu.getControllerEntityID(), aecpdu.getTargetEntityID(), aecpdu.getSequenceID() };
+	}
+
+	static SentCommand fromMessage(Acmpdu const& acmpdu) noexcept
+	{
+		// Odd numbers are responses (see Clause 8.2.1.5)
+		if ((acmpdu.getMessageType().getValue() % 2) == 1)
+		{
+			return {};
+		}
+		return SentCommand{ Type::Acmp, acmpdu.getControllerEntityID(), UniqueIdentifier{}, acmpdu.getSequenceID() };
+	}
+};
+
 class ProtocolInterfaceDelegate
 {
 public:
@@ -48,6 +86,11 @@ public:
 	virtual ProtocolInterface::Error sendMessage(la::avdecc::protocol::Adpdu const& adpdu) const noexcept = 0;
 	virtual ProtocolInterface::Error sendMessage(la::avdecc::protocol::Aecpdu const& aecpdu) const noexcept = 0;
 	virtual ProtocolInterface::Error sendMessage(la::avdecc::protocol::Acmpdu const& acmpdu) const noexcept = 0;
+	/** Returns false if the transport cannot accept more commands for now (back-pressure), in which case it calls Manager::notifyReadyToSendCommands as soon as it can. Transports sending synchronously are always ready. */
+	virtual bool isReadyToSendCommands() const noexcept
+	{
+		return true;
+	}
 	/* *** Other methods **** */
 	virtual std::uint32_t getVuAecpCommandTimeoutMsec(VuAecpdu::ProtocolIdentifier const& protocolIdentifier, la::avdecc::protocol::VuAecpdu const& aecpdu) const noexcept = 0;
 };
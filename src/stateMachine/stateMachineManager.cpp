@@ -27,6 +27,15 @@
 
 #include "stateMachineManager.hpp"
 #include "logHelper.hpp"
+#include "dispatchTable.hpp"
+
+#ifdef ENABLE_AVDECC_IO_REACTOR
+#	include <sys/timerfd.h>
+#	include <unistd.h>
+#	include <cerrno>
+#	include <cstring>
+#endif // ENABLE_AVDECC_IO_REACTOR
+#include <algorithm>
 
 // Only enable instrumentation in static library and in debug (for unit testing mainly)
 #if defined(DEBUG) && defined(la_avdecc_cxx_STATICS)
@@ -43,6 +52,8 @@ namespace protocol
 {
 namespace stateMachine
 {
+static constexpr auto MaxStateMachinesWait = std::chrono::milliseconds{ 250u }; // Maximum time between 2 runs of the state machines, even without any deadline
+
 /* ************************************************************ */
 /* Public methods                                               */
 /* ************************************************************ */
@@ -215,6 +226,50 @@ Adpdu Manager::makeEntityDepartingMessage(entity::LocalEntity const& entity, ent
 /* ************************************************************ */
 void Manager::startStateMachines() noexcept
 {
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	// Share the I/O reactor thread instead of creating a new thread for each ProtocolInterface
+	if (_stateMachineTimer == IoReactor::InvalidHandle && !_stateMachineThread.joinable())
+	{
+		// Use a one-shot timer armed to the next deadline of the state machines
+		auto const fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (fd != -1)
+		{
+			{
+				auto const lg = std::lock_guard{ _scheduleLock };
+				_stateMachineTimerFd = fd;
+				_nextCheckTime = std::chrono::steady_clock::time_point::max();
+			}
+			_stateMachineTimer = IoReactor::getInstance()->addReader(fd,
+				[this](bool const /*hasError*/)
+				{
+					// Acknowledge the timer expiration
+					auto expirations = std::uint64_t{ 0u };
+					[[maybe_unused]] auto const ret = read(_stateMachineTimerFd, &expirations, sizeof(expirations));
+
+					// Deadlines set while running the state machines will re-arm the timer
+					{
+						auto const lg = std::lock_guard{ _scheduleLock };
+						_nextCheckTime = std::chrono::steady_clock::time_point::max();
+					}
+
+					auto const nextCheckTime = checkStateMachines();
+					scheduleStateMachines(std::min(nextCheckTime, std::chrono::steady_clock::now() + MaxStateMachinesWait));
+				});
+			if (_stateMachineTimer != IoReactor::InvalidHandle)
+			{
+				// Run the state machines right away
+				scheduleStateMachines(std::chrono::steady_clock::now());
+				return;
+			}
+
+			auto const lg = std::lock_guard{ _scheduleLock };
+			_stateMachineTimerFd = -1;
+			close(fd);
+		}
+		LOG_GENERIC_WARN("Failed to register the StateMachines to the I/O reactor, using a dedicated thread");
+	}
+#endif // ENABLE_AVDECC_IO_REACTOR
+
 	// StateMachines are not already started
 	if (!_stateMachineThread.joinable())
 	{
@@ -229,40 +284,62 @@ void Manager::startStateMachines() noexcept
 
 				auto watchDogSharedPointer = watchDog::WatchDog::getInstance();
 				auto& watchDog = *watchDogSharedPointer;
-				watchDog.registerWatch("avdecc::StateMachine", std::chrono::milliseconds{ 1000u }, true);
+				auto const heartbeat = watchDog.registerHeartbeat("avdecc::StateMachine::" + utils::toHexString(reinterpret_cast<size_t>(this)), std::chrono::milliseconds{ 1000u });
+				watchDog.armHeartbeat(heartbeat);
 
-				while (!_shouldTerminate)
+				auto shouldTerminate = false;
+				while (!shouldTerminate)
 				{
-					// Check for local entities announcement
-					_advertiseStateMachine.checkLocalEntitiesAnnouncement();
+					// Deadlines set while running the state machines will be taken into account when computing the next wait
+					{
+						auto const lg = std::lock_guard{ _scheduleLock };
+						_nextCheckTime = std::chrono::steady_clock::time_point::max();
+					}
 
-					// Check for discovery time
-					_discoveryStateMachine.checkDiscovery();
-
-					// Check for timeout expiracy on all remote entities
-					_discoveryStateMachine.checkRemoteEntitiesTimeoutExpiracy();
-
-					// Check for inflight commands expiracy
-					_commandStateMachine.checkInflightCommandsTimeoutExpiracy();
+					auto const nextCheckTime = checkStateMachines();
 
 					// Try to detect deadlocks
-					watchDog.alive("avdecc::StateMachine", true);
-
-					// Wait a little bit so we don't burn the CPU
-					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+					watchDog.armHeartbeat(heartbeat);
+
+					// Wait for the next deadline of the state machines, or for an earlier one to be scheduled (never waiting more than MaxStateMachinesWait so the heartbeat is armed)
+					auto lock = std::unique_lock{ _scheduleLock };
+					auto const maxCheckTime = std::chrono::steady_clock::now() + MaxStateMachinesWait;
+					_nextCheckTime = std::min(_nextCheckTime, nextCheckTime);
+					while (!_shouldTerminate && std::chrono::steady_clock::now() < std::min(_nextCheckTime, maxCheckTime))
+					{
+						_scheduleCondition.wait_until(lock, std::min(_nextCheckTime, maxCheckTime));
+					}
+					shouldTerminate = _shouldTerminate;
 				}
-				watchDog.unregisterWatch("avdecc::StateMachine", true);
+				watchDog.unregisterHeartbeat(heartbeat);
 			});
 	}
 }
 
 void Manager::stopStateMachines() noexcept
 {
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	// Waits for the timer handler to complete if it's currently running
+	if (_stateMachineTimer != IoReactor::InvalidHandle)
+	{
+		IoReactor::getInstance()->remove(_stateMachineTimer);
+		_stateMachineTimer = IoReactor::InvalidHandle;
+
+		auto const lg = std::lock_guard{ _scheduleLock };
+		close(_stateMachineTimerFd);
+		_stateMachineTimerFd = -1;
+	}
+#endif // ENABLE_AVDECC_IO_REACTOR
+
 	// StateMachines are started
 	if (_stateMachineThread.joinable())
 	{
 		// Notify the thread we are shutting down
-		_shouldTerminate = true;
+		{
+			auto const lg = std::lock_guard{ _scheduleLock };
+			_shouldTerminate = true;
+		}
+		_scheduleCondition.notify_one();
 
 		// Wait for the thread to complete its pending tasks
 		_stateMachineThread.join();
@@ -276,14 +353,17 @@ ProtocolInterface::Error Manager::registerLocalEntity(entity::LocalEntity& entit
 
 	// Check if an entity has already been registered with the same EntityID
 	auto const entityID = entity.getEntityID();
-	for (auto const& entityKV : _localEntities)
 	{
-		if (entityID == entityKV.first)
-			return ProtocolInterface::Error::DuplicateLocalEntityID;
-	}
+		auto const localEntitiesLg = std::lock_guard{ _localEntitiesLock };
+		for (auto const& entityKV : _localEntities)
+		{
+			if (entityID == entityKV.first)
+				return ProtocolInterface::Error::DuplicateLocalEntityID;
+		}
 
-	// Ok, register the new entity
-	_localEntities.insert(std::make_pair(entityID, std::ref(entity)));
+		// Ok, register the new entity
+		_localEntities.insert(std::make_pair(entityID, std::ref(entity)));
+	}
 
 	// Any entity should be able to send commands, so register it to the CommandStateMachine
 	_commandStateMachine.registerLocalEntity(entity);
@@ -308,6 +388,7 @@ ProtocolInterface::Error Manager::unregisterLocalEntity(entity::LocalEntity& ent
 			// Disable advertising
 			disableEntityAdvertising(entity);
 			// Remove from the list
+			auto const localEntitiesLg = std::lock_guard{ _localEntitiesLock };
 			it = _localEntities.erase(it);
 			removed = true;
 		}
@@ -336,7 +417,7 @@ void Manager::processAdpdu(Adpdu const& adpdu) noexcept
 {
 	// Dispatching and handling of ADP messages is done on this layer
 
-	static auto const s_Dispatch = std::unordered_map<AdpMessageType::value_type, std::function<void(Manager* const manager, Adpdu const& adpdu)>>{
+	static auto const s_Dispatch = DispatchTable<AdpMessageType::value_type, MessageTypeDispatchSize, void(Manager* const manager, Adpdu const& adpdu)>{
 		// Entity Available
 		{ AdpMessageType::EntityAvailable.getValue(),
 			[](Manager* const manager, Adpdu const& adpdu)
@@ -358,14 +439,10 @@ void Manager::processAdpdu(Adpdu const& adpdu) noexcept
 	};
 
 	auto const messageType = adpdu.getMessageType().getValue();
-	auto const& it = s_Dispatch.find(messageType);
-	if (it != s_Dispatch.end())
-	{
-		utils::invokeProtectedHandler(it->second, this, adpdu);
-	}
+	utils::invokeProtectedHandler(s_Dispatch.get(messageType), this, adpdu);
 }
 
-void Manager::processAecpdu(Aecpdu const& aecpdu) noexcept
+void Manager::processAecpdu(Aecpdu const& aecpdu, std::chrono::steady_clock::time_point const receiveTime) noexcept
 {
 	auto const messageType = aecpdu.getMessageType();
 	auto const isResponse = (messageType.getValue() % 2) == 1; // Odd numbers are responses (see Clause 9.2.1.1.5)
@@ -374,7 +451,7 @@ void Manager::processAecpdu(Aecpdu const& aecpdu) noexcept
 	if (isResponse)
 	{
 		// Forward to the CommandStateMachine
-		_commandStateMachine.handleAecpResponse(aecpdu);
+		_commandStateMachine.handleAecpResponse(aecpdu, receiveTime);
 	}
 	// If the message is a COMMAND
 	else
@@ -417,27 +494,82 @@ void Manager::processAcmpdu(Acmpdu const& acmpdu) noexcept
 	}
 }
 
+void Manager::scheduleStateMachines(std::chrono::steady_clock::time_point const checkTime) noexcept
+{
+	auto const lg = std::lock_guard{ _scheduleLock };
+
+	// Only wake up the state machines if the new deadline is earlier than the scheduled one
+	if (checkTime < _nextCheckTime)
+	{
+		_nextCheckTime = checkTime;
+#ifdef ENABLE_AVDECC_IO_REACTOR
+		if (_stateMachineTimerFd != -1)
+		{
+			armStateMachinesTimer(checkTime);
+			return;
+		}
+#endif // ENABLE_AVDECC_IO_REACTOR
+		_scheduleCondition.notify_one();
+	}
+}
+
 void Manager::lock() noexcept
 {
 	SEND_INSTRUMENTATION_NOTIFICATION("StateMachineManager::lock::PreLock");
-	_lock.lock();
-	if (_lockedCount == 0)
+	if (_lock.try_lock())
 	{
-		_lockingThreadID = std::this_thread::get_id();
+		onLockAcquired({}, false);
+	}
+	else
+	{
+		// Held by another thread, measure the time we wait for it
+		auto const waitStart = std::chrono::steady_clock::now();
+		_lock.lock();
+		onLockAcquired(std::chrono::steady_clock::now() - waitStart, true);
 	}
-	++_lockedCount;
 	SEND_INSTRUMENTATION_NOTIFICATION("StateMachineManager::lock::PostLock");
 }
 
+bool Manager::try_lock() noexcept
+{
+	if (!_lock.try_lock())
+	{
+		return false;
+	}
+	onLockAcquired({}, false);
+	return true;
+}
+
 void Manager::unlock() noexcept
 {
 	SEND_INSTRUMENTATION_NOTIFICATION("StateMachineManager::unlock::PreUnlock");
-	--_lockedCount;
-	if (_lockedCount == 0)
+	auto shouldUnlock = true;
+	while (shouldUnlock)
 	{
-		_lockingThreadID = {};
+		auto const isReleasing = _lockedCount == 1;
+		if (isReleasing)
+		{
+			// Send the commands other threads submitted while we were holding the lock, before releasing it
+			if (_hasSubmittedCommands.load(std::memory_order_acquire))
+			{
+				sendSubmittedCommands();
+			}
+
+			// Statistics
+			auto const holdTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _lockAcquireTime);
+			_lockStatistics.totalHoldTime += holdTime;
+			_lockStatistics.maximumHoldTime = std::max(_lockStatistics.maximumHoldTime, holdTime);
+		}
+		--_lockedCount;
+		if (_lockedCount == 0)
+		{
+			_lockingThreadID = {};
+		}
+		_lock.unlock();
+
+		// A command might have been submitted while we were releasing the lock, in which case the submitter failed to take it: send the command ourself if the lock is still available
+		shouldUnlock = isReleasing && _hasSubmittedCommands.load(std::memory_order_acquire) && try_lock();
 	}
-	_lock.unlock();
 	SEND_INSTRUMENTATION_NOTIFICATION("StateMachineManager::unlock::PostUnlock");
 }
 
@@ -475,12 +607,27 @@ std::optional<entity::model::AvbInterfaceIndex> Manager::getMatchingInterfaceInd
 
 bool Manager::isLocalEntity(UniqueIdentifier const entityID) noexcept
 {
-	// Lock
-	auto const lg = std::lock_guard{ *this };
+	// Only lock the local entities (called for each received message and each sent command, without waiting for the whole StateMachine)
+	auto const lg = std::shared_lock{ _localEntitiesLock };
 
 	return _localEntities.find(entityID) != _localEntities.end();
 }
 
+std::vector<UniqueIdentifier> Manager::getLocalEntityIDs() noexcept
+{
+	// Only lock the local entities
+	auto const lg = std::shared_lock{ _localEntitiesLock };
+
+	auto entityIDs = std::vector<UniqueIdentifier>{};
+	entityIDs.reserve(_localEntities.size());
+	for (auto const& [entityID, entity] : _localEntities)
+	{
+		entityIDs.push_back(entityID);
+	}
+
+	return entityIDs;
+}
+
 void Manager::notifyDiscoveredEntities(DiscoveryStateMachine::Delegate& delegate) noexcept
 {
 	// Notify local entities
@@ -531,7 +678,7 @@ ProtocolInterface::Error Manager::discoverRemoteEntities() noexcept
 ProtocolInterface::Error Manager::discoverRemoteEntity(UniqueIdentifier const entityID) noexcept
 {
 	auto const frame = Manager::makeDiscoveryMessage(_protocolInterface->getMacAddress(), entityID);
-	_discoveryStateMachine.discoverMessageSent(); // Notify we are sending a discover message
+	_discoveryStateMachine.discoverMessageSent(entityID); // Notify we are sending a discover message
 	return _protocolInterfaceDelegate->sendMessage(frame);
 }
 
@@ -541,24 +688,234 @@ ProtocolInterface::Error Manager::setAutomaticDiscoveryDelay(std::chrono::millis
 	return ProtocolInterface::Error::NoError;
 }
 
+ProtocolInterface::Error Manager::setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) noexcept
+{
+	_discoveryStateMachine.setUpdatesCoalescingDelay(delay);
+	return ProtocolInterface::Error::NoError;
+}
+
+ProtocolInterface::Error Manager::setAutomaticDiscoveryPacing(bool const enabled) noexcept
+{
+	_discoveryStateMachine.setDiscoveryPacing(enabled);
+	return ProtocolInterface::Error::NoError;
+}
+
+void Manager::onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept
+{
+	// If the entity comes back, it might not be the same device (nor have the same load), start over with the standard timeout and inflight window
+	_commandStateMachine.forgetAecpTarget(entityID);
+}
+
 /* ************************************************************ */
 /* Sending entry points                                         */
 /* ************************************************************ */
-ProtocolInterface::Error Manager::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult) noexcept
+ProtocolInterface::Error Manager::sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult, ProtocolInterface::AecpCommandPriority const priority) noexcept
 {
 #pragma message("TODO: If TargetEntity is a LocalEntity, then bypass the CommandStateMachine, directly dispatch the message (and asynchroneously trigger onResult)")
-	return _commandStateMachine.sendAecpCommand(std::move(aecpdu), onResult);
+	// Only registered LocalEntities are allowed to send commands (checked without taking the lock)
+	if (!isLocalEntity(aecpdu->getControllerEntityID()))
+	{
+		return ProtocolInterface::Error::InvalidEntityType;
+	}
+
+	// Don't wait for the lock if it's held by another thread (processing received messages or checking timeouts), it will send the command when releasing it
+	auto lock = std::unique_lock{ *this, std::try_to_lock };
+	if (!lock.owns_lock())
+	{
+		try
+		{
+			auto const lg = std::lock_guard{ _submittedCommandsLock };
+			_submittedAecpCommands.push_back(SubmittedAecpCommand{ std::move(aecpdu), onResult, priority });
+			_hasSubmittedCommands.store(true, std::memory_order_release);
+		}
+		catch (...)
+		{
+			return ProtocolInterface::Error::InternalError;
+		}
+		_deferredCommands.fetch_add(1u, std::memory_order_relaxed);
+
+		// The lock might have been released in the meantime (the command is then sent when we release it)
+		lock.try_lock();
+		return ProtocolInterface::Error::NoError;
+	}
+
+	// Send the commands submitted before this one first, to keep them in order
+	if (_hasSubmittedCommands.load(std::memory_order_acquire))
+	{
+		sendSubmittedCommands();
+	}
+
+	return _commandStateMachine.sendAecpCommand(std::move(aecpdu), onResult, priority);
 }
 
 ProtocolInterface::Error Manager::sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, ProtocolInterface::AcmpCommandResultHandler const& onResult) noexcept
 {
 #pragma message("TODO: If TargetEntity is a LocalEntity, then bypass the CommandStateMachine, directly dispatch the message (and asynchroneously trigger onResult)")
+	// Only registered LocalEntities are allowed to send commands (checked without taking the lock)
+	if (!isLocalEntity(acmpdu->getControllerEntityID()))
+	{
+		return ProtocolInterface::Error::InvalidEntityType;
+	}
+
+	// Don't wait for the lock if it's held by another thread (processing received messages or checking timeouts), it will send the command when releasing it
+	auto lock = std::unique_lock{ *this, std::try_to_lock };
+	if (!lock.owns_lock())
+	{
+		try
+		{
+			auto const lg = std::lock_guard{ _submittedCommandsLock };
+			_submittedAcmpCommands.push_back(SubmittedAcmpCommand{ std::move(acmpdu), onResult });
+			_hasSubmittedCommands.store(true, std::memory_order_release);
+		}
+		catch (...)
+		{
+			return ProtocolInterface::Error::InternalError;
+		}
+		_deferredCommands.fetch_add(1u, std::memory_order_relaxed);
+
+		// The lock might have been released in the meantime (the command is then sent when we release it)
+		lock.try_lock();
+		return ProtocolInterface::Error::NoError;
+	}
+
+	// Send the commands submitted before this one first, to keep them in order
+	if (_hasSubmittedCommands.load(std::memory_order_acquire))
+	{
+		sendSubmittedCommands();
+	}
+
 	return _commandStateMachine.sendAcmpCommand(std::move(acmpdu), onResult);
 }
 
+void Manager::notifyCommandNotSent(SentCommand const& command) noexcept
+{
+	if (command.type != SentCommand::Type::None)
+	{
+		_commandStateMachine.notifyCommandNotSent(command);
+	}
+}
+
+void Manager::notifyReadyToSendCommands() noexcept
+{
+	_commandStateMachine.notifyReadyToSendCommands();
+}
+
+/* ************************************************************ */
+/* Statistics entry points                                      */
+/* ************************************************************ */
+ProtocolInterface::CommandTimeoutStatistics Manager::getCommandTimeoutStatistics() noexcept
+{
+	return _commandStateMachine.getTimeoutStatistics();
+}
+
+ProtocolInterface::LockStatistics Manager::getLockStatistics() noexcept
+{
+	// Lock
+	auto const lg = std::lock_guard{ *this };
+
+	auto statistics = _lockStatistics;
+	statistics.deferredCommands = _deferredCommands.load(std::memory_order_relaxed);
+	return statistics;
+}
+
 /* ************************************************************ */
 /* Private methods                                              */
 /* ************************************************************ */
+void Manager::onLockAcquired(std::chrono::steady_clock::duration const waitTime, bool const contended) noexcept
+{
+	if (_lockedCount == 0)
+	{
+		_lockingThreadID = std::this_thread::get_id();
+		_lockAcquireTime = std::chrono::steady_clock::now();
+
+		// Statistics
+		++_lockStatistics.acquisitions;
+		if (contended)
+		{
+			auto const wait = std::chrono::duration_cast<std::chrono::nanoseconds>(waitTime);
+			++_lockStatistics.contentions;
+			_lockStatistics.totalWaitTime += wait;
+			_lockStatistics.maximumWaitTime = std::max(_lockStatistics.maximumWaitTime, wait);
+		}
+	}
+	++_lockedCount;
+}
+
+void Manager::sendSubmittedCommands() noexcept
+{
+	// Already sending them (a result handler called while sending is sending a new command)
+	if (_isSendingSubmittedCommands)
+	{
+		return;
+	}
+	_isSendingSubmittedCommands = true;
+
+	// Take all the submitted commands at once
+	{
+		auto const lg = std::lock_guard{ _submittedCommandsLock };
+		_submittedAecpCommands.swap(_sendingAecpCommands);
+		_submittedAcmpCommands.swap(_sendingAcmpCommands);
+		_hasSubmittedCommands.store(false, std::memory_order_release);
+	}
+
+	for (auto& command : _sendingAecpCommands)
+	{
+		if (auto const error = _commandStateMachine.sendAecpCommand(std::move(command.aecpdu), command.onResult, command.priority); !!error)
+		{
+			utils::invokeProtectedHandler(command.onResult, nullptr, error);
+		}
+	}
+	_sendingAecpCommands.clear();
+
+	for (auto& command : _sendingAcmpCommands)
+	{
+		if (auto const error = _commandStateMachine.sendAcmpCommand(std::move(command.acmpdu), command.onResult); !!error)
+		{
+			utils::invokeProtectedHandler(command.onResult, nullptr, error);
+		}
+	}
+	_sendingAcmpCommands.clear();
+
+	_isSendingSubmittedCommands = false;
+}
+
+std::chrono::steady_clock::time_point Manager::checkStateMachines() noexcept
+{
+	// Check for local entities announcement
+	_advertiseStateMachine.checkLocalEntitiesAnnouncement();
+
+	// Check for discovery time
+	_discoveryStateMachine.checkDiscovery();
+
+	// Check for timeout expiracy on all remote entities
+	_discoveryStateMachine.checkRemoteEntitiesTimeoutExpiracy();
+
+	// Notify the coalesced remote entities updates
+	_discoveryStateMachine.checkPendingUpdates();
+
+	// Check for inflight commands expiracy
+	_commandStateMachine.checkInflightCommandsTimeoutExpiracy();
+
+	// Get the earliest deadline of all state machines
+	return std::min({ _advertiseStateMachine.getNextCheckTime(), _discoveryStateMachine.getNextCheckTime(), _commandStateMachine.getNextCheckTime() });
+}
+
+#ifdef ENABLE_AVDECC_IO_REACTOR
+void Manager::armStateMachinesTimer(std::chrono::steady_clock::time_point const checkTime) noexcept
+{
+	// steady_clock is CLOCK_MONOTONIC, so the time point can directly be used as an absolute timer value
+	auto const timeSinceEpoch = checkTime.time_since_epoch();
+	auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(timeSinceEpoch);
+	auto const nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeSinceEpoch - seconds);
+	auto spec = itimerspec{}; // Null it_interval for a one-shot timer
+	spec.it_value.tv_sec = static_cast<decltype(spec.it_value.tv_sec)>(seconds.count());
+	spec.it_value.tv_nsec = static_cast<decltype(spec.it_value.tv_nsec)>(std::max(nanoseconds.count(), decltype(nanoseconds.count()){ 1 })); // A null it_value would disarm the timer
+	if (timerfd_settime(_stateMachineTimerFd, TFD_TIMER_ABSTIME, &spec, nullptr) == -1)
+	{
+		LOG_GENERIC_ERROR(std::string("Failed to arm the StateMachines timer: ") + std::strerror(errno));
+	}
+}
+#endif // ENABLE_AVDECC_IO_REACTOR
 
 } // namespace stateMachine
 } // namespace protocol
@@ -30,12 +30,19 @@
 #include "advertiseStateMachine.hpp"
 #include "discoveryStateMachine.hpp"
 #include "commandStateMachine.hpp"
+#ifdef ENABLE_AVDECC_IO_REACTOR
+#	include "ioReactor.hpp"
+#endif // ENABLE_AVDECC_IO_REACTOR
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
 #include <thread>
 #include <cstdint>
+#include <vector>
 
 namespace la
 {
@@ -66,11 +73,15 @@ public:
 	ProtocolInterface::Error registerLocalEntity(entity::LocalEntity& entity) noexcept;
 	ProtocolInterface::Error unregisterLocalEntity(entity::LocalEntity& entity) noexcept;
 	void processAdpdu(Adpdu const& adpdu) noexcept;
-	void processAecpdu(Aecpdu const& aecpdu) noexcept;
+	void processAecpdu(Aecpdu const& aecpdu, std::chrono::steady_clock::time_point const receiveTime) noexcept;
 	void processAcmpdu(Acmpdu const& acmpdu) noexcept;
+	/** Wakes up the state machines at checkTime, if it's earlier than the currently scheduled check. Called by the state machines each time they set a new deadline. */
+	void scheduleStateMachines(std::chrono::steady_clock::time_point const checkTime) noexcept;
 
 	/** BasicLockable concept 'lock' method for the whole StateMachine */
 	void lock() noexcept;
+	/** Lockable concept 'try_lock' method for the whole StateMachine */
+	bool try_lock() noexcept;
 	/** BasicLockable concept 'unlock' method for the whole StateMachine */
 	void unlock() noexcept;
 	/** Debug method: Returns true if the whole ProtocolInterface is locked by the calling thread */
@@ -80,6 +91,7 @@ public:
 	ProtocolInterfaceDelegate* getProtocolInterfaceDelegate() noexcept;
 	std::optional<entity::model::AvbInterfaceIndex> getMatchingInterfaceIndex(entity::LocalEntity const& entity) const noexcept;
 	bool isLocalEntity(UniqueIdentifier const entityID) noexcept;
+	std::vector<UniqueIdentifier> getLocalEntityIDs() noexcept;
 	void notifyDiscoveredEntities(DiscoveryStateMachine::Delegate& delegate) noexcept;
 
 	/* ************************************************************ */
@@ -95,22 +107,58 @@ public:
 	ProtocolInterface::Error discoverRemoteEntities() noexcept;
 	ProtocolInterface::Error discoverRemoteEntity(UniqueIdentifier const entityID) noexcept;
 	ProtocolInterface::Error setAutomaticDiscoveryDelay(std::chrono::milliseconds const delay) noexcept;
+	ProtocolInterface::Error setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds const delay) noexcept;
+	ProtocolInterface::Error setAutomaticDiscoveryPacing(bool const enabled) noexcept;
+	/** Called by the DiscoveryStateMachine (with the lock taken) when a remote entity goes offline, before the delegate is notified */
+	void onRemoteEntityOffline(UniqueIdentifier const entityID) noexcept;
 
 	/* ************************************************************ */
 	/* Sending entry points                                         */
 	/* ************************************************************ */
-	ProtocolInterface::Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult) noexcept;
+	ProtocolInterface::Error sendAecpCommand(Aecpdu::UniquePointer&& aecpdu, ProtocolInterface::AecpCommandResultHandler const& onResult, ProtocolInterface::AecpCommandPriority const priority) noexcept;
 	ProtocolInterface::Error sendAcmpCommand(Acmpdu::UniquePointer&& acmpdu, ProtocolInterface::AcmpCommandResultHandler const& onResult) noexcept;
+	/** Reports a command the transport failed to send after ProtocolInterfaceDelegate::sendMessage returned. Can be called from any thread, without taking the lock. */
+	void notifyCommandNotSent(SentCommand const& command) noexcept;
+	/** Reports the transport can accept commands again, after ProtocolInterfaceDelegate::isReadyToSendCommands returned false. Can be called from any thread, without taking the lock. */
+	void notifyReadyToSendCommands() noexcept;
+
+	/* ************************************************************ */
+	/* Statistics entry points                                      */
+	/* ************************************************************ */
+	ProtocolInterface::CommandTimeoutStatistics getCommandTimeoutStatistics() noexcept;
+	ProtocolInterface::LockStatistics getLockStatistics() noexcept;
 
 private:
 	/* ************************************************************ */
 	/* Private types                                                */
 	/* ************************************************************ */
 	using LocalEntities = std::unordered_map<UniqueIdentifier, entity::LocalEntity&, UniqueIdentifier::hash>;
+	struct SubmittedAecpCommand
+	{
+		Aecpdu::UniquePointer aecpdu{ nullptr, nullptr };
+		ProtocolInterface::AecpCommandResultHandler onResult{};
+		ProtocolInterface::AecpCommandPriority priority{ ProtocolInterface::AecpCommandPriority::Interactive };
+	};
+	struct SubmittedAcmpCommand
+	{
+		Acmpdu::UniquePointer acmpdu{ nullptr, nullptr };
+		ProtocolInterface::AcmpCommandResultHandler onResult{};
+	};
+	using SubmittedAecpCommands = std::vector<SubmittedAecpCommand>;
+	using SubmittedAcmpCommands = std::vector<SubmittedAcmpCommand>;
 
 	/* ************************************************************ */
 	/* Private methods                                              */
 	/* ************************************************************ */
+	/** Runs all the state machines, and returns the time they have to be run again */
+	std::chrono::steady_clock::time_point checkStateMachines() noexcept;
+	/** Updates the lock bookkeeping, _lock having just been acquired by the calling thread */
+	void onLockAcquired(std::chrono::steady_clock::duration const waitTime, bool const contended) noexcept;
+	/** Sends the commands submitted by other threads while _lock was held, in submission order. Must be called with _lock taken */
+	void sendSubmittedCommands() noexcept;
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	void armStateMachinesTimer(std::chrono::steady_clock::time_point const checkTime) noexcept;
+#endif // ENABLE_AVDECC_IO_REACTOR
 
 	/* ************************************************************ */
 	/* Common members                                               */
@@ -121,8 +169,34 @@ private:
 	bool _shouldTerminate{ false };
 	ProtocolInterface const* const _protocolInterface{ nullptr };
 	std::thread _stateMachineThread{}; // Can safely be declared here, will be joined during destruction
+#ifdef ENABLE_AVDECC_IO_REACTOR
+	IoReactor::Handle _stateMachineTimer{ IoReactor::InvalidHandle }; // Used instead of _stateMachineThread when registered to the I/O reactor
+	int _stateMachineTimerFd{ -1 }; // One-shot timerfd registered to the I/O reactor, armed to _nextCheckTime
+#endif // ENABLE_AVDECC_IO_REACTOR
+	std::mutex _scheduleLock{}; /** Lock to protect _nextCheckTime and _shouldTerminate, never taken before _lock */
+	std::condition_variable _scheduleCondition{}; /** Wakes up _stateMachineThread when _nextCheckTime is updated */
+	std::chrono::steady_clock::time_point _nextCheckTime{ std::chrono::steady_clock::time_point::max() }; /** Time the state machines have to be run again */
+	mutable std::shared_mutex _localEntitiesLock{}; /** Lock to protect _localEntities, which is only modified with both locks taken (in that order), so it can be read with either _lock or this lock */
 	LocalEntities _localEntities{}; /** Local entities declared by the running program */
 
+	/* ************************************************************ */
+	/* Submitted commands members                                   */
+	/* ************************************************************ */
+	std::mutex _submittedCommandsLock{}; /** Lock to protect the submitted commands, never held while taking _lock */
+	SubmittedAecpCommands _submittedAecpCommands{}; /** AECP commands submitted while _lock was held by another thread */
+	SubmittedAcmpCommands _submittedAcmpCommands{}; /** ACMP commands submitted while _lock was held by another thread */
+	std::atomic_bool _hasSubmittedCommands{ false };
+	SubmittedAecpCommands _sendingAecpCommands{}; /** Submitted AECP commands being sent (swapped with _submittedAecpCommands to keep its capacity), protected by _lock */
+	SubmittedAcmpCommands _sendingAcmpCommands{}; /** Submitted ACMP commands being sent (swapped with _submittedAcmpCommands to keep its capacity), protected by _lock */
+	bool _isSendingSubmittedCommands{ false }; /** Protected by _lock */
+
+	/* ************************************************************ */
+	/* Lock statistics members                                      */
+	/* ************************************************************ */
+	ProtocolInterface::LockStatistics _lockStatistics{}; /** Protected by _lock */
+	std::chrono::steady_clock::time_point _lockAcquireTime{}; /** Time _lock was acquired by _lockingThreadID, protected by _lock */
+	std::atomic<std::uint64_t> _deferredCommands{ 0u };
+
 	/* ************************************************************ */
 	/* Delegate members                                             */
 	/* ************************************************************ */
@@ -0,0 +1,275 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file timingWheel.hpp
+* @author Christophe Calmejane
+* @brief Hashed timing wheel, for large numbers of timers frequently re-armed.
+*/
+
+#pragma once
+
+#include "la/avdecc/utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace la
+{
+namespace avdecc
+{
+namespace protocol
+{
+namespace stateMachine
+{
+/**
+* @brief Hook of the objects stored in a TimingWheel (to be inherited from).
+* @details The hook links the timer in its TimingWheel slot, so it can neither be copied nor moved. A timer must be disarmed before being destroyed.
+*/
+class TimingWheelTimer
+{
+public:
+	TimingWheelTimer() noexcept = default;
+	~TimingWheelTimer() noexcept
+	{
+		AVDECC_ASSERT(!_armed, "Destroying a timer still armed");
+	}
+
+	bool isArmed() const noexcept
+	{
+		return _armed;
+	}
+
+	// Deleted compiler auto-generated methods
+	TimingWheelTimer(TimingWheelTimer&&) = delete;
+	TimingWheelTimer(TimingWheelTimer const&) = delete;
+	TimingWheelTimer& operator=(TimingWheelTimer const&) = delete;
+	TimingWheelTimer& operator=(TimingWheelTimer&&) = delete;
+
+private:
+	template<class Timer, std::size_t SlotsCount>
+	friend class TimingWheel;
+
+	TimingWheelTimer* _previous{ nullptr };
+	TimingWheelTimer* _next{ nullptr };
+	std::uint64_t _expiryTick{ 0u };
+	bool _armed{ false };
+};
+
+/**
+* @brief Hashed timing wheel of Timer (which must inherit from TimingWheelTimer).
+* @details Expiry times are rounded up to the next tick, and timers are stored in the slot of their tick (modulo SlotsCount).
+*          Arming (or re-arming) and disarming a timer are constant-time, and popping the expired timers only touches the slots
+*          elapsed since the previous call, plus the expired timers themselves. Timers expiring more than SlotsCount ticks ahead are
+*          supported (they are skipped until their round comes), but SlotsCount * tickDuration should be greater than the usual timeouts.
+*          A timer is never reported before its expiry time, and at most tickDuration after it.
+*          The wheel does not own its timers.
+* @warning Not thread-safe, to be used with the Manager locked.
+*/
+template<class Timer, std::size_t SlotsCount>
+class TimingWheel final
+{
+	static_assert(SlotsCount != 0u && (SlotsCount % 64u) == 0u && (SlotsCount & (SlotsCount - 1u)) == 0u, "SlotsCount must be a power of 2, multiple of 64");
+
+public:
+	using TimePoint = std::chrono::steady_clock::time_point;
+
+	TimingWheel(std::chrono::steady_clock::duration const tickDuration, TimePoint const origin = std::chrono::steady_clock::now()) noexcept
+		: _tickDuration(tickDuration)
+		, _origin(origin)
+	{
+	}
+
+	/** Arms the timer (moving it if already armed), and returns the time it will actually be reported as expired */
+	TimePoint arm(Timer* const timer, TimePoint const expiryTime) noexcept
+	{
+		TimingWheelTimer* const hook = timer;
+		if (hook->_armed)
+		{
+			unlink(hook);
+		}
+
+		// Round up to the next tick, never scheduling in an already processed slot
+		auto expiryTick = _currentTick;
+		if (expiryTime > _origin)
+		{
+			auto const elapsed = expiryTime - _origin;
+			expiryTick = std::max(expiryTick, static_cast<std::uint64_t>((elapsed + _tickDuration - std::chrono::steady_clock::duration{ 1 }) / _tickDuration));
+		}
+		hook->_expiryTick = expiryTick;
+		link(hook);
+		return getTickTime(expiryTick);
+	}
+
+	void disarm(Timer* const timer) noexcept
+	{
+		TimingWheelTimer* const hook = timer;
+		if (hook->_armed)
+		{
+			unlink(hook);
+		}
+	}
+
+	/** Disarms and returns the next expired timer (in no specific order), or nullptr if no timer expired at currentTime */
+	Timer* popExpired(TimePoint const currentTime) noexcept
+	{
+		if (currentTime < _origin)
+		{
+			return nullptr;
+		}
+		auto const tick = static_cast<std::uint64_t>((currentTime - _origin) / _tickDuration);
+
+		// Slots of a full round ago have already been visited
+		if (tick >= _currentTick + SlotsCount)
+		{
+			_currentTick = tick - SlotsCount + 1u;
+		}
+
+		while (true)
+		{
+			// Search the current slot (timers of a later round stay in it)
+			for (auto* hook = _slots[getSlotIndex(_currentTick)]; hook != nullptr; hook = hook->_next)
+			{
+				if (hook->_expiryTick <= tick)
+				{
+					unlink(hook);
+					return static_cast<Timer*>(hook);
+				}
+			}
+
+			// The slot of the current tick is searched again on the next call, as timers may still be armed for it
+			if (_currentTick >= tick)
+			{
+				return nullptr;
+			}
+			++_currentTick;
+		}
+	}
+
+	/** Returns the time the next timer may expire (the time of the next non-empty slot, which may only contain timers of a later round), or TimePoint::max() if no timer is armed */
+	TimePoint getNextExpiryTime() const noexcept
+	{
+		if (_armedCount == 0u)
+		{
+			return TimePoint::max();
+		}
+
+		// The current slot is searched for its earliest timer, as it might only contain timers of a later round
+		auto const currentSlotIndex = getSlotIndex(_currentTick);
+		auto nextTick = std::numeric_limits<std::uint64_t>::max();
+		for (auto const* hook = _slots[currentSlotIndex]; hook != nullptr; hook = hook->_next)
+		{
+			nextTick = std::min(nextTick, hook->_expiryTick);
+		}
+
+		// Then the next non-empty slot, using the occupancy bitmap
+		for (auto distance = std::size_t{ 1u }; distance < SlotsCount; /* Iterate inside the loop */)
+		{
+			auto const slotIndex = (currentSlotIndex + distance) & (SlotsCount - 1u);
+			auto const bits = _occupiedSlots[slotIndex / 64u] >> (slotIndex % 64u);
+			if (bits == 0u)
+			{
+				// Skip to the next word
+				distance += 64u - (slotIndex % 64u);
+				continue;
+			}
+			if ((bits & 1u) != 0u)
+			{
+				nextTick = std::min(nextTick, _currentTick + distance);
+				break;
+			}
+			++distance;
+		}
+
+		return getTickTime(nextTick);
+	}
+
+	std::size_t getArmedCount() const noexcept
+	{
+		return _armedCount;
+	}
+
+private:
+	static constexpr std::size_t getSlotIndex(std::uint64_t const tick) noexcept
+	{
+		return static_cast<std::size_t>(tick & (SlotsCount - 1u));
+	}
+
+	TimePoint getTickTime(std::uint64_t const tick) const noexcept
+	{
+		return _origin + static_cast<std::chrono::steady_clock::duration::rep>(tick) * _tickDuration;
+	}
+
+	void link(TimingWheelTimer* const hook) noexcept
+	{
+		auto const slotIndex = getSlotIndex(hook->_expiryTick);
+		auto& head = _slots[slotIndex];
+		hook->_previous = nullptr;
+		hook->_next = head;
+		if (head != nullptr)
+		{
+			head->_previous = hook;
+		}
+		head = hook;
+		hook->_armed = true;
+		_occupiedSlots[slotIndex / 64u] |= std::uint64_t{ 1u } << (slotIndex % 64u);
+		++_armedCount;
+	}
+
+	void unlink(TimingWheelTimer* const hook) noexcept
+	{
+		auto const slotIndex = getSlotIndex(hook->_expiryTick);
+		if (hook->_previous != nullptr)
+		{
+			hook->_previous->_next = hook->_next;
+		}
+		else
+		{
+			_slots[slotIndex] = hook->_next;
+			if (hook->_next == nullptr)
+			{
+				_occupiedSlots[slotIndex / 64u] &= ~(std::uint64_t{ 1u } << (slotIndex % 64u));
+			}
+		}
+		if (hook->_next != nullptr)
+		{
+			hook->_next->_previous = hook->_previous;
+		}
+		hook->_previous = nullptr;
+		hook->_next = nullptr;
+		hook->_armed = false;
+		--_armedCount;
+	}
+
+	std::chrono::steady_clock::duration const _tickDuration{};
+	TimePoint const _origin{};
+	std::uint64_t _currentTick{ 0u }; // Slots of the previous ticks have been processed
+	std::size_t _armedCount{ 0u };
+	std::array<TimingWheelTimer*, SlotsCount> _slots{};
+	std::array<std::uint64_t, SlotsCount / 64u> _occupiedSlots{};
+};
+
+} // namespace stateMachine
+} // namespace protocol
+} // namespace avdecc
+} // namespace la
@@ -25,6 +25,9 @@
 #include "la/avdecc/watchDog.hpp"
 
 #include <unordered_map>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <thread>
 #include <string>
 #include <iostream>
@@ -49,6 +52,20 @@ private:
 		bool ignore{ false };
 	};
 
+	static constexpr auto DisarmedTime = std::chrono::steady_clock::rep{ 0 };
+	/** Heartbeat slots are allocated by segments, each one twice as big as the previous one, so the storage grows without ever moving a slot */
+	static constexpr auto FirstSegmentSize = size_t{ 64u };
+	static constexpr auto SegmentsCount = size_t{ 32u }; // Enough segments for more than 2^37 heartbeats
+
+	struct HeartbeatSlot
+	{
+		bool used{ false }; // Only accessed under _lock
+		std::string name{}; // Only accessed under _lock
+		std::chrono::milliseconds maximumInterval{ 0u }; // Only accessed under _lock
+		std::atomic<std::chrono::steady_clock::rep> armedTime{ DisarmedTime }; // Time at which the heartbeat was armed (or DisarmedTime)
+		std::chrono::steady_clock::rep reportedTime{ DisarmedTime }; // Last armedTime value reported as exceeded, only accessed under _lock
+	};
+
 public:
 	WatchDogImpl() noexcept
 	{
@@ -89,6 +106,45 @@ public:
 								}
 							}
 						}
+
+						// Check all armed heartbeats
+						auto const currentHeartbeatTime = std::chrono::steady_clock::now();
+						for (auto handle = HeartbeatHandle{ 0u }; handle < _heartbeatsCount; ++handle)
+						{
+							auto& slot = *getHeartbeatSlot(handle);
+							if (!slot.used)
+							{
+								continue;
+							}
+
+							auto armedTime = slot.armedTime.load(std::memory_order_relaxed);
+							if (armedTime == DisarmedTime)
+							{
+								continue;
+							}
+
+#ifdef _WIN32
+							// If debugger is present, refresh the armed time and don't check the timeout
+							if (IsDebuggerPresent())
+							{
+								slot.armedTime.compare_exchange_strong(armedTime, currentHeartbeatTime.time_since_epoch().count(), std::memory_order_relaxed);
+								continue;
+							}
+#endif // _WIN32
+
+							// Check if we timed out (only report once per arming)
+							auto const elapsed = currentHeartbeatTime - std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration{ armedTime } };
+							if (armedTime != slot.reportedTime && elapsed > slot.maximumInterval)
+							{
+								_observers.notifyObserversMethod<Observer>(&Observer::onIntervalExceeded, slot.name, slot.maximumInterval);
+
+								auto stream = std::stringstream{};
+								stream << "WatchDog heartbeat '" << slot.name << "' exceeded the maximum allowed time. Deadlock?";
+								AVDECC_ASSERT(false, stream.str());
+
+								slot.reportedTime = armedTime;
+							}
+						}
 					}
 					// Wait a little bit so we don't burn the CPU
 					std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -174,12 +230,124 @@ private:
 		}
 	}
 
+	virtual HeartbeatHandle registerHeartbeat(std::string const& name, std::chrono::milliseconds const maximumInterval) noexcept override
+	{
+		auto const lg = std::lock_guard{ _lock };
+
+		try
+		{
+			// Reuse a released slot, or grow the storage
+			auto handle = HeartbeatHandle{ 0u };
+			for (; handle < _heartbeatsCount; ++handle)
+			{
+				if (!getHeartbeatSlot(handle)->used)
+				{
+					break;
+				}
+			}
+			if (handle == _heartbeatsCount && !growHeartbeats())
+			{
+				AVDECC_ASSERT(false, "No more heartbeat slot available");
+				return InvalidHeartbeatHandle;
+			}
+
+			auto& slot = *getHeartbeatSlot(handle);
+			slot.name = name;
+			slot.used = true;
+			slot.maximumInterval = maximumInterval;
+			slot.armedTime.store(DisarmedTime, std::memory_order_relaxed);
+			slot.reportedTime = DisarmedTime;
+			return handle;
+		}
+		catch (...)
+		{
+			return InvalidHeartbeatHandle;
+		}
+	}
+
+	virtual void unregisterHeartbeat(HeartbeatHandle const handle) noexcept override
+	{
+		// Registration may have failed, accept the invalid handle silently
+		if (handle == InvalidHeartbeatHandle)
+		{
+			return;
+		}
+
+		auto const lg = std::lock_guard{ _lock };
+
+		if (!AVDECC_ASSERT_WITH_RET(handle < _heartbeatsCount, "Invalid heartbeat handle"))
+		{
+			return;
+		}
+
+		auto& slot = *getHeartbeatSlot(handle);
+		AVDECC_ASSERT(slot.used, "Cannot unregisterHeartbeat, handle not registered");
+		slot.used = false;
+		slot.name.clear();
+		slot.armedTime.store(DisarmedTime, std::memory_order_relaxed);
+	}
+
+	virtual void armHeartbeat(HeartbeatHandle const handle) noexcept override
+	{
+		if (auto* const slot = getHeartbeatSlot(handle))
+		{
+			slot->armedTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+		}
+	}
+
+	virtual void disarmHeartbeat(HeartbeatHandle const handle) noexcept override
+	{
+		if (auto* const slot = getHeartbeatSlot(handle))
+		{
+			slot->armedTime.store(DisarmedTime, std::memory_order_relaxed);
+		}
+	}
+
+	/** Returns the slot of the handle, or nullptr if its segment has not been allocated. Lock-free (segments are never moved nor released until destruction). */
+	HeartbeatSlot* getHeartbeatSlot(HeartbeatHandle handle) const noexcept
+	{
+		auto segmentSize = FirstSegmentSize;
+		for (auto segmentIndex = size_t{ 0u }; segmentIndex < SegmentsCount; ++segmentIndex)
+		{
+			if (handle < segmentSize)
+			{
+				auto* const segment = _segments[segmentIndex].load(std::memory_order_acquire);
+				return segment != nullptr ? &segment[handle] : nullptr;
+			}
+			handle -= segmentSize;
+			segmentSize *= 2u;
+		}
+		return nullptr;
+	}
+
+	/** Allocates the next segment of slots. Must be called with the lock taken. Returns false if all segments are already allocated, throws if allocation fails. */
+	bool growHeartbeats()
+	{
+		auto segmentSize = FirstSegmentSize;
+		for (auto segmentIndex = size_t{ 0u }; segmentIndex < SegmentsCount; ++segmentIndex)
+		{
+			if (!_segmentsStorage[segmentIndex])
+			{
+				_segmentsStorage[segmentIndex] = std::make_unique<HeartbeatSlot[]>(segmentSize);
+				// Publish the segment, arm/disarm may use it as soon as a handle is returned
+				_segments[segmentIndex].store(_segmentsStorage[segmentIndex].get(), std::memory_order_release);
+				_heartbeatsCount += segmentSize;
+				return true;
+			}
+			segmentSize *= 2u;
+		}
+		return false;
+	}
+
 	using WatchedMap = std::unordered_map<std::string, WatchInfo>;
 
 	// Private members
 	std::mutex _lock{};
 	std::unordered_map<std::thread::id, WatchedMap> _watched{};
 	//WatchedMap _watched{};
+	std::array<std::unique_ptr<HeartbeatSlot[]>, SegmentsCount> _segmentsStorage{}; // Only accessed under _lock
+	std::array<std::atomic<HeartbeatSlot*>, SegmentsCount> _segments{}; // Same segments, read without lock by arm/disarm
+	size_t _heartbeatsCount{ 0u }; // Number of allocated slots, only accessed under _lock
 	bool _shouldTerminate{ false };
 	std::thread _watchThread{};
 	Subject _observers{};
@@ -24,6 +24,7 @@
 
 // Public API
 #include <la/avdecc/avdecc.hpp>
+#include <la/avdecc/internals/entityModelControlValuesTraits.hpp>
 
 // Internal API
 #include "protocol/protocolAemPayloads.hpp"
@@ -524,3 +525,157 @@ TEST(AemPayloads, RecvPayloadMaximumSize)
 }
 
 #endif // _WIN32
+
+TEST(AemPayloads, ReadEntityDescriptorResponse)
+{
+	auto entityDescriptor = la::avdecc::entity::model::EntityDescriptor{};
+	entityDescriptor.entityID = la::avdecc::UniqueIdentifier{ 0x0102030405060708 };
+	entityDescriptor.entityModelID = la::avdecc::UniqueIdentifier{ 0x1112131415161718 };
+	entityDescriptor.talkerStreamSources = 4u;
+	entityDescriptor.listenerStreamSinks = 2u;
+	entityDescriptor.availableIndex = 42u;
+	entityDescriptor.entityName = la::avdecc::entity::model::AvdeccFixedString{ "Entity Name" };
+	entityDescriptor.configurationsCount = 3u;
+	entityDescriptor.currentConfiguration = 1u;
+
+	try
+	{
+		auto const ser = la::avdecc::protocol::aemPayload::serializeReadEntityDescriptorResponse(entityDescriptor);
+		EXPECT_EQ(la::avdecc::protocol::aemPayload::AecpAemReadEntityDescriptorResponsePayloadSize, ser.size());
+		auto const payload = la::avdecc::protocol::AemAecpdu::Payload{ ser.data(), ser.usedBytes() };
+		auto const [commonSize, configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommonResponse(payload);
+		EXPECT_EQ(0u, configurationIndex);
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::Entity, descriptorType);
+		EXPECT_EQ(0u, descriptorIndex);
+		auto const result = la::avdecc::protocol::aemPayload::deserializeReadEntityDescriptorResponse(payload, commonSize, la::avdecc::protocol::AemAecpStatus{ la::avdecc::protocol::AecpStatus::Success.getValue() });
+		EXPECT_EQ(entityDescriptor.entityID, result.entityID);
+		EXPECT_EQ(entityDescriptor.entityModelID, result.entityModelID);
+		EXPECT_EQ(entityDescriptor.talkerStreamSources, result.talkerStreamSources);
+		EXPECT_EQ(entityDescriptor.listenerStreamSinks, result.listenerStreamSinks);
+		EXPECT_EQ(entityDescriptor.availableIndex, result.availableIndex);
+		EXPECT_EQ(entityDescriptor.entityName, result.entityName);
+		EXPECT_EQ(entityDescriptor.configurationsCount, result.configurationsCount);
+		EXPECT_EQ(entityDescriptor.currentConfiguration, result.currentConfiguration);
+	}
+	catch (...)
+	{
+		EXPECT_FALSE(true) << "Should not have thrown";
+	}
+}
+
+TEST(AemPayloads, ReadConfigurationDescriptorResponse)
+{
+	auto configurationDescriptor = la::avdecc::entity::model::ConfigurationDescriptor{};
+	configurationDescriptor.objectName = la::avdecc::entity::model::AvdeccFixedString{ "Configuration" };
+	configurationDescriptor.descriptorCounts[la::avdecc::entity::model::DescriptorType::AudioUnit] = 1u;
+	configurationDescriptor.descriptorCounts[la::avdecc::entity::model::DescriptorType::StreamInput] = 8u;
+
+	try
+	{
+		auto const ser = la::avdecc::protocol::aemPayload::serializeReadConfigurationDescriptorResponse(la::avdecc::entity::model::ConfigurationIndex{ 2u }, configurationDescriptor);
+		auto const payload = la::avdecc::protocol::AemAecpdu::Payload{ ser.data(), ser.usedBytes() };
+		auto const [commonSize, configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommonResponse(payload);
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::Configuration, descriptorType);
+		EXPECT_EQ(2u, descriptorIndex);
+		auto const result = la::avdecc::protocol::aemPayload::deserializeReadConfigurationDescriptorResponse(payload, commonSize, la::avdecc::protocol::AemAecpStatus{ la::avdecc::protocol::AecpStatus::Success.getValue() });
+		EXPECT_EQ(configurationDescriptor.objectName, result.objectName);
+		EXPECT_EQ(configurationDescriptor.descriptorCounts, result.descriptorCounts);
+	}
+	catch (...)
+	{
+		EXPECT_FALSE(true) << "Should not have thrown";
+	}
+}
+
+TEST(AemPayloads, ReadStreamDescriptorResponse)
+{
+	auto streamDescriptor = la::avdecc::entity::model::StreamDescriptor{};
+	streamDescriptor.objectName = la::avdecc::entity::model::AvdeccFixedString{ "Stream" };
+	streamDescriptor.currentFormat = la::avdecc::entity::model::StreamFormat{ 0x00A0020840000800 };
+	streamDescriptor.formats.insert(la::avdecc::entity::model::StreamFormat{ 0x00A0020840000800 });
+	streamDescriptor.formats.insert(la::avdecc::entity::model::StreamFormat{ 0x00A0020240000200 });
+	streamDescriptor.bufferLength = 666u;
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+	streamDescriptor.redundantStreams.insert(la::avdecc::entity::model::StreamIndex{ 1u });
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+
+	try
+	{
+		auto const ser = la::avdecc::protocol::aemPayload::serializeReadStreamDescriptorResponse(la::avdecc::entity::model::ConfigurationIndex{ 0u }, la::avdecc::entity::model::DescriptorType::StreamOutput, la::avdecc::entity::model::StreamIndex{ 3u }, streamDescriptor);
+		auto const payload = la::avdecc::protocol::AemAecpdu::Payload{ ser.data(), ser.usedBytes() };
+		auto const [commonSize, configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommonResponse(payload);
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::StreamOutput, descriptorType);
+		EXPECT_EQ(3u, descriptorIndex);
+		auto const result = la::avdecc::protocol::aemPayload::deserializeReadStreamDescriptorResponse(payload, commonSize, la::avdecc::protocol::AemAecpStatus{ la::avdecc::protocol::AecpStatus::Success.getValue() });
+		EXPECT_EQ(streamDescriptor.objectName, result.objectName);
+		EXPECT_EQ(streamDescriptor.currentFormat, result.currentFormat);
+		EXPECT_EQ(streamDescriptor.formats, result.formats);
+		EXPECT_EQ(streamDescriptor.bufferLength, result.bufferLength);
+#ifdef ENABLE_AVDECC_FEATURE_REDUNDANCY
+		EXPECT_EQ(streamDescriptor.redundantStreams, result.redundantStreams);
+#endif // ENABLE_AVDECC_FEATURE_REDUNDANCY
+	}
+	catch (...)
+	{
+		EXPECT_FALSE(true) << "Should not have thrown";
+	}
+}
+
+TEST(AemPayloads, ReadControlDescriptorResponse)
+{
+	using StaticValues = la::avdecc::entity::model::LinearValues<la::avdecc::entity::model::LinearValueStatic<std::uint8_t>>;
+	using DynamicValues = la::avdecc::entity::model::LinearValues<la::avdecc::entity::model::LinearValueDynamic<std::uint8_t>>;
+
+	auto controlDescriptor = la::avdecc::entity::model::ControlDescriptor{};
+	controlDescriptor.objectName = la::avdecc::entity::model::AvdeccFixedString{ "Identify" };
+	controlDescriptor.controlType = la::avdecc::UniqueIdentifier{ 0x90E0F00000000001 };
+	controlDescriptor.controlValueType = la::avdecc::entity::model::ControlValueType{ false, false, la::avdecc::entity::model::ControlValueType::Type::ControlLinearUInt8 };
+	controlDescriptor.valuesStatic = la::avdecc::entity::model::ControlValues{ StaticValues{ { { 0u, 255u, 255u, 0u } } } };
+	controlDescriptor.valuesDynamic = la::avdecc::entity::model::ControlValues{ DynamicValues{ { { 255u } } } };
+
+	try
+	{
+		auto const ser = la::avdecc::protocol::aemPayload::serializeReadControlDescriptorResponse(la::avdecc::entity::model::ConfigurationIndex{ 0u }, la::avdecc::entity::model::ControlIndex{ 0u }, controlDescriptor);
+		auto const payload = la::avdecc::protocol::AemAecpdu::Payload{ ser.data(), ser.usedBytes() };
+		auto const [commonSize, configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommonResponse(payload);
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::Control, descriptorType);
+		auto const result = la::avdecc::protocol::aemPayload::deserializeReadControlDescriptorResponse(payload, commonSize, la::avdecc::protocol::AemAecpStatus{ la::avdecc::protocol::AecpStatus::Success.getValue() });
+		EXPECT_EQ(controlDescriptor.objectName, result.objectName);
+		EXPECT_EQ(controlDescriptor.controlType, result.controlType);
+		EXPECT_EQ(controlDescriptor.controlValueType, result.controlValueType);
+		auto const staticValues = result.valuesStatic.getValues<StaticValues>();
+		ASSERT_EQ(1u, staticValues.countValues());
+		EXPECT_EQ(255u, staticValues.getValues()[0].maximum);
+		auto const dynamicValues = result.valuesDynamic.getValues<DynamicValues>();
+		ASSERT_EQ(1u, dynamicValues.countValues());
+		EXPECT_EQ(255u, dynamicValues.getValues()[0].currentValue);
+	}
+	catch (...)
+	{
+		EXPECT_FALSE(true) << "Should not have thrown";
+	}
+}
+
+TEST(AemPayloads, ReadClockDomainDescriptorResponse)
+{
+	auto clockDomainDescriptor = la::avdecc::entity::model::ClockDomainDescriptor{};
+	clockDomainDescriptor.objectName = la::avdecc::entity::model::AvdeccFixedString{ "Clock Domain" };
+	clockDomainDescriptor.clockSourceIndex = 1u;
+	clockDomainDescriptor.clockSources = { 0u, 1u, 2u };
+
+	try
+	{
+		auto const ser = la::avdecc::protocol::aemPayload::serializeReadClockDomainDescriptorResponse(la::avdecc::entity::model::ConfigurationIndex{ 0u }, la::avdecc::entity::model::ClockDomainIndex{ 0u }, clockDomainDescriptor);
+		auto const payload = la::avdecc::protocol::AemAecpdu::Payload{ ser.data(), ser.usedBytes() };
+		auto const [commonSize, configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommonResponse(payload);
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::ClockDomain, descriptorType);
+		auto const result = la::avdecc::protocol::aemPayload::deserializeReadClockDomainDescriptorResponse(payload, commonSize, la::avdecc::protocol::AemAecpStatus{ la::avdecc::protocol::AecpStatus::Success.getValue() });
+		EXPECT_EQ(clockDomainDescriptor.objectName, result.objectName);
+		EXPECT_EQ(clockDomainDescriptor.clockSourceIndex, result.clockSourceIndex);
+		EXPECT_EQ(clockDomainDescriptor.clockSources, result.clockSources);
+	}
+	catch (...)
+	{
+		EXPECT_FALSE(true) << "Should not have thrown";
+	}
+}
@@ -0,0 +1,232 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file commandContainers_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "stateMachine/commandContainers.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace
+{
+struct CommandInfo
+{
+	std::uint16_t sequenceID{ 0u };
+	std::uint32_t target{ 0u };
+	std::uint32_t timeoutTime{ 0u };
+	std::shared_ptr<int> payload{};
+};
+
+using Pool = la::avdecc::protocol::stateMachine::CommandNodePool<CommandInfo>;
+using Node = Pool::Node;
+using List = la::avdecc::protocol::stateMachine::CommandNodeList<Node>;
+using Ring = la::avdecc::protocol::stateMachine::SequenceIDRing<Node, 8>;
+using Heap = la::avdecc::protocol::stateMachine::CommandTimerHeap<Node>;
+
+std::vector<std::uint16_t> getSequenceIDs(List const& list)
+{
+	auto sequenceIDs = std::vector<std::uint16_t>{};
+	for (auto const& node : list)
+	{
+		sequenceIDs.push_back(node.info.sequenceID);
+	}
+	return sequenceIDs;
+}
+} // namespace
+
+TEST(CommandContainers, PoolRecycleReleasedNode)
+{
+	auto pool = Pool{};
+
+	auto* const first = pool.acquire();
+	ASSERT_NE(nullptr, first);
+	auto payload = std::make_shared<int>(42);
+	first->info = CommandInfo{ 1u, 0u, 0u, payload };
+	EXPECT_EQ(2, payload.use_count());
+
+	// Releasing a node destroys its content right away
+	pool.release(first);
+	EXPECT_EQ(1, payload.use_count());
+
+	// Released node must be reused, with a default info
+	auto* const second = pool.acquire();
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(0u, second->info.sequenceID);
+	EXPECT_EQ(1u, pool.getAllocatedCount());
+
+	// A new node is allocated when none is free
+	auto* const third = pool.acquire();
+	EXPECT_NE(second, third);
+	EXPECT_EQ(2u, pool.getAllocatedCount());
+
+	pool.release(second);
+	pool.release(third);
+}
+
+TEST(CommandContainers, ListOrder)
+{
+	auto pool = Pool{};
+	auto list = List{};
+	EXPECT_TRUE(list.empty());
+	EXPECT_EQ(nullptr, list.pop_front());
+
+	auto nodes = std::vector<Node*>{};
+	for (auto i = std::uint16_t{ 0u }; i < 4u; ++i)
+	{
+		auto* const node = pool.acquire();
+		node->info.sequenceID = i;
+		list.push_back(node);
+		nodes.push_back(node);
+	}
+	EXPECT_EQ(4u, list.size());
+	EXPECT_EQ((std::vector<std::uint16_t>{ 0u, 1u, 2u, 3u }), getSequenceIDs(list));
+
+	// Erase in the middle returns the next node
+	EXPECT_EQ(nodes[2], list.erase(nodes[1]));
+	EXPECT_EQ((std::vector<std::uint16_t>{ 0u, 2u, 3u }), getSequenceIDs(list));
+
+	// Erase the tail, then push back again
+	EXPECT_EQ(nullptr, list.erase(nodes[3]));
+	list.push_back(nodes[1]);
+	EXPECT_EQ((std::vector<std::uint16_t>{ 0u, 2u, 1u }), getSequenceIDs(list));
+
+	// FIFO order
+	EXPECT_EQ(nodes[0], list.pop_front());
+	EXPECT_EQ(nodes[2], list.pop_front());
+	EXPECT_EQ(nodes[1], list.pop_front());
+	EXPECT_TRUE(list.empty());
+	EXPECT_EQ(0u, list.size());
+
+	for (auto* const node : nodes)
+	{
+		pool.release(node);
+	}
+}
+
+TEST(CommandContainers, RingFind)
+{
+	auto pool = Pool{};
+	auto ring = Ring{};
+
+	// More nodes than slots, and the same sequenceID for two targets (wrap-around)
+	auto nodes = std::vector<Node*>{};
+	for (auto i = std::uint16_t{ 0u }; i < 20u; ++i)
+	{
+		auto* const node = pool.acquire();
+		node->info.sequenceID = i;
+		node->info.target = 1u;
+		ring.insert(node);
+		nodes.push_back(node);
+	}
+	auto* const wrapped = pool.acquire();
+	wrapped->info.sequenceID = 3u;
+	wrapped->info.target = 2u;
+	ring.insert(wrapped);
+
+	auto const isTarget = [](std::uint32_t const target)
+	{
+		return [target](Node const& node)
+		{
+			return node.info.target == target;
+		};
+	};
+
+	for (auto i = std::uint16_t{ 0u }; i < 20u; ++i)
+	{
+		EXPECT_EQ(nodes[i], ring.find(i, isTarget(1u)));
+	}
+	EXPECT_EQ(wrapped, ring.find(std::uint16_t{ 3u }, isTarget(2u)));
+	EXPECT_EQ(nullptr, ring.find(std::uint16_t{ 4u }, isTarget(2u)));
+	EXPECT_EQ(nullptr, ring.find(std::uint16_t{ 20u }, isTarget(1u)));
+
+	// Remove nodes sharing the same slot
+	ring.remove(nodes[3]);
+	ring.remove(nodes[11]);
+	EXPECT_EQ(nullptr, ring.find(std::uint16_t{ 3u }, isTarget(1u)));
+	EXPECT_EQ(nullptr, ring.find(std::uint16_t{ 11u }, isTarget(1u)));
+	EXPECT_EQ(nodes[19], ring.find(std::uint16_t{ 19u }, isTarget(1u)));
+	EXPECT_EQ(wrapped, ring.find(std::uint16_t{ 3u }, isTarget(2u)));
+
+	for (auto i = 0u; i < 20u; ++i)
+	{
+		if (i != 3u && i != 11u)
+		{
+			ring.remove(nodes[i]);
+		}
+		pool.release(nodes[i]);
+	}
+	ring.remove(wrapped);
+	pool.release(wrapped);
+}
+
+TEST(CommandContainers, TimerHeapOrder)
+{
+	auto pool = Pool{};
+	auto heap = Heap{};
+	EXPECT_TRUE(heap.empty());
+	EXPECT_EQ(nullptr, heap.top());
+
+	auto nodes = std::vector<Node*>{};
+	for (auto const timeoutTime : { 50u, 10u, 40u, 30u, 20u, 60u, 70u })
+	{
+		auto* const node = pool.acquire();
+		node->info.timeoutTime = timeoutTime;
+		ASSERT_TRUE(heap.reserve(pool.getAllocatedCount()));
+		heap.schedule(node);
+		nodes.push_back(node);
+	}
+	EXPECT_EQ(7u, heap.size());
+	EXPECT_EQ(nodes[1], heap.top());
+
+	// Postpone the earliest timeout
+	nodes[1]->info.timeoutTime = 65u;
+	heap.schedule(nodes[1]);
+	EXPECT_EQ(nodes[4], heap.top());
+
+	// Advance a timeout
+	nodes[6]->info.timeoutTime = 5u;
+	heap.schedule(nodes[6]);
+	EXPECT_EQ(nodes[6], heap.top());
+
+	// Remove a node in the middle
+	heap.remove(nodes[3]);
+	EXPECT_EQ(Node::NotInHeap, nodes[3]->heapIndex);
+	EXPECT_EQ(6u, heap.size());
+
+	// Nodes are popped in timeout order
+	auto timeoutTimes = std::vector<std::uint32_t>{};
+	while (auto* const node = heap.top())
+	{
+		timeoutTimes.push_back(node->info.timeoutTime);
+		heap.remove(node);
+	}
+	EXPECT_EQ((std::vector<std::uint32_t>{ 5u, 20u, 40u, 50u, 60u, 65u }), timeoutTimes);
+
+	for (auto* const node : nodes)
+	{
+		pool.release(node);
+	}
+}
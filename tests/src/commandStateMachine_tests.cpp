@@ -22,7 +22,522 @@
 * @author Christophe Calmejane
 */
 
+// Public API
+#include <la/avdecc/internals/controllerEntity.hpp>
+#include <la/avdecc/internals/entityFarm.hpp>
+
 // Internal API
 #include "stateMachine/commandStateMachine.hpp"
+#include "entity/controllerEntityImpl.hpp"
+#include "protocolInterface/protocolInterface_virtual.hpp"
 
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr auto ControllerID = la::avdecc::UniqueIdentifier{ 0x0102030405060708 };
+constexpr auto TargetEntityID = la::avdecc::UniqueIdentifier{ 0x000102FFFE030405 };
+constexpr auto AecpCommandTimeout = std::chrono::milliseconds{ 250u }; // Clause 9.2.1
+constexpr auto MaxWakeUpLatency = std::chrono::milliseconds{ 100u }; // Much less than the maximum sleep time of the state machines thread
+
+using ProtocolInterfaceVirtualPointer = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>;
+using ControllerGuard = la::avdecc::entity::LocalEntityGuard<la::avdecc::entity::ControllerEntityImpl>;
+
+class Delegate final : public la::avdecc::entity::controller::Delegate
+{
+public:
+	Delegate(la::avdecc::UniqueIdentifier const targetEntityID = TargetEntityID) noexcept
+		: _targetEntityID(targetEntityID)
+	{
+	}
+
+	/** Waits for the target entity to be discovered by the controller (for the onlineCount time) */
+	bool waitForTargetEntity(std::size_t const onlineCount = 1u)
+	{
+		auto lock = std::unique_lock{ _lock };
+		return _condition.wait_for(lock, std::chrono::seconds(2),
+			[this, onlineCount]
+			{
+				return _onlineCount >= onlineCount;
+			});
+	}
+
+	/** Waits for the target entity to go offline */
+	bool waitForTargetEntityOffline()
+	{
+		auto lock = std::unique_lock{ _lock };
+		return _condition.wait_for(lock, std::chrono::seconds(2),
+			[this]
+			{
+				return _offlineCount != 0u;
+			});
+	}
+
+	/** Returns the mac address of the target entity (once discovered) */
+	la::avdecc::networkInterface::MacAddress const& getTargetMacAddress() const noexcept
+	{
+		return _targetMacAddress;
+	}
+
+private:
+	virtual void onEntityOnline(la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const entityID, la::avdecc::entity::Entity const& entity) noexcept override
+	{
+		if (entityID == _targetEntityID)
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_targetMacAddress = entity.getInterfacesInformation().begin()->second.macAddress;
+			++_onlineCount;
+			_condition.notify_all();
+		}
+	}
+	virtual void onEntityOffline(la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const entityID) noexcept override
+	{
+		if (entityID == _targetEntityID)
+		{
+			auto const lg = std::lock_guard{ _lock };
+			++_offlineCount;
+			_condition.notify_all();
+		}
+	}
+
+	la::avdecc::UniqueIdentifier const _targetEntityID{};
+	la::avdecc::networkInterface::MacAddress _targetMacAddress{};
+	std::mutex _lock{};
+	std::condition_variable _condition{};
+	std::size_t _onlineCount{ 0u };
+	std::size_t _offlineCount{ 0u };
+};
+
+// Each test uses its own virtual network, so no other entity answers the commands
+std::string getNetworkName(std::string const& testName)
+{
+	return "CommandStateMachineTests_" + testName + "_" + std::to_string(::getpid());
+}
+
+// Sends an ADP message for the target entity from the specified interface
+void sendTargetAdpMessage(la::avdecc::protocol::ProtocolInterfaceVirtual& intfc, la::avdecc::protocol::AdpMessageType const messageType)
+{
+	// Build adpdu frame
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	// Set Ether2 fields
+	adpdu.setSrcAddress(intfc.getMacAddress());
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	// Set ADP fields
+	adpdu.setMessageType(messageType);
+	adpdu.setValidTime(31u);
+	adpdu.setEntityID(TargetEntityID);
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setEntityCapabilities(la::avdecc::entity::EntityCapabilities{ la::avdecc::entity::EntityCapability::AemSupported });
+	adpdu.setTalkerStreamSources(0);
+	adpdu.setTalkerCapabilities({});
+	adpdu.setListenerStreamSinks(0);
+	adpdu.setListenerCapabilities({});
+	adpdu.setControllerCapabilities({});
+	adpdu.setAvailableIndex(1);
+	adpdu.setGptpGrandmasterID({});
+	adpdu.setGptpDomainNumber(0);
+	adpdu.setIdentifyControlIndex(0);
+	adpdu.setInterfaceIndex(0);
+	adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+
+	// Send the adp message
+	intfc.sendAdpMessage(adpdu);
+}
+
+// Advertises the target entity from another interface of the virtual network, without ever answering its commands
+ProtocolInterfaceVirtualPointer advertiseTargetEntity(std::string const& networkName)
+{
+	auto intfc = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x06, 0x05, 0x04, 0x03, 0x02 } }) };
+
+	sendTargetAdpMessage(*intfc, la::avdecc::protocol::AdpMessageType::EntityAvailable);
+
+	return intfc;
+}
+
+std::unique_ptr<ControllerGuard> createController(la::avdecc::protocol::ProtocolInterface* const pi, Delegate& delegate)
+{
+	auto const commonInformation = la::avdecc::entity::Entity::CommonInformation{ ControllerID, la::avdecc::UniqueIdentifier{ 0x1122334455667788 }, la::avdecc::entity::EntityCapabilities{}, 0u, la::avdecc::entity::TalkerCapabilities{}, 0u, la::avdecc::entity::ListenerCapabilities{}, la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented }, std::nullopt, std::nullopt };
+	auto const interfaceInfo = la::avdecc::entity::Entity::InterfaceInformation{ pi->getMacAddress(), 31u, 0u, std::nullopt, std::nullopt };
+	// Set the delegate right away, the already discovered entities being notified during construction
+	return std::make_unique<ControllerGuard>(pi, commonInformation, la::avdecc::entity::Entity::InterfacesInformation{ { la::avdecc::entity::Entity::GlobalAvbInterfaceIndex, interfaceInfo } }, &delegate);
+}
+} // namespace
+
+/*
+ * The state machines thread sleeps until the next deadline, it must be woken up for the retry and the timeout of a new command
+ */
+TEST(CommandStateMachine, CommandTimeout)
+{
+	auto const networkName = getNetworkName("CommandTimeout");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+	auto delegate = Delegate{};
+	auto const controllerGuard = createController(pi.get(), delegate);
+	auto& controller = static_cast<la::avdecc::entity::ControllerEntity&>(*controllerGuard);
+	auto const targetInterface = advertiseTargetEntity(networkName);
+	ASSERT_TRUE(delegate.waitForTargetEntity());
+
+	auto resultPromise = std::promise<la::avdecc::entity::LocalEntity::AemCommandStatus>{};
+	auto const start = std::chrono::steady_clock::now();
+	controller.readEntityDescriptor(TargetEntityID,
+		[&resultPromise](la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::LocalEntity::AemCommandStatus const status, la::avdecc::entity::model::EntityDescriptor const& /*descriptor*/)
+		{
+			resultPromise.set_value(status);
+		});
+
+	auto resultFuture = resultPromise.get_future();
+	ASSERT_EQ(std::future_status::ready, resultFuture.wait_for(std::chrono::seconds(2)));
+	auto const elapsed = std::chrono::steady_clock::now() - start;
+
+	// The command is sent twice before timing out, the retry using the backed off retransmission timeout
+	EXPECT_EQ(la::avdecc::entity::LocalEntity::AemCommandStatus::TimedOut, resultFuture.get());
+	EXPECT_LE(AecpCommandTimeout + 2 * AecpCommandTimeout, elapsed);
+	EXPECT_GE(AecpCommandTimeout + 2 * AecpCommandTimeout + MaxWakeUpLatency, elapsed);
+
+	// Only the expired command is examined, once for its retry and once for its timeout
+	auto const statistics = pi->getCommandTimeoutStatistics();
+	EXPECT_EQ(2u, statistics.expiredCommands);
+	EXPECT_GE(statistics.checks + statistics.expiredCommands, statistics.examinedCommands);
+}
+
+/*
+ * Commands exceeding the inflight window are queued, and must be sent as soon as an inflight command completes
+ */
+TEST(CommandStateMachine, QueuedCommandSentOnTimeout)
+{
+	static constexpr auto InflightWindow = 10u;
+
+	auto const networkName = getNetworkName("QueuedCommandSentOnTimeout");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+	auto delegate = Delegate{};
+	auto const controllerGuard = createController(pi.get(), delegate);
+	auto& controller = static_cast<la::avdecc::entity::ControllerEntity&>(*controllerGuard);
+	auto const targetInterface = advertiseTargetEntity(networkName);
+	ASSERT_TRUE(delegate.waitForTargetEntity());
+
+	// Fill the inflight window, plus one queued command
+	auto resultPromises = std::vector<std::promise<std::chrono::steady_clock::time_point>>(InflightWindow + 1u);
+	auto const start = std::chrono::steady_clock::now();
+	for (auto& resultPromise : resultPromises)
+	{
+		controller.readEntityDescriptor(TargetEntityID,
+			[&resultPromise](la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::LocalEntity::AemCommandStatus const /*status*/, la::avdecc::entity::model::EntityDescriptor const& /*descriptor*/)
+			{
+				resultPromise.set_value(std::chrono::steady_clock::now());
+			});
+	}
+
+	auto resultFutures = std::vector<std::future<std::chrono::steady_clock::time_point>>{};
+	for (auto& resultPromise : resultPromises)
+	{
+		resultFutures.push_back(resultPromise.get_future());
+	}
+	for (auto& resultFuture : resultFutures)
+	{
+		ASSERT_EQ(std::future_status::ready, resultFuture.wait_for(std::chrono::seconds(5)));
+	}
+
+	// The first commands time out together (their retry being sent with a backed off retransmission timeout)
+	for (auto i = 0u; i < InflightWindow; ++i)
+	{
+		auto const elapsed = resultFutures[i].get() - start;
+		EXPECT_LE(AecpCommandTimeout + 2 * AecpCommandTimeout, elapsed);
+		EXPECT_GE(AecpCommandTimeout + 2 * AecpCommandTimeout + MaxWakeUpLatency, elapsed);
+	}
+
+	// The last command is sent when the first ones time out, then times out itself (the retransmission timeout being backed off again for its retry)
+	auto const lastElapsed = resultFutures.back().get() - start;
+	EXPECT_LE(3 * AecpCommandTimeout + 2 * AecpCommandTimeout + 4 * AecpCommandTimeout, lastElapsed);
+	EXPECT_GE(3 * AecpCommandTimeout + 2 * AecpCommandTimeout + 4 * AecpCommandTimeout + 2 * MaxWakeUpLatency, lastElapsed);
+}
+
+/*
+ * The retransmission timeout learned from a target entity must be forgotten when it goes offline
+ */
+TEST(CommandStateMachine, TargetOfflineResetsRetransmissionTimeout)
+{
+	auto const networkName = getNetworkName("TargetOfflineResetsRetransmissionTimeout");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+	auto delegate = Delegate{};
+	auto const controllerGuard = createController(pi.get(), delegate);
+	auto& controller = static_cast<la::avdecc::entity::ControllerEntity&>(*controllerGuard);
+	auto const targetInterface = advertiseTargetEntity(networkName);
+	ASSERT_TRUE(delegate.waitForTargetEntity());
+
+	auto const timeCommand = [&controller]()
+	{
+		auto resultPromise = std::promise<void>{};
+		auto const start = std::chrono::steady_clock::now();
+		controller.readEntityDescriptor(TargetEntityID,
+			[&resultPromise](la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::LocalEntity::AemCommandStatus const /*status*/, la::avdecc::entity::model::EntityDescriptor const& /*descriptor*/)
+			{
+				resultPromise.set_value();
+			});
+		auto resultFuture = resultPromise.get_future();
+		EXPECT_EQ(std::future_status::ready, resultFuture.wait_for(std::chrono::seconds(3)));
+		return std::chrono::steady_clock::now() - start;
+	};
+
+	// First command times out, backing off the retransmission timeout of the target
+	timeCommand();
+
+	// The target entity leaves and comes back
+	sendTargetAdpMessage(*targetInterface, la::avdecc::protocol::AdpMessageType::EntityDeparting);
+	ASSERT_TRUE(delegate.waitForTargetEntityOffline());
+	sendTargetAdpMessage(*targetInterface, la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	ASSERT_TRUE(delegate.waitForTargetEntity(2u));
+
+	// Next command starts over with the standard timeout (it would be sent with the backed off one, then retried with twice that, otherwise)
+	auto const elapsed = timeCommand();
+	EXPECT_LE(AecpCommandTimeout + 2 * AecpCommandTimeout, elapsed);
+	EXPECT_GE(AecpCommandTimeout + 2 * AecpCommandTimeout + MaxWakeUpLatency, elapsed);
+}
+
+/*
+ * Commands sent to a fast responder must all succeed while its inflight window grows
+ */
+TEST(CommandStateMachine, FastResponder)
+{
+	static constexpr auto NumberOfCommands = 200u;
+
+	auto const networkName = getNetworkName("FastResponder");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+
+	// Simulate the target entity
+	auto entityTree = la::avdecc::entity::model::EntityTree{};
+	entityTree.dynamicModel.currentConfiguration = 0u;
+	entityTree.configurationTrees[0u];
+	auto commonInformation = la::avdecc::entity::Entity::CommonInformation{};
+	commonInformation.entityCapabilities = la::avdecc::entity::EntityCapabilities{ la::avdecc::entity::EntityCapability::AemSupported };
+	auto const farm = la::avdecc::entity::EntityFarm::create(networkName, commonInformation, entityTree, la::avdecc::entity::EntityFarm::Configuration{});
+	auto const targetEntityID = farm->getEntityID(0u);
+
+	auto delegate = Delegate{ targetEntityID };
+	auto const controllerGuard = createController(pi.get(), delegate);
+	auto& controller = static_cast<la::avdecc::entity::ControllerEntity&>(*controllerGuard);
+	ASSERT_TRUE(delegate.waitForTargetEntity());
+
+	// Send all the commands at once, more than the initial inflight window
+	auto resultPromises = std::vector<std::promise<la::avdecc::entity::LocalEntity::AemCommandStatus>>(NumberOfCommands);
+	for (auto& resultPromise : resultPromises)
+	{
+		controller.readEntityDescriptor(targetEntityID,
+			[&resultPromise](la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::LocalEntity::AemCommandStatus const status, la::avdecc::entity::model::EntityDescriptor const& /*descriptor*/)
+			{
+				resultPromise.set_value(status);
+			});
+	}
+
+	for (auto& resultPromise : resultPromises)
+	{
+		auto resultFuture = resultPromise.get_future();
+		ASSERT_EQ(std::future_status::ready, resultFuture.wait_for(std::chrono::seconds(5)));
+		EXPECT_EQ(la::avdecc::entity::LocalEntity::AemCommandStatus::Success, resultFuture.get());
+	}
+
+	// Nothing was lost, so nothing was retried
+	EXPECT_EQ(NumberOfCommands, farm->getStatistics().receivedCommands);
+
+	// Inflight commands that did not expire are not examined, except the one with the earliest timeout
+	auto const statistics = pi->getCommandTimeoutStatistics();
+	EXPECT_EQ(0u, statistics.expiredCommands);
+	EXPECT_GE(statistics.checks, statistics.examinedCommands);
+}
+
+/*
+ * A command sent while another thread holds the ProtocolInterface lock must not wait for it, the command being sent by that thread when releasing the lock
+ */
+TEST(CommandStateMachine, CommandSubmittedWhileLocked)
+{
+	static constexpr auto HoldTime = std::chrono::milliseconds{ 100u };
+
+	auto const networkName = getNetworkName("CommandSubmittedWhileLocked");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+
+	// Simulate the target entity
+	auto entityTree = la::avdecc::entity::model::EntityTree{};
+	entityTree.dynamicModel.currentConfiguration = 0u;
+	entityTree.configurationTrees[0u];
+	auto commonInformation = la::avdecc::entity::Entity::CommonInformation{};
+	commonInformation.entityCapabilities = la::avdecc::entity::EntityCapabilities{ la::avdecc::entity::EntityCapability::AemSupported };
+	auto const farm = la::avdecc::entity::EntityFarm::create(networkName, commonInformation, entityTree, la::avdecc::entity::EntityFarm::Configuration{});
+	auto const targetEntityID = farm->getEntityID(0u);
+
+	auto delegate = Delegate{ targetEntityID };
+	auto const controllerGuard = createController(pi.get(), delegate);
+	ASSERT_TRUE(delegate.waitForTargetEntity());
+
+	// Build the command
+	auto aecpdu = la::avdecc::protocol::AemAecpdu::create(false);
+	auto& aem = static_cast<la::avdecc::protocol::AemAecpdu&>(*aecpdu);
+	aem.setSrcAddress(pi->getMacAddress());
+	aem.setDestAddress(delegate.getTargetMacAddress());
+	aem.setTargetEntityID(targetEntityID);
+	aem.setControllerEntityID(ControllerID);
+	aem.setUnsolicited(false);
+	aem.setCommandType(la::avdecc::protocol::AemCommandType::ReadDescriptor);
+	auto const payload = std::array<std::uint8_t, 8>{}; // ConfigurationIndex, Reserved, DescriptorType (Entity), DescriptorIndex
+	aem.setCommandSpecificData(payload.data(), payload.size());
+
+	auto resultPromise = std::promise<la::avdecc::protocol::ProtocolInterface::Error>{};
+	auto resultFuture = resultPromise.get_future();
+
+	pi->lock();
+
+	// Send from another thread, it must return right away
+	auto sendFuture = std::async(std::launch::async,
+		[&pi, &aecpdu, &resultPromise]()
+		{
+			return pi->sendAecpCommand(std::move(aecpdu),
+				[&resultPromise](la::avdecc::protocol::Aecpdu const* const /*response*/, la::avdecc::protocol::ProtocolInterface::Error const error)
+				{
+					resultPromise.set_value(error);
+				});
+		});
+	ASSERT_EQ(std::future_status::ready, sendFuture.wait_for(std::chrono::seconds(1)));
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, sendFuture.get());
+
+	// Not sent while we hold the lock
+	std::this_thread::sleep_for(HoldTime);
+	EXPECT_EQ(std::future_status::timeout, resultFuture.wait_for(std::chrono::milliseconds{ 0u }));
+	pi->unlock();
+
+	ASSERT_EQ(std::future_status::ready, resultFuture.wait_for(std::chrono::seconds(2)));
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, resultFuture.get());
+	EXPECT_EQ(1u, farm->getStatistics().receivedCommands);
+
+	auto const statistics = pi->getLockStatistics();
+	EXPECT_EQ(1u, statistics.deferredCommands);
+	EXPECT_LE(HoldTime, statistics.maximumHoldTime);
+	EXPECT_GE(statistics.acquisitions, statistics.contentions);
+}
+
+/*
+ * A command submitted while another thread holds the lock is reported as sent, the error detected when it's actually sent must be reported through its result handler, by the thread releasing the lock
+ */
+TEST(CommandStateMachine, DeferredCommandFailure)
+{
+	auto const networkName = getNetworkName("DeferredCommandFailure");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+	auto delegate = Delegate{};
+	auto const controllerGuard = createController(pi.get(), delegate);
+
+	// Build the command
+	auto aecpdu = la::avdecc::protocol::AemAecpdu::create(false);
+	auto& aem = static_cast<la::avdecc::protocol::AemAecpdu&>(*aecpdu);
+	aem.setSrcAddress(pi->getMacAddress());
+	aem.setDestAddress({ { 0x00, 0x06, 0x05, 0x04, 0x03, 0x02 } });
+	aem.setTargetEntityID(TargetEntityID);
+	aem.setControllerEntityID(ControllerID);
+	aem.setUnsolicited(false);
+	aem.setCommandType(la::avdecc::protocol::AemCommandType::ReadDescriptor);
+	auto const payload = std::array<std::uint8_t, 8>{}; // ConfigurationIndex, Reserved, DescriptorType (Entity), DescriptorIndex
+	aem.setCommandSpecificData(payload.data(), payload.size());
+
+	auto resultPromise = std::promise<std::pair<la::avdecc::protocol::ProtocolInterface::Error, std::thread::id>>{};
+	auto resultFuture = resultPromise.get_future();
+
+	pi->lock();
+
+	// Send from another thread, it must return right away
+	auto sendFuture = std::async(std::launch::async,
+		[&pi, &aecpdu, &resultPromise]()
+		{
+			return pi->sendAecpCommand(std::move(aecpdu),
+				[&resultPromise](la::avdecc::protocol::Aecpdu const* const /*response*/, la::avdecc::protocol::ProtocolInterface::Error const error)
+				{
+					resultPromise.set_value({ error, std::this_thread::get_id() });
+				});
+		});
+	ASSERT_EQ(std::future_status::ready, sendFuture.wait_for(std::chrono::seconds(1)));
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, sendFuture.get());
+
+	// The controller is gone before the command could be sent
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, pi->unregisterLocalEntity(*controllerGuard));
+	EXPECT_EQ(std::future_status::timeout, resultFuture.wait_for(std::chrono::milliseconds{ 0u }));
+	pi->unlock();
+
+	// Failure reported while we released the lock
+	ASSERT_EQ(std::future_status::ready, resultFuture.wait_for(std::chrono::milliseconds{ 0u }));
+	auto const [error, threadID] = resultFuture.get();
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::InvalidEntityType, error);
+	EXPECT_EQ(std::this_thread::get_id(), threadID);
+	EXPECT_EQ(1u, pi->getLockStatistics().deferredCommands);
+}
+
+/*
+ * Interactive commands must be sent before the Background commands queued for the same target entity
+ */
+TEST(CommandStateMachine, InteractiveCommandPreemptsBackground)
+{
+	static constexpr auto InflightWindow = 10u;
+	static constexpr auto NumberOfBackgroundCommands = 2u * InflightWindow;
+
+	auto const networkName = getNetworkName("InteractiveCommandPreemptsBackground");
+	auto const pi = ProtocolInterfaceVirtualPointer{ la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }) };
+
+	// Simulate the target entity
+	auto entityTree = la::avdecc::entity::model::EntityTree{};
+	entityTree.dynamicModel.currentConfiguration = 0u;
+	entityTree.configurationTrees[0u];
+	auto commonInformation = la::avdecc::entity::Entity::CommonInformation{};
+	commonInformation.entityCapabilities = la::avdecc::entity::EntityCapabilities{ la::avdecc::entity::EntityCapability::AemSupported };
+	auto const farm = la::avdecc::entity::EntityFarm::create(networkName, commonInformation, entityTree, la::avdecc::entity::EntityFarm::Configuration{});
+	auto const targetEntityID = farm->getEntityID(0u);
+
+	auto delegate = Delegate{ targetEntityID };
+	auto const controllerGuard = createController(pi.get(), delegate);
+	auto& controller = static_cast<la::avdecc::entity::ControllerEntity&>(*controllerGuard);
+	ASSERT_TRUE(delegate.waitForTargetEntity());
+
+	// Results are always called from the state machines thread, in the order they complete
+	auto completedCommands = 0u;
+	auto interactiveCompletionIndex = std::optional<unsigned int>{};
+	auto allCompletedPromise = std::promise<void>{};
+	auto const onCompleted = [&completedCommands, &allCompletedPromise](bool const isInteractive, std::optional<unsigned int>& interactiveIndex)
+	{
+		if (isInteractive)
+		{
+			interactiveIndex = completedCommands;
+		}
+		if (++completedCommands == NumberOfBackgroundCommands + 1u)
+		{
+			allCompletedPromise.set_value();
+		}
+	};
+
+	// Fill the inflight window and queue more enumeration commands, then change the entity name
+	{
+		auto const lg = std::lock_guard{ *pi };
+		for (auto i = 0u; i < NumberOfBackgroundCommands; ++i)
+		{
+			controller.readEntityDescriptor(targetEntityID,
+				[&onCompleted, &interactiveCompletionIndex](la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::LocalEntity::AemCommandStatus const /*status*/, la::avdecc::entity::model::EntityDescriptor const& /*descriptor*/)
+				{
+					onCompleted(false, interactiveCompletionIndex);
+				});
+		}
+		controller.setEntityName(targetEntityID, la::avdecc::entity::model::AvdeccFixedString{ "Interactive" },
+			[&onCompleted, &interactiveCompletionIndex](la::avdecc::entity::controller::Interface const* const /*controller*/, la::avdecc::UniqueIdentifier const /*entityID*/, la::avdecc::entity::LocalEntity::AemCommandStatus const /*status*/, la::avdecc::entity::model::AvdeccFixedString const& /*entityName*/)
+			{
+				onCompleted(true, interactiveCompletionIndex);
+			});
+	}
+
+	ASSERT_EQ(std::future_status::ready, allCompletedPromise.get_future().wait_for(std::chrono::seconds(5)));
+
+	// Sent as soon as the first inflight command completed, before the queued enumeration commands
+	ASSERT_TRUE(interactiveCompletionIndex.has_value());
+	EXPECT_GE(InflightWindow, *interactiveCompletionIndex);
+}
@@ -0,0 +1,69 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file dispatchTable_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "dispatchTable.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+
+namespace
+{
+using TestTable = la::avdecc::DispatchTable<std::uint8_t, 4u, int(int const value)>;
+
+// Must be buildable in a constant expression
+static constexpr auto s_ConstexprTable = TestTable{
+	{ std::uint8_t{ 0u },
+		[](int const value)
+		{
+			return value + 1;
+		} },
+	{ std::uint8_t{ 2u },
+		[](int const value)
+		{
+			return value * 2;
+		} },
+};
+static_assert(s_ConstexprTable.get(0u) != nullptr, "Handler should be defined");
+static_assert(s_ConstexprTable.get(1u) == nullptr, "Handler should not be defined");
+static_assert(s_ConstexprTable.get(4u) == nullptr, "Out of range key should return nullptr");
+} // namespace
+
+TEST(DispatchTable, Lookup)
+{
+	EXPECT_EQ(6, s_ConstexprTable.get(0u)(5));
+	EXPECT_EQ(10, s_ConstexprTable.get(2u)(5));
+	EXPECT_EQ(nullptr, s_ConstexprTable.get(3u));
+	EXPECT_EQ(nullptr, s_ConstexprTable.get(255u));
+}
+
+TEST(DispatchTable, InvalidKeys)
+{
+	EXPECT_THROW((TestTable{ { std::uint8_t{ 4u }, nullptr } }), std::out_of_range);
+	auto const handler = [](int const value)
+	{
+		return value;
+	};
+	EXPECT_THROW((TestTable{ { std::uint8_t{ 1u }, handler }, { std::uint8_t{ 1u }, handler } }), std::invalid_argument);
+}
@@ -0,0 +1,301 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file entityFarm_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Public API
+#include <la/avdecc/internals/entityFarm.hpp>
+#include <la/avdecc/internals/protocolAemAecpdu.hpp>
+
+// Internal API
+#include "protocol/protocolAemPayloads.hpp"
+#include "protocolInterface/protocolInterface_virtual.hpp"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr auto PeerMacAddress = la::avdecc::networkInterface::MacAddress{ { 0x00, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e } };
+constexpr auto ControllerID = la::avdecc::UniqueIdentifier{ 0x0001020304050607 };
+
+// Each test uses its own virtual network, so concurrent test runs don't see each other
+std::string getNetworkName(std::string const& testName)
+{
+	return "EntityFarmTests_" + testName + "_" + std::to_string(::getpid());
+}
+
+la::avdecc::entity::model::EntityTree buildEntityTree()
+{
+	auto entityTree = la::avdecc::entity::model::EntityTree{};
+	entityTree.dynamicModel.entityName = la::avdecc::entity::model::AvdeccFixedString{ "Farm Entity" };
+	entityTree.dynamicModel.currentConfiguration = 0u;
+
+	auto& configTree = entityTree.configurationTrees[0u];
+	configTree.staticModel.descriptorCounts[la::avdecc::entity::model::DescriptorType::StreamInput] = 1u;
+	configTree.dynamicModel.objectName = la::avdecc::entity::model::AvdeccFixedString{ "Default" };
+	auto& streamNode = configTree.streamInputModels[0u];
+	streamNode.dynamicModel.objectName = la::avdecc::entity::model::AvdeccFixedString{ "Input" };
+
+	return entityTree;
+}
+
+la::avdecc::entity::Entity::CommonInformation buildCommonInformation()
+{
+	auto commonInformation = la::avdecc::entity::Entity::CommonInformation{};
+	commonInformation.entityModelID = la::avdecc::UniqueIdentifier{ 0x001B92FFFF000001 };
+	commonInformation.entityCapabilities = la::avdecc::entity::EntityCapabilities{ la::avdecc::entity::EntityCapability::AemSupported };
+	commonInformation.listenerStreamSinks = 1u;
+	commonInformation.listenerCapabilities = la::avdecc::entity::ListenerCapabilities{ la::avdecc::entity::ListenerCapability::Implemented, la::avdecc::entity::ListenerCapability::AudioSink };
+	return commonInformation;
+}
+
+la::avdecc::protocol::AemAecpdu::UniquePointer buildAemCommand(la::avdecc::networkInterface::MacAddress const& destAddress, la::avdecc::UniqueIdentifier const targetID, la::avdecc::protocol::AemCommandType const commandType, la::avdecc::protocol::AecpSequenceID const sequenceID)
+{
+	auto aecpdu = la::avdecc::protocol::AemAecpdu::create(false);
+	auto& aem = static_cast<la::avdecc::protocol::AemAecpdu&>(*aecpdu);
+
+	// Set Ether2 fields
+	aem.setSrcAddress(PeerMacAddress);
+	aem.setDestAddress(destAddress);
+	// Set AECP fields
+	aem.setStatus(la::avdecc::protocol::AecpStatus::Success);
+	aem.setTargetEntityID(targetID);
+	aem.setControllerEntityID(ControllerID);
+	aem.setSequenceID(sequenceID);
+	// Set AEM fields
+	aem.setUnsolicited(false);
+	aem.setCommandType(commandType);
+	return aecpdu;
+}
+
+class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+{
+public:
+	struct Response
+	{
+		la::avdecc::UniqueIdentifier targetID{};
+		la::avdecc::protocol::AecpStatus status{ la::avdecc::protocol::AecpStatus::Success };
+		la::avdecc::protocol::AemCommandType commandType{ la::avdecc::protocol::AemCommandType::ReadDescriptor };
+		bool unsolicited{ false };
+		std::vector<std::uint8_t> payload{};
+	};
+
+	/** Waits until the specified number of entities have been discovered */
+	bool waitForEntities(std::size_t const count)
+	{
+		auto lock = std::unique_lock{ _lock };
+		return _condition.wait_for(lock, std::chrono::seconds(2),
+			[this, count]
+			{
+				return _entities.size() >= count;
+			});
+	}
+
+	/** Waits until the specified number of AEM responses have been received, and returns them */
+	std::vector<Response> waitForResponses(std::size_t const count)
+	{
+		auto lock = std::unique_lock{ _lock };
+		_condition.wait_for(lock, std::chrono::seconds(2),
+			[this, count]
+			{
+				return _responses.size() >= count;
+			});
+		return _responses;
+	}
+
+private:
+	virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& entity) noexcept override
+	{
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_entities.insert(entity.getEntityID());
+		}
+		_condition.notify_all();
+	}
+	virtual void onAecpduReceived(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept override
+	{
+		if (aecpdu.getMessageType() != la::avdecc::protocol::AecpMessageType::AemResponse)
+		{
+			return;
+		}
+		auto const& aem = static_cast<la::avdecc::protocol::AemAecpdu const&>(aecpdu);
+		auto const [payload, payloadLength] = aem.getPayload();
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_responses.push_back(Response{ aem.getTargetEntityID(), aem.getStatus(), aem.getCommandType(), aem.getUnsolicited(), std::vector<std::uint8_t>(static_cast<std::uint8_t const*>(payload), static_cast<std::uint8_t const*>(payload) + payloadLength) });
+		}
+		_condition.notify_all();
+	}
+
+	std::mutex _lock{};
+	std::condition_variable _condition{};
+	std::set<la::avdecc::UniqueIdentifier> _entities{};
+	std::vector<Response> _responses{};
+	DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+};
+
+using VirtualPointer = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>;
+} // namespace
+
+TEST(EntityFarm, InvalidConfiguration)
+{
+	auto configuration = la::avdecc::entity::EntityFarm::Configuration{};
+	configuration.numberOfEntities = 0u;
+	EXPECT_THROW(la::avdecc::entity::EntityFarm::create(getNetworkName("InvalidConfiguration"), buildCommonInformation(), buildEntityTree(), configuration), std::invalid_argument);
+}
+
+TEST(EntityFarm, AdvertiseEntities)
+{
+	auto const networkName = getNetworkName("AdvertiseEntities");
+	auto const peer = VirtualPointer(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, PeerMacAddress));
+	auto obs = Observer{};
+	peer->registerObserver(&obs);
+
+	auto configuration = la::avdecc::entity::EntityFarm::Configuration{};
+	configuration.numberOfEntities = 16u;
+	auto const farm = la::avdecc::entity::EntityFarm::create(networkName, buildCommonInformation(), buildEntityTree(), configuration);
+
+	ASSERT_EQ(16u, farm->getNumberOfEntities());
+	EXPECT_EQ(configuration.baseEntityID, farm->getEntityID(0u));
+	EXPECT_EQ(la::avdecc::UniqueIdentifier{ configuration.baseEntityID.getValue() + 15u }, farm->getEntityID(15u));
+
+	// All the entities are advertised
+	EXPECT_TRUE(obs.waitForEntities(16u));
+	EXPECT_LE(16u, farm->getStatistics().sentAdvertisements);
+
+	peer->unregisterObserver(&obs);
+}
+
+TEST(EntityFarm, AnswerCommands)
+{
+	auto const networkName = getNetworkName("AnswerCommands");
+	auto const peer = VirtualPointer(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, PeerMacAddress));
+	auto obs = Observer{};
+	peer->registerObserver(&obs);
+
+	auto configuration = la::avdecc::entity::EntityFarm::Configuration{};
+	configuration.numberOfEntities = 4u;
+	auto const farm = la::avdecc::entity::EntityFarm::create(networkName, buildCommonInformation(), buildEntityTree(), configuration);
+	auto const targetID = farm->getEntityID(2u);
+
+	// READ_DESCRIPTOR(ENTITY) is answered with the EntityID of the targeted entity
+	{
+		auto command = buildAemCommand(configuration.macAddress, targetID, la::avdecc::protocol::AemCommandType::ReadDescriptor, 1u);
+		auto const ser = la::avdecc::protocol::aemPayload::serializeReadDescriptorCommand(0u, la::avdecc::entity::model::DescriptorType::Entity, 0u);
+		static_cast<la::avdecc::protocol::AemAecpdu&>(*command).setCommandSpecificData(ser.data(), ser.size());
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAecpMessage(*command));
+	}
+	// GET_NAME of the stream input
+	{
+		auto command = buildAemCommand(configuration.macAddress, targetID, la::avdecc::protocol::AemCommandType::GetName, 2u);
+		auto const ser = la::avdecc::protocol::aemPayload::serializeGetNameCommand(la::avdecc::entity::model::DescriptorType::StreamInput, 0u, 0u, 0u);
+		static_cast<la::avdecc::protocol::AemAecpdu&>(*command).setCommandSpecificData(ser.data(), ser.size());
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAecpMessage(*command));
+	}
+	// Commands not in the template are NOT_IMPLEMENTED
+	{
+		auto command = buildAemCommand(configuration.macAddress, targetID, la::avdecc::protocol::AemCommandType::SetName, 3u);
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAecpMessage(*command));
+	}
+
+	auto const responses = obs.waitForResponses(3u);
+	ASSERT_EQ(3u, responses.size());
+
+	// Responses are sent in order by the farm thread
+	{
+		auto const& response = responses[0];
+		EXPECT_EQ(targetID, response.targetID);
+		EXPECT_EQ(la::avdecc::protocol::AecpStatus::Success, response.status);
+		auto const payload = la::avdecc::protocol::AemAecpdu::Payload{ response.payload.data(), response.payload.size() };
+		auto const [commonSize, configurationIndex, descriptorType, descriptorIndex] = la::avdecc::protocol::aemPayload::deserializeReadDescriptorCommonResponse(payload);
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::Entity, descriptorType);
+		auto const descriptor = la::avdecc::protocol::aemPayload::deserializeReadEntityDescriptorResponse(payload, commonSize, la::avdecc::protocol::AemAecpStatus{ la::avdecc::protocol::AecpStatus::Success.getValue() });
+		EXPECT_EQ(targetID, descriptor.entityID);
+		EXPECT_EQ(la::avdecc::UniqueIdentifier{ 0x001B92FFFF000001 }, descriptor.entityModelID);
+		EXPECT_EQ(la::avdecc::entity::model::AvdeccFixedString{ "Farm Entity" }, descriptor.entityName);
+		EXPECT_EQ(1u, descriptor.configurationsCount);
+	}
+	{
+		auto const& response = responses[1];
+		EXPECT_EQ(la::avdecc::protocol::AecpStatus::Success, response.status);
+		auto const [descriptorType, descriptorIndex, nameIndex, configurationIndex, name] = la::avdecc::protocol::aemPayload::deserializeGetNameResponse(la::avdecc::protocol::AemAecpdu::Payload{ response.payload.data(), response.payload.size() });
+		EXPECT_EQ(la::avdecc::entity::model::DescriptorType::StreamInput, descriptorType);
+		EXPECT_EQ(la::avdecc::entity::model::AvdeccFixedString{ "Input" }, name);
+	}
+	{
+		auto const& response = responses[2];
+		EXPECT_EQ(la::avdecc::protocol::AecpStatus::NotImplemented, response.status);
+		EXPECT_EQ(la::avdecc::protocol::AemCommandType::SetName, response.commandType);
+	}
+
+	// Counters are updated by the farm thread once the response has been sent
+	auto statistics = farm->getStatistics();
+	for (auto retry = 0; retry < 100 && statistics.sentResponses < 3u; ++retry)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		statistics = farm->getStatistics();
+	}
+	EXPECT_EQ(3u, statistics.receivedCommands);
+	EXPECT_EQ(3u, statistics.sentResponses);
+	EXPECT_EQ(1u, statistics.notImplementedResponses);
+
+	peer->unregisterObserver(&obs);
+}
+
+TEST(EntityFarm, UnsolicitedNotifications)
+{
+	auto const networkName = getNetworkName("UnsolicitedNotifications");
+	auto const peer = VirtualPointer(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, PeerMacAddress));
+	auto obs = Observer{};
+	peer->registerObserver(&obs);
+
+	auto configuration = la::avdecc::entity::EntityFarm::Configuration{};
+	configuration.numberOfEntities = 2u;
+	configuration.unsolicitedNotificationsPerSecond = 100u;
+	auto const farm = la::avdecc::entity::EntityFarm::create(networkName, buildCommonInformation(), buildEntityTree(), configuration);
+
+	// No notification is sent until a controller registers
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAecpMessage(*buildAemCommand(configuration.macAddress, farm->getEntityID(1u), la::avdecc::protocol::AemCommandType::RegisterUnsolicitedNotification, 1u)));
+
+	auto const responses = obs.waitForResponses(5u);
+	ASSERT_LE(5u, responses.size());
+	EXPECT_FALSE(responses[0].unsolicited);
+	EXPECT_EQ(la::avdecc::protocol::AemCommandType::RegisterUnsolicitedNotification, responses[0].commandType);
+	for (auto i = size_t{ 1u }; i < responses.size(); ++i)
+	{
+		EXPECT_TRUE(responses[i].unsolicited);
+		EXPECT_EQ(farm->getEntityID(1u), responses[i].targetID);
+		EXPECT_EQ(la::avdecc::protocol::AemCommandType::GetCounters, responses[i].commandType);
+	}
+	EXPECT_LE(4u, farm->getStatistics().sentUnsolicitedNotifications);
+
+	peer->unregisterObserver(&obs);
+}
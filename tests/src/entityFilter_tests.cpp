@@ -0,0 +1,208 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file entityFilter_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Public API
+#include <la/avdecc/internals/protocolAemAecpdu.hpp>
+#include <la/avdecc/internals/protocolDefines.hpp>
+
+// Internal API
+#include "protocolInterface/entityFilter.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+using Frame = std::vector<std::uint8_t>;
+
+constexpr auto LocalEntityID = la::avdecc::UniqueIdentifier{ 0x0001020304050607 };
+constexpr auto OtherEntityID = la::avdecc::UniqueIdentifier{ 0x0001020304050608 };
+constexpr auto RemoteEntityID = la::avdecc::UniqueIdentifier{ 0x1011121314151617 };
+
+/** Minimal classic BPF interpreter, for the opcodes generated by entityFilter */
+bool runProgram(la::avdecc::protocol::entityFilter::Program const& program, Frame const& frame)
+{
+	auto accumulator = std::uint32_t{ 0u };
+	auto const load = [&frame](std::uint32_t const offset, std::size_t const size, std::uint32_t& value)
+	{
+		if (offset + size > frame.size())
+		{
+			return false;
+		}
+		value = 0u;
+		for (auto i = std::size_t{ 0u }; i < size; ++i)
+		{
+			value = (value << 8) | frame[offset + i];
+		}
+		return true;
+	};
+
+	for (auto pc = std::size_t{ 0u }; pc < program.size(); ++pc)
+	{
+		auto const& instruction = program[pc];
+		switch (instruction.code)
+		{
+			case la::avdecc::protocol::entityFilter::LoadWordAbsolute:
+				if (!load(instruction.k, 4u, accumulator))
+					return false;
+				break;
+			case la::avdecc::protocol::entityFilter::LoadHalfAbsolute:
+				if (!load(instruction.k, 2u, accumulator))
+					return false;
+				break;
+			case la::avdecc::protocol::entityFilter::LoadByteAbsolute:
+				if (!load(instruction.k, 1u, accumulator))
+					return false;
+				break;
+			case la::avdecc::protocol::entityFilter::JumpIfEqual:
+				pc += (accumulator == instruction.k) ? instruction.jt : instruction.jf;
+				break;
+			case la::avdecc::protocol::entityFilter::JumpIfSet:
+				pc += (accumulator & instruction.k) != 0u ? instruction.jt : instruction.jf;
+				break;
+			case la::avdecc::protocol::entityFilter::Return:
+				return instruction.k != 0u;
+			default:
+				ADD_FAILURE() << "Unexpected opcode " << instruction.code;
+				return false;
+		}
+	}
+
+	ADD_FAILURE() << "Program did not return";
+	return false;
+}
+
+void writeEntityID(Frame& frame, std::size_t const offset, la::avdecc::UniqueIdentifier const entityID)
+{
+	auto const value = entityID.getValue();
+	for (auto i = std::size_t{ 0u }; i < 8u; ++i)
+	{
+		frame[offset + i] = static_cast<std::uint8_t>(value >> (56u - 8u * i));
+	}
+}
+
+Frame makeFrame(std::uint16_t const etherType, std::uint8_t const subType, bool const isMulticast = false, la::avdecc::UniqueIdentifier const targetID = {}, la::avdecc::UniqueIdentifier const controllerID = {})
+{
+	auto frame = Frame(64u, 0u);
+	frame[0] = isMulticast ? 0x91 : 0x00;
+	frame[12] = static_cast<std::uint8_t>(etherType >> 8);
+	frame[13] = static_cast<std::uint8_t>(etherType & 0xFF);
+	frame[14] = subType;
+	writeEntityID(frame, 18u, targetID);
+	writeEntityID(frame, 26u, controllerID);
+	return frame;
+}
+
+Frame makeAecpFrame(la::avdecc::UniqueIdentifier const targetID, la::avdecc::UniqueIdentifier const controllerID, bool const isMulticast = false)
+{
+	return makeFrame(la::avdecc::protocol::AvtpEtherType, 0x80 | la::avdecc::protocol::AvtpSubType_Aecp, isMulticast, targetID, controllerID);
+}
+} // namespace
+
+TEST(EntityFilter, AvdeccProgram)
+{
+	auto const program = la::avdecc::protocol::entityFilter::makeAvdeccProgram();
+
+	EXPECT_TRUE(runProgram(program, makeFrame(la::avdecc::protocol::AvtpEtherType, 0x80 | la::avdecc::protocol::AvtpSubType_Adp)));
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, RemoteEntityID)));
+	// AVTP stream frame
+	EXPECT_FALSE(runProgram(program, makeFrame(la::avdecc::protocol::AvtpEtherType, 0x00)));
+	// IPv4 frame
+	EXPECT_FALSE(runProgram(program, makeFrame(0x0800, 0x45)));
+}
+
+TEST(EntityFilter, LocalEntitiesProgram)
+{
+	auto const program = la::avdecc::protocol::entityFilter::makeLocalEntitiesProgram({ LocalEntityID, OtherEntityID });
+
+	// Not AVDECC
+	EXPECT_FALSE(runProgram(program, makeFrame(la::avdecc::protocol::AvtpEtherType, 0x00)));
+	EXPECT_FALSE(runProgram(program, makeFrame(0x0800, 0x45)));
+
+	// ADP and ACMP are always accepted
+	EXPECT_TRUE(runProgram(program, makeFrame(la::avdecc::protocol::AvtpEtherType, 0x80 | la::avdecc::protocol::AvtpSubType_Adp)));
+	EXPECT_TRUE(runProgram(program, makeFrame(la::avdecc::protocol::AvtpEtherType, 0x80 | la::avdecc::protocol::AvtpSubType_Acmp, false, RemoteEntityID)));
+
+	// AECP addressed to (or answering) one of our entities
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(LocalEntityID, RemoteEntityID)));
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(OtherEntityID, RemoteEntityID)));
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, LocalEntityID)));
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, OtherEntityID)));
+
+	// Multicast AECP and IDENTIFY notifications
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, RemoteEntityID, true)));
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, la::avdecc::protocol::AemAecpdu::Identify_ControllerEntityID)));
+
+	// AECP exchanged between other entities
+	EXPECT_FALSE(runProgram(program, makeAecpFrame(RemoteEntityID, RemoteEntityID)));
+	// Only the high part of the EntityID is matching
+	EXPECT_FALSE(runProgram(program, makeAecpFrame(la::avdecc::UniqueIdentifier{ 0x0001020300000000 }, RemoteEntityID)));
+}
+
+TEST(EntityFilter, NoLocalEntity)
+{
+	auto const program = la::avdecc::protocol::entityFilter::makeLocalEntitiesProgram({});
+
+	EXPECT_TRUE(runProgram(program, makeFrame(la::avdecc::protocol::AvtpEtherType, 0x80 | la::avdecc::protocol::AvtpSubType_Adp)));
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, la::avdecc::protocol::AemAecpdu::Identify_ControllerEntityID)));
+	EXPECT_FALSE(runProgram(program, makeAecpFrame(LocalEntityID, RemoteEntityID)));
+}
+
+TEST(EntityFilter, TooManyLocalEntities)
+{
+	auto entityIDs = std::vector<la::avdecc::UniqueIdentifier>{};
+	for (auto i = 0u; i < 100u; ++i)
+	{
+		entityIDs.push_back(la::avdecc::UniqueIdentifier{ LocalEntityID.getValue() + i });
+	}
+
+	// Jumps cannot be encoded anymore, falling back to AVDECC only filtering
+	auto const program = la::avdecc::protocol::entityFilter::makeLocalEntitiesProgram(entityIDs);
+	EXPECT_EQ(la::avdecc::protocol::entityFilter::makeAvdeccProgram().size(), program.size());
+	EXPECT_TRUE(runProgram(program, makeAecpFrame(RemoteEntityID, RemoteEntityID)));
+}
+
+TEST(EntityFilter, Accepts)
+{
+	auto const program = la::avdecc::protocol::entityFilter::makeLocalEntitiesProgram({ LocalEntityID });
+	auto const frames = std::vector<Frame>{
+		makeFrame(la::avdecc::protocol::AvtpEtherType, 0x80 | la::avdecc::protocol::AvtpSubType_Adp),
+		makeFrame(0x0800, 0x45),
+		makeAecpFrame(LocalEntityID, RemoteEntityID),
+		makeAecpFrame(RemoteEntityID, LocalEntityID),
+		makeAecpFrame(RemoteEntityID, RemoteEntityID),
+		makeAecpFrame(RemoteEntityID, RemoteEntityID, true),
+	};
+
+	// Userland interpreter must give the same verdict than the kernel would
+	for (auto const& frame : frames)
+	{
+		EXPECT_EQ(runProgram(program, frame), la::avdecc::protocol::entityFilter::accepts(program, frame.data(), frame.size()));
+	}
+
+	// Truncated frame
+	auto const frame = makeAecpFrame(LocalEntityID, RemoteEntityID);
+	EXPECT_FALSE(la::avdecc::protocol::entityFilter::accepts(program, frame.data(), 20u));
+}
@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameDecoder_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "protocolInterface/frameDecoder.hpp"
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace
+{
+using FrameDecoder = la::avdecc::protocol::FrameDecoder;
+
+/** Returns the current system time as a kernel timestamp (CLOCK_REALTIME, in nanoseconds) */
+std::chrono::nanoseconds getKernelNow() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+}
+
+/** Converts the kernel timestamp, checking the result is the current steady time (fallback for invalid timestamps) */
+void expectFallbackToNow(std::chrono::nanoseconds const realTime)
+{
+	auto const before = std::chrono::steady_clock::now();
+	auto const timestamp = FrameDecoder::fromKernelTimestamp(realTime);
+	auto const after = std::chrono::steady_clock::now();
+
+	EXPECT_LE(before, timestamp);
+	EXPECT_GE(after, timestamp);
+}
+} // namespace
+
+TEST(FrameDecoder, KernelTimestampRecent)
+{
+	auto const frameAge = std::chrono::milliseconds{ 100 };
+
+	auto const before = std::chrono::steady_clock::now();
+	auto const realTime = getKernelNow() - frameAge;
+	auto const timestamp = FrameDecoder::fromKernelTimestamp(realTime);
+	auto const after = std::chrono::steady_clock::now();
+
+	// The frame age is removed from the current steady time (which is somewhere between before and after)
+	EXPECT_LE(before - frameAge - (after - before), timestamp);
+	EXPECT_GE(after - frameAge, timestamp);
+}
+
+TEST(FrameDecoder, KernelTimestampNull)
+{
+	// No timestamp provided by the kernel
+	expectFallbackToNow(std::chrono::nanoseconds{ 0 });
+}
+
+TEST(FrameDecoder, KernelTimestampInTheFuture)
+{
+	// System clock adjusted backward since the frame was received
+	expectFallbackToNow(getKernelNow() + std::chrono::seconds{ 10 });
+}
+
+TEST(FrameDecoder, KernelTimestampTooOld)
+{
+	// System clock adjusted forward since the frame was received (or frame waited too long)
+	expectFallbackToNow(getKernelNow() - FrameDecoder::MaximumFrameAge - std::chrono::milliseconds{ 100 });
+}
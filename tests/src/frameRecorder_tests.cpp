@@ -0,0 +1,216 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameRecorder_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "protocolInterface/frameRecorder.hpp"
+#include "protocolInterface/protocolInterface_virtual.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct DumpedFrame
+{
+	std::uint32_t flags{ 0u };
+	std::vector<std::uint8_t> data{};
+};
+
+/** Dump file written in the current directory, deleted when going out of scope */
+class DumpFile final
+{
+public:
+	explicit DumpFile(std::string const& name)
+		: _path{ "avdecc_tests_" + name + ".pcapng" }
+	{
+	}
+
+	~DumpFile()
+	{
+		std::remove(_path.c_str());
+	}
+
+	std::string const& getPath() const noexcept
+	{
+		return _path;
+	}
+
+	/** Parses the Enhanced Packet Blocks of the file (written in native byte order) */
+	std::vector<DumpedFrame> readFrames() const
+	{
+		auto stream = std::ifstream{ _path, std::ios::binary };
+		auto const content = std::vector<std::uint8_t>{ std::istreambuf_iterator<char>{ stream }, std::istreambuf_iterator<char>{} };
+		auto frames = std::vector<DumpedFrame>{};
+
+		auto offset = std::size_t{ 0u };
+		while (offset + 12u <= content.size())
+		{
+			auto const blockType = readValue<std::uint32_t>(content, offset);
+			auto const blockLength = readValue<std::uint32_t>(content, offset + 4u);
+			if (blockLength < 12u || offset + blockLength > content.size())
+			{
+				break;
+			}
+			// Enhanced Packet Block with a single 'flags' option
+			if (blockType == 6u)
+			{
+				auto const capturedLength = readValue<std::uint32_t>(content, offset + 20u);
+				auto const dataOffset = offset + 28u;
+				auto const optionsOffset = dataOffset + ((capturedLength + 3u) & ~3u);
+				auto frame = DumpedFrame{};
+				frame.data.assign(content.begin() + dataOffset, content.begin() + dataOffset + capturedLength);
+				if (readValue<std::uint16_t>(content, optionsOffset) == 2u)
+				{
+					frame.flags = readValue<std::uint32_t>(content, optionsOffset + 4u);
+				}
+				frames.push_back(std::move(frame));
+			}
+			offset += blockLength;
+		}
+
+		return frames;
+	}
+
+private:
+	template<typename T>
+	static T readValue(std::vector<std::uint8_t> const& content, std::size_t const offset)
+	{
+		auto value = T{};
+		std::memcpy(&value, content.data() + offset, sizeof(value));
+		return value;
+	}
+
+	std::string _path{};
+};
+
+std::vector<std::uint8_t> makeFrame(std::size_t const length, std::uint8_t const value)
+{
+	return std::vector<std::uint8_t>(length, value);
+}
+} // namespace
+
+TEST(FrameRecorder, DumpRecordedFrames)
+{
+	auto recorder = la::avdecc::protocol::FrameRecorder{ 0u };
+	auto const dumpFile = DumpFile{ "FrameRecorder_DumpRecordedFrames" };
+
+	auto const frame1 = makeFrame(60u, 1u);
+	auto const frame2 = makeFrame(61u, 2u);
+	recorder.record(la::avdecc::protocol::FrameRecorder::Direction::Received, frame1.data(), frame1.size());
+	recorder.record(la::avdecc::protocol::FrameRecorder::Direction::Sent, frame2.data(), frame2.size());
+	// Not recorded: empty and oversized frames
+	recorder.record(la::avdecc::protocol::FrameRecorder::Direction::Sent, frame2.data(), 0u);
+	auto const oversized = makeFrame(la::avdecc::protocol::EthernetMaxFrameSize + 1u, 3u);
+	recorder.record(la::avdecc::protocol::FrameRecorder::Direction::Sent, oversized.data(), oversized.size());
+
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, recorder.dump(dumpFile.getPath()));
+
+	auto const frames = dumpFile.readFrames();
+	ASSERT_EQ(2u, frames.size());
+	EXPECT_EQ(1u, frames[0].flags);
+	EXPECT_EQ(frame1, frames[0].data);
+	EXPECT_EQ(2u, frames[1].flags);
+	EXPECT_EQ(frame2, frames[1].data);
+}
+
+TEST(FrameRecorder, OldestFramesOverwritten)
+{
+	auto recorder = la::avdecc::protocol::FrameRecorder{ 0u };
+	auto const dumpFile = DumpFile{ "FrameRecorder_OldestFramesOverwritten" };
+
+	// Record much more than the ring can hold, with frames wrapping around the end of the data ring
+	auto constexpr FramesCount = 5000u;
+	for (auto i = 0u; i < FramesCount; ++i)
+	{
+		auto const frame = makeFrame(100u, static_cast<std::uint8_t>(i));
+		recorder.record(la::avdecc::protocol::FrameRecorder::Direction::Sent, frame.data(), frame.size());
+	}
+
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, recorder.dump(dumpFile.getPath()));
+
+	auto const frames = dumpFile.readFrames();
+	ASSERT_FALSE(frames.empty());
+	EXPECT_GT(FramesCount, frames.size());
+
+	// Only the most recent frames are dumped, in order
+	auto expectedValue = static_cast<std::uint8_t>(FramesCount - frames.size());
+	for (auto const& frame : frames)
+	{
+		EXPECT_EQ(makeFrame(100u, expectedValue), frame.data);
+		++expectedValue;
+	}
+}
+
+TEST(FrameRecorder, InvalidDumpPath)
+{
+	auto recorder = la::avdecc::protocol::FrameRecorder{ 0u };
+
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::InvalidParameters, recorder.dump("invalid_directory/invalid_file.pcapng"));
+}
+
+TEST(FrameRecorder, ProtocolInterfaceRecorder)
+{
+	auto intfc = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("FrameRecorderInterface", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto const dumpFile = DumpFile{ "FrameRecorder_ProtocolInterfaceRecorder" };
+
+	// Not enabled yet
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::InvalidParameters, intfc->dumpRecordedFrames(dumpFile.getPath()));
+
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->enableFrameRecorder(128u * 1024u, {}));
+	// The ring cannot be resized
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::InvalidParameters, intfc->enableFrameRecorder(256u * 1024u, {}));
+
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	adpdu.setSrcAddress(intfc->getMacAddress());
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityDiscover);
+	adpdu.setEntityID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->sendAdpMessage(adpdu));
+
+	// Not recorded while disabled
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->disableFrameRecorder());
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->sendAdpMessage(adpdu));
+
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->dumpRecordedFrames(dumpFile.getPath()));
+
+	// The virtual interface might also have received its own frame back, only check the sent ones
+	auto sentFrames = std::vector<DumpedFrame>{};
+	for (auto const& frame : dumpFile.readFrames())
+	{
+		if (frame.flags == 2u)
+		{
+			sentFrames.push_back(frame);
+		}
+	}
+	ASSERT_EQ(1u, sentFrames.size());
+	ASSERT_LE(la::avdecc::protocol::EthernetPayloadMinimumSize + la::avdecc::protocol::EtherLayer2::HeaderLength, sentFrames[0].data.size());
+	auto const& multicastMacAddress = la::avdecc::protocol::Adpdu::Multicast_Mac_Address;
+	EXPECT_EQ(0, std::memcmp(multicastMacAddress.data(), sentFrames[0].data.data(), multicastMacAddress.size()));
+}
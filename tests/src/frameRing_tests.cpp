@@ -0,0 +1,144 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file frameRing_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "protocolInterface/frameRing.hpp"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST(FrameRing, PushPeekRelease)
+{
+	auto ring = la::avdecc::protocol::FrameRing{};
+	EXPECT_TRUE(ring.empty());
+
+	auto const data = std::array<std::uint8_t, 3>{ 1u, 2u, 3u };
+	EXPECT_TRUE(ring.tryPush(data.data(), data.size()));
+	EXPECT_TRUE(ring.tryPush(data.data(), 1u));
+	EXPECT_FALSE(ring.empty());
+
+	auto frames = std::array<la::avdecc::protocol::FrameRing::Frame const*, 4>{};
+	ASSERT_EQ(2u, ring.peek(frames.data(), frames.size()));
+	EXPECT_EQ(3u, frames[0]->length);
+	EXPECT_EQ(0, std::memcmp(data.data(), frames[0]->data.data(), data.size()));
+	EXPECT_EQ(1u, frames[1]->length);
+
+	// Frames are not released until release is called
+	EXPECT_EQ(2u, ring.peek(frames.data(), frames.size()));
+	ring.release(1u);
+	ASSERT_EQ(1u, ring.peek(frames.data(), frames.size()));
+	EXPECT_EQ(1u, frames[0]->length);
+	ring.release(1u);
+	EXPECT_TRUE(ring.empty());
+
+	// Too big frame
+	auto const bigFrame = std::vector<std::uint8_t>(la::avdecc::protocol::EthernetMaxFrameSize + 1u);
+	EXPECT_FALSE(ring.tryPush(bigFrame.data(), bigFrame.size()));
+}
+
+TEST(FrameRing, Full)
+{
+	auto ring = la::avdecc::protocol::FrameRing{};
+	auto const data = std::uint8_t{ 0u };
+
+	for (auto index = std::size_t{ 0u }; index < la::avdecc::protocol::FrameRing::Capacity; ++index)
+	{
+		EXPECT_TRUE(ring.tryPush(&data, 1u));
+	}
+	EXPECT_FALSE(ring.tryPush(&data, 1u));
+
+	// Releasing a slot makes room for one frame
+	auto const* frame = static_cast<la::avdecc::protocol::FrameRing::Frame const*>(nullptr);
+	ASSERT_EQ(1u, ring.peek(&frame, 1u));
+	ring.release(1u);
+	EXPECT_TRUE(ring.tryPush(&data, 1u));
+	EXPECT_FALSE(ring.tryPush(&data, 1u));
+}
+
+// Several producers push frames to a single consumer, which checks the frames of each producer are received in order.
+TEST(FrameRing, MultipleProducers)
+{
+	constexpr auto ProducersCount = std::size_t{ 4u };
+	constexpr auto FramesPerProducer = std::uint32_t{ 250000u };
+	constexpr auto FrameSize = std::size_t{ 64u };
+
+	auto ring = la::avdecc::protocol::FrameRing{};
+	auto nextExpected = std::array<std::uint32_t, ProducersCount>{};
+	auto outOfOrder = std::size_t{ 0u };
+
+	auto producers = std::vector<std::thread>{};
+	for (auto producer = std::size_t{ 0u }; producer < ProducersCount; ++producer)
+	{
+		producers.emplace_back(
+			[&ring, producer]
+			{
+				auto frame = std::array<std::uint8_t, FrameSize>{};
+				frame[0] = static_cast<std::uint8_t>(producer);
+				for (auto sequence = std::uint32_t{ 0u }; sequence < FramesPerProducer; ++sequence)
+				{
+					std::memcpy(&frame[1], &sequence, sizeof(sequence));
+					while (!ring.tryPush(frame.data(), frame.size()))
+					{
+						std::this_thread::yield();
+					}
+				}
+			});
+	}
+
+	auto received = std::size_t{ 0u };
+	auto frames = std::array<la::avdecc::protocol::FrameRing::Frame const*, 32>{};
+	while (received < ProducersCount * FramesPerProducer)
+	{
+		auto const count = ring.peek(frames.data(), frames.size());
+		for (auto index = std::size_t{ 0u }; index < count; ++index)
+		{
+			auto const producer = frames[index]->data[0];
+			auto sequence = std::uint32_t{ 0u };
+			std::memcpy(&sequence, &frames[index]->data[1], sizeof(sequence));
+			if (sequence != nextExpected[producer])
+			{
+				++outOfOrder;
+			}
+			nextExpected[producer] = sequence + 1u;
+		}
+		ring.release(count);
+		received += count;
+		if (count == 0u)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+
+	EXPECT_EQ(0u, outOfOrder);
+	EXPECT_TRUE(ring.empty());
+}
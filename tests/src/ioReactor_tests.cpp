@@ -0,0 +1,238 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file ioReactor_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "ioReactor.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+/** Non-blocking eventfd, closed when going out of scope */
+class EventFd final
+{
+public:
+	EventFd()
+		: _fd{ eventfd(0u, EFD_NONBLOCK | EFD_CLOEXEC) }
+	{
+	}
+
+	~EventFd()
+	{
+		close(_fd);
+	}
+
+	int getFd() const noexcept
+	{
+		return _fd;
+	}
+
+	void signal() const noexcept
+	{
+		auto const value = std::uint64_t{ 1u };
+		[[maybe_unused]] auto const ret = write(_fd, &value, sizeof(value));
+	}
+
+	void acknowledge() const noexcept
+	{
+		auto value = std::uint64_t{ 0u };
+		[[maybe_unused]] auto const ret = read(_fd, &value, sizeof(value));
+	}
+
+private:
+	int _fd{ -1 };
+};
+} // namespace
+
+TEST(IoReactor, Reader)
+{
+	auto const reactor = la::avdecc::IoReactor::getInstance();
+	auto const event = EventFd{};
+	auto promise = std::promise<std::thread::id>{};
+	auto readCount = std::atomic<std::uint32_t>{ 0u };
+
+	auto const handle = reactor->addReader(event.getFd(),
+		[&event, &promise, &readCount](bool const hasError)
+		{
+			EXPECT_FALSE(hasError);
+			event.acknowledge();
+			if (++readCount == 1u)
+			{
+				promise.set_value(std::this_thread::get_id());
+			}
+		});
+	ASSERT_NE(la::avdecc::IoReactor::InvalidHandle, handle);
+
+	event.signal();
+	auto future = promise.get_future();
+	ASSERT_EQ(std::future_status::ready, future.wait_for(std::chrono::seconds{ 1 }));
+	EXPECT_NE(std::this_thread::get_id(), future.get());
+
+	// Handler is never called once removed
+	reactor->remove(handle);
+	auto const count = readCount.load();
+	event.signal();
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	EXPECT_EQ(count, readCount);
+
+	// Removing twice is harmless
+	reactor->remove(handle);
+	reactor->remove(la::avdecc::IoReactor::InvalidHandle);
+}
+
+TEST(IoReactor, Timer)
+{
+	auto const reactor = la::avdecc::IoReactor::getInstance();
+	auto promise = std::promise<void>{};
+	auto tickCount = std::atomic<std::uint32_t>{ 0u };
+
+	auto const handle = reactor->addTimer(std::chrono::milliseconds{ 5u },
+		[&promise, &tickCount]
+		{
+			if (++tickCount == 3u)
+			{
+				promise.set_value();
+			}
+		});
+	ASSERT_NE(la::avdecc::IoReactor::InvalidHandle, handle);
+
+	EXPECT_EQ(std::future_status::ready, promise.get_future().wait_for(std::chrono::seconds{ 1 }));
+
+	reactor->remove(handle);
+	auto const count = tickCount.load();
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	EXPECT_EQ(count, tickCount);
+}
+
+TEST(IoReactor, RemoveFromHandler)
+{
+	auto const reactor = la::avdecc::IoReactor::getInstance();
+	auto promise = std::promise<void>{};
+	auto handle = std::atomic<la::avdecc::IoReactor::Handle>{ la::avdecc::IoReactor::InvalidHandle };
+	auto tickCount = std::atomic<std::uint32_t>{ 0u };
+
+	// Handlers are called one at a time, so the timer cannot be handled before the handle is stored when registering from another handler
+	auto const event = EventFd{};
+	auto const registerHandle = reactor->addReader(event.getFd(),
+		[&](bool const /*hasError*/)
+		{
+			event.acknowledge();
+			handle = reactor->addTimer(std::chrono::milliseconds{ 1u },
+				[&]
+				{
+					++tickCount;
+					reactor->remove(handle);
+					promise.set_value();
+				});
+		});
+	ASSERT_NE(la::avdecc::IoReactor::InvalidHandle, registerHandle);
+
+	event.signal();
+	EXPECT_EQ(std::future_status::ready, promise.get_future().wait_for(std::chrono::seconds{ 1 }));
+	reactor->remove(registerHandle);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+	EXPECT_EQ(1u, tickCount);
+}
+
+TEST(IoReactor, InvalidDescriptor)
+{
+	auto const reactor = la::avdecc::IoReactor::getInstance();
+
+	EXPECT_EQ(la::avdecc::IoReactor::InvalidHandle, reactor->addReader(-1, [](bool const) {}));
+}
+
+TEST(IoReactor, RemoveWaitsForRunningHandler)
+{
+	auto const reactor = la::avdecc::IoReactor::getInstance();
+	auto const event = EventFd{};
+	auto entered = std::promise<void>{};
+	auto isCompleted = std::atomic_bool{ false };
+
+	auto const handle = reactor->addReader(event.getFd(),
+		[&](bool const /*hasError*/)
+		{
+			event.acknowledge();
+			entered.set_value();
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+			isCompleted = true;
+		});
+	ASSERT_NE(la::avdecc::IoReactor::InvalidHandle, handle);
+
+	event.signal();
+	ASSERT_EQ(std::future_status::ready, entered.get_future().wait_for(std::chrono::seconds{ 1 }));
+
+	// The handler is running, remove must return only once it completed
+	reactor->remove(handle);
+	EXPECT_TRUE(isCompleted);
+}
+
+TEST(IoReactor, RemoveWhileAnotherHandlerWaitsForLock)
+{
+	auto const reactor = la::avdecc::IoReactor::getInstance();
+	auto const blockedEvent = EventFd{};
+	auto const otherEvent = EventFd{};
+	auto lock = std::mutex{};
+	auto entered = std::promise<void>{};
+
+	// Handler taking a lock held by the thread removing another source (like a state machines handler and a ProtocolInterface being destroyed)
+	auto const blockedHandle = reactor->addReader(blockedEvent.getFd(),
+		[&](bool const /*hasError*/)
+		{
+			blockedEvent.acknowledge();
+			entered.set_value();
+			auto const lg = std::lock_guard{ lock };
+		});
+	auto const otherHandle = reactor->addReader(otherEvent.getFd(), [](bool const /*hasError*/) {});
+	ASSERT_NE(la::avdecc::IoReactor::InvalidHandle, blockedHandle);
+	ASSERT_NE(la::avdecc::IoReactor::InvalidHandle, otherHandle);
+
+	auto removed = std::future<void>{}; // Declared before the lock guard, so the lock is released before waiting for the future on destruction
+	auto removeStatus = std::future_status::timeout;
+	{
+		auto const lg = std::lock_guard{ lock };
+		blockedEvent.signal();
+		ASSERT_EQ(std::future_status::ready, entered.get_future().wait_for(std::chrono::seconds{ 1 }));
+
+		// Removing the other source must not wait for the blocked handler
+		removed = std::async(std::launch::async,
+			[&reactor, otherHandle]
+			{
+				reactor->remove(otherHandle);
+			});
+		removeStatus = removed.wait_for(std::chrono::seconds{ 1 });
+		// Releasing the lock (even if remove is stuck), so the test does not hang
+	}
+	EXPECT_EQ(std::future_status::ready, removeStatus);
+
+	reactor->remove(blockedHandle);
+}
@@ -0,0 +1,78 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file pduPool_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "protocolInterface/pduPool.hpp"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+TEST(PduPool, RecycleReleasedPdu)
+{
+	auto pool = la::avdecc::protocol::PduPool<la::avdecc::protocol::AemAecpdu>{};
+
+	auto* firstAddress = static_cast<la::avdecc::protocol::Aecpdu*>(nullptr);
+	{
+		auto pdu = pool.acquire(true);
+		firstAddress = pdu.get();
+		EXPECT_EQ(la::avdecc::protocol::AecpMessageType::AemResponse, pdu->getMessageType());
+	}
+	EXPECT_EQ(0u, pool.getHits());
+	EXPECT_EQ(1u, pool.getMisses());
+
+	// Released memory must be reused
+	{
+		auto pdu = pool.acquire(false);
+		EXPECT_EQ(firstAddress, pdu.get());
+	}
+	EXPECT_EQ(1u, pool.getHits());
+	EXPECT_EQ(1u, pool.getMisses());
+
+	// Two PDUs in use at the same time
+	{
+		auto pdu1 = pool.acquire(false);
+		auto pdu2 = pool.acquire(false);
+		EXPECT_NE(pdu1.get(), pdu2.get());
+	}
+	EXPECT_EQ(2u, pool.getHits());
+	EXPECT_EQ(2u, pool.getMisses());
+}
+
+TEST(PduPool, ReleaseFromAnotherThread)
+{
+	auto pool = la::avdecc::protocol::PduPool<la::avdecc::protocol::Adpdu>{};
+
+	for (auto i = 0u; i < 100u; ++i)
+	{
+		auto pdu = pool.acquire();
+		auto releaseThread = std::thread(
+			[pdu = std::move(pdu)]() mutable
+			{
+				pdu.reset();
+			});
+		releaseThread.join();
+	}
+	EXPECT_EQ(99u, pool.getHits());
+	EXPECT_EQ(1u, pool.getMisses());
+}
@@ -0,0 +1,265 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_pcapReplay_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Public API
+#include <la/avdecc/internals/serialization.hpp>
+#include <la/avdecc/internals/protocolAemAecpdu.hpp>
+
+// Internal API
+#include "protocolInterface/protocolInterface_pcapReplay.hpp"
+
+#include <gtest/gtest.h>
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+namespace
+{
+using Frame = std::vector<std::uint8_t>;
+
+/** Capture file written in the current directory, deleted when going out of scope */
+class CaptureFile final
+{
+public:
+	CaptureFile(std::string const& name, std::vector<Frame> const& frames)
+		: _path{ "avdecc_tests_" + name + ".pcap" }
+	{
+		auto stream = std::ofstream{ _path, std::ios::binary };
+
+		// Classic pcap global header (native byte order, microseconds resolution, ethernet link type)
+		writeValue(stream, std::uint32_t{ 0xa1b2c3d4 });
+		writeValue(stream, std::uint16_t{ 2u });
+		writeValue(stream, std::uint16_t{ 4u });
+		writeValue(stream, std::int32_t{ 0 });
+		writeValue(stream, std::uint32_t{ 0u });
+		writeValue(stream, std::uint32_t{ 65535u });
+		writeValue(stream, std::uint32_t{ 1u });
+
+		// One frame every millisecond
+		auto timestamp = std::uint32_t{ 0u };
+		for (auto const& frame : frames)
+		{
+			writeValue(stream, std::uint32_t{ 1000u });
+			writeValue(stream, timestamp);
+			writeValue(stream, static_cast<std::uint32_t>(frame.size()));
+			writeValue(stream, static_cast<std::uint32_t>(frame.size()));
+			stream.write(reinterpret_cast<char const*>(frame.data()), frame.size());
+			timestamp += 1000u;
+		}
+	}
+
+	~CaptureFile()
+	{
+		std::remove(_path.c_str());
+	}
+
+	std::string const& getPath() const noexcept
+	{
+		return _path;
+	}
+
+private:
+	template<typename T>
+	static void writeValue(std::ofstream& stream, T const value)
+	{
+		stream.write(reinterpret_cast<char const*>(&value), sizeof(value));
+	}
+
+	std::string _path{};
+};
+
+template<class PduType>
+Frame serializeFrame(PduType const& pdu)
+{
+	auto buffer = la::avdecc::protocol::SerializationBuffer{};
+	la::avdecc::protocol::serialize<la::avdecc::protocol::EtherLayer2>(pdu, buffer);
+	la::avdecc::protocol::serialize<la::avdecc::protocol::AvtpduControl>(pdu, buffer);
+	la::avdecc::protocol::serialize<PduType>(pdu, buffer);
+
+	auto frame = Frame{ buffer.data(), buffer.data() + buffer.size() };
+	frame.resize(std::max(frame.size(), la::avdecc::protocol::EthernetPayloadMinimumSize + la::avdecc::protocol::EtherLayer2::HeaderLength));
+	return frame;
+}
+
+Frame buildEntityAvailable(la::avdecc::networkInterface::MacAddress const& srcAddress, la::avdecc::UniqueIdentifier const entityID, std::uint32_t const availableIndex = 1u)
+{
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	// Set Ether2 fields
+	adpdu.setSrcAddress(srcAddress);
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	// Set ADP fields
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	adpdu.setValidTime(10);
+	adpdu.setEntityID(entityID);
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setEntityCapabilities({});
+	adpdu.setTalkerStreamSources(0);
+	adpdu.setTalkerCapabilities({});
+	adpdu.setListenerStreamSinks(0);
+	adpdu.setListenerCapabilities({});
+	adpdu.setControllerCapabilities({});
+	adpdu.setAvailableIndex(availableIndex);
+	adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setGptpDomainNumber(0);
+	adpdu.setIdentifyControlIndex(0);
+	adpdu.setInterfaceIndex(0);
+	adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+	return serializeFrame(adpdu);
+}
+
+la::avdecc::protocol::Aecpdu::UniquePointer buildReadEntityDescriptor(bool const isResponse, la::avdecc::networkInterface::MacAddress const& srcAddress, la::avdecc::networkInterface::MacAddress const& destAddress, la::avdecc::UniqueIdentifier const targetID, la::avdecc::UniqueIdentifier const controllerID, la::avdecc::protocol::AecpSequenceID const sequenceID, std::uint8_t const configurationIndex)
+{
+	auto aecpdu = la::avdecc::protocol::AemAecpdu::create(isResponse);
+	auto& aem = static_cast<la::avdecc::protocol::AemAecpdu&>(*aecpdu);
+
+	// Set Ether2 fields
+	aem.setSrcAddress(srcAddress);
+	aem.setDestAddress(destAddress);
+	// Set AECP fields
+	aem.setStatus(la::avdecc::protocol::AecpStatus::Success);
+	aem.setTargetEntityID(targetID);
+	aem.setControllerEntityID(controllerID);
+	aem.setSequenceID(sequenceID);
+	// Set AEM fields
+	aem.setUnsolicited(false);
+	aem.setCommandType(la::avdecc::protocol::AemCommandType::ReadDescriptor);
+	// ConfigurationIndex, Reserved, DescriptorType (ENTITY), DescriptorIndex (plus some descriptor data for the response)
+	auto const payload = std::vector<std::uint8_t>{ 0u, configurationIndex, 0u, 0u, 0u, 0u, 0u, 0u, 0xca, 0xfe };
+	aem.setCommandSpecificData(payload.data(), isResponse ? payload.size() : 8u);
+
+	return aecpdu;
+}
+} // namespace
+
+TEST(ProtocolInterfacePcapReplay, InvalidFile)
+{
+	// Not using EXPECT_THROW, we want to check the error code inside our custom exception
+	try
+	{
+		std::unique_ptr<la::avdecc::protocol::ProtocolInterfacePcapReplay>(la::avdecc::protocol::ProtocolInterfacePcapReplay::createRawProtocolInterfacePcapReplay("avdecc_tests_MissingFile.pcap", la::avdecc::protocol::ProtocolInterfacePcapReplay::DefaultMacAddress, la::avdecc::protocol::ProtocolInterfacePcapReplay::ReplayMode::AsFastAsPossible));
+		EXPECT_FALSE(true); // We expect an exception to have been raised
+	}
+	catch (la::avdecc::protocol::ProtocolInterface::Exception const& e)
+	{
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::InterfaceNotFound, e.getError());
+	}
+}
+
+TEST(ProtocolInterfacePcapReplay, ReplayDiscovery)
+{
+	class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+	{
+	public:
+		std::size_t getOnlineCount() const noexcept
+		{
+			return _onlineCount;
+		}
+
+	private:
+		virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept override
+		{
+			++_onlineCount;
+		}
+		std::atomic<std::size_t> _onlineCount{ 0u };
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	auto frames = std::vector<Frame>{};
+	frames.push_back(buildEntityAvailable({ { 0x02, 0x01, 0x00, 0x00, 0x00, 0x01 } }, la::avdecc::UniqueIdentifier{ 0x0001000000000001 }));
+	frames.push_back(Frame(60u, 0u)); // Not an AVDECC frame, should be ignored
+	frames.push_back(buildEntityAvailable({ { 0x02, 0x01, 0x00, 0x00, 0x00, 0x02 } }, la::avdecc::UniqueIdentifier{ 0x0001000000000002 }));
+	frames.push_back(buildEntityAvailable({ { 0x02, 0x01, 0x00, 0x00, 0x00, 0x01 } }, la::avdecc::UniqueIdentifier{ 0x0001000000000001 }, 2u)); // Same entity advertising again
+	auto const captureFile = CaptureFile{ "ReplayDiscovery", frames };
+
+	auto obs = Observer{};
+	auto intfc = std::unique_ptr<la::avdecc::protocol::ProtocolInterfacePcapReplay>(la::avdecc::protocol::ProtocolInterfacePcapReplay::createRawProtocolInterfacePcapReplay(captureFile.getPath(), la::avdecc::protocol::ProtocolInterfacePcapReplay::DefaultMacAddress, la::avdecc::protocol::ProtocolInterfacePcapReplay::ReplayMode::AsFastAsPossible));
+	intfc->registerObserver(&obs);
+
+	ASSERT_TRUE(intfc->waitForCompletion(std::chrono::milliseconds{ 2000u }));
+	EXPECT_EQ(3u, intfc->getReplayStatistics().replayedFrames);
+	EXPECT_EQ(2u, obs.getOnlineCount());
+}
+
+TEST(ProtocolInterfacePcapReplay, AnswerRecordedCommand)
+{
+	static auto constexpr RecordedControllerMacAddress = la::avdecc::networkInterface::MacAddress{ { 0x02, 0x03, 0x00, 0x00, 0x00, 0x01 } };
+	static auto constexpr EntityMacAddress = la::avdecc::networkInterface::MacAddress{ { 0x02, 0x01, 0x00, 0x00, 0x00, 0x01 } };
+	static auto constexpr EntityID = la::avdecc::UniqueIdentifier{ 0x0001000000000001 };
+	static auto constexpr RecordedControllerID = la::avdecc::UniqueIdentifier{ 0x0003000000000001 };
+	static auto constexpr ControllerID = la::avdecc::UniqueIdentifier{ 0x0004000000000001 };
+
+	class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+	{
+	public:
+		std::promise<la::avdecc::protocol::AecpSequenceID>& getPromise() noexcept
+		{
+			return _promise;
+		}
+
+	private:
+		virtual void onAecpduReceived(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::protocol::Aecpdu const& aecpdu) noexcept override
+		{
+			// Only interested in responses to our own controller
+			if (aecpdu.getMessageType() == la::avdecc::protocol::AecpMessageType::AemResponse && aecpdu.getControllerEntityID() == ControllerID)
+			{
+				_promise.set_value(aecpdu.getSequenceID());
+			}
+		}
+		std::promise<la::avdecc::protocol::AecpSequenceID> _promise{};
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	// Record a READ_DESCRIPTOR command from another controller, and the entity's response
+	auto frames = std::vector<Frame>{};
+	frames.push_back(buildEntityAvailable(EntityMacAddress, EntityID));
+	frames.push_back(serializeFrame(static_cast<la::avdecc::protocol::Aecpdu const&>(*buildReadEntityDescriptor(false, RecordedControllerMacAddress, EntityMacAddress, EntityID, RecordedControllerID, 5u, 0u))));
+	frames.push_back(serializeFrame(static_cast<la::avdecc::protocol::Aecpdu const&>(*buildReadEntityDescriptor(true, EntityMacAddress, RecordedControllerMacAddress, EntityID, RecordedControllerID, 5u, 0u))));
+	auto const captureFile = CaptureFile{ "AnswerRecordedCommand", frames };
+
+	auto obs = Observer{};
+	auto intfc = std::unique_ptr<la::avdecc::protocol::ProtocolInterfacePcapReplay>(la::avdecc::protocol::ProtocolInterfacePcapReplay::createRawProtocolInterfacePcapReplay(captureFile.getPath(), la::avdecc::protocol::ProtocolInterfacePcapReplay::DefaultMacAddress, la::avdecc::protocol::ProtocolInterfacePcapReplay::ReplayMode::AsFastAsPossible));
+	intfc->registerObserver(&obs);
+	ASSERT_TRUE(intfc->waitForCompletion(std::chrono::milliseconds{ 2000u }));
+
+	// Same command from our own controller: answered from the capture, with our ControllerID and SequenceID
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->sendAecpMessage(*buildReadEntityDescriptor(false, intfc->getMacAddress(), EntityMacAddress, EntityID, ControllerID, 42u, 0u)));
+	auto future = obs.getPromise().get_future();
+	ASSERT_NE(std::future_status::timeout, future.wait_for(std::chrono::milliseconds{ 500u }));
+	EXPECT_EQ(42u, future.get());
+
+	// Command not found in the capture (other configuration)
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc->sendAecpMessage(*buildReadEntityDescriptor(false, intfc->getMacAddress(), EntityMacAddress, EntityID, ControllerID, 43u, 1u)));
+
+	auto const statistics = intfc->getReplayStatistics();
+	EXPECT_EQ(1u, statistics.answeredCommands);
+	EXPECT_EQ(1u, statistics.unansweredCommands);
+	EXPECT_EQ(2u, intfc->getTransmitQueueStatistics().sentFrames);
+}
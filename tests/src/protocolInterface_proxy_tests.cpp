@@ -0,0 +1,317 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_proxy_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Public API
+#include <la/avdecc/internals/proxyServer.hpp>
+#include <la/avdecc/internals/protocolAemAecpdu.hpp>
+
+// Internal API
+#include "protocolInterface/protocolInterface_proxy.hpp"
+#include "protocolInterface/protocolInterface_virtual.hpp"
+#include "protocolInterface/proxyProtocol.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <array>
+#include <cstring>
+#include <future>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr auto PeerMacAddress = la::avdecc::networkInterface::MacAddress{ { 0x00, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e } };
+
+// Each test uses its own virtual network and socket, so concurrent test runs don't see each other
+std::string getNetworkName(std::string const& testName)
+{
+	return "ProxyTests_" + testName + "_" + std::to_string(::getpid());
+}
+
+std::string getAddress(std::string const& networkName)
+{
+	return "unix:/tmp/avdecc-" + networkName + ".sock";
+}
+
+la::avdecc::protocol::Adpdu buildEntityAvailable(la::avdecc::networkInterface::MacAddress const& srcAddress, la::avdecc::UniqueIdentifier const entityID)
+{
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	// Set Ether2 fields
+	adpdu.setSrcAddress(srcAddress);
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	// Set ADP fields
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	adpdu.setValidTime(2);
+	adpdu.setEntityID(entityID);
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setEntityCapabilities({});
+	adpdu.setTalkerStreamSources(0);
+	adpdu.setTalkerCapabilities({});
+	adpdu.setListenerStreamSinks(0);
+	adpdu.setListenerCapabilities({});
+	adpdu.setControllerCapabilities(la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented });
+	adpdu.setAvailableIndex(1);
+	adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setGptpDomainNumber(0);
+	adpdu.setIdentifyControlIndex(0);
+	adpdu.setInterfaceIndex(0);
+	adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+	return adpdu;
+}
+
+la::avdecc::protocol::Aecpdu::UniquePointer buildAemCommand(la::avdecc::networkInterface::MacAddress const& srcAddress, la::avdecc::networkInterface::MacAddress const& destAddress, la::avdecc::UniqueIdentifier const targetID, la::avdecc::UniqueIdentifier const controllerID)
+{
+	auto aecpdu = la::avdecc::protocol::AemAecpdu::create(false);
+	auto& aem = static_cast<la::avdecc::protocol::AemAecpdu&>(*aecpdu);
+
+	// Set Ether2 fields
+	aem.setSrcAddress(srcAddress);
+	aem.setDestAddress(destAddress);
+	// Set AECP fields
+	aem.setStatus(la::avdecc::protocol::AecpStatus::Success);
+	aem.setTargetEntityID(targetID);
+	aem.setControllerEntityID(controllerID);
+	aem.setSequenceID(1);
+	// Set AEM fields
+	aem.setUnsolicited(false);
+	aem.setCommandType(la::avdecc::protocol::AemCommandType::ReadDescriptor);
+	return aecpdu;
+}
+
+class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+{
+public:
+	/** Returns a future set when the specified entity is discovered */
+	std::future<void> waitForEntity(la::avdecc::UniqueIdentifier const entityID)
+	{
+		auto const lg = std::lock_guard{ _lock };
+		_expectedEntityID = entityID;
+		_promise = std::promise<void>{};
+		return _promise.get_future();
+	}
+
+	std::size_t getReceivedAecpdus() const
+	{
+		auto const lg = std::lock_guard{ _lock };
+		return _receivedAecpdus;
+	}
+
+private:
+	virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& entity) noexcept override
+	{
+		auto const lg = std::lock_guard{ _lock };
+		if (entity.getEntityID() == _expectedEntityID)
+		{
+			_promise.set_value();
+		}
+	}
+	virtual void onAecpduReceived(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::protocol::Aecpdu const& /*aecpdu*/) noexcept override
+	{
+		auto const lg = std::lock_guard{ _lock };
+		++_receivedAecpdus;
+	}
+
+	mutable std::mutex _lock{};
+	la::avdecc::UniqueIdentifier _expectedEntityID{};
+	std::promise<void> _promise{};
+	std::size_t _receivedAecpdus{ 0u };
+	DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+};
+
+using ProxyPointer = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceProxy>;
+using VirtualPointer = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>;
+} // namespace
+
+TEST(ProtocolInterfaceProxy, NoServer)
+{
+	// Not using EXPECT_THROW, we want to check the error code inside our custom exception
+	try
+	{
+		ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(getNetworkName("NoServer"))));
+		EXPECT_FALSE(true); // We expect an exception to have been raised
+	}
+	catch (la::avdecc::protocol::ProtocolInterface::Exception const& e)
+	{
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::TransportError, e.getError());
+	}
+}
+
+TEST(ProtocolInterfaceProxy, InvalidAddress)
+{
+	EXPECT_THROW(la::avdecc::protocol::ProxyServer::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, getNetworkName("InvalidAddress"), "unix:"), la::avdecc::protocol::ProtocolInterface::Exception);
+}
+
+TEST(ProtocolInterfaceProxy, ReceiveFromNetwork)
+{
+	auto const networkName = getNetworkName("ReceiveFromNetwork");
+	auto const server = la::avdecc::protocol::ProxyServer::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, networkName, getAddress(networkName));
+	auto const peer = VirtualPointer(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, PeerMacAddress));
+	auto const client = ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(networkName)));
+
+	// All clients share the MAC address of the served interface
+	EXPECT_EQ(server->getProtocolInterface().getMacAddress(), client->getMacAddress());
+
+	auto obs = Observer{};
+	client->registerObserver(&obs);
+	auto future = obs.waitForEntity(la::avdecc::UniqueIdentifier{ 0x0001020304050607 });
+
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAdpMessage(buildEntityAvailable(PeerMacAddress, la::avdecc::UniqueIdentifier{ 0x0001020304050607 })));
+	ASSERT_NE(std::future_status::timeout, future.wait_for(std::chrono::seconds(1)));
+
+	auto const statistics = server->getStatistics();
+	EXPECT_LE(1u, statistics.receivedFrames);
+	EXPECT_LE(1u, statistics.forwardedFrames);
+	client->unregisterObserver(&obs);
+}
+
+TEST(ProtocolInterfaceProxy, SendToNetworkAndClients)
+{
+	auto const networkName = getNetworkName("SendToNetworkAndClients");
+	auto const server = la::avdecc::protocol::ProxyServer::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, networkName, getAddress(networkName));
+	auto const peer = VirtualPointer(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, PeerMacAddress));
+	auto const client1 = ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(networkName)));
+	auto const client2 = ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(networkName)));
+
+	auto peerObs = Observer{};
+	auto clientObs = Observer{};
+	peer->registerObserver(&peerObs);
+	client2->registerObserver(&clientObs);
+	auto peerFuture = peerObs.waitForEntity(la::avdecc::UniqueIdentifier{ 0x0001020304050607 });
+	auto clientFuture = clientObs.waitForEntity(la::avdecc::UniqueIdentifier{ 0x0001020304050607 });
+
+	// Frames sent by a client are sent on the network, and captured back for all the clients of the server
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, client1->sendAdpMessage(buildEntityAvailable(client1->getMacAddress(), la::avdecc::UniqueIdentifier{ 0x0001020304050607 })));
+	ASSERT_NE(std::future_status::timeout, peerFuture.wait_for(std::chrono::seconds(1)));
+	ASSERT_NE(std::future_status::timeout, clientFuture.wait_for(std::chrono::seconds(1)));
+
+	EXPECT_EQ(1u, client1->getTransmitQueueStatistics().sentFrames);
+	EXPECT_EQ(1u, server->getStatistics().clientFrames);
+	peer->unregisterObserver(&peerObs);
+	client2->unregisterObserver(&clientObs);
+}
+
+TEST(ProtocolInterfaceProxy, RejectInvalidClientFrames)
+{
+	auto const networkName = getNetworkName("RejectInvalidClientFrames");
+	auto const server = la::avdecc::protocol::ProxyServer::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, networkName, getAddress(networkName));
+	auto const& serverMacAddress = server->getProtocolInterface().getMacAddress();
+
+	// Build invalid frames: too short, not AVTP (IPv4 EtherType), and spoofing the MAC address of another device
+	auto const shortFrame = std::vector<std::uint8_t>(10u, std::uint8_t{ 0u });
+	auto notAvtpFrame = std::vector<std::uint8_t>(60u, std::uint8_t{ 0u });
+	std::memcpy(notAvtpFrame.data() + 6, serverMacAddress.data(), serverMacAddress.size());
+	notAvtpFrame[12] = 0x08;
+	notAvtpFrame[13] = 0x00;
+	auto spoofedFrame = std::vector<std::uint8_t>(60u, std::uint8_t{ 0u });
+	std::memcpy(spoofedFrame.data() + 6, PeerMacAddress.data(), PeerMacAddress.size());
+	spoofedFrame[12] = 0x22;
+	spoofedFrame[13] = 0xf0;
+
+	// Send them in a single Frames message, directly on the socket (a proxy ProtocolInterface would not let them through)
+	auto const recordHeaders = std::array<la::avdecc::protocol::proxy::RecordHeader, 3>{ la::avdecc::protocol::proxy::makeRecordHeader(shortFrame.size()), la::avdecc::protocol::proxy::makeRecordHeader(notAvtpFrame.size()), la::avdecc::protocol::proxy::makeRecordHeader(spoofedFrame.size()) };
+	auto const header = la::avdecc::protocol::proxy::makeHeader(la::avdecc::protocol::proxy::MessageType::Frames, 3u, 3u * la::avdecc::protocol::proxy::RecordHeaderLength + shortFrame.size() + notAvtpFrame.size() + spoofedFrame.size());
+	auto vectors = std::array<iovec, 7>{ iovec{ const_cast<std::uint8_t*>(header.data()), header.size() }, iovec{ const_cast<std::uint8_t*>(recordHeaders[0].data()), recordHeaders[0].size() }, iovec{ const_cast<std::uint8_t*>(shortFrame.data()), shortFrame.size() }, iovec{ const_cast<std::uint8_t*>(recordHeaders[1].data()), recordHeaders[1].size() }, iovec{ notAvtpFrame.data(), notAvtpFrame.size() }, iovec{ const_cast<std::uint8_t*>(recordHeaders[2].data()), recordHeaders[2].size() }, iovec{ spoofedFrame.data(), spoofedFrame.size() } };
+	auto const fd = la::avdecc::protocol::proxy::connectTo(getAddress(networkName));
+	ASSERT_TRUE(la::avdecc::protocol::proxy::sendAllVectors(fd, vectors.data(), vectors.size()));
+
+	// Wait for the server to process the message
+	auto const timeout = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (server->getStatistics().clientFrames != 3u && std::chrono::steady_clock::now() < timeout)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	::close(fd);
+
+	// None of the frames were sent on the network
+	auto const statistics = server->getStatistics();
+	EXPECT_EQ(3u, statistics.clientFrames);
+	EXPECT_EQ(3u, statistics.rejectedFrames);
+	EXPECT_EQ(0u, statistics.receivedFrames);
+}
+
+TEST(ProtocolInterfaceProxy, AecpFiltering)
+{
+	auto const networkName = getNetworkName("AecpFiltering");
+	auto const server = la::avdecc::protocol::ProxyServer::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, networkName, getAddress(networkName));
+	auto const peer = VirtualPointer(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual(networkName, PeerMacAddress));
+	auto const client = ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(networkName)));
+	auto const sniffer = ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(networkName)));
+
+	auto peerObs = Observer{};
+	auto clientObs = Observer{};
+	auto snifferObs = Observer{};
+	peer->registerObserver(&peerObs);
+	client->registerObserver(&clientObs);
+	sniffer->registerObserver(&snifferObs);
+
+	// Messages of a connection are processed in order, so the filter is active once the following frame reached the network
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, sniffer->setSniffingMode(true));
+	auto peerFuture = peerObs.waitForEntity(la::avdecc::UniqueIdentifier{ 0x0001020304050607 });
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, sniffer->sendAdpMessage(buildEntityAvailable(sniffer->getMacAddress(), la::avdecc::UniqueIdentifier{ 0x0001020304050607 })));
+	ASSERT_NE(std::future_status::timeout, peerFuture.wait_for(std::chrono::seconds(1)));
+
+	// Send an AECP command between two remote entities, followed by an ADP message (frames of the network are forwarded in order)
+	auto clientFuture = clientObs.waitForEntity(la::avdecc::UniqueIdentifier{ 0x1011121314151617 });
+	auto snifferFuture = snifferObs.waitForEntity(la::avdecc::UniqueIdentifier{ 0x1011121314151617 });
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAecpMessage(*buildAemCommand(PeerMacAddress, server->getProtocolInterface().getMacAddress(), la::avdecc::UniqueIdentifier{ 0x2021222324252627 }, la::avdecc::UniqueIdentifier{ 0x3031323334353637 })));
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, peer->sendAdpMessage(buildEntityAvailable(PeerMacAddress, la::avdecc::UniqueIdentifier{ 0x1011121314151617 })));
+	ASSERT_NE(std::future_status::timeout, clientFuture.wait_for(std::chrono::seconds(1)));
+	ASSERT_NE(std::future_status::timeout, snifferFuture.wait_for(std::chrono::seconds(1)));
+
+	// Only the sniffing client received the AECP command
+	EXPECT_EQ(0u, clientObs.getReceivedAecpdus());
+	EXPECT_EQ(1u, snifferObs.getReceivedAecpdus());
+
+	peer->unregisterObserver(&peerObs);
+	client->unregisterObserver(&clientObs);
+	sniffer->unregisterObserver(&snifferObs);
+}
+
+TEST(ProtocolInterfaceProxy, ClientDisconnection)
+{
+	auto const networkName = getNetworkName("ClientDisconnection");
+	auto const server = la::avdecc::protocol::ProxyServer::create(la::avdecc::protocol::ProtocolInterface::Type::Virtual, networkName, getAddress(networkName));
+	// The server updates its clients list from its own thread
+	auto const waitForClients = [&server](std::size_t const count)
+	{
+		auto const timeout = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		while (server->getStatistics().connectedClients != count && std::chrono::steady_clock::now() < timeout)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return server->getStatistics().connectedClients;
+	};
+
+	{
+		auto const client = ProxyPointer(la::avdecc::protocol::ProtocolInterfaceProxy::createRawProtocolInterfaceProxy(getAddress(networkName)));
+		EXPECT_EQ(1u, waitForClients(1u));
+	}
+
+	EXPECT_EQ(0u, waitForClients(0u));
+}
@@ -0,0 +1,179 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file protocolInterface_sharedMemory_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "protocolInterface/protocolInterface_sharedMemory.hpp"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <future>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+// Each test process uses its own shared memory network, so concurrent test runs don't see each other
+std::string getNetworkName(std::string const& testName)
+{
+	return "avdecc_tests_" + testName + "_" + std::to_string(::getpid());
+}
+
+la::avdecc::protocol::Adpdu buildEntityAvailable(la::avdecc::networkInterface::MacAddress const& srcAddress, la::avdecc::UniqueIdentifier const entityID)
+{
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	// Set Ether2 fields
+	adpdu.setSrcAddress(srcAddress);
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	// Set ADP fields
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	adpdu.setValidTime(2);
+	adpdu.setEntityID(entityID);
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setEntityCapabilities({});
+	adpdu.setTalkerStreamSources(0);
+	adpdu.setTalkerCapabilities({});
+	adpdu.setListenerStreamSinks(0);
+	adpdu.setListenerCapabilities({});
+	adpdu.setControllerCapabilities(la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented });
+	adpdu.setAvailableIndex(1);
+	adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setGptpDomainNumber(0);
+	adpdu.setIdentifyControlIndex(0);
+	adpdu.setInterfaceIndex(0);
+	adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+	return adpdu;
+}
+} // namespace
+
+TEST(ProtocolInterfaceSharedMemory, InvalidName)
+{
+	// Not using EXPECT_THROW, we want to check the error code inside our custom exception
+	try
+	{
+		std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory("Invalid/Name", la::avdecc::protocol::ProtocolInterfaceSharedMemory::generateMacAddress()));
+		EXPECT_FALSE(true); // We expect an exception to have been raised
+	}
+	catch (la::avdecc::protocol::ProtocolInterface::Exception const& e)
+	{
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::InvalidParameters, e.getError());
+	}
+}
+
+TEST(ProtocolInterfaceSharedMemory, GenerateMacAddress)
+{
+	auto const macAddress = la::avdecc::protocol::ProtocolInterfaceSharedMemory::generateMacAddress();
+
+	EXPECT_TRUE(la::avdecc::networkInterface::isMacAddressValid(macAddress));
+	// Locally administered unicast address
+	EXPECT_EQ(0x02, macAddress[0] & 0x03);
+	EXPECT_NE(macAddress, la::avdecc::protocol::ProtocolInterfaceSharedMemory::generateMacAddress());
+}
+
+TEST(ProtocolInterfaceSharedMemory, SendMessage)
+{
+	class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+	{
+	public:
+		std::promise<void>& getPromise() noexcept
+		{
+			return _promise;
+		}
+
+	private:
+		virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept override
+		{
+			_promise.set_value();
+		}
+		std::promise<void> _promise{};
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+
+	// Each interface maps the segment on its own, exactly like interfaces from different processes would
+	auto const networkName = getNetworkName("SendMessage");
+	auto intfc1 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkName, { { 0x02, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto intfc2 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkName, { { 0x02, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	auto obs = Observer{};
+	intfc2->registerObserver(&obs);
+
+	// Send the adp message
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc1->sendAdpMessage(buildEntityAvailable(intfc1->getMacAddress(), la::avdecc::UniqueIdentifier{ 0x0001020304050607 })));
+
+	// Wait for the discover message to be received by the second interface (should be almost instant)
+	auto const status = obs.getPromise().get_future().wait_for(std::chrono::milliseconds(500));
+	ASSERT_NE(std::future_status::timeout, status);
+	EXPECT_EQ(1u, intfc1->getTransmitQueueStatistics().sentFrames);
+}
+
+TEST(ProtocolInterfaceSharedMemory, SegmentReleasedByLastInterface)
+{
+	auto const networkName = getNetworkName("SegmentReleased");
+	auto const segmentPath = "/dev/shm/avdecc." + networkName;
+
+	{
+		auto intfc1 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkName, { { 0x02, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+		{
+			auto intfc2 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkName, { { 0x02, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+		}
+		// Still used by the first interface
+		EXPECT_EQ(0, ::access(segmentPath.c_str(), F_OK));
+	}
+
+	EXPECT_NE(0, ::access(segmentPath.c_str(), F_OK));
+}
+
+TEST(ProtocolInterfaceSharedMemory, OverrunFramesCountedAsDropped)
+{
+	constexpr auto SentCount = std::uint64_t{ 10000u }; // More than the slots of the ring
+
+	auto const networkName = getNetworkName("Overrun");
+	auto intfc1 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkName, { { 0x02, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto intfc2 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceSharedMemory>(la::avdecc::protocol::ProtocolInterfaceSharedMemory::createRawProtocolInterfaceSharedMemory(networkName, { { 0x02, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	auto const adpdu = buildEntityAvailable(intfc1->getMacAddress(), la::avdecc::UniqueIdentifier{ 0x0001020304050607 });
+
+	// Locking the second interface prevents it from processing the frames, so the first one overruns it
+	{
+		auto const lg = std::lock_guard{ *intfc2 };
+		for (auto index = std::uint64_t{ 0u }; index < SentCount; ++index)
+		{
+			ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc1->sendAdpMessage(adpdu));
+		}
+	}
+
+	// Wait for the second interface to catch up
+	auto const timeout = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+	auto statistics = intfc2->getReceiveStatistics();
+	while (statistics.receivedFrames + statistics.droppedFrames < SentCount && std::chrono::steady_clock::now() < timeout)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		statistics = intfc2->getReceiveStatistics();
+	}
+
+	// Every frame has either been received or reported as dropped
+	EXPECT_EQ(SentCount, statistics.receivedFrames + statistics.droppedFrames);
+	EXPECT_LT(0u, statistics.droppedFrames);
+	EXPECT_EQ(SentCount, intfc1->getTransmitQueueStatistics().sentFrames);
+}
@@ -27,8 +27,13 @@
 #include "instrumentationObserver.hpp"
 
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <condition_variable>
 #include <future>
 #include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 TEST(ProtocolInterfaceVirtual, InvalidName)
 {
@@ -179,6 +184,242 @@ TEST(ProtocolInterfaceVirtual, RegisterAfterDiscoveredEntities)
 	}
 }
 
+TEST(ProtocolInterfaceVirtual, CoalescedRemoteEntitiesUpdates)
+{
+	class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+	{
+	public:
+		std::future<void> getOnlineFuture() noexcept
+		{
+			return _onlinePromise.get_future();
+		}
+		std::future<void> getBatchFuture() noexcept
+		{
+			return _batchPromise.get_future();
+		}
+		std::vector<std::vector<la::avdecc::entity::Entity>> getBatches() const noexcept
+		{
+			auto const lg = std::lock_guard{ _lock };
+			return _batches;
+		}
+		size_t getSingleUpdatesCount() const noexcept
+		{
+			auto const lg = std::lock_guard{ _lock };
+			return _singleUpdatesCount;
+		}
+
+	private:
+		virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept override
+		{
+			auto const lg = std::lock_guard{ _lock };
+			if (++_onlineCount == 2u)
+			{
+				_onlinePromise.set_value();
+			}
+		}
+		virtual void onRemoteEntityUpdated(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept override
+		{
+			auto const lg = std::lock_guard{ _lock };
+			++_singleUpdatesCount;
+		}
+		virtual void onRemoteEntitiesUpdated(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::protocol::ProtocolInterface::EntityReferences const& entities) noexcept override
+		{
+			auto const lg = std::lock_guard{ _lock };
+			_batches.emplace_back(entities.begin(), entities.end());
+			if (_batches.size() == 1u)
+			{
+				_batchPromise.set_value();
+			}
+		}
+
+		mutable std::mutex _lock{};
+		size_t _onlineCount{ 0u };
+		size_t _singleUpdatesCount{ 0u };
+		std::vector<std::vector<la::avdecc::entity::Entity>> _batches{};
+		std::promise<void> _onlinePromise{};
+		std::promise<void> _batchPromise{};
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+	auto intfc1 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("CoalescingInterface", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto intfc2 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("CoalescingInterface", { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc2->setRemoteEntitiesUpdateCoalescingDelay(std::chrono::milliseconds{ 200 }));
+
+	auto obs = Observer{};
+	intfc2->registerObserver(&obs);
+	auto onlineFuture = obs.getOnlineFuture();
+	auto batchFuture = obs.getBatchFuture();
+
+	auto const sendEntityAvailable = [&intfc1](la::avdecc::UniqueIdentifier const entityID, std::uint32_t const availableIndex, la::avdecc::UniqueIdentifier const grandmasterID)
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu{};
+		// Set Ether2 fields
+		adpdu.setSrcAddress(intfc1->getMacAddress());
+		adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu.setValidTime(10);
+		adpdu.setEntityID(entityID);
+		adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu.setEntityCapabilities(la::avdecc::entity::EntityCapabilities{ la::avdecc::entity::EntityCapability::GptpSupported });
+		adpdu.setTalkerStreamSources(0);
+		adpdu.setTalkerCapabilities({});
+		adpdu.setListenerStreamSinks(0);
+		adpdu.setListenerCapabilities({});
+		adpdu.setControllerCapabilities(la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented });
+		adpdu.setAvailableIndex(availableIndex);
+		adpdu.setGptpGrandmasterID(grandmasterID);
+		adpdu.setGptpDomainNumber(0);
+		adpdu.setIdentifyControlIndex(0);
+		adpdu.setInterfaceIndex(0);
+		adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+		intfc1->sendAdpMessage(adpdu);
+	};
+
+	auto const entityIDs = std::vector<la::avdecc::UniqueIdentifier>{ la::avdecc::UniqueIdentifier{ 0x0001020304050607 }, la::avdecc::UniqueIdentifier{ 0x0001020304050608 } };
+	for (auto const entityID : entityIDs)
+	{
+		sendEntityAvailable(entityID, 1u, la::avdecc::UniqueIdentifier{ 0x1000 });
+	}
+	ASSERT_NE(std::future_status::timeout, onlineFuture.wait_for(std::chrono::seconds(1)));
+
+	// Simulate a storm of grandmaster changes
+	auto const LastGrandmasterID = la::avdecc::UniqueIdentifier{ 0x1005 };
+	for (auto index = 1u; index <= 5u; ++index)
+	{
+		for (auto const entityID : entityIDs)
+		{
+			sendEntityAvailable(entityID, 1u + index, la::avdecc::UniqueIdentifier{ 0x1000 + index });
+		}
+	}
+
+	// All updates should be notified in a single batch, with the latest state of each entity
+	ASSERT_NE(std::future_status::timeout, batchFuture.wait_for(std::chrono::seconds(1)));
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+	auto const batches = obs.getBatches();
+	ASSERT_EQ(1u, batches.size());
+	ASSERT_EQ(2u, batches[0].size());
+	for (auto const& entity : batches[0])
+	{
+		auto const& grandmasterID = entity.getInterfacesInformation().begin()->second.gptpGrandmasterID;
+		ASSERT_TRUE(grandmasterID.has_value());
+		EXPECT_EQ(LastGrandmasterID, *grandmasterID);
+	}
+	EXPECT_NE(batches[0][0].getEntityID(), batches[0][1].getEntityID());
+	EXPECT_EQ(0u, obs.getSingleUpdatesCount());
+
+	intfc2->unregisterObserver(&obs);
+}
+
+TEST(ProtocolInterfaceVirtual, PacedDiscovery)
+{
+	using Clock = std::chrono::steady_clock;
+	struct DiscoverMessage
+	{
+		la::avdecc::UniqueIdentifier targetEntityID{};
+		Clock::time_point time{};
+	};
+	class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+	{
+	public:
+		std::vector<DiscoverMessage> getDiscoverMessages() const noexcept
+		{
+			auto const lg = std::lock_guard{ _lock };
+			return _discoverMessages;
+		}
+
+	private:
+		virtual void onAdpduReceived(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::protocol::Adpdu const& adpdu) noexcept override
+		{
+			if (adpdu.getMessageType() == la::avdecc::protocol::AdpMessageType::EntityDiscover)
+			{
+				auto const lg = std::lock_guard{ _lock };
+				_discoverMessages.push_back(DiscoverMessage{ adpdu.getEntityID(), Clock::now() });
+			}
+		}
+
+		mutable std::mutex _lock{};
+		std::vector<DiscoverMessage> _discoverMessages{};
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+	auto intfc1 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("PacedDiscoveryInterface", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto intfc2 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("PacedDiscoveryInterface", { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+
+	auto obs = Observer{};
+	intfc1->registerObserver(&obs);
+
+	auto const sendEntityAvailable = [&intfc1](la::avdecc::UniqueIdentifier const entityID, std::uint32_t const availableIndex)
+	{
+		auto adpdu = la::avdecc::protocol::Adpdu{};
+		// Set Ether2 fields
+		adpdu.setSrcAddress(intfc1->getMacAddress());
+		adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+		// Set ADP fields
+		adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+		adpdu.setValidTime(10);
+		adpdu.setEntityID(entityID);
+		adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu.setEntityCapabilities({});
+		adpdu.setTalkerStreamSources(0);
+		adpdu.setTalkerCapabilities({});
+		adpdu.setListenerStreamSinks(0);
+		adpdu.setListenerCapabilities({});
+		adpdu.setControllerCapabilities(la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented });
+		adpdu.setAvailableIndex(availableIndex);
+		adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+		adpdu.setGptpDomainNumber(0);
+		adpdu.setIdentifyControlIndex(0);
+		adpdu.setInterfaceIndex(0);
+		adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+		intfc1->sendAdpMessage(adpdu);
+	};
+
+	// The first entity keeps advertising itself, the other ones are only heard once
+	auto const advertisingEntityID = la::avdecc::UniqueIdentifier{ 0x0001020304050600 };
+	auto const silentEntityIDs = std::vector<la::avdecc::UniqueIdentifier>{ la::avdecc::UniqueIdentifier{ 0x0001020304050601 }, la::avdecc::UniqueIdentifier{ 0x0001020304050602 }, la::avdecc::UniqueIdentifier{ 0x0001020304050603 } };
+	sendEntityAvailable(advertisingEntityID, 1u);
+	for (auto const entityID : silentEntityIDs)
+	{
+		sendEntityAvailable(entityID, 1u);
+	}
+
+	constexpr auto DiscoveryDelay = std::chrono::milliseconds{ 400 };
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc2->setAutomaticDiscoveryPacing(true));
+	ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc2->setAutomaticDiscoveryDelay(DiscoveryDelay));
+
+	// Run for a global discovery period followed by (at least) a paced one
+	auto const endTime = Clock::now() + std::chrono::milliseconds{ 1400 };
+	for (auto availableIndex = 2u; Clock::now() < endTime; ++availableIndex)
+	{
+		sendEntityAvailable(advertisingEntityID, availableIndex);
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+	}
+	intfc2->setAutomaticDiscoveryDelay(std::chrono::milliseconds{ 0 });
+
+	auto const messages = obs.getDiscoverMessages();
+	intfc1->unregisterObserver(&obs);
+
+	// A single global DISCOVER, the entities being known afterwards
+	ASSERT_FALSE(messages.empty());
+	EXPECT_FALSE(messages[0].targetEntityID);
+	auto targetedMessages = std::vector<DiscoverMessage>{};
+	for (auto index = size_t{ 1u }; index < messages.size(); ++index)
+	{
+		EXPECT_TRUE(messages[index].targetEntityID) << "Unexpected global DISCOVER";
+		targetedMessages.push_back(messages[index]);
+	}
+
+	// Only the silent entities are targeted, spread over the period
+	ASSERT_GE(targetedMessages.size(), silentEntityIDs.size());
+	for (auto index = size_t{ 0u }; index < silentEntityIDs.size(); ++index)
+	{
+		auto const& message = targetedMessages[index];
+		EXPECT_NE(advertisingEntityID, message.targetEntityID);
+		EXPECT_NE(silentEntityIDs.end(), std::find(silentEntityIDs.begin(), silentEntityIDs.end(), message.targetEntityID));
+	}
+	EXPECT_GE(targetedMessages[silentEntityIDs.size() - 1u].time - targetedMessages[0].time, DiscoveryDelay / 4);
+}
+
 //TEST(ProtocolInterfaceVirtual, TransportError)
 //{
 //	static std::promise<void> entityOnlinePromise;
@@ -266,3 +507,80 @@ TEST(ProtocolInterfaceVirtual, RegisterAfterDiscoveredEntities)
 //	status = completedPromise.get_future().wait_for(std::chrono::seconds(1));
 //	ASSERT_NE(std::future_status::timeout, status) << "Deadlock!";
 //}
+
+/*
+ * Frames sent while the dispatch thread is stuck must not be dropped (nor block the sender), even when they don't fit in the ring
+ */
+TEST(ProtocolInterfaceVirtual, NoDropWhenRingIsFull)
+{
+	static constexpr auto NumberOfEntities = std::size_t{ 3000u }; // Much more than the ring capacity
+
+	class Observer : public la::avdecc::protocol::ProtocolInterface::Observer
+	{
+	public:
+		bool waitForEntities(std::size_t const count)
+		{
+			auto lock = std::unique_lock{ _lock };
+			return _condition.wait_for(lock, std::chrono::seconds(5),
+				[this, count]
+				{
+					return _onlineCount >= count;
+				});
+		}
+
+	private:
+		virtual void onRemoteEntityOnline(la::avdecc::protocol::ProtocolInterface* const /*pi*/, la::avdecc::entity::Entity const& /*entity*/) noexcept override
+		{
+			auto const lg = std::lock_guard{ _lock };
+			++_onlineCount;
+			_condition.notify_all();
+		}
+		std::mutex _lock{};
+		std::condition_variable _condition{};
+		std::size_t _onlineCount{ 0u };
+		DECLARE_AVDECC_OBSERVER_GUARD(Observer);
+	};
+	auto obs = Observer{};
+	auto intfc1 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("NoDropWhenRingIsFull", { { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 } }));
+	auto intfc2 = std::unique_ptr<la::avdecc::protocol::ProtocolInterfaceVirtual>(la::avdecc::protocol::ProtocolInterfaceVirtual::createRawProtocolInterfaceVirtual("NoDropWhenRingIsFull", { { 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b } }));
+	intfc2->registerObserver(&obs);
+
+	// Build adpdu frame
+	auto adpdu = la::avdecc::protocol::Adpdu{};
+	// Set Ether2 fields
+	adpdu.setSrcAddress(intfc1->getMacAddress());
+	adpdu.setDestAddress(la::avdecc::protocol::Adpdu::Multicast_Mac_Address);
+	// Set ADP fields
+	adpdu.setMessageType(la::avdecc::protocol::AdpMessageType::EntityAvailable);
+	adpdu.setValidTime(31);
+	adpdu.setEntityModelID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setEntityCapabilities({});
+	adpdu.setTalkerStreamSources(0);
+	adpdu.setTalkerCapabilities({});
+	adpdu.setListenerStreamSinks(0);
+	adpdu.setListenerCapabilities({});
+	adpdu.setControllerCapabilities(la::avdecc::entity::ControllerCapabilities{ la::avdecc::entity::ControllerCapability::Implemented });
+	adpdu.setAvailableIndex(1);
+	adpdu.setGptpGrandmasterID(la::avdecc::UniqueIdentifier::getNullUniqueIdentifier());
+	adpdu.setGptpDomainNumber(0);
+	adpdu.setIdentifyControlIndex(0);
+	adpdu.setInterfaceIndex(0);
+	adpdu.setAssociationID(la::avdecc::UniqueIdentifier{});
+
+	{
+		// Holding the lock of the receiving interface blocks the dispatch thread on the first message
+		auto const lg = std::lock_guard{ *intfc2 };
+
+		for (auto index = std::size_t{ 0u }; index < NumberOfEntities; ++index)
+		{
+			adpdu.setEntityID(la::avdecc::UniqueIdentifier{ 0x0001020304050000 + index });
+			ASSERT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, intfc1->sendAdpMessage(adpdu));
+		}
+	}
+
+	ASSERT_TRUE(obs.waitForEntities(NumberOfEntities));
+
+	auto const statistics = intfc1->getTransmitQueueStatistics();
+	EXPECT_EQ(0u, statistics.droppedFrames);
+	EXPECT_LE(NumberOfEntities, statistics.sentFrames);
+}
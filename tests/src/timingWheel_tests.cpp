@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file timingWheel_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "stateMachine/timingWheel.hpp"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <set>
+
+namespace
+{
+struct Timer : public la::avdecc::protocol::stateMachine::TimingWheelTimer
+{
+	int id{ 0 };
+};
+
+using Wheel = la::avdecc::protocol::stateMachine::TimingWheel<Timer, 64>;
+using Clock = std::chrono::steady_clock;
+
+constexpr auto Tick = std::chrono::milliseconds{ 10 };
+auto const Origin = Clock::time_point{ std::chrono::seconds{ 1000 } };
+
+std::set<int> popAllExpired(Wheel& wheel, Clock::time_point const currentTime)
+{
+	auto ids = std::set<int>{};
+	while (auto* const timer = wheel.popExpired(currentTime))
+	{
+		EXPECT_FALSE(timer->isArmed());
+		ids.insert(timer->id);
+	}
+	return ids;
+}
+} // namespace
+
+TEST(TimingWheel, NeverExpiresEarly)
+{
+	auto wheel = Wheel{ Tick, Origin };
+	auto timer = Timer{};
+	timer.id = 1;
+
+	// Expiry time is rounded up to the next tick
+	EXPECT_EQ(Origin + 26 * Tick, wheel.arm(&timer, Origin + 25 * Tick + std::chrono::milliseconds{ 5 }));
+	EXPECT_EQ(Origin + 26 * Tick, wheel.getNextExpiryTime());
+	EXPECT_EQ(1u, wheel.getArmedCount());
+
+	EXPECT_TRUE(popAllExpired(wheel, Origin + 26 * Tick - std::chrono::milliseconds{ 1 }).empty());
+	EXPECT_TRUE(timer.isArmed());
+	EXPECT_EQ((std::set<int>{ 1 }), popAllExpired(wheel, Origin + 26 * Tick));
+	EXPECT_EQ(0u, wheel.getArmedCount());
+	EXPECT_EQ(Clock::time_point::max(), wheel.getNextExpiryTime());
+}
+
+TEST(TimingWheel, RearmAndDisarm)
+{
+	auto wheel = Wheel{ Tick, Origin };
+	auto timers = std::array<Timer, 3>{};
+	for (auto i = 0u; i < timers.size(); ++i)
+	{
+		timers[i].id = static_cast<int>(i);
+		wheel.arm(&timers[i], Origin + 10 * Tick);
+	}
+
+	// Re-arming moves the timer
+	wheel.arm(&timers[0], Origin + 20 * Tick);
+	wheel.disarm(&timers[1]);
+	EXPECT_FALSE(timers[1].isArmed());
+	EXPECT_EQ(2u, wheel.getArmedCount());
+
+	EXPECT_EQ((std::set<int>{ 2 }), popAllExpired(wheel, Origin + 15 * Tick));
+	EXPECT_EQ(Origin + 20 * Tick, wheel.getNextExpiryTime());
+	EXPECT_EQ((std::set<int>{ 0 }), popAllExpired(wheel, Origin + 20 * Tick));
+
+	// Arming in the past reports the timer on the next pop
+	wheel.arm(&timers[1], Origin + 5 * Tick);
+	EXPECT_EQ((std::set<int>{ 1 }), popAllExpired(wheel, Origin + 20 * Tick));
+}
+
+TEST(TimingWheel, LaterRounds)
+{
+	auto wheel = Wheel{ Tick, Origin };
+	auto shortTimer = Timer{};
+	shortTimer.id = 1;
+	auto longTimer = Timer{};
+	longTimer.id = 2;
+
+	// Both timers share the same slot, the second one being 2 rounds later
+	wheel.arm(&shortTimer, Origin + 10 * Tick);
+	wheel.arm(&longTimer, Origin + (10 + 2 * 64) * Tick);
+
+	EXPECT_EQ((std::set<int>{ 1 }), popAllExpired(wheel, Origin + 10 * Tick));
+	EXPECT_EQ(Origin + (10 + 2 * 64) * Tick, wheel.getNextExpiryTime());
+	EXPECT_TRUE(popAllExpired(wheel, Origin + (10 + 64) * Tick).empty());
+	EXPECT_TRUE(longTimer.isArmed());
+
+	// Not checked for more than a full round
+	EXPECT_EQ((std::set<int>{ 2 }), popAllExpired(wheel, Origin + 1000 * Tick));
+}
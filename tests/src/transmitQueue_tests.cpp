@@ -0,0 +1,278 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+* @file transmitQueue_tests.cpp
+* @author Christophe Calmejane
+*/
+
+// Internal API
+#include "protocolInterface/transmitQueue.hpp"
+
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class Transport : public la::avdecc::protocol::TransmitQueue::Delegate
+{
+public:
+	std::vector<std::uint8_t> getSentFrames() const
+	{
+		auto const lg = std::lock_guard{ _lock };
+		return _sentFrames;
+	}
+
+	std::vector<la::avdecc::protocol::stateMachine::SentCommand> getNotSentCommands() const
+	{
+		auto const lg = std::lock_guard{ _lock };
+		return _notSentCommands;
+	}
+
+	void block()
+	{
+		_blocked = true;
+	}
+
+	void unblock()
+	{
+		_unblockPromise.set_value();
+	}
+
+	/** Frames identified by this first byte (and all the following ones of the batch) fail to be sent */
+	void failFrame(std::uint8_t const frame)
+	{
+		_failingFrame = frame;
+	}
+
+	/** Each batch takes this time to be sent */
+	void setSendDuration(std::chrono::microseconds const duration)
+	{
+		_sendDuration = duration;
+	}
+
+	/** Waits for the queue to accept commands, the same way the command state machine does */
+	bool waitForReadyForCommands(la::avdecc::protocol::TransmitQueue& queue)
+	{
+		auto lock = std::unique_lock{ _lock };
+		return _readyCondition.wait_for(lock, std::chrono::seconds(2),
+			[this, &queue, &lock]
+			{
+				// Not holding our lock while calling the queue, its sender thread may be waiting for it
+				lock.unlock();
+				auto const isReady = queue.isReadyForCommands();
+				lock.lock();
+				return isReady || std::exchange(_isReadyNotified, false);
+			});
+	}
+
+private:
+	virtual std::size_t sendFrames(la::avdecc::protocol::TransmitQueue::Frame const* const* const frames, std::size_t const count) noexcept override
+	{
+		if (_blocked)
+		{
+			_unblockPromise.get_future().wait();
+			_blocked = false;
+		}
+
+		if (_sendDuration.count() != 0)
+		{
+			std::this_thread::sleep_for(_sendDuration);
+		}
+
+		auto const lg = std::lock_guard{ _lock };
+		for (auto index = std::size_t{ 0u }; index < count; ++index)
+		{
+			// The first byte of the frame identifies it
+			if (_failingFrame && *_failingFrame == frames[index]->data[0])
+			{
+				return index;
+			}
+			_sentFrames.push_back(frames[index]->data[0]);
+		}
+		return count;
+	}
+
+	virtual void onCommandNotSent(la::avdecc::protocol::stateMachine::SentCommand const& command) noexcept override
+	{
+		auto const lg = std::lock_guard{ _lock };
+		_notSentCommands.push_back(command);
+	}
+
+	virtual void onReadyForCommands() noexcept override
+	{
+		auto const lg = std::lock_guard{ _lock };
+		_isReadyNotified = true;
+		_readyCondition.notify_all();
+	}
+
+	mutable std::mutex _lock{};
+	std::vector<std::uint8_t> _sentFrames{};
+	std::vector<la::avdecc::protocol::stateMachine::SentCommand> _notSentCommands{};
+	std::atomic_bool _blocked{ false };
+	std::promise<void> _unblockPromise{};
+	std::optional<std::uint8_t> _failingFrame{ std::nullopt };
+	std::chrono::microseconds _sendDuration{ 0 };
+	std::condition_variable _readyCondition{};
+	bool _isReadyNotified{ false };
+};
+} // namespace
+
+TEST(TransmitQueue, SendInOrder)
+{
+	auto transport = Transport{};
+	auto queue = la::avdecc::protocol::TransmitQueue{ transport };
+	queue.start("TransmitQueueTest");
+
+	for (auto frame = std::uint8_t{ 0u }; frame < 200u; ++frame)
+	{
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, queue.enqueue(&frame, 1u));
+	}
+
+	// Stopping the queue sends all the pending frames
+	queue.stop();
+
+	auto const sentFrames = transport.getSentFrames();
+	ASSERT_EQ(200u, sentFrames.size());
+	for (auto frame = std::uint8_t{ 0u }; frame < 200u; ++frame)
+	{
+		EXPECT_EQ(frame, sentFrames[frame]);
+	}
+
+	auto const statistics = queue.getStatistics();
+	EXPECT_EQ(200u, statistics.sentFrames);
+	EXPECT_EQ(0u, statistics.failedFrames);
+	EXPECT_EQ(0u, statistics.droppedFrames);
+	EXPECT_LE(statistics.sendBatches, 200u);
+
+	// Queue is stopped, frames are dropped
+	auto const frame = std::uint8_t{ 0u };
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::TransportError, queue.enqueue(&frame, 1u));
+	EXPECT_EQ(1u, queue.getStatistics().droppedFrames);
+}
+
+TEST(TransmitQueue, DropWhenFull)
+{
+	auto transport = Transport{};
+	auto queue = la::avdecc::protocol::TransmitQueue{ transport };
+	transport.block();
+	queue.start("TransmitQueueTest");
+
+	// Fill the queue (plus the batch being sent, blocked in the transport)
+	auto const frame = std::uint8_t{ 0u };
+	auto droppedCount = std::size_t{ 0u };
+	auto const start = std::chrono::steady_clock::now();
+	for (auto index = std::size_t{ 0u }; index < la::avdecc::protocol::TransmitQueue::Capacity + 1u; ++index)
+	{
+		if (queue.enqueue(&frame, 1u) != la::avdecc::protocol::ProtocolInterface::Error::NoError)
+		{
+			++droppedCount;
+		}
+	}
+
+	// At least the last frame couldn't fit, and was dropped without waiting for the transport
+	EXPECT_GE(droppedCount, 1u);
+	EXPECT_GT(std::chrono::seconds{ 1 }, std::chrono::steady_clock::now() - start);
+	auto const statistics = queue.getStatistics();
+	EXPECT_EQ(droppedCount, statistics.droppedFrames);
+	EXPECT_EQ(la::avdecc::protocol::TransmitQueue::Capacity, statistics.maximumDepth);
+
+	transport.unblock();
+	queue.stop();
+
+	EXPECT_EQ(la::avdecc::protocol::TransmitQueue::Capacity + 1u - droppedCount, queue.getStatistics().sentFrames);
+}
+
+TEST(TransmitQueue, CommandNotSent)
+{
+	auto transport = Transport{};
+	auto queue = la::avdecc::protocol::TransmitQueue{ transport };
+	transport.failFrame(1u);
+	transport.block();
+	queue.start("TransmitQueueTest");
+
+	auto command = la::avdecc::protocol::stateMachine::SentCommand{};
+	command.type = la::avdecc::protocol::stateMachine::SentCommand::Type::Aecp;
+	command.controllerEntityID = la::avdecc::UniqueIdentifier{ 0x0102030405060708 };
+	command.sequenceID = 42u;
+
+	// Frames are queued together, the transport stopping at the failing frame
+	auto const frames = std::array<std::uint8_t, 3>{ 0u, 1u, 2u };
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, queue.enqueue(&frames[0], 1u));
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, queue.enqueue(&frames[1], 1u, command));
+	EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, queue.enqueue(&frames[2], 1u));
+
+	transport.unblock();
+	queue.stop();
+
+	// Only the failed frame carrying a command is reported
+	auto const notSentCommands = transport.getNotSentCommands();
+	ASSERT_EQ(1u, notSentCommands.size());
+	EXPECT_EQ(la::avdecc::protocol::stateMachine::SentCommand::Type::Aecp, notSentCommands[0].type);
+	EXPECT_EQ(command.controllerEntityID, notSentCommands[0].controllerEntityID);
+	EXPECT_EQ(42u, notSentCommands[0].sequenceID);
+
+	auto const statistics = queue.getStatistics();
+	EXPECT_EQ(1u, statistics.failedCommands);
+	EXPECT_EQ(1u, statistics.sentFrames);
+	EXPECT_EQ(2u, statistics.failedFrames);
+}
+
+TEST(TransmitQueue, CommandsBackPressure)
+{
+	auto transport = Transport{};
+	auto queue = la::avdecc::protocol::TransmitQueue{ transport };
+	transport.setSendDuration(std::chrono::microseconds{ 500 });
+	queue.start("TransmitQueueTest");
+
+	auto command = la::avdecc::protocol::stateMachine::SentCommand{};
+	command.type = la::avdecc::protocol::stateMachine::SentCommand::Type::Aecp;
+	command.controllerEntityID = la::avdecc::UniqueIdentifier{ 0x0102030405060708 };
+
+	// Enqueue more commands than the queue can hold, waiting for the queue to accept them (instead of dropping them)
+	constexpr auto CommandsCount = 2u * la::avdecc::protocol::TransmitQueue::Capacity;
+	for (auto index = std::size_t{ 0u }; index < CommandsCount; ++index)
+	{
+		ASSERT_TRUE(transport.waitForReadyForCommands(queue));
+		auto const frame = static_cast<std::uint8_t>(index);
+		command.sequenceID = static_cast<std::uint16_t>(index);
+		EXPECT_EQ(la::avdecc::protocol::ProtocolInterface::Error::NoError, queue.enqueue(&frame, 1u, command));
+	}
+
+	queue.stop();
+
+	// None of the commands failed, the queue applied back-pressure instead
+	EXPECT_TRUE(transport.getNotSentCommands().empty());
+	EXPECT_EQ(CommandsCount, transport.getSentFrames().size());
+	auto const statistics = queue.getStatistics();
+	EXPECT_EQ(CommandsCount, statistics.sentFrames);
+	EXPECT_EQ(0u, statistics.droppedFrames);
+	EXPECT_EQ(0u, statistics.failedFrames);
+	EXPECT_EQ(0u, statistics.failedCommands);
+	EXPECT_LT(0u, statistics.commandWaits);
+	EXPECT_GT(la::avdecc::protocol::TransmitQueue::Capacity, statistics.maximumDepth);
+}
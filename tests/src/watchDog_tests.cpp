@@ -0,0 +1,153 @@
+/*
+* Copyright (C) 2016-2021, L-Acoustics and its contributors
+
+* This file is part of LA_avdecc.
+
+* LA_avdecc is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* LA_avdecc is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+
+* You should have received a copy of the GNU Lesser General Public License
+* along with LA_avdecc.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file watchDog_tests.cpp
+ * @author Christophe Calmejane
+ */
+
+// Public API
+#include <la/avdecc/watchDog.hpp>
+#include <la/avdecc/utils.hpp>
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+class Observer : public la::avdecc::watchDog::WatchDog::Observer
+{
+public:
+	Observer(std::string const& name) noexcept
+		: _name{ name }
+	{
+		la::avdecc::watchDog::WatchDog::getInstance()->registerObserver(this);
+	}
+
+	virtual ~Observer() noexcept override
+	{
+		la::avdecc::watchDog::WatchDog::getInstance()->unregisterObserver(this);
+	}
+
+	size_t getExceededCount() const noexcept
+	{
+		return _exceededCount;
+	}
+
+private:
+	virtual void onIntervalExceeded(std::string const& name, std::chrono::milliseconds const /*maximumInterval*/) noexcept override
+	{
+		if (name == _name)
+		{
+			++_exceededCount;
+		}
+	}
+
+	std::string const _name{};
+	std::atomic<size_t> _exceededCount{ 0u };
+};
+
+} // namespace
+
+TEST(WatchDog, HeartbeatExceeded)
+{
+	auto const name = std::string{ "WatchDogTests::HeartbeatExceeded" };
+	auto obs = Observer{ name };
+	auto& watchDog = *la::avdecc::watchDog::WatchDog::getInstance();
+
+	auto const handle = watchDog.registerHeartbeat(name, std::chrono::milliseconds{ 10u });
+	ASSERT_NE(la::avdecc::watchDog::WatchDog::InvalidHeartbeatHandle, handle);
+
+	la::avdecc::utils::disableAssert();
+	watchDog.armHeartbeat(handle);
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 100u });
+	watchDog.disarmHeartbeat(handle);
+	la::avdecc::utils::enableAssert();
+
+	// Only reported once per arming
+	EXPECT_EQ(1u, obs.getExceededCount());
+
+	watchDog.unregisterHeartbeat(handle);
+}
+
+TEST(WatchDog, HeartbeatNotExceeded)
+{
+	auto const name = std::string{ "WatchDogTests::HeartbeatNotExceeded" };
+	auto obs = Observer{ name };
+	auto& watchDog = *la::avdecc::watchDog::WatchDog::getInstance();
+
+	auto const handle = watchDog.registerHeartbeat(name, std::chrono::milliseconds{ 1000u });
+	ASSERT_NE(la::avdecc::watchDog::WatchDog::InvalidHeartbeatHandle, handle);
+
+	// Armed but refreshed in time
+	for (auto i = 0u; i < 5u; ++i)
+	{
+		watchDog.armHeartbeat(handle);
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 10u });
+	}
+	watchDog.disarmHeartbeat(handle);
+
+	// Disarmed, never checked
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 50u });
+
+	EXPECT_EQ(0u, obs.getExceededCount());
+
+	watchDog.unregisterHeartbeat(handle);
+}
+
+TEST(WatchDog, HeartbeatStorageGrows)
+{
+	auto const name = std::string{ "WatchDogTests::HeartbeatStorageGrows" };
+	auto obs = Observer{ name };
+	auto& watchDog = *la::avdecc::watchDog::WatchDog::getInstance();
+
+	// Register more heartbeats than the initially allocated slots
+	auto handles = std::vector<la::avdecc::watchDog::WatchDog::HeartbeatHandle>{};
+	for (auto i = 0u; i < 200u; ++i)
+	{
+		auto const handle = watchDog.registerHeartbeat(name + std::to_string(i), std::chrono::milliseconds{ 10u });
+		ASSERT_NE(la::avdecc::watchDog::WatchDog::InvalidHeartbeatHandle, handle);
+		handles.push_back(handle);
+	}
+	EXPECT_EQ(handles.size(), std::unordered_set<la::avdecc::watchDog::WatchDog::HeartbeatHandle>(handles.begin(), handles.end()).size());
+
+	// The last registered heartbeat is checked like the first ones
+	auto const handle = watchDog.registerHeartbeat(name, std::chrono::milliseconds{ 10u });
+	ASSERT_NE(la::avdecc::watchDog::WatchDog::InvalidHeartbeatHandle, handle);
+	la::avdecc::utils::disableAssert();
+	watchDog.armHeartbeat(handle);
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 100u });
+	watchDog.disarmHeartbeat(handle);
+	la::avdecc::utils::enableAssert();
+	EXPECT_EQ(1u, obs.getExceededCount());
+
+	watchDog.unregisterHeartbeat(handle);
+	for (auto const h : handles)
+	{
+		watchDog.unregisterHeartbeat(h);
+	}
+
+	// A failed registration handle is accepted
+	watchDog.unregisterHeartbeat(la::avdecc::watchDog::WatchDog::InvalidHeartbeatHandle);
+}